@@ -80,6 +80,13 @@ extern "C"
 */
 #define CA_MAX_TOKEN_LEN (8)
 
+/**
+ * Max number of IP receive threads, see CASetIPReceiveShards().
+ */
+#ifndef CA_IP_MAX_RECEIVE_SHARDS
+#define CA_IP_MAX_RECEIVE_SHARDS (8)
+#endif
+
 /**
  * Max URI length.
  */
@@ -451,6 +458,27 @@ typedef struct
     char optionData[CA_MAX_HEADER_OPTION_DATA_LENGTH];      /**< Optional data values**/
 } CAHeaderOption_t;
 
+/**
+ * Callback producing a part of a streamed payload on demand.
+ * @param[in]   context     context given to CACreatePayloadStream.
+ * @param[in]   offset      offset of the part in the payload.
+ * @param[out]  buf         buffer for the part.
+ * @param[in]   length      number of bytes to write into buf.
+ * @return  true if length bytes were written to buf.
+ */
+typedef bool (*CAPayloadProducer_t)(void *context, size_t offset, uint8_t *buf, size_t length);
+
+/**
+ * Callback releasing the context of a streamed payload once it is no longer used.
+ * @param[in]   context     context given to CACreatePayloadStream.
+ */
+typedef void (*CAPayloadRelease_t)(void *context);
+
+/**
+ * Streamed payload, private to the CA layer.
+ */
+typedef struct CAPayloadStream CAPayloadStream_t;
+
 /**
  * Base Information received.
  *
@@ -472,6 +500,8 @@ typedef struct
     uint8_t numOptions;         /**< Number of Header options */
     CAPayload_t payload;        /**< payload of the request  */
     size_t payloadSize;         /**< size in bytes of the payload */
+    CAPayloadStream_t *payloadStream;   /**< produces the payloadSize bytes of the payload
+                                             block by block, used if payload is NULL */
     CAPayloadFormat_t payloadFormat;    /**< encoding format of the request payload */
     CAPayloadFormat_t acceptFormat;     /**< accept format for the response payload */
     uint16_t payloadVersion;    /**< version of the payload */
@@ -603,6 +633,9 @@ typedef struct
         int netlinkFd;              /**< netlink */
         int shutdownFds[2];         /**< fds used to signal threads to stop */
         int maxfd;                  /**< highest fd (for select) */
+#if defined(HAVE_SYS_EPOLL_H)
+        int epollFd;                /**< epoll instance (used instead of select) */
+#endif
 #endif
         int selectTimeout;          /**< in seconds */
         bool started;               /**< the IP adapter has started */
@@ -610,6 +643,8 @@ typedef struct
         bool ipv6enabled;           /**< IPv6 enabled by OCInit flags */
         bool ipv4enabled;           /**< IPv4 enabled by OCInit flags */
         bool dualstack;             /**< IPv6 and IPv4 enabled */
+        uint8_t receiveShards;      /**< receive threads with their own unicast sockets */
+        bool receiveAffinity;       /**< pin each receive thread to a CPU */
 #if defined (_WIN32)
         LPFN_WSARECVMSG wsaRecvMsg; /**< Win32 function pointer to WSARecvMsg() */
 #endif
@@ -640,12 +675,16 @@ typedef struct
         CASocket_t ipv6s;       /**< IPv6 accept socket secure */
         int selectTimeout;      /**< in seconds */
         int listenBacklog;      /**< backlog counts*/
+        size_t sendHighWaterMark;/**< queued bytes per session before sends are refused */
 #if defined(_WIN32)
         WSAEVENT updateEvent;   /**< Event used to signal thread to stop or update the FD list */
 #else
         int shutdownFds[2];     /**< shutdown pipe */
         int connectionFds[2];   /**< connection pipe */
         int maxfd;              /**< highest fd (for select) */
+#if defined(HAVE_SYS_EPOLL_H)
+        int epollFd;            /**< epoll instance (used instead of select) */
+#endif
 #endif
         bool started;           /**< the TCP adapter has started */
         volatile bool terminate;/**< the TCP adapter needs to stop */
@@ -172,6 +172,31 @@ CAResult_t CAGenerateToken(CAToken_t *token, uint8_t tokenLength);
  */
 void CADestroyToken(CAToken_t token);
 
+/**
+ * Create a streamed payload.  A request or response carrying it in
+ * CAInfo_t::payloadStream, with payload NULL and payloadSize set to the total
+ * length, is sent without the whole payload in memory: each block of a
+ * block-wise transfer is produced by the producer when it is sent.  Messages
+ * sent without block-wise transfer get the payload produced at once.
+ * @param[in]   producer    callback producing the payload.
+ * @param[in]   release     callback releasing context when the stream is no
+ *                          longer used, may be NULL.
+ * @param[in]   context     context passed to the callbacks.
+ * @param[out]  stream      streamed payload.
+ * @return  ::CA_STATUS_OK or ::CA_STATUS_INVALID_PARAM or ::CA_MEMORY_ALLOC_FAILED
+ * @remark  The stream is destroyed by the caller using CADestroyPayloadStream(),
+ *          messages sent with it keep their own reference.
+ * @see     CADestroyPayloadStream
+ */
+CAResult_t CACreatePayloadStream(CAPayloadProducer_t producer, CAPayloadRelease_t release,
+                                 void *context, CAPayloadStream_t **stream);
+
+/**
+ * Destroy the streamed payload created by CACreatePayloadStream.
+ * @param[in]   stream   streamed payload to be released.
+ */
+void CADestroyPayloadStream(CAPayloadStream_t *stream);
+
 /**
  * Send control Request on a resource.
  * @param[in]   object       Endpoint where the payload need to be sent.
@@ -231,6 +256,29 @@ CATransportAdapter_t CAGetSelectedNetwork();
  */
 CAResult_t CAHandleRequestResponse();
 
+/**
+ * To Handle up to maxCount queued Requests or Responses in one call.
+ * @param[in]   maxCount    maximum number of requests and responses to handle.
+ * @param[out]  remaining   number still queued afterwards. may be NULL.
+ * @return   ::CA_STATUS_OK or ::CA_STATUS_NOT_INITIALIZED
+ */
+CAResult_t CAHandleRequestResponseBatch(uint32_t maxCount, uint32_t *remaining);
+
+/**
+ * Block until Requests or Responses are waiting to be handled.
+ * @param[in]   timeoutMs   longest wait in milliseconds, 0 waits until woken.
+ * @return   ::CA_STATUS_OK if there is something to handle, ::CA_REQUEST_TIMEOUT on
+ *           timeout or ::CAWakeUpRequestResponse, ::CA_NOT_SUPPORTED if this build
+ *           cannot wait, or ::CA_STATUS_NOT_INITIALIZED
+ */
+CAResult_t CAWaitForRequestResponse(uint32_t timeoutMs);
+
+/**
+ * Wake up all threads blocked in ::CAWaitForRequestResponse.
+ * @return   ::CA_STATUS_OK or ::CA_STATUS_NOT_INITIALIZED
+ */
+CAResult_t CAWakeUpRequestResponse();
+
 #ifdef RA_ADAPTER
 /**
  * Set Remote Access information for XMPP Client.
@@ -250,6 +298,17 @@ CAResult_t CASetRAInfo(const CARAInfo_t *caraInfo);
  */
 CAResult_t CASetProxyUri(const char *uri);
 
+/**
+ * This function sets NSTART, the number of CON exchanges outstanding with an
+ * endpoint at once; further CON messages are held back until one completes.
+ * It takes effect from the next ::CAInitialize.
+ *
+ * @param nstart         maximum outstanding exchanges per endpoint, 0 for no limit.
+ *
+ * @return  ::CA_STATUS_OK
+ */
+CAResult_t CASetRetransmissionNStart(uint8_t nstart);
+
 /**
  * This function return zone id related from ifindex and address.
  *
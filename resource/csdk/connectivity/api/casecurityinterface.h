@@ -160,6 +160,14 @@ typedef void (*CAgetPkixInfoHandler)(PkiInfo_t * inf);
  */
 CAResult_t CAregisterPkixInfoHandler(CAgetPkixInfoHandler getPkixInfoHandler);
 
+/**
+ * Notify CA that the PKIX related info has changed.
+ * Certificates, key and CRL are parsed once and reused by every handshake
+ * until this is called or another PKIX info callback is registered.
+ * @return  ::CA_STATUS_OK or appropriate error code.
+ */
+CAResult_t CAinvalidatePkixInfo();
+
 /**
  * Select the cipher suite for dtls handshake.
  *
@@ -194,6 +202,20 @@ CAResult_t CASelectCipherSuite(const uint16_t cipher, CATransportAdapter_t adapt
  */
 CAResult_t CAEnableAnonECDHCipherSuite(const bool enable);
 
+/**
+ * Run DTLS handshakes on a dedicated thread instead of the adapter receive thread,
+ * so that a slow handshake does not hold up data of established sessions.
+ * Handshake results are still reported through the registered handshake callback.
+ *
+ * @param[in] enable  TRUE/FALSE enables/disables asynchronous handshakes.
+ *
+ * @retval  ::CA_STATUS_OK    Successful.
+ * @retval  ::CA_STATUS_FAILED Operation failed.
+ *
+ * @note The IP or BLE adapter must be started first.
+ */
+CAResult_t CAEnableAsyncHandshake(const bool enable);
+
 
 /**
  * Generate ownerPSK using PRF.
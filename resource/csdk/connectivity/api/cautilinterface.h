@@ -124,6 +124,19 @@ CAResult_t CASetPortNumberToAssign(CATransportAdapter_t adapter,
  */
 uint16_t CAGetAssignedPortNumber(CATransportAdapter_t adapter, CATransportFlags_t flag);
 
+/**
+ * Set the number of threads receiving IP unicast datagrams.
+ * Each thread reads its own SO_REUSEPORT sockets bound to the unicast ports,
+ * and the kernel keeps the datagrams of a peer on one of them.
+ * Applies from the next start of the IP adapter. Platforms without
+ * SO_REUSEPORT keep one receive thread.
+ * @param[in]   shards      number of receive threads, 1 to ::CA_IP_MAX_RECEIVE_SHARDS.
+ * @param[in]   pinToCpus   pin each receive thread to its own CPU.
+ *
+ * @return  ::CA_STATUS_OK or ::CA_STATUS_INVALID_PARAM.
+ */
+CAResult_t CASetIPReceiveShards(uint8_t shards, bool pinToCpus);
+
 #if defined(TCP_ADAPTER) && defined(WITH_CLOUD)
 /**
  * Initializes the Connection Manager
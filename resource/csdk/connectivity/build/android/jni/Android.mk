@@ -85,7 +85,7 @@ LOCAL_C_INCLUDES += $(OIC_C_COMMON_PATH)/oic_malloc/include
 LOCAL_C_INCLUDES += $(OIC_C_COMMON_PATH)/oic_string/include
 
 LOCAL_SRC_FILES =       oic_logger.c oic_console_logger.c logger.c \
-                        uarraylist.c uqueue.c \
+                        uarraylist.c uqueue.c umempool.c \
                         cathreadpool_pthreads.c camutex_pthreads.c \
                         caremotehandler.c
 
@@ -140,7 +140,7 @@ LOCAL_CFLAGS += $(BUILD_FLAG)
 LOCAL_CFLAGS += -std=c99 -DWITH_POSIX -DWITH_BWT
 
 LOCAL_SRC_FILES = \
-                caconnectivitymanager.c cainterfacecontroller.c \
+                caconnectivitymanager.c cadedup.c cainterfacecontroller.c \
                 camessagehandler.c canetworkconfigurator.c caprotocolmessage.c \
                 caretransmission.c caqueueingthread.c cablockwisetransfer.c \
                 $(ADAPTER_UTILS)/caadapternetdtls.c $(ADAPTER_UTILS)/caadapterutils.c \
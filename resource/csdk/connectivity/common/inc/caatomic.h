@@ -0,0 +1,142 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ *
+ * This file contains the minimal set of atomic operations used by the
+ * lock-free CA utilities.  GCC/Clang builtins are used where available,
+ * Interlocked functions on MSVC.
+ */
+
+#ifndef CA_ATOMIC_H_
+#define CA_ATOMIC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/**
+ * Load a value with acquire semantics.
+ */
+static inline uint32_t CAAtomicLoad32(const volatile uint32_t *ptr)
+{
+#if defined(_MSC_VER)
+    uint32_t value = *ptr;
+    MemoryBarrier();
+    return value;
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+ * Store a value with release semantics.
+ */
+static inline void CAAtomicStore32(volatile uint32_t *ptr, uint32_t value)
+{
+#if defined(_MSC_VER)
+    MemoryBarrier();
+    *ptr = value;
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+ * Replace *ptr with desired if it still holds expected.
+ * @return true if the value was replaced.
+ */
+static inline bool CAAtomicCompareExchange32(volatile uint32_t *ptr,
+                                             uint32_t expected, uint32_t desired)
+{
+#if defined(_MSC_VER)
+    return (uint32_t)InterlockedCompareExchange((volatile LONG *)ptr,
+                                                (LONG)desired, (LONG)expected) == expected;
+#else
+    return __atomic_compare_exchange_n(ptr, &expected, desired, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * Add value to *ptr.
+ * @return the new value.
+ */
+static inline uint32_t CAAtomicAdd32(volatile uint32_t *ptr, uint32_t value)
+{
+#if defined(_MSC_VER)
+    return (uint32_t)InterlockedExchangeAdd((volatile LONG *)ptr, (LONG)value) + value;
+#else
+    return __atomic_add_fetch(ptr, value, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/**
+ * Load a pointer with acquire semantics.
+ */
+static inline void *CAAtomicLoadPtr(void * const volatile *ptr)
+{
+#if defined(_MSC_VER)
+    void *value = *ptr;
+    MemoryBarrier();
+    return value;
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+ * Replace a pointer and return the previous one (acquire/release).
+ */
+static inline void *CAAtomicExchangePtr(void * volatile *ptr, void *value)
+{
+#if defined(_MSC_VER)
+    return InterlockedExchangePointer((PVOID volatile *)ptr, value);
+#else
+    return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/**
+ * Full memory barrier.
+ */
+static inline void CAAtomicFence(void)
+{
+#if defined(_MSC_VER)
+    MemoryBarrier();
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* CA_ATOMIC_H_ */
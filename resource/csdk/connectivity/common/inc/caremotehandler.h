@@ -28,6 +28,29 @@
 #define CA_REMOTE_HANDLER_H_
 
 #include "cacommon.h"
+#include "umempool.h"
+
+/** free objects of each type kept for reuse. **/
+#ifndef CA_OBJECT_POOL_SIZE
+#define CA_OBJECT_POOL_SIZE     256
+#endif
+
+/** objects of each type allocated when the pools are created. **/
+#ifndef CA_OBJECT_POOL_PREALLOC
+#define CA_OBJECT_POOL_PREALLOC 32
+#endif
+
+/**
+ * Statistics of the object pools.
+ */
+typedef struct
+{
+    u_mempool_stats_t endpoint;         /**< ::CAEndpoint_t */
+    u_mempool_stats_t requestInfo;      /**< ::CARequestInfo_t */
+    u_mempool_stats_t responseInfo;     /**< ::CAResponseInfo_t */
+    u_mempool_stats_t errorInfo;        /**< ::CAErrorInfo_t */
+    u_mempool_stats_t token;            /**< tokens of ::CA_MAX_TOKEN_LEN bytes */
+} CAObjectPoolStats_t;
 
 #ifdef __cplusplus
 extern "C"
@@ -97,6 +120,94 @@ void CADestroyResponseInfoInternal(CAResponseInfo_t *response);
  */
 void CADestroyErrorInfoInternal(CAErrorInfo_t *errorInfo);
 
+/**
+ * Allocate a streamed payload, freed with ::CAFreePayloadStream.
+ * @param[in]   producer    callback producing the payload.
+ * @param[in]   release     callback releasing context, may be NULL.
+ * @param[in]   context     context passed to the callbacks.
+ * @return  streamed payload holding one reference.
+ */
+CAPayloadStream_t *CACreatePayloadStreamObject(CAPayloadProducer_t producer,
+                                               CAPayloadRelease_t release, void *context);
+
+/**
+ * Take another reference to a streamed payload.
+ * @param[in]   stream      streamed payload.
+ * @return  stream.
+ */
+CAPayloadStream_t *CARetainPayloadStream(CAPayloadStream_t *stream);
+
+/**
+ * Drop a reference to a streamed payload.  The release callback is called
+ * when the last reference is dropped.
+ * @param[in]   stream      streamed payload.
+ */
+void CAFreePayloadStream(CAPayloadStream_t *stream);
+
+/**
+ * Produce a part of a streamed payload.
+ * @param[in]   stream      streamed payload.
+ * @param[in]   offset      offset of the part in the payload.
+ * @param[out]  buf         buffer for the part.
+ * @param[in]   length      number of bytes to produce.
+ * @return  ::CA_STATUS_OK or Appropriate error code.
+ */
+CAResult_t CAReadPayloadStream(CAPayloadStream_t *stream, size_t offset,
+                               uint8_t *buf, size_t length);
+
+/**
+ * Creates the pools endpoints, infos and tokens are allocated from.  Objects
+ * are allocated from the heap while there are no pools.
+ * @return  ::CA_STATUS_OK or Appropriate error code.
+ */
+CAResult_t CAInitializeObjectPools(void);
+
+/**
+ * Deletes the object pools.  Objects in use stay valid and are freed to the heap.
+ * No other thread may allocate or free objects meanwhile.
+ */
+void CATerminateObjectPools(void);
+
+/**
+ * Allocate a zero filled request information, destroyed with
+ * ::CADestroyRequestInfoInternal.
+ * @return  request info object.
+ */
+CARequestInfo_t *CAAllocRequestInfo(void);
+
+/**
+ * Allocate a zero filled response information, destroyed with
+ * ::CADestroyResponseInfoInternal.
+ * @return  response info object.
+ */
+CAResponseInfo_t *CAAllocResponseInfo(void);
+
+/**
+ * Allocate a zero filled error information, destroyed with
+ * ::CADestroyErrorInfoInternal.
+ * @return  error info object.
+ */
+CAErrorInfo_t *CAAllocErrorInfo(void);
+
+/**
+ * Allocate a token buffer of ::CA_MAX_TOKEN_LEN bytes.
+ * @return  token buffer, freed with ::CAFreeToken or OICFree.
+ */
+CAToken_t CAAllocToken(void);
+
+/**
+ * Free a token.
+ * @param[in]   token           token to be freed.
+ * @param[in]   tokenLength     length of the token.
+ */
+void CAFreeToken(CAToken_t token, uint8_t tokenLength);
+
+/**
+ * Get the statistics of the object pools.
+ * @param[out]  stats           statistics.
+ */
+void CAGetObjectPoolStats(CAObjectPoolStats_t *stats);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -38,6 +38,13 @@ extern "C"
 {
 #endif // __cplusplus
 
+/**
+ * Upper bound on workers started on demand beyond num_of_threads.
+ */
+#ifndef CA_THREAD_POOL_MAX_THREADS
+#define CA_THREAD_POOL_MAX_THREADS 32
+#endif
+
 /**
  * Callback type can be registered to thread pool.
  */
@@ -52,8 +59,24 @@ typedef struct ca_thread_pool
     struct ca_thread_pool_details_t* details;
 }*ca_thread_pool_t;
 
+/**
+ * Thread pool statistics.
+ */
+typedef struct
+{
+    uint32_t num_of_threads;    /**< worker threads currently owned by the pool */
+    uint32_t idle_threads;      /**< worker threads waiting for a task */
+    uint32_t dedicated_threads; /**< threads running a dedicated task */
+    uint32_t queue_depth;       /**< tasks waiting for a worker */
+    uint32_t max_queue_depth;   /**< highest queue depth seen */
+    uint64_t tasks_completed;   /**< tasks which have finished running */
+    uint64_t total_latency_us;  /**< sum of the time tasks spent queued */
+    uint64_t max_latency_us;    /**< longest time a task spent queued */
+} ca_thread_pool_stats_t;
+
 /**
  * This function creates a newly allocated thread pool.
+ * num_of_threads workers are started up front and reused for every task.
  *
  * @param num_of_threads The number of worker thread used in this pool.
  * @param thread_pool_handle Handle to newly create thread pool.
@@ -63,17 +86,49 @@ CAResult_t ca_thread_pool_init(int32_t num_of_threads, ca_thread_pool_t *thread_
 
 /**
  * This function adds a routine to be executed by the thread pool at some future time.
+ * Every task gets a worker of its own, so a routine may block for a while. The task
+ * is refused when all workers are busy and the pool has reached its maximum size;
+ * a routine which runs until its adapter stops belongs in
+ * ::ca_thread_pool_add_dedicated_task instead.
  *
  * @param thread_pool The thread pool structure.
  * @param method The routine to be executed.
  * @param data The data to be passed to the routine.
  *
  * @return CA_STATUS_OK on success.
+ * @return CA_STATUS_FAILED if no worker is left for the task.
  * @return Error on failure.
  */
 CAResult_t ca_thread_pool_add_task(ca_thread_pool_t thread_pool, ca_thread_func method,
                     void *data);
 
+/**
+ * This function runs a routine on a thread of its own, which is not one of the workers
+ * and does not count against ::CA_THREAD_POOL_MAX_THREADS.  It is meant for routines
+ * which run for the lifetime of an adapter, such as receive loops.  The thread is
+ * joined when the next dedicated task is added or when the pool is freed.
+ *
+ * @param thread_pool The thread pool structure.
+ * @param method The routine to be executed.
+ * @param data The data to be passed to the routine.
+ *
+ * @return CA_STATUS_OK on success.
+ * @return Error on failure.
+ */
+CAResult_t ca_thread_pool_add_dedicated_task(ca_thread_pool_t thread_pool, ca_thread_func method,
+                                             void *data);
+
+/**
+ * This function gets a snapshot of the thread pool statistics.
+ *
+ * @param thread_pool The thread pool structure.
+ * @param stats Statistics filled in by this function.
+ *
+ * @return CA_STATUS_OK on success.
+ * @return Error on failure.
+ */
+CAResult_t ca_thread_pool_get_stats(ca_thread_pool_t thread_pool, ca_thread_pool_stats_t *stats);
+
 /**
  * This function stops all the worker threads (stop & exit). And frees all the allocated memory.
  * Function will return only after joining all threads executing the currently scheduled tasks.
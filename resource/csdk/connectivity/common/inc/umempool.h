@@ -0,0 +1,119 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ *
+ * This file contains the APIs for a pool of fixed size objects.  Freed
+ * objects are kept for reuse instead of being returned to the heap, so a
+ * steady flow of messages does not allocate.  Every object is a heap block
+ * of its own: an object of the pool's size allocated with OICMalloc() may
+ * be freed into the pool, and an object taken from the pool may be freed
+ * with OICFree().
+ */
+
+#ifndef U_MEMPOOL_H_
+#define U_MEMPOOL_H_
+
+#include "cacommon.h"
+#include "octhread.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/**
+ * Object pool statistics.
+ */
+typedef struct u_mempool_stats_t
+{
+    /** Allocations served from the pool. */
+    uint32_t hits;
+    /** Allocations that went to the heap because the pool was empty. */
+    uint32_t misses;
+    /** Objects freed into the pool. */
+    uint32_t releases;
+    /** Objects freed to the heap because the pool was full. */
+    uint32_t overflows;
+    /** Objects in the pool now. */
+    uint32_t cached;
+} u_mempool_stats_t;
+
+/**
+ * Object pool structure.
+ */
+typedef struct u_mempool_t
+{
+    /** Mutex for synchronization. */
+    oc_mutex lock;
+    /** Free objects, linked through their first bytes. */
+    void *free;
+    /** Size of the objects. */
+    size_t objectSize;
+    /** Most objects kept in the pool. */
+    uint32_t maxCached;
+    /** Statistics. */
+    u_mempool_stats_t stats;
+} u_mempool_t;
+
+/**
+ * API to create an object pool.
+ * @param objectSize size of the objects, at least sizeof(void *).
+ * @param preallocate number of objects allocated up front.
+ * @param maxCached most free objects kept, more are returned to the heap.
+ * @return  u_mempool_t pointer if Success, NULL otherwise.
+ */
+u_mempool_t *u_mempool_create(size_t objectSize, uint32_t preallocate, uint32_t maxCached);
+
+/**
+ * Deletes the pool and the objects in it.  Objects still in use are not
+ * affected and can be freed with OICFree().
+ * @param pool pool pointer.
+ */
+void u_mempool_delete(u_mempool_t *pool);
+
+/**
+ * Takes a zero filled object from the pool, or from the heap if the pool is
+ * empty.  Safe to call from several threads at once.
+ * @param pool pool pointer.
+ * @return  object pointer, NULL if out of memory or pool is NULL.
+ */
+void *u_mempool_alloc(u_mempool_t *pool);
+
+/**
+ * Returns an object to the pool.  Safe to call from several threads at once.
+ * @param pool pool pointer.  If NULL, the object is freed to the heap.
+ * @param object object from u_mempool_alloc() or a heap block of the size
+ *               of the pool's objects.  NULL is ignored.
+ */
+void u_mempool_free(u_mempool_t *pool, void *object);
+
+/**
+ * @param pool pool pointer.
+ * @param stats receives the statistics of the pool, zeros if pool is NULL.
+ */
+void u_mempool_get_stats(u_mempool_t *pool, u_mempool_stats_t *stats);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* U_MEMPOOL_H_ */
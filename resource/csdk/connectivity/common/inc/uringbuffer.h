@@ -0,0 +1,114 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ *
+ * This file contains the APIs for a bounded, preallocated ring buffer of
+ * queue messages.  Any number of threads may add messages concurrently
+ * without a lock; only one thread at a time may remove them.
+ */
+
+#ifndef U_RINGBUFFER_H_
+#define U_RINGBUFFER_H_
+
+#include "cacommon.h"
+#include "uqueue.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/**
+ * Ring buffer slot.  seq tells producers and the consumer whose turn it is.
+ */
+typedef struct u_ringbuffer_slot_t
+{
+    volatile uint32_t seq;
+    u_queue_message_t message;
+} u_ringbuffer_slot_t;
+
+/**
+ * Ring buffer structure.
+ */
+typedef struct u_ringbuffer_t
+{
+    /** Preallocated slots. */
+    u_ringbuffer_slot_t *slots;
+    /** Number of slots - 1 (capacity is a power of two). */
+    uint32_t mask;
+    /** Next position producers claim. */
+    volatile uint32_t tail;
+    /** Next position the consumer reads. */
+    volatile uint32_t head;
+} u_ringbuffer_t;
+
+/**
+ * API to create a ring buffer.
+ * @param capacity number of messages, rounded up to a power of two.
+ * @return  u_ringbuffer_t pointer if Success, NULL otherwise.
+ */
+u_ringbuffer_t *u_ringbuffer_create(uint32_t capacity);
+
+/**
+ * Deletes the ring buffer.  Messages still in it are not freed.
+ * @param ring ring buffer pointer.
+ */
+void u_ringbuffer_delete(u_ringbuffer_t *ring);
+
+/**
+ * Adds a message at the end of the ring buffer.  Safe to call from several
+ * threads at once.
+ * @param ring pointer to ring buffer.
+ * @param msg Pointer to message.
+ * @param size message size.
+ * @return true if added, false if the ring buffer is full.
+ */
+bool u_ringbuffer_push(u_ringbuffer_t *ring, void *msg, uint32_t size);
+
+/**
+ * Removes up to max messages from the front of the ring buffer.
+ * Only one thread may remove messages at a time.
+ * @param ring pointer to ring buffer.
+ * @param messages array receiving the messages.
+ * @param max size of the messages array.
+ * @return number of messages removed.
+ */
+uint32_t u_ringbuffer_pop_batch(u_ringbuffer_t *ring, u_queue_message_t *messages,
+                                uint32_t max);
+
+/**
+ * @param ring pointer to ring buffer.
+ * @return approximate number of messages in the ring buffer.
+ */
+uint32_t u_ringbuffer_get_size(u_ringbuffer_t *ring);
+
+/**
+ * @param ring pointer to ring buffer.
+ * @return number of messages the ring buffer can hold.
+ */
+uint32_t u_ringbuffer_get_capacity(u_ringbuffer_t *ring);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* U_RINGBUFFER_H_ */
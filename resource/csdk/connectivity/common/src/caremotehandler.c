@@ -19,14 +19,123 @@
  ******************************************************************/
 
 #include <string.h>
+#include <inttypes.h>
 
 #include "oic_malloc.h"
 #include "oic_string.h"
 #include "caremotehandler.h"
+#include "caatomic.h"
 #include "logger.h"
 
 #define TAG "OIC_CA_REMOTE_HANDLER"
 
+struct CAPayloadStream
+{
+    CAPayloadProducer_t producer;       /**< produces the payload */
+    CAPayloadRelease_t release;         /**< releases context */
+    void *context;                      /**< context of the callbacks */
+    volatile uint32_t refCount;         /**< number of infos using the stream */
+};
+
+static u_mempool_t *g_endpointPool = NULL;
+static u_mempool_t *g_requestInfoPool = NULL;
+static u_mempool_t *g_responseInfoPool = NULL;
+static u_mempool_t *g_errorInfoPool = NULL;
+static u_mempool_t *g_tokenPool = NULL;
+
+/**
+ * take an object from pool, or from the heap if there is no pool.
+ */
+static void *CAAllocObject(u_mempool_t *pool, size_t size)
+{
+    return pool ? u_mempool_alloc(pool) : OICCalloc(1, size);
+}
+
+CAResult_t CAInitializeObjectPools(void)
+{
+    if (g_endpointPool)
+    {
+        return CA_STATUS_OK;
+    }
+
+    g_endpointPool = u_mempool_create(sizeof(CAEndpoint_t), CA_OBJECT_POOL_PREALLOC,
+                                      CA_OBJECT_POOL_SIZE);
+    g_requestInfoPool = u_mempool_create(sizeof(CARequestInfo_t), CA_OBJECT_POOL_PREALLOC,
+                                         CA_OBJECT_POOL_SIZE);
+    g_responseInfoPool = u_mempool_create(sizeof(CAResponseInfo_t), CA_OBJECT_POOL_PREALLOC,
+                                          CA_OBJECT_POOL_SIZE);
+    g_errorInfoPool = u_mempool_create(sizeof(CAErrorInfo_t), 0, CA_OBJECT_POOL_SIZE);
+    g_tokenPool = u_mempool_create(CA_MAX_TOKEN_LEN, CA_OBJECT_POOL_PREALLOC,
+                                   CA_OBJECT_POOL_SIZE);
+
+    if (!g_endpointPool || !g_requestInfoPool || !g_responseInfoPool || !g_errorInfoPool
+        || !g_tokenPool)
+    {
+        OIC_LOG(ERROR, TAG, "object pool creation failed");
+        CATerminateObjectPools();
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+
+    return CA_STATUS_OK;
+}
+
+void CATerminateObjectPools(void)
+{
+    u_mempool_t *pools[] = { g_endpointPool, g_requestInfoPool, g_responseInfoPool,
+                             g_errorInfoPool, g_tokenPool };
+
+    g_endpointPool = NULL;
+    g_requestInfoPool = NULL;
+    g_responseInfoPool = NULL;
+    g_errorInfoPool = NULL;
+    g_tokenPool = NULL;
+
+    for (size_t i = 0; i < sizeof(pools) / sizeof(pools[0]); i++)
+    {
+        u_mempool_delete(pools[i]);
+    }
+}
+
+CARequestInfo_t *CAAllocRequestInfo(void)
+{
+    return (CARequestInfo_t *) CAAllocObject(g_requestInfoPool, sizeof(CARequestInfo_t));
+}
+
+CAResponseInfo_t *CAAllocResponseInfo(void)
+{
+    return (CAResponseInfo_t *) CAAllocObject(g_responseInfoPool, sizeof(CAResponseInfo_t));
+}
+
+CAErrorInfo_t *CAAllocErrorInfo(void)
+{
+    return (CAErrorInfo_t *) CAAllocObject(g_errorInfoPool, sizeof(CAErrorInfo_t));
+}
+
+CAToken_t CAAllocToken(void)
+{
+    return (CAToken_t) CAAllocObject(g_tokenPool, CA_MAX_TOKEN_LEN);
+}
+
+void CAFreeToken(CAToken_t token, uint8_t tokenLength)
+{
+    // only a token of full length is known to be as large as the pooled ones.
+    u_mempool_free((CA_MAX_TOKEN_LEN == tokenLength) ? g_tokenPool : NULL, token);
+}
+
+void CAGetObjectPoolStats(CAObjectPoolStats_t *stats)
+{
+    if (NULL == stats)
+    {
+        return;
+    }
+
+    u_mempool_get_stats(g_endpointPool, &stats->endpoint);
+    u_mempool_get_stats(g_requestInfoPool, &stats->requestInfo);
+    u_mempool_get_stats(g_responseInfoPool, &stats->responseInfo);
+    u_mempool_get_stats(g_errorInfoPool, &stats->errorInfo);
+    u_mempool_get_stats(g_tokenPool, &stats->token);
+}
+
 CAEndpoint_t *CACloneEndpoint(const CAEndpoint_t *rep)
 {
     if (NULL == rep)
@@ -36,7 +145,7 @@ CAEndpoint_t *CACloneEndpoint(const CAEndpoint_t *rep)
     }
 
     // allocate the remote end point structure.
-    CAEndpoint_t *clone = (CAEndpoint_t *)OICMalloc(sizeof (CAEndpoint_t));
+    CAEndpoint_t *clone = (CAEndpoint_t *) CAAllocObject(g_endpointPool, sizeof(CAEndpoint_t));
     if (NULL == clone)
     {
         OIC_LOG(ERROR, TAG, "CACloneRemoteEndpoint Out of memory");
@@ -70,7 +179,7 @@ CARequestInfo_t *CACloneRequestInfo(const CARequestInfo_t *rep)
     }
 
     // allocate the request info structure.
-    CARequestInfo_t *clone = (CARequestInfo_t *) OICMalloc(sizeof(CARequestInfo_t));
+    CARequestInfo_t *clone = CAAllocRequestInfo();
     if (!clone)
     {
         OIC_LOG(ERROR, TAG, "CACloneRequestInfo Out of memory");
@@ -127,7 +236,7 @@ CAResponseInfo_t *CACloneResponseInfo(const CAResponseInfo_t *rep)
     }
 
     // allocate the response info structure.
-    CAResponseInfo_t *clone = (CAResponseInfo_t *) OICCalloc(1, sizeof(CAResponseInfo_t));
+    CAResponseInfo_t *clone = CAAllocResponseInfo();
     if (NULL == clone)
     {
         OIC_LOG(ERROR, TAG, "CACloneResponseInfo Out of memory");
@@ -152,7 +261,7 @@ CAEndpoint_t *CACreateEndpointObject(CATransportFlags_t flags,
                                      const char *address,
                                      uint16_t port)
 {
-    CAEndpoint_t *info = (CAEndpoint_t *)OICCalloc(1, sizeof(CAEndpoint_t));
+    CAEndpoint_t *info = (CAEndpoint_t *) CAAllocObject(g_endpointPool, sizeof(CAEndpoint_t));
     if (NULL == info)
     {
         OIC_LOG(ERROR, TAG, "Memory allocation failed !");
@@ -173,13 +282,13 @@ CAEndpoint_t *CACreateEndpointObject(CATransportFlags_t flags,
 
 void CAFreeEndpoint(CAEndpoint_t *rep)
 {
-    OICFree(rep);
+    u_mempool_free(g_endpointPool, rep);
 }
 
 static void CADestroyInfoInternal(CAInfo_t *info)
 {
     // free token field
-    OICFree(info->token);
+    CAFreeToken(info->token, info->tokenLength);
     info->token = NULL;
     info->tokenLength = 0;
 
@@ -193,6 +302,9 @@ static void CADestroyInfoInternal(CAInfo_t *info)
     info->payload = NULL;
     info->payloadSize = 0;
 
+    CAFreePayloadStream(info->payloadStream);
+    info->payloadStream = NULL;
+
     // free uri
     OICFree(info->resourceUri);
     info->resourceUri = NULL;
@@ -207,7 +319,7 @@ void CADestroyRequestInfoInternal(CARequestInfo_t *rep)
     }
 
     CADestroyInfoInternal(&rep->info);
-    OICFree(rep);
+    u_mempool_free(g_requestInfoPool, rep);
 }
 
 void CADestroyResponseInfoInternal(CAResponseInfo_t *rep)
@@ -219,7 +331,7 @@ void CADestroyResponseInfoInternal(CAResponseInfo_t *rep)
     }
 
     CADestroyInfoInternal(&rep->info);
-    OICFree(rep);
+    u_mempool_free(g_responseInfoPool, rep);
 }
 
 void CADestroyErrorInfoInternal(CAErrorInfo_t *errorInfo)
@@ -231,7 +343,71 @@ void CADestroyErrorInfoInternal(CAErrorInfo_t *errorInfo)
     }
 
     CADestroyInfoInternal(&errorInfo->info);
-    OICFree(errorInfo);
+    u_mempool_free(g_errorInfoPool, errorInfo);
+}
+
+CAPayloadStream_t *CACreatePayloadStreamObject(CAPayloadProducer_t producer,
+                                               CAPayloadRelease_t release, void *context)
+{
+    if (NULL == producer)
+    {
+        OIC_LOG(ERROR, TAG, "producer is NULL");
+        return NULL;
+    }
+
+    CAPayloadStream_t *stream = (CAPayloadStream_t *) OICCalloc(1, sizeof(CAPayloadStream_t));
+    if (NULL == stream)
+    {
+        OIC_LOG(ERROR, TAG, "Memory allocation failed !");
+        return NULL;
+    }
+
+    stream->producer = producer;
+    stream->release = release;
+    stream->context = context;
+    stream->refCount = 1;
+    return stream;
+}
+
+CAPayloadStream_t *CARetainPayloadStream(CAPayloadStream_t *stream)
+{
+    if (stream)
+    {
+        CAAtomicAdd32(&stream->refCount, 1);
+    }
+    return stream;
+}
+
+void CAFreePayloadStream(CAPayloadStream_t *stream)
+{
+    if (NULL == stream || 0 != CAAtomicAdd32(&stream->refCount, (uint32_t) -1))
+    {
+        return;
+    }
+
+    if (stream->release)
+    {
+        stream->release(stream->context);
+    }
+    OICFree(stream);
+}
+
+CAResult_t CAReadPayloadStream(CAPayloadStream_t *stream, size_t offset,
+                               uint8_t *buf, size_t length)
+{
+    if (NULL == stream || NULL == buf)
+    {
+        OIC_LOG(ERROR, TAG, "input parameter invalid");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    if (!stream->producer(stream->context, offset, buf, length))
+    {
+        OIC_LOG_V(ERROR, TAG, "producing %" PRIuPTR " bytes at %" PRIuPTR " failed",
+                  length, offset);
+        return CA_STATUS_FAILED;
+    }
+    return CA_STATUS_OK;
 }
 
 CAResult_t CACloneInfo(const CAInfo_t *info, CAInfo_t *clone)
@@ -250,7 +426,7 @@ CAResult_t CACloneInfo(const CAInfo_t *info, CAInfo_t *clone)
         // allocate token field
         uint8_t len = info->tokenLength;
 
-        char *temp = (char *) OICMalloc(len * sizeof(char));
+        char *temp = (len <= CA_MAX_TOKEN_LEN) ? CAAllocToken() : (char *) OICMalloc(len);
         if (!temp)
         {
             OIC_LOG(ERROR, TAG, "CACloneInfo Out of memory");
@@ -295,6 +471,12 @@ CAResult_t CACloneInfo(const CAInfo_t *info, CAInfo_t *clone)
         clone->payload = temp;
         clone->payloadSize = info->payloadSize;
     }
+    else if (info->payloadStream)
+    {
+        // the stream is shared, each block is produced when it is sent
+        clone->payloadStream = CARetainPayloadStream(info->payloadStream);
+        clone->payloadSize = info->payloadSize;
+    }
     clone->payloadFormat = info->payloadFormat;
     clone->acceptFormat = info->acceptFormat;
     clone->payloadVersion = info->payloadVersion;
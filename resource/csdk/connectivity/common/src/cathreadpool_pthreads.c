@@ -35,6 +35,7 @@
 #include "cathreadpool.h"
 #include "logger.h"
 #include "oic_malloc.h"
+#include "oic_time.h"
 #include "uarraylist.h"
 #include "octhread.h"
 #include "platform_features.h"
@@ -42,44 +43,168 @@
 #define TAG PCF("OIC_CA_UTHREADPOOL")
 
 /**
- * empty struct to represent the details.  This implementation has no data
- * that it needs to keep track of, so it only uses NULL for the internal value.
+ * Maximum number of tasks which can wait for a worker.
  */
-typedef struct ca_thread_pool_details_t
-{
-    u_arraylist_t* threads_list;
-    oc_mutex list_lock;
-} ca_thread_pool_details_t;
+#ifndef CA_THREAD_POOL_QUEUE_SIZE
+#define CA_THREAD_POOL_QUEUE_SIZE 64
+#endif
 
 /**
- * struct to wrap the pthreads callback properly.  The function pointer for
- * pthreads requires a void* return value, however u_thread_func is a void.
+ * A task waiting in the pool queue.
  */
-typedef struct ca_thread_pool_callback_info_t
+typedef struct ca_thread_pool_task_t
 {
     ca_thread_func func;
     void* data;
-} ca_thread_pool_callback_info_t;
+    uint64_t enqueued;      /**< time the task was added, in microseconds */
+} ca_thread_pool_task_t;
+
+/**
+ * Pool state.  Workers pull tasks from a bounded ring of pending tasks which
+ * is guarded by list_lock.  When every worker is busy a new worker is added,
+ * up to max_threads, rather than leaving the task queued behind them.  Tasks
+ * which run for the lifetime of an adapter (receive loops, queueing threads)
+ * get a dedicated thread instead, so they don't use up the workers.  Workers
+ * are only joined in ca_thread_pool_free(); dedicated threads which have
+ * returned are also joined when the next one is started.
+ */
+typedef struct ca_thread_pool_details_t
+{
+    u_arraylist_t* threads_list;
+    oc_mutex list_lock;
+    oc_cond task_cond;
+    ca_thread_pool_task_t tasks[CA_THREAD_POOL_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t count;
+    uint32_t idle_threads;
+    uint32_t max_threads;
+    bool stopping;
+    ca_thread_pool_stats_t stats;
+} ca_thread_pool_details_t;
 
 typedef struct ca_thread_pool_thread_info_t
 {
     oc_thread thread;
+    ca_thread_func func;                        /**< task of a dedicated thread */
+    void *data;
+    struct ca_thread_pool_details_t *details;
+    bool finished;                              /**< the dedicated task has returned */
 } ca_thread_pool_thread_info_t;
 
-// passthrough function to convert the pthreads call to a u_thread_func call
-void* ca_thread_pool_pthreads_delegate(void* data)
+// worker loop: run queued tasks until the pool is freed and the queue is empty
+static void* ca_thread_pool_worker(void* data)
 {
-    ca_thread_pool_callback_info_t* info = (ca_thread_pool_callback_info_t*)data;
-    info->func(info->data);
-    OICFree(info);
+    ca_thread_pool_details_t* details = (ca_thread_pool_details_t*)data;
+
+    oc_mutex_lock(details->list_lock);
+    while (true)
+    {
+        while (0 == details->count && !details->stopping)
+        {
+            oc_cond_wait(details->task_cond, details->list_lock);
+        }
+        if (0 == details->count)
+        {
+            break;
+        }
+
+        ca_thread_pool_task_t task = details->tasks[details->head];
+        details->head = (details->head + 1) % CA_THREAD_POOL_QUEUE_SIZE;
+        details->count--;
+        details->idle_threads--;
+
+        uint64_t latency = OICGetCurrentTime(TIME_IN_US) - task.enqueued;
+        details->stats.total_latency_us += latency;
+        if (latency > details->stats.max_latency_us)
+        {
+            details->stats.max_latency_us = latency;
+        }
+        oc_mutex_unlock(details->list_lock);
+
+        task.func(task.data);
+
+        oc_mutex_lock(details->list_lock);
+        details->stats.tasks_completed++;
+        details->idle_threads++;
+    }
+    details->idle_threads--;
+    oc_mutex_unlock(details->list_lock);
+    return NULL;
+}
+
+// dedicated thread: run one task and mark the thread for joining
+static void* ca_thread_pool_dedicated(void* data)
+{
+    ca_thread_pool_thread_info_t *threadInfo = (ca_thread_pool_thread_info_t *) data;
+    ca_thread_pool_details_t *details = threadInfo->details;
+
+    threadInfo->func(threadInfo->data);
+
+    oc_mutex_lock(details->list_lock);
+    threadInfo->finished = true;
+    details->stats.tasks_completed++;
+    details->stats.dedicated_threads--;
+    oc_mutex_unlock(details->list_lock);
     return NULL;
 }
 
-// this implementation doesn't do a thread pool, so this function is essentially
-// a no-op besides creating a valid ca_thread_pool_t object.  It was determined after
-// reading through the existing implementation that the thread-pooling was unnecessary
-// for the posix platforms.  Behavior shouldn't be changed since previously num_of_threads
-// was greater than the number of requested threads.
+// join the dedicated threads which have returned. must be called with list_lock held
+static void ca_thread_pool_join_finished(ca_thread_pool_details_t* details)
+{
+    uint32_t i = 0;
+    while (i < u_arraylist_length(details->threads_list))
+    {
+        ca_thread_pool_thread_info_t *threadInfo = (ca_thread_pool_thread_info_t *)
+                u_arraylist_get(details->threads_list, i);
+        if (threadInfo && threadInfo->finished)
+        {
+            u_arraylist_remove(details->threads_list, i);
+            oc_thread_wait(threadInfo->thread);
+            oc_thread_free(threadInfo->thread);
+            OICFree(threadInfo);
+            continue;
+        }
+        i++;
+    }
+}
+
+// must be called with list_lock held
+static CAResult_t ca_thread_pool_add_worker(ca_thread_pool_details_t* details)
+{
+    ca_thread_pool_thread_info_t *threadInfo =
+            (ca_thread_pool_thread_info_t *) OICCalloc(1, sizeof(ca_thread_pool_thread_info_t));
+    if (!threadInfo)
+    {
+        OIC_LOG(ERROR, TAG, "Memory allocation failed");
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+
+    if (!u_arraylist_add(details->threads_list, (void*) threadInfo))
+    {
+        OIC_LOG(ERROR, TAG, "Arraylist add failed");
+        OICFree(threadInfo);
+        return CA_STATUS_FAILED;
+    }
+
+    int thrRet = oc_thread_new(&threadInfo->thread, ca_thread_pool_worker, details);
+    if (thrRet != 0)
+    {
+        uint32_t index = 0;
+        if (u_arraylist_get_index(details->threads_list, threadInfo, &index))
+        {
+            u_arraylist_remove(details->threads_list, index);
+        }
+        OIC_LOG_V(ERROR, TAG, "Thread start failed with error %d", thrRet);
+        OICFree(threadInfo);
+        return CA_STATUS_FAILED;
+    }
+
+    // a new worker counts as idle until it takes a task
+    details->stats.num_of_threads++;
+    details->idle_threads++;
+    return CA_STATUS_OK;
+}
+
 CAResult_t ca_thread_pool_init(int32_t num_of_threads, ca_thread_pool_t *thread_pool)
 {
     OIC_LOG(DEBUG, TAG, "IN");
@@ -104,8 +229,9 @@ CAResult_t ca_thread_pool_init(int32_t num_of_threads, ca_thread_pool_t *thread_
         return CA_MEMORY_ALLOC_FAILED;
     }
 
-    (*thread_pool)->details = OICMalloc(sizeof(struct ca_thread_pool_details_t));
-    if(!(*thread_pool)->details)
+    ca_thread_pool_details_t* details = OICCalloc(1, sizeof(struct ca_thread_pool_details_t));
+    (*thread_pool)->details = details;
+    if(!details)
     {
         OIC_LOG(ERROR, TAG, "Failed to allocate for thread-pool details");
         OICFree(*thread_pool);
@@ -113,31 +239,56 @@ CAResult_t ca_thread_pool_init(int32_t num_of_threads, ca_thread_pool_t *thread_
         return CA_MEMORY_ALLOC_FAILED;
     }
 
-    (*thread_pool)->details->list_lock = oc_mutex_new();
+    details->list_lock = oc_mutex_new();
 
-    if(!(*thread_pool)->details->list_lock)
+    if(!details->list_lock)
     {
         OIC_LOG(ERROR, TAG, "Failed to create thread-pool mutex");
         goto exit;
     }
 
-    (*thread_pool)->details->threads_list = u_arraylist_create();
+    details->task_cond = oc_cond_new();
+
+    if(!details->task_cond)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to create thread-pool condition");
+        oc_mutex_free(details->list_lock);
+        goto exit;
+    }
+
+    details->threads_list = u_arraylist_create();
 
-    if(!(*thread_pool)->details->threads_list)
+    if(!details->threads_list)
     {
         OIC_LOG(ERROR, TAG, "Failed to create thread-pool list");
-        if(!oc_mutex_free((*thread_pool)->details->list_lock))
+        oc_cond_free(details->task_cond);
+        if(!oc_mutex_free(details->list_lock))
         {
             OIC_LOG(ERROR, TAG, "Failed to free thread-pool mutex");
         }
         goto exit;
     }
 
+    details->max_threads = (num_of_threads > CA_THREAD_POOL_MAX_THREADS) ?
+                           (uint32_t)num_of_threads : CA_THREAD_POOL_MAX_THREADS;
+
+    oc_mutex_lock(details->list_lock);
+    for (int32_t i = 0; i < num_of_threads; i++)
+    {
+        if (CA_STATUS_OK != ca_thread_pool_add_worker(details))
+        {
+            // Note that this is considered non-fatal; workers are added on demand.
+            OIC_LOG_V(ERROR, TAG, "Only %d of %d workers started", i, num_of_threads);
+            break;
+        }
+    }
+    oc_mutex_unlock(details->list_lock);
+
     OIC_LOG(DEBUG, TAG, "OUT");
     return CA_STATUS_OK;
 
 exit:
-    OICFree((*thread_pool)->details);
+    OICFree(details);
     OICFree(*thread_pool);
     *thread_pool = NULL;
     return CA_STATUS_FAILED;
@@ -154,56 +305,138 @@ CAResult_t ca_thread_pool_add_task(ca_thread_pool_t thread_pool, ca_thread_func
         return CA_STATUS_INVALID_PARAM;
     }
 
-    ca_thread_pool_callback_info_t* info = OICMalloc(sizeof(ca_thread_pool_callback_info_t));
-    if(!info)
+    ca_thread_pool_details_t* details = thread_pool->details;
+
+    oc_mutex_lock(details->list_lock);
+    if (details->stopping)
     {
-        OIC_LOG(ERROR, TAG, "Failed to allocate for memory wrapper");
-        return CA_MEMORY_ALLOC_FAILED;
+        oc_mutex_unlock(details->list_lock);
+        OIC_LOG(ERROR, TAG, "thread pool is being freed");
+        return CA_STATUS_FAILED;
+    }
+
+    if (CA_THREAD_POOL_QUEUE_SIZE == details->count)
+    {
+        oc_mutex_unlock(details->list_lock);
+        OIC_LOG(ERROR, TAG, "thread pool queue is full");
+        return CA_STATUS_FAILED;
+    }
+
+    // Every waiting task needs an idle worker, or it could wait behind tasks
+    // that never return.
+    if (details->idle_threads <= details->count &&
+        details->stats.num_of_threads < details->max_threads)
+    {
+        (void)ca_thread_pool_add_worker(details);
+    }
+    if (details->idle_threads <= details->count)
+    {
+        oc_mutex_unlock(details->list_lock);
+        OIC_LOG_V(ERROR, TAG, "no idle worker for task, %u workers busy",
+                  details->stats.num_of_threads);
+        return CA_STATUS_FAILED;
+    }
+
+    uint32_t tail = (details->head + details->count) % CA_THREAD_POOL_QUEUE_SIZE;
+    details->tasks[tail].func = method;
+    details->tasks[tail].data = data;
+    details->tasks[tail].enqueued = OICGetCurrentTime(TIME_IN_US);
+    details->count++;
+    if (details->count > details->stats.max_queue_depth)
+    {
+        details->stats.max_queue_depth = details->count;
     }
 
-    info->func = method;
-    info->data = data;
+    oc_cond_signal(details->task_cond);
+    oc_mutex_unlock(details->list_lock);
+
+    OIC_LOG(DEBUG, TAG, "OUT");
+    return CA_STATUS_OK;
+}
+
+CAResult_t ca_thread_pool_add_dedicated_task(ca_thread_pool_t thread_pool, ca_thread_func method,
+                                             void *data)
+{
+    OIC_LOG(DEBUG, TAG, "IN");
+
+    if(NULL == thread_pool || NULL == method)
+    {
+        OIC_LOG(ERROR, TAG, "thread_pool or method was NULL");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    ca_thread_pool_details_t* details = thread_pool->details;
+
+    oc_mutex_lock(details->list_lock);
+    if (details->stopping)
+    {
+        oc_mutex_unlock(details->list_lock);
+        OIC_LOG(ERROR, TAG, "thread pool is being freed");
+        return CA_STATUS_FAILED;
+    }
+
+    ca_thread_pool_join_finished(details);
 
     ca_thread_pool_thread_info_t *threadInfo =
             (ca_thread_pool_thread_info_t *) OICCalloc(1, sizeof(ca_thread_pool_thread_info_t));
     if (!threadInfo)
     {
+        oc_mutex_unlock(details->list_lock);
         OIC_LOG(ERROR, TAG, "Memory allocation failed");
-        OICFree(info);
-        return CA_STATUS_FAILED;
+        return CA_MEMORY_ALLOC_FAILED;
     }
+    threadInfo->func = method;
+    threadInfo->data = data;
+    threadInfo->details = details;
 
-    oc_mutex_lock(thread_pool->details->list_lock);
-    bool addResult = u_arraylist_add(thread_pool->details->threads_list, (void*) threadInfo);
-    if (!addResult)
+    if (!u_arraylist_add(details->threads_list, (void*) threadInfo))
     {
-        // Note that this is considered non-fatal.
-        oc_mutex_unlock(thread_pool->details->list_lock);
+        oc_mutex_unlock(details->list_lock);
         OIC_LOG(ERROR, TAG, "Arraylist add failed");
-        OICFree(info);
         OICFree(threadInfo);
         return CA_STATUS_FAILED;
     }
 
-    int thrRet = oc_thread_new(&threadInfo->thread, ca_thread_pool_pthreads_delegate, info);
+    int thrRet = oc_thread_new(&threadInfo->thread, ca_thread_pool_dedicated, threadInfo);
     if (thrRet != 0)
     {
         uint32_t index = 0;
-        if (u_arraylist_get_index(thread_pool->details->threads_list, threadInfo, &index))
+        if (u_arraylist_get_index(details->threads_list, threadInfo, &index))
         {
-            u_arraylist_remove(thread_pool->details->threads_list, index);
+            u_arraylist_remove(details->threads_list, index);
         }
-        oc_mutex_unlock(thread_pool->details->list_lock);
+        oc_mutex_unlock(details->list_lock);
         OIC_LOG_V(ERROR, TAG, "Thread start failed with error %d", thrRet);
-        OICFree(info);
+        OICFree(threadInfo);
         return CA_STATUS_FAILED;
     }
-    oc_mutex_unlock(thread_pool->details->list_lock);
+
+    details->stats.dedicated_threads++;
+    oc_mutex_unlock(details->list_lock);
 
     OIC_LOG(DEBUG, TAG, "OUT");
     return CA_STATUS_OK;
 }
 
+CAResult_t ca_thread_pool_get_stats(ca_thread_pool_t thread_pool, ca_thread_pool_stats_t *stats)
+{
+    if (NULL == thread_pool || NULL == stats)
+    {
+        OIC_LOG(ERROR, TAG, "thread_pool or stats was NULL");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    ca_thread_pool_details_t* details = thread_pool->details;
+
+    oc_mutex_lock(details->list_lock);
+    *stats = details->stats;
+    stats->idle_threads = details->idle_threads;
+    stats->queue_depth = details->count;
+    oc_mutex_unlock(details->list_lock);
+
+    return CA_STATUS_OK;
+}
+
 void ca_thread_pool_free(ca_thread_pool_t thread_pool)
 {
     OIC_LOG(DEBUG, TAG, "IN");
@@ -214,12 +447,19 @@ void ca_thread_pool_free(ca_thread_pool_t thread_pool)
         return;
     }
 
-    oc_mutex_lock(thread_pool->details->list_lock);
+    ca_thread_pool_details_t* details = thread_pool->details;
+
+    // workers finish the queued tasks before they exit
+    oc_mutex_lock(details->list_lock);
+    details->stopping = true;
+    oc_cond_broadcast(details->task_cond);
+    oc_mutex_unlock(details->list_lock);
 
-    for (uint32_t i = 0; i < u_arraylist_length(thread_pool->details->threads_list); ++i)
+    // No new workers can be added once stopping is set, so the list is stable.
+    for (uint32_t i = 0; i < u_arraylist_length(details->threads_list); ++i)
     {
         ca_thread_pool_thread_info_t *threadInfo = (ca_thread_pool_thread_info_t *)
-                u_arraylist_get(thread_pool->details->threads_list, i);
+                u_arraylist_get(details->threads_list, i);
         if (threadInfo)
         {
             if (threadInfo->thread)
@@ -231,12 +471,12 @@ void ca_thread_pool_free(ca_thread_pool_t thread_pool)
         }
     }
 
-    u_arraylist_free(&(thread_pool->details->threads_list));
+    u_arraylist_free(&(details->threads_list));
 
-    oc_mutex_unlock(thread_pool->details->list_lock);
-    oc_mutex_free(thread_pool->details->list_lock);
+    oc_cond_free(details->task_cond);
+    oc_mutex_free(details->list_lock);
 
-    OICFree(thread_pool->details);
+    OICFree(details);
     OICFree(thread_pool);
 
     OIC_LOG(DEBUG, TAG, "OUT");
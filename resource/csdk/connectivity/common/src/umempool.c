@@ -0,0 +1,183 @@
+/******************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/*
+ * Objects are taken from and returned to a free list under a mutex that is
+ * held for a few pointer operations only.  Objects are allocated and freed
+ * on different threads (receive thread and handler thread), so a per thread
+ * cache would fill up on one side and run empty on the other.
+ */
+
+#include "umempool.h"
+
+#include <stddef.h>
+#include <string.h>
+#include "logger.h"
+#include "oic_malloc.h"
+
+/**
+ * @def TAG
+ * @brief Logging tag for module name
+ */
+#define TAG "OIC_UMEMPOOL"
+
+u_mempool_t *u_mempool_create(size_t objectSize, uint32_t preallocate, uint32_t maxCached)
+{
+    if (objectSize < sizeof(void *))
+    {
+        OIC_LOG(DEBUG, TAG, "MemPoolCreate FAIL, invalid object size");
+        return NULL;
+    }
+
+    u_mempool_t *pool = (u_mempool_t *) OICCalloc(1, sizeof(u_mempool_t));
+    if (NULL == pool)
+    {
+        OIC_LOG(DEBUG, TAG, "MemPoolCreate FAIL");
+        return NULL;
+    }
+
+    pool->lock = oc_mutex_new();
+    if (NULL == pool->lock)
+    {
+        OIC_LOG(DEBUG, TAG, "MemPoolCreate FAIL, oc_mutex_new failed");
+        OICFree(pool);
+        return NULL;
+    }
+
+    pool->objectSize = objectSize;
+    pool->maxCached = maxCached;
+
+    if (preallocate > maxCached)
+    {
+        preallocate = maxCached;
+    }
+
+    for (uint32_t i = 0; i < preallocate; i++)
+    {
+        void *object = OICMalloc(objectSize);
+        if (NULL == object)
+        {
+            OIC_LOG(DEBUG, TAG, "MemPoolCreate, preallocation stopped");
+            break;
+        }
+        *(void **) object = pool->free;
+        pool->free = object;
+        pool->stats.cached++;
+    }
+
+    return pool;
+}
+
+void u_mempool_delete(u_mempool_t *pool)
+{
+    if (NULL == pool)
+    {
+        return;
+    }
+
+    while (NULL != pool->free)
+    {
+        void *object = pool->free;
+        pool->free = *(void **) object;
+        OICFree(object);
+    }
+
+    oc_mutex_free(pool->lock);
+    OICFree(pool);
+}
+
+void *u_mempool_alloc(u_mempool_t *pool)
+{
+    if (NULL == pool)
+    {
+        return NULL;
+    }
+
+    oc_mutex_lock(pool->lock);
+    void *object = pool->free;
+    if (NULL != object)
+    {
+        pool->free = *(void **) object;
+        pool->stats.cached--;
+        pool->stats.hits++;
+    }
+    else
+    {
+        pool->stats.misses++;
+    }
+    oc_mutex_unlock(pool->lock);
+
+    if (NULL == object)
+    {
+        return OICCalloc(1, pool->objectSize);
+    }
+
+    memset(object, 0, pool->objectSize);
+    return object;
+}
+
+void u_mempool_free(u_mempool_t *pool, void *object)
+{
+    if (NULL == object)
+    {
+        return;
+    }
+
+    if (NULL == pool)
+    {
+        OICFree(object);
+        return;
+    }
+
+    oc_mutex_lock(pool->lock);
+    if (pool->stats.cached < pool->maxCached)
+    {
+        *(void **) object = pool->free;
+        pool->free = object;
+        pool->stats.cached++;
+        pool->stats.releases++;
+        object = NULL;
+    }
+    else
+    {
+        pool->stats.overflows++;
+    }
+    oc_mutex_unlock(pool->lock);
+
+    OICFree(object);
+}
+
+void u_mempool_get_stats(u_mempool_t *pool, u_mempool_stats_t *stats)
+{
+    if (NULL == stats)
+    {
+        return;
+    }
+
+    if (NULL == pool)
+    {
+        memset(stats, 0, sizeof(u_mempool_stats_t));
+        return;
+    }
+
+    oc_mutex_lock(pool->lock);
+    *stats = pool->stats;
+    oc_mutex_unlock(pool->lock);
+}
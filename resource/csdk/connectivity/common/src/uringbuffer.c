@@ -0,0 +1,177 @@
+/******************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/*
+ * Bounded multi-producer/single-consumer queue after D. Vyukov.  Every slot
+ * carries a sequence number: a producer may fill the slot at position pos
+ * once seq == pos, and publishes it by setting seq = pos + 1; the consumer
+ * takes it once seq == pos + 1, and frees it for the next lap by setting
+ * seq = pos + capacity.  Positions wrap around; comparisons use the signed
+ * difference.
+ */
+
+#include "uringbuffer.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "caatomic.h"
+#include "logger.h"
+#include "oic_malloc.h"
+
+/**
+ * @def TAG
+ * @brief Logging tag for module name
+ */
+#define TAG "OIC_URINGBUFFER"
+
+u_ringbuffer_t *u_ringbuffer_create(uint32_t capacity)
+{
+    if (0 == capacity || capacity > (UINT32_MAX / 2))
+    {
+        OIC_LOG(DEBUG, TAG, "RingBufferCreate FAIL, invalid capacity");
+        return NULL;
+    }
+
+    uint32_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+
+    u_ringbuffer_t *ring = (u_ringbuffer_t *) OICCalloc(1, sizeof(u_ringbuffer_t));
+    if (NULL == ring)
+    {
+        OIC_LOG(DEBUG, TAG, "RingBufferCreate FAIL");
+        return NULL;
+    }
+
+    ring->slots = (u_ringbuffer_slot_t *) OICCalloc(size, sizeof(u_ringbuffer_slot_t));
+    if (NULL == ring->slots)
+    {
+        OIC_LOG(DEBUG, TAG, "RingBufferCreate FAIL, memory allocation failed");
+        OICFree(ring);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        ring->slots[i].seq = i;
+    }
+    ring->mask = size - 1;
+
+    return ring;
+}
+
+void u_ringbuffer_delete(u_ringbuffer_t *ring)
+{
+    if (NULL == ring)
+    {
+        return;
+    }
+
+    OICFree(ring->slots);
+    OICFree(ring);
+}
+
+bool u_ringbuffer_push(u_ringbuffer_t *ring, void *msg, uint32_t size)
+{
+    if (NULL == ring)
+    {
+        OIC_LOG(DEBUG, TAG, "RingBufferPush FAIL, Invalid ring buffer");
+        return false;
+    }
+
+    u_ringbuffer_slot_t *slot = NULL;
+    uint32_t pos = CAAtomicLoad32(&ring->tail);
+    while (true)
+    {
+        slot = &ring->slots[pos & ring->mask];
+        int32_t diff = (int32_t)(CAAtomicLoad32(&slot->seq) - pos);
+        if (0 == diff)
+        {
+            if (CAAtomicCompareExchange32(&ring->tail, pos, pos + 1))
+            {
+                break;
+            }
+            pos = CAAtomicLoad32(&ring->tail);
+        }
+        else if (diff < 0)
+        {
+            // the consumer has not freed this slot yet
+            return false;
+        }
+        else
+        {
+            // another producer claimed pos
+            pos = CAAtomicLoad32(&ring->tail);
+        }
+    }
+
+    slot->message.msg = msg;
+    slot->message.size = size;
+    CAAtomicStore32(&slot->seq, pos + 1);
+    return true;
+}
+
+uint32_t u_ringbuffer_pop_batch(u_ringbuffer_t *ring, u_queue_message_t *messages,
+                                uint32_t max)
+{
+    if (NULL == ring || NULL == messages)
+    {
+        return 0;
+    }
+
+    uint32_t count = 0;
+    uint32_t pos = ring->head;
+    while (count < max)
+    {
+        u_ringbuffer_slot_t *slot = &ring->slots[pos & ring->mask];
+        if (CAAtomicLoad32(&slot->seq) != pos + 1)
+        {
+            break;
+        }
+
+        messages[count++] = slot->message;
+        CAAtomicStore32(&slot->seq, pos + ring->mask + 1);
+        pos++;
+    }
+    CAAtomicStore32(&ring->head, pos);
+
+    return count;
+}
+
+uint32_t u_ringbuffer_get_size(u_ringbuffer_t *ring)
+{
+    if (NULL == ring)
+    {
+        return 0;
+    }
+
+    // head first: it never passes tail, which may briefly run ahead of the
+    // published slots
+    uint32_t head = CAAtomicLoad32(&ring->head);
+    uint32_t size = CAAtomicLoad32(&ring->tail) - head;
+    return (size > ring->mask + 1) ? ring->mask + 1 : size;
+}
+
+uint32_t u_ringbuffer_get_capacity(u_ringbuffer_t *ring)
+{
+    return ring ? ring->mask + 1 : 0;
+}
@@ -74,6 +74,11 @@ void CAsetSslAdapterCallbacks(CAPacketReceivedCallback recvCallback,
  * @param[in]   credTypesCallback    callback to get credential types.
  */
 void CAsetCredentialTypesCallback(CAgetCredentialTypesHandler credTypesCallback);
+
+/**
+ * Drops the parsed PKIX info, it is reloaded on the next handshake.
+ */
+void CAinvalidatePkixInfoCache();
 /**
  * Register callback to get credential types.
  * @param[in]  typesCallback    callback to get credential types.
@@ -140,6 +145,20 @@ CAResult_t CAencryptSsl(const CAEndpoint_t *endpoint, void *data, uint32_t dataL
  */
 CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, uint32_t dataLen);
 
+/**
+ * Selects where DTLS handshake records are processed.
+ * When enabled, ::CAdecryptSsl queues them to a dedicated thread and returns at once;
+ * records of established sessions are still decrypted by the caller.  The handshake
+ * result is reported through the handshake callback either way.
+ *
+ * @param[in]  enable  true to process handshakes on the handshake thread.
+ *
+ * @retval  ::CA_STATUS_OK  Successful.
+ * @retval  ::CA_STATUS_NOT_INITIALIZED  SSL adapter is not initialized.
+ * @retval  ::CA_STATUS_FAILED Operation failed.
+ */
+CAResult_t CAsetSslAsyncHandshake(bool enable);
+
 /**
  * Initiate TLS handshake with selected cipher suite.
  *
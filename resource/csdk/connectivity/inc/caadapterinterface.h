@@ -202,6 +202,7 @@ typedef void (*CAConnectionChangeCallback)(const CAEndpoint_t *info, bool isConn
 
 /**
  * This will be used to notify error result to the connectivity common logic layer.
+ * data is NULL and dataLen 0 for an error of the endpoint as a whole.
  */
 typedef void (*CAErrorHandleCallback)(const CAEndpoint_t *endpoint,
                                       const void *data, size_t dataLen,
@@ -53,6 +53,14 @@ typedef void (*CASendThreadFunc)(CAData_t *data);
  */
 typedef void (*CAReceiveThreadFunc)(CAData_t *data);
 
+/** number of buckets of the block data table (power of two). **/
+#ifndef CA_BLOCK_DATA_TABLE_SIZE
+#define CA_BLOCK_DATA_TABLE_SIZE    64
+#endif
+
+/** Block Data Set, defined below. **/
+struct CABlockData;
+
 /**
  * context of blockwise transfer.
  */
@@ -64,8 +72,8 @@ typedef struct
     /** callback function for received message. **/
     CAReceiveThreadFunc receivedThreadFunc;
 
-    /** array list on which the thread is operating. **/
-    u_arraylist_t *dataList;
+    /** block data chained by the hash of their ID. **/
+    struct CABlockData **dataTable;
 
     /** data list mutex for synchronization. **/
     oc_mutex blockDataListMutex;
@@ -86,7 +94,7 @@ typedef struct
 /**
  * Block Data Set.
  */
-typedef struct
+typedef struct CABlockData
 {
     coap_block_t block1;                /**< block1 option. */
     coap_block_t block2;                /**< block2 option. */
@@ -96,6 +104,9 @@ typedef struct
     CAPayload_t payload;                /**< payload buffer. */
     size_t payloadLength;               /**< the total payload length to be received. */
     size_t receivedPayloadLen;          /**< currently received payload length. */
+    size_t payloadCapacity;             /**< allocated size of the payload buffer. */
+    uint32_t hash;                      /**< hash of blockDataId. */
+    struct CABlockData *next;           /**< next block data in the same bucket. */
 } CABlockData_t;
 
 /**
@@ -296,7 +307,8 @@ CAResult_t CASetMoreBitFromBlock(size_t payloadLen, coap_block_t *block);
 
 /**
  * check the block option what kind of option have to set.
- * @param[out]  pdu pdu object.
+ * pdu is replaced by the message encoded with its options and payload.
+ * @param[in,out]  pdu pdu object.
  * @param[in]   info    information of the request/response.
  * @param[in]   endpoint    port of transport.
  * @return ::CASTATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
@@ -465,8 +477,8 @@ CAResult_t CAUpdatePayloadToCAData(CAData_t *data, const CAPayload_t payload,
 /**
  * Get payload and payload length from the input information.
  * @param[in]   data    CAData information.
- * @param[out]  payloadLen  The payload length is stored.
- * @return payload.
+ * @param[out]  payloadLen  The payload length is stored, also for a streamed payload.
+ * @return payload, or NULL for a streamed payload.
  */
 CAPayload_t CAGetPayloadInfo(const CAData_t *data, size_t *payloadLen);
 
@@ -0,0 +1,124 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ * This file contains the duplicate detection of received requests
+ * (RFC 7252, section 4.5). The ACK or reset sent for a request is kept
+ * so that a retransmission of the request can be answered with it
+ * instead of being passed to the application again.
+ */
+
+#ifndef CA_DEDUP_H_
+#define CA_DEDUP_H_
+
+#include <stdint.h>
+
+#include "octhread.h"
+#include "cacommon.h"
+
+/** time a confirmable message id is remembered, EXCHANGE_LIFETIME of RFC 7252. **/
+#define CA_EXCHANGE_LIFETIME_SEC    247
+
+/** time a non-confirmable message id is remembered, NON_LIFETIME of RFC 7252. **/
+#define CA_NON_LIFETIME_SEC         145
+
+/** number of dedup table buckets (power of two). **/
+#ifndef CA_DEDUP_TABLE_SIZE
+#define CA_DEDUP_TABLE_SIZE         128
+#endif
+
+/** number of requests remembered, the oldest one is forgotten beyond this. **/
+#ifndef CA_DEDUP_MAX_ENTRIES
+#define CA_DEDUP_MAX_ENTRIES        512
+#endif
+
+/** remembered request, private to cadedup.c. **/
+typedef struct CADedupEntry CADedupEntry_t;
+
+typedef struct
+{
+    /** mutex for synchronization. **/
+    oc_mutex lock;
+
+    /** entries chained by endpoint and message id. **/
+    CADedupEntry_t **table;
+
+    /** oldest entry, entries are linked in the order they were added or reused. **/
+    CADedupEntry_t *oldest;
+
+    /** most recently added entry. **/
+    CADedupEntry_t *newest;
+
+    /** number of entries. **/
+    uint32_t count;
+
+} CADedup_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Initializes the dedup context.
+ * @param[in]   context      context for duplicate detection.
+ * @return  ::CA_STATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CADedupInitialize(CADedup_t *context);
+
+/**
+ * Terminates the dedup context and forgets all requests.
+ * @param[in]   context      context for duplicate detection.
+ */
+void CADedupTerminate(CADedup_t *context);
+
+/**
+ * Checks whether a received request is a duplicate. A request seen for the first
+ * time is remembered until its lifetime expires.
+ * @param[in]   context          context for duplicate detection.
+ * @param[in]   endpoint         endpoint the request came from.
+ * @param[in]   info             information of the received request.
+ * @param[out]  response         copy of the response sent for the original request.
+ *                               An empty ACK if a confirmable request has none yet,
+ *                               NULL for a non-confirmable one. The caller frees it.
+ * @param[out]  responseLength   length of response.
+ * @return  true if the request was received before.
+ */
+bool CADedupCheckRequest(CADedup_t *context, const CAEndpoint_t *endpoint,
+                         const CAInfo_t *info, void **response, uint32_t *responseLength);
+
+/**
+ * Keeps the ACK or reset sent for a remembered request. Nothing happens if no
+ * request with messageId was received from endpoint.
+ * @param[in]   context      context for duplicate detection.
+ * @param[in]   endpoint     endpoint the response is sent to.
+ * @param[in]   messageId    message id of the response.
+ * @param[in]   pdu          encoded response.
+ * @param[in]   size         length of pdu.
+ */
+void CADedupSaveResponse(CADedup_t *context, const CAEndpoint_t *endpoint,
+                         uint16_t messageId, const void *pdu, uint32_t size);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif  /* CA_DEDUP_H_ */
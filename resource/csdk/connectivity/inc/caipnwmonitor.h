@@ -101,6 +101,25 @@ u_arraylist_t *CAIPGetInterfaceInformation(int desiredIndex);
  */
 u_arraylist_t *CAFindInterfaceChange();
 
+#if defined(__linux__) && !defined(__ANDROID__) && !defined(__TIZEN__)
+/** the network monitor caches the interface list and refreshes it on netlink events. **/
+#define CA_IP_INTERFACE_SNAPSHOT
+
+/**
+ * Get the cached list of CAInterface_t items without taking a lock.  The list
+ * must not be modified and stays valid until CAIPReleaseInterfaceSnapshot().
+ *
+ * @return  List of CAInterface_t items, NULL if there is no cached list.
+ *          CAIPGetInterfaceInformation() has to be used instead then.
+ */
+const u_arraylist_t *CAIPAcquireInterfaceSnapshot();
+
+/**
+ * Release the list returned by CAIPAcquireInterfaceSnapshot().
+ */
+void CAIPReleaseInterfaceSnapshot();
+#endif
+
 /**
  * Start network monitor.
  *
@@ -27,6 +27,7 @@
 #define CA_MESSAGE_HANDLER_H_
 
 #include "cacommon.h"
+#include "caremotehandler.h"
 #include <coap/coap.h>
 
 #define CA_MEMORY_ALLOC_CHECK(arg) { if (NULL == arg) {OIC_LOG(ERROR, TAG, "Out of memory"); \
@@ -46,8 +47,19 @@ typedef struct
     CAResponseInfo_t *responseInfo;
     CAErrorInfo_t *errorInfo;
     CADataType_t dataType;
+    void *pdu;                  /**< encoded message sent as is, instead of the info */
+    uint32_t pduLength;         /**< length of pdu */
 } CAData_t;
 
+/**
+ * Statistics of the pools the message handler allocates from.
+ */
+typedef struct
+{
+    u_mempool_stats_t data;             /**< ::CAData_t */
+    CAObjectPoolStats_t objects;        /**< endpoints, infos and tokens */
+} CAMessagePoolStats_t;
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -91,6 +103,33 @@ void CATerminateMessageHandler();
  */
 void CAHandleRequestResponseCallbacks();
 
+/**
+ * Handler for receiving request and response callback in single thread model,
+ * dispatching up to maxCount received data in one call.
+ * @param[in]   maxCount    maximum number of data to dispatch.
+ * @return  number of received data still waiting to be dispatched.
+ */
+uint32_t CAHandleRequestResponseCallbacksBatch(uint32_t maxCount);
+
+/**
+ * Block until received data is waiting for ::CAHandleRequestResponseCallbacksBatch.
+ * @param[in]   timeoutUs   longest wait in microseconds, 0 waits until woken.
+ * @return  ::CA_STATUS_OK if data is waiting, ::CA_REQUEST_TIMEOUT on timeout or
+ *          ::CAWakeUpReceivedDataWait, ::CA_NOT_SUPPORTED if this build cannot wait.
+ */
+CAResult_t CAWaitForReceivedData(uint64_t timeoutUs);
+
+/**
+ * Wake up all threads blocked in ::CAWaitForReceivedData.
+ */
+void CAWakeUpReceivedDataWait();
+
+/**
+ * Get the statistics of the message pools.
+ * @param[out]  stats       statistics.
+ */
+void CAGetMessagePoolStats(CAMessagePoolStats_t *stats);
+
 /**
  * Setting the Callback funtion for network state change callback.
  * @param[in] nwMonitorHandler    callback for network state change.
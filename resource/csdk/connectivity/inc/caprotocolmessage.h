@@ -104,6 +104,42 @@ coap_pdu_t *CAGeneratePDUImpl(code_t code, const CAInfo_t *info,
                               const CAEndpoint_t *endpoint, coap_list_t *options,
                               coap_transport_t *transport);
 
+/**
+ * encodes a message from the information into the buffer in one pass, without
+ * building an option list or a coap_pdu_t. Options are taken from the resource
+ * URI and the header options of info, in the order CAGeneratePDU uses.
+ * @param[in]   code                 request or response code.
+ * @param[in]   info                 information to encode.
+ * @param[in]   endpoint             endpoint information.
+ * @param[out]  buffer               buffer for the message. NULL to get the length only.
+ * @param[in]   bufferSize           size of buffer.
+ * @param[out]  outLength            length of the message.
+ * @param[out]  transport            transport type of the message header.
+ * @return  CA_STATUS_OK, CA_STATUS_FAILED if buffer is too small,
+ *          or ERROR CODES (CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CAEncodePDU(code_t code, const CAInfo_t *info, const CAEndpoint_t *endpoint,
+                       uint8_t *buffer, size_t bufferSize, size_t *outLength,
+                       coap_transport_t *transport);
+
+#ifdef WITH_BWT
+/**
+ * generates a blockwise transfer message from the pdu CAGeneratePDU made, which has the
+ * header and the token only. The options of info and the block options are encoded in
+ * one pass, the payload is left to the caller.
+ * @param[in]   pdu                  pdu with the header and the token of the message.
+ * @param[in]   info                 information of the message.
+ * @param[in]   optlist              Block1, Block2, Size1 and Size2 options. The options
+ *                                   of info are added to it if there are too many for
+ *                                   one pass.
+ * @param[in]   payloadLength        length of the payload the caller writes to the data
+ *                                   of the generated pdu.
+ * @return  generated pdu, NULL if the message is too large for a pdu.
+ */
+coap_pdu_t *CAGenerateBlockPDU(const coap_pdu_t *pdu, const CAInfo_t *info,
+                               coap_list_t **optlist, size_t payloadLength);
+#endif
+
 /**
  * parse the URI and creates the options.
  * @param[in]    uriInfo             uri information.
@@ -187,6 +223,37 @@ uint32_t CAGetOptionCount(coap_opt_iterator_t opt_iter);
 uint32_t CAGetOptionData(uint16_t key, const uint8_t *data, uint32_t len,
                          uint8_t *option, uint32_t buflen);
 
+/** iterator over the options of an encoded message, values are not copied. */
+typedef struct
+{
+    const uint8_t *next;        /**< next option. */
+    const uint8_t *end;         /**< end of the message. */
+    uint16_t number;            /**< number of the last option. */
+} CAOptionIterator_t;
+
+/**
+ * initializes an iterator over the options of an encoded message.
+ * @param[out]  iter                iterator.
+ * @param[in]   pdu                 pdu data.
+ * @param[in]   size                size of pdu data.
+ * @param[in]   endpoint            endpoint information, selects the header format.
+ * @return  CA_STATUS_OK or CA_STATUS_INVALID_PARAM if the header is truncated.
+ */
+CAResult_t CAOptionIteratorInit(CAOptionIterator_t *iter, const void *pdu, size_t size,
+                                const CAEndpoint_t *endpoint);
+
+/**
+ * gets the next option. The value points into the pdu data.
+ * @param[in,out]   iter            iterator.
+ * @param[out]      number          option number.
+ * @param[out]      value           option value.
+ * @param[out]      length          length of the value.
+ * @return  true for an option, false at the payload or the end of the pdu data,
+ *          or if the option is malformed.
+ */
+bool CAOptionIteratorNext(CAOptionIterator_t *iter, uint16_t *number,
+                          const uint8_t **value, uint16_t *length);
+
 /**
  * extracts request information from received pdu.
  * @param[in]    pdu                  received pdu.
@@ -32,6 +32,7 @@
 #include "cathreadpool.h"
 #include "octhread.h"
 #include "uqueue.h"
+#include "uringbuffer.h"
 #include "cacommon.h"
 #ifdef __cplusplus
 extern "C"
@@ -44,6 +45,17 @@ typedef void (*CAThreadTask)(void *threadData);
 /** Data destroy function. **/
 typedef void (*CADataDestroyFunction)(void *data, uint32_t size);
 
+/** What CAQueueingThreadAddData does when a bounded queue is full. **/
+typedef enum
+{
+    /** Destroy the new data and return CA_STATUS_OK. **/
+    CA_QUEUE_FULL_DROP = 0,
+    /** Wait for the queue thread to make room (at most CA_QUEUE_BLOCK_TIMEOUT_US). **/
+    CA_QUEUE_FULL_BLOCK,
+    /** Return CA_STATUS_FAILED; the caller keeps ownership of the data. **/
+    CA_QUEUE_FULL_ERROR
+} CAQueueFullPolicy_t;
+
 typedef struct
 {
     /** Thread pool of the thread started. **/
@@ -58,8 +70,28 @@ typedef struct
     CADataDestroyFunction destroy;
     /** Variable to inform the thread to stop. **/
     bool isStop;
+    /** Set by the thread when it has left its routine. **/
+    bool isStopped;
     /** Que on which the thread is operating. **/
     u_queue_t *dataQueue;
+    /** Bounded lock-free queue used instead of dataQueue if not NULL. **/
+    u_ringbuffer_t *ring;
+    /** Policy applied when ring is full. **/
+    CAQueueFullPolicy_t fullPolicy;
+    /** signaled when the thread has made room in ring. **/
+    oc_cond spaceCond;
+    /** Number of threads waiting for data in ring. **/
+    volatile uint32_t consumerWaiting;
+    /** Number of producers waiting for room in ring. **/
+    volatile uint32_t producersWaiting;
+    /** Number of messages dropped because ring was full. **/
+    volatile uint32_t droppedCount;
+    /** Set by ::CAQueueingThreadWakeUp when no caller waits, for the next one. **/
+    bool wakeRequested;
+    /** Incremented by ::CAQueueingThreadWakeUp to release every waiting caller. **/
+    uint32_t wakeGeneration;
+    /** Number of callers blocked in ::CAQueueingThreadWaitForData. **/
+    uint32_t dataWaiters;
 } CAQueueingThread_t;
 
 /**
@@ -73,6 +105,26 @@ typedef struct
 CAResult_t CAQueueingThreadInitialize(CAQueueingThread_t *thread, ca_thread_pool_t handle,
                                       CAThreadTask task, CADataDestroyFunction destroy);
 
+/**
+ * Initializes the queuing thread with a bounded, preallocated queue.
+ * Data can be added from many threads without taking threadMutex, but only
+ * the queuing thread (or a single caller of CAQueueingThreadGetDataBatch
+ * if the thread is never started) may remove it.
+ * @param[in]   thread       thread data for each thread.
+ * @param[in]   handle       thread pool handle created.
+ * @param[in]   task         function to be called for each data.
+ * @param[in]   destroy      function to data destroy.
+ * @param[in]   capacity     maximum number of queued data.
+ * @param[in]   policy       what to do when the queue is full.
+ * @return  CA_STATUS_OK or ERROR CODES (CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CAQueueingThreadInitializeBounded(CAQueueingThread_t *thread,
+                                             ca_thread_pool_t handle,
+                                             CAThreadTask task,
+                                             CADataDestroyFunction destroy,
+                                             uint32_t capacity,
+                                             CAQueueFullPolicy_t policy);
+
 /**
  * Start the queuing thread.
  * @param[in]   thread        thread data that needs to be started.
@@ -82,6 +134,7 @@ CAResult_t CAQueueingThreadStart(CAQueueingThread_t *thread);
 
 /**
  * Add queuing thread data for new thread.
+ * On failure the caller keeps ownership of data.
  * @param[in]   thread       thread data for new thread control.
  * @param[in]   data         data that needs to be given for each thread.
  * @param[in]   size         length of the data.
@@ -89,6 +142,39 @@ CAResult_t CAQueueingThreadStart(CAQueueingThread_t *thread);
  */
 CAResult_t CAQueueingThreadAddData(CAQueueingThread_t *thread, void *data, uint32_t size);
 
+/**
+ * Remove up to max queued data in one go, for a caller which processes the
+ * queue itself instead of starting the queuing thread.
+ * @param[in]   thread       thread data.
+ * @param[out]  messages     array receiving the data and their sizes.
+ * @param[in]   max          size of the messages array.
+ * @return  number of data removed.
+ */
+uint32_t CAQueueingThreadGetDataBatch(CAQueueingThread_t *thread,
+                                      u_queue_message_t *messages, uint32_t max);
+
+/**
+ * Get the number of queued data.
+ * @param[in]   thread       thread data.
+ * @return  number of data waiting in the queue.
+ */
+uint32_t CAQueueingThreadGetSize(CAQueueingThread_t *thread);
+
+/**
+ * Wait until data is queued, for a caller which processes the queue itself.
+ * @param[in]   thread       thread data.
+ * @param[in]   timeoutUs    longest wait in microseconds, 0 waits until woken.
+ * @return  true if data is waiting, false on timeout or ::CAQueueingThreadWakeUp.
+ */
+bool CAQueueingThreadWaitForData(CAQueueingThread_t *thread, uint64_t timeoutUs);
+
+/**
+ * Wake up every caller blocked in ::CAQueueingThreadWaitForData. If none is
+ * waiting, the next call returns at once instead.
+ * @param[in]   thread       thread data.
+ */
+void CAQueueingThreadWakeUp(CAQueueingThread_t *thread);
+
 /**
  * Stop the queuing thread.
  * @param[in]   thread       thread data that needs to be started.
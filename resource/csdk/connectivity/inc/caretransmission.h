@@ -47,6 +47,32 @@
 /** check period is 1 sec. **/
 #define RETRANSMISSION_CHECK_PERIOD_SEC     1
 
+/**
+ * default number of simultaneous outstanding CON exchanges per endpoint (NSTART).
+ * 0 puts no limit.
+ **/
+#ifndef DEFAULT_NSTART
+#define DEFAULT_NSTART                      0
+#endif
+
+/** bounds of the RTO estimated from measured round trip times. **/
+#ifndef RETRANSMISSION_MIN_RTO_MSEC
+#define RETRANSMISSION_MIN_RTO_MSEC         200
+#endif
+#ifndef RETRANSMISSION_MAX_RTO_MSEC
+#define RETRANSMISSION_MAX_RTO_MSEC         60000
+#endif
+
+/** endpoints whose round trip times are remembered. **/
+#ifndef RETRANSMISSION_MAX_PEERS
+#define RETRANSMISSION_MAX_PEERS            256
+#endif
+
+/** CON messages held back per endpoint while NSTART exchanges are outstanding. **/
+#ifndef RETRANSMISSION_MAX_DEFERRED
+#define RETRANSMISSION_MAX_DEFERRED         64
+#endif
+
 /** retransmission data send method type. **/
 typedef CAResult_t (*CADataSendMethod_t)(const CAEndpoint_t *endpoint,
                                          const void *pdu,
@@ -66,8 +92,17 @@ typedef struct
     /** retransmission trying count. **/
     uint8_t tryingCount;
 
+    /** outstanding CON exchanges per endpoint (NSTART), 0 for no limit. **/
+    uint8_t nstart;
+
 } CARetransmissionConfig_t;
 
+/** retransmission data, private to caretransmission.c. **/
+typedef struct CARetransmissionData CARetransmissionData_t;
+
+/** round trip time estimation of an endpoint, private to caretransmission.c. **/
+typedef struct CARetransmissionPeer CARetransmissionPeer_t;
+
 typedef struct
 {
     /** Thread pool of the thread started. **/
@@ -91,8 +126,26 @@ typedef struct
     /** Variable to inform the thread to stop. **/
     bool isStop;
 
-    /** array list on which the thread is operating. **/
-    u_arraylist_t *dataList;
+    /** retransmission data ordered by next deadline (binary min-heap). **/
+    CARetransmissionData_t **dataHeap;
+
+    /** number of retransmission data in dataHeap. **/
+    uint32_t dataCount;
+
+    /** allocated length of dataHeap. **/
+    uint32_t heapCapacity;
+
+    /** retransmission data chained by message id. **/
+    CARetransmissionData_t **idTable;
+
+    /** number of idTable buckets (power of two). **/
+    uint32_t idTableSize;
+
+    /** endpoints chained by the hash of their address. **/
+    CARetransmissionPeer_t **peerTable;
+
+    /** number of endpoints in peerTable. **/
+    uint32_t peerCount;
 
 } CARetransmission_t;
 
@@ -125,20 +178,33 @@ CAResult_t CARetransmissionInitialize(CARetransmission_t *context,
 CAResult_t CARetransmissionStart(CARetransmission_t *context);
 
 /**
- * Pass the sent pdu data. if retransmission process need, internal thread will wake up and
- * process the retransmission data.
+ * Send a CON pdu and retransmit it until it is acknowledged.  The pdu is held back
+ * and sent later if the endpoint has NSTART outstanding exchanges.  A pdu whose
+ * message id is already retransmitted is sent once without retransmission.
  * @param[in]   context      context for retransmission.
  * @param[in]   endpoint     endpoint information.
  * @param[in]   dataType     Data type which is REQUEST or RESPONSE.
- * @param[in]   pdu          sent pdu binary data.
- * @param[in]   size         sent pdu binary data size.
- * @return  ::CA_STATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
+ * @param[in]   pdu          pdu binary data.
+ * @param[in]   size         pdu binary data size.
+ * @return  ::CA_STATUS_OK if the pdu was sent or held back, ::CA_NOT_SUPPORTED if it
+ *          is not retransmitted and has to be sent by the caller, or other ERROR CODES
+ *          (::CAResult_t error codes in cacommon.h).
  */
-CAResult_t CARetransmissionSentData(CARetransmission_t *context,
+CAResult_t CARetransmissionSendData(CARetransmission_t *context,
                                     const CAEndpoint_t *endpoint,
                                     CADataType_t dataType,
                                     const void *pdu, uint32_t size);
 
+/**
+ * Get the retransmission timeout a new exchange with the endpoint starts with,
+ * before the random factor is applied.
+ * @param[in]   context      context for retransmission.
+ * @param[in]   endpoint     endpoint information.
+ * @return  milliseconds.
+ */
+uint64_t CARetransmissionGetTimeout(CARetransmission_t *context,
+                                    const CAEndpoint_t *endpoint);
+
 /**
  * Pass the received pdu data. if received pdu is ACK data for the retransmission CON data,
  * the specified CON data will remove on retransmission list.
@@ -54,6 +54,16 @@ typedef enum
     DISCONNECTED
 } CATCPConnectionState_t;
 
+/**
+ * Outbound data queued on a session until its socket accepts it.
+ */
+typedef struct CATCPPendingData_t
+{
+    struct CATCPPendingData_t *next;    /**< next queued frame */
+    size_t len;                         /**< frame length */
+    unsigned char *data;                /**< frame data (allocated with this node) */
+} CATCPPendingData_t;
+
 /**
  * TCP Session Information for IPv4/IPv6 TCP transport
  */
@@ -61,7 +71,8 @@ typedef struct CATCPSessionInfo_t
 {
     CASecureEndpoint_t sep;             /**< secure endpoint information */
     int fd;                             /**< file descriptor info */
-    unsigned char* data;                /**< received data from remote device */
+    unsigned char* data;                /**< message received partially from remote device */
+    size_t dataSize;                    /**< allocated size of data, kept across messages */
     size_t len;                         /**< received data length */
     size_t totalLen;                    /**< total coap data length required to receive */
     unsigned char tlsdata[18437];       /**< tls data(rfc5246: TLSCiphertext max (2^14+2048+5)) */
@@ -69,7 +80,17 @@ typedef struct CATCPSessionInfo_t
     CAProtocol_t protocol;              /**< application-level protocol */
     CATCPConnectionState_t state;       /**< current tcp session state */
     bool isClient;                      /**< Host Mode of Operation. */
+    CATCPPendingData_t *sendHead;       /**< outbound frames the socket has not taken yet */
+    CATCPPendingData_t *sendTail;       /**< last queued outbound frame */
+    size_t sendOffset;                  /**< bytes of sendHead already written */
+    size_t sendQueued;                  /**< bytes waiting in the send queue */
+    bool waitWritable;                  /**< the receive thread polls the socket for output */
+    uint64_t connectDeadline;           /**< ms time a pending connect is abandoned at */
+    struct CATCPSessionInfo_t *connectNext; /**< next session with a pending connect */
     struct CATCPSessionInfo_t *next;    /**< Linked list; for multiple session list. */
+    struct CATCPSessionInfo_t *prev;    /**< Previous session, for O(1) removal. */
+    struct CATCPSessionInfo_t *fdNext;  /**< Next session in the same fd hash bucket. */
+    struct CATCPSessionInfo_t *epNext;  /**< Next session in the same endpoint hash bucket. */
 } CATCPSessionInfo_t;
 
 /**
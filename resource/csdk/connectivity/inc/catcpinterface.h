@@ -54,7 +54,8 @@ typedef void (*CATCPPacketReceivedCallback)(const CASecureEndpoint_t *endpoint,
   * Callback to notify error in the TCP adapter.
   *
   * @param[in]  endpoint      network endpoint description.
-  * @param[in]  data          Data sent/received.
+  * @param[in]  data          Data sent/received, NULL if the error concerns the
+  *                           endpoint rather than a message (e.g. a failed TLS session).
   * @param[in]  dataLength    Length of data in bytes.
   * @param[in]  result        result of request from R.I.
   * @pre  Callback must be registered using CAIPSetPacketReceiveCallback().
@@ -155,10 +156,20 @@ void CATCPSetConnectionChangedCallback(CATCPConnectionHandleCallback connHandler
  * @param[in]  endpoint          complete network address to send to.
  * @param[in]  data              Data to be send.
  * @param[in]  dataLength        Length of data in bytes.
- * @return  Sent data length or -1 on error.
+ * @return  Sent data length or -1 on error.  Data the socket cannot take
+ *          immediately is queued on the session and counts as sent.
  */
 ssize_t CATCPSendData(CAEndpoint_t *endpoint, const void *data, size_t dataLength);
 
+/**
+ * Check whether the session with a remote device has reached the send
+ * high-water mark (caglobals.tcp.sendHighWaterMark queued bytes).
+ *
+ * @param[in]  endpoint          remote endpoint information.
+ * @return  true if new messages for the endpoint should be refused for now.
+ */
+bool CATCPIsSendQueueFull(const CAEndpoint_t *endpoint);
+
 /**
  * Get a list of CAInterface_t items.
  *
@@ -167,7 +178,10 @@ ssize_t CATCPSendData(CAEndpoint_t *endpoint, const void *data, size_t dataLengt
 u_arraylist_t *CATCPGetInterfaceInformation(int desiredIndex);
 
 /**
- * Connect to TCP Server.
+ * Connect to TCP Server.  The connect completes asynchronously on the
+ * receive thread; data sent to the endpoint meanwhile is queued, and is
+ * reported through ::CATCPErrorHandleCallback if the connect fails or
+ * times out.
  *
  * @param[in]   endpoint    remote endpoint information.
  * @return  Created socket file descriptor.
@@ -203,6 +217,15 @@ CATCPSessionInfo_t *CAGetTCPSessionInfoFromEndpoint(const CAEndpoint_t *endpoint
  */
 size_t CAGetTotalLengthFromHeader(const unsigned char *recvBuffer);
 
+/**
+ * Get the length of the message at the start of a receive buffer.
+ *
+ * @param[in]   recvBuffer    received data.
+ * @param[in]   size          received data length.
+ * @return  total length of the first message, or 0 if its header is not complete.
+ */
+size_t CAGetMessageLengthFromBuffer(const unsigned char *recvBuffer, size_t size);
+
 /**
  * Get session information from socket file descriptor.
  *
@@ -26,12 +26,16 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include "ca_adapter_net_ssl.h"
+#include "caatomic.h"
 #include "cacommon.h"
 #include "caipinterface.h"
 #include "oic_malloc.h"
+#include "oic_string.h"
 #include "ocrandom.h"
 #include "byte_array.h"
 #include "octhread.h"
+#include "caqueueingthread.h"
+#include "oic_time.h"
 #include "timer.h"
 
 // headers required for mbed TLS
@@ -42,6 +46,8 @@
 #include "mbedtls/pkcs12.h"
 #include "mbedtls/ssl_internal.h"
 #include "mbedtls/net_sockets.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_ticket.h"
 #ifdef __WITH_DTLS__
 #include "mbedtls/timing.h"
 #include "mbedtls/ssl_cookie.h"
@@ -176,6 +182,44 @@
  */
 #define RETRANSMISSION_TIME 1
 
+/**
+ * @def SSL_SESSION_LIFETIME
+ * @brief Time (in seconds) a (D)TLS session may be resumed after its full handshake.
+ */
+#ifndef SSL_SESSION_LIFETIME
+#define SSL_SESSION_LIFETIME (86400)
+#endif
+
+/**
+ * @def SSL_SESSION_CACHE_SIZE
+ * @brief Number of sessions kept for resumption, on the server and on the client side.
+ */
+#ifndef SSL_SESSION_CACHE_SIZE
+#define SSL_SESSION_CACHE_SIZE (32)
+#endif
+
+/**
+ * @def SSL_PEER_HASH_SIZE
+ * @brief Number of buckets in the peer table (power of two).
+ */
+#ifndef SSL_PEER_HASH_SIZE
+#define SSL_PEER_HASH_SIZE (256)
+#endif
+
+/**
+ * @def SSL_PEER_LOCK_COUNT
+ * @brief Number of locks sharing the peer table buckets (divides SSL_PEER_HASH_SIZE).
+ */
+#define SSL_PEER_LOCK_COUNT (16)
+
+/**
+ * @def SSL_HANDSHAKE_QUEUE_SIZE
+ * @brief Number of records waiting for the handshake thread; further records are dropped.
+ */
+#ifndef SSL_HANDSHAKE_QUEUE_SIZE
+#define SSL_HANDSHAKE_QUEUE_SIZE (64)
+#endif
+
 /**@def SSL_CLOSE_NOTIFY(peer, ret)
  *
  * Notifies of existing \a peer about closing TLS connection.
@@ -202,18 +246,19 @@ if (g_sslCallback)
     errorInfo.result = (status);                                                                   \
     g_sslCallback(&(peer)->sep.endpoint, &errorInfo);                                              \
 }
-/**@def SSL_CHECK_FAIL(peer, ret, str, mutex, error, msg)
+/**@def SSL_CHECK_FAIL(peer, ret, str, ctxMutex, error, msg)
  *
  * Checks handshake result and send alert if needed.
+ * On failure the peer is removed, unlocked and released.
  *
- * @param[in] peer remote peer
+ * @param[in] peer remote peer, locked and referenced by the caller
  * @param[in] ret error code
  * @param[in] str debug string
- * @param[in] mutex ca mutex
+ * @param[in] ctxMutex unlock ca mutex as well
  * @param[in] if code does not equal to -1 returns error code
  * @param[in] msg allert message
  */
-#define SSL_CHECK_FAIL(peer, ret, str, mutex, error, msg)                                          \
+#define SSL_CHECK_FAIL(peer, ret, str, ctxMutex, error, msg)                                       \
 if (0 != (ret) && MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY != (int) (ret) &&                              \
     MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED != (int) (ret) &&                                        \
     MBEDTLS_ERR_SSL_WANT_READ != (int) (ret) &&                                                    \
@@ -240,8 +285,13 @@ if (0 != (ret) && MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY != (int) (ret) &&
     {                                                                                              \
         mbedtls_ssl_send_alert_message(&(peer)->ssl, MBEDTLS_SSL_ALERT_LEVEL_FATAL, (msg));        \
     }                                                                                              \
-    RemovePeerFromList(&(peer)->sep.endpoint);                                                     \
-    if (mutex)                                                                                     \
+    if (MBEDTLS_SSL_IS_CLIENT == (peer)->ssl.conf->endpoint)                                       \
+    {                                                                                              \
+        DeleteClientSession(&(peer)->sep.endpoint);                                                \
+    }                                                                                              \
+    RemovePeerFromList(peer);                                                                      \
+    oc_mutex_unlock((peer)->mutex);                                                                \
+    if (ctxMutex)                                                                                  \
     {                                                                                              \
         oc_mutex_unlock(g_sslContextMutex);                                                        \
     }                                                                                              \
@@ -249,6 +299,7 @@ if (0 != (ret) && MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY != (int) (ret) &&
     {                                                                                              \
         SSL_RES((peer), CA_DTLS_AUTHENTICATION_FAILURE);                                           \
     }                                                                                              \
+    ReleaseSslPeer(peer);                                                                          \
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);                                             \
     if (-1 != error)                                                                               \
     {                                                                                              \
@@ -414,6 +465,19 @@ typedef struct TlsCallBacks
     CAPacketSendCallback sendCallback;      /**< Callback used to send data to socket layer. */
 } SslCallbacks_t;
 
+/**
+ * Session to resume on the next connection to a server.
+ */
+typedef struct SslClientSession
+{
+    CATransportAdapter_t adapter;
+    char addr[MAX_ADDR_STR_SIZE_CA];
+    uint16_t port;
+    char remoteId[CA_MAX_IDENTITY_SIZE];   /**< device ID of the server, if known */
+    uint64_t expires;                      /**< in milliseconds, 0 if the entry is free */
+    mbedtls_ssl_session session;
+} SslClientSession_t;
+
 /**
  * Data structure for holding the mbedTLS interface related info.
  */
@@ -435,6 +499,12 @@ typedef struct SslContext
     SslCipher_t cipher;
     SslCallbacks_t adapterCallbacks[MAX_SUPPORTED_ADAPTERS];
     mbedtls_x509_crl crl;
+    uint32_t pkixGeneration;        /**< g_pkixGeneration ca/crt/pkey/crl were parsed at */
+    bool ownCertLoaded;             /**< crt and pkey are usable */
+    bool caLoaded;                  /**< ca holds at least one certificate */
+    bool crlLoaded;                 /**< crl is usable */
+    uint32_t tlsPkixGeneration;     /**< g_pkixGeneration the TLS configs were set up at */
+    uint32_t dtlsPkixGeneration;    /**< g_pkixGeneration the DTLS configs were set up at */
     bool cipherFlag[2];
     int selectedCipher;
 
@@ -442,6 +512,14 @@ typedef struct SslContext
     int timerId;
 #endif
 
+#ifdef MBEDTLS_SSL_CACHE_C
+    mbedtls_ssl_cache_context sessionCache;    /**< sessions resumable by our clients */
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+    mbedtls_ssl_ticket_context ticketCtx;      /**< keys of the tickets we issue */
+#endif
+    SslClientSession_t clientSessions[SSL_SESSION_CACHE_SIZE];  /**< guarded by context mutex */
+
 } SslContext_t;
 
 /**
@@ -466,19 +544,69 @@ static CAgetCredentialTypesHandler g_getCredentialTypesCallback = NULL;
  * @brief callback to get X.509-based Public Key Infrastructure
  */
 static CAgetPkixInfoHandler g_getPkixInfoCallback = NULL;
+/**
+ * @var g_pkixGeneration
+ *
+ * @brief bumped whenever the PKIX info may have changed; 0 is never a valid generation
+ */
+static volatile uint32_t g_pkixGeneration = 1;
 
 /**
  * @var g_dtlsContextMutex
  * @brief Mutex to synchronize access to g_caSslContext.
+ *
+ * Guards the configs, the peer list and every handshake.  Records of
+ * established sessions are only protected by the mutex of their peer.
+ * Lock order: g_sslContextMutex, a peer mutex, a peer table lock.
  */
 static oc_mutex g_sslContextMutex = NULL;
 
+/**
+ * @var g_sslRngMutex
+ * @brief Mutex to serialize the shared RNG, used by records of all sessions.
+ */
+static oc_mutex g_sslRngMutex = NULL;
+
 /**
  * @var g_sslCallback
  * @brief callback to deliver the TLS handshake result
  */
 static CAErrorCallback g_sslCallback = NULL;
 
+/**
+ * @var g_sslHandshakeThread
+ * @brief Runs DTLS handshakes off the receive threads when asynchronous handshakes are on.
+ */
+static CAQueueingThread_t g_sslHandshakeThread;
+
+/**
+ * @var g_sslHandshakePool
+ * @brief Thread pool of g_sslHandshakeThread, NULL until asynchronous handshakes are enabled.
+ */
+static ca_thread_pool_t g_sslHandshakePool = NULL;
+
+/**
+ * @var g_sslAsyncHandshake
+ * @brief Non-zero when handshake records are queued to g_sslHandshakeThread.
+ */
+static volatile uint32_t g_sslAsyncHandshake = 0;
+
+/**
+ * @var g_sslHandshakeMutex
+ * @brief Guards g_sslHandshakeThread, g_sslHandshakePool and changes of g_sslAsyncHandshake.
+ */
+static oc_mutex g_sslHandshakeMutex = NULL;
+
+/**
+ * Record of a DTLS handshake waiting for g_sslHandshakeThread.
+ */
+typedef struct SslHandshakeRecord
+{
+    CASecureEndpoint_t sep;
+    uint8_t * data;         /**< follows the structure in the same allocation */
+    uint32_t dataLen;
+} SslHandshakeRecord_t;
+
 /**
  * Data structure for holding the data to be received.
  */
@@ -504,8 +632,27 @@ typedef struct SslEndPoint
     mbedtls_ssl_cookie_ctx cookieCtx;
     mbedtls_timing_delay_context timer;
 #endif // __WITH_DTLS__
+    oc_mutex mutex;                 /**< guards ssl, recBuf and cacheList */
+    bool removed;                   /**< no longer in the peer table, guarded by mutex */
+    uint32_t hash;                  /**< hash of the endpoint */
+    uint32_t refCount;              /**< guarded by the table lock of hash */
+    struct SslEndPoint * hashNext;  /**< next peer in the same bucket */
 } SslEndPoint_t;
 
+/**
+ * @var g_sslPeerTable
+ * @brief Peers indexed by adapter, address and port (address only for BLE).
+ *
+ * The table holds one reference on each peer it contains.
+ */
+static SslEndPoint_t * g_sslPeerTable[SSL_PEER_HASH_SIZE];
+
+/**
+ * @var g_sslPeerTableMutex
+ * @brief Locks for the buckets and reference counts of g_sslPeerTable.
+ */
+static oc_mutex g_sslPeerTableMutex[SSL_PEER_LOCK_COUNT];
+
 void CAsetPskCredentialsCallback(CAgetPskCredentialsHandler credCallback)
 {
     // TODO Does this method needs protection of tlsContextMutex?
@@ -518,8 +665,17 @@ void CAsetPkixInfoCallback(CAgetPkixInfoHandler infoCallback)
 {
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
     g_getPkixInfoCallback = infoCallback;
+    CAinvalidatePkixInfoCache();
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
 }
+void CAinvalidatePkixInfoCache()
+{
+    // skip 0 on wrap around, it marks configs that were never set up
+    if (0 == CAAtomicAdd32(&g_pkixGeneration, 1))
+    {
+        CAAtomicAdd32(&g_pkixGeneration, 1);
+    }
+}
 void CAsetCredentialTypesCallback(CAgetCredentialTypesHandler credTypesCallback)
 {
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
@@ -611,6 +767,22 @@ static int RecvCallBack(void * tep, unsigned char * data, size_t dataLen)
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
     return (int)retLen;
 }
+/**
+ * RNG callback shared by all sessions.
+ *
+ * @param[in]  rng    mbedTLS DRBG context
+ * @param[out] output    random bytes
+ * @param[in]  len    number of bytes
+ *
+ * @return  0 on success
+ */
+static int SslRandom(void * rng, unsigned char * output, size_t len)
+{
+    oc_mutex_lock(g_sslRngMutex);
+    int ret = mbedtls_ctr_drbg_random(rng, output, len);
+    oc_mutex_unlock(g_sslRngMutex);
+    return ret;
+}
 
 /**
  * Parse chain of X.509 certificates.
@@ -728,19 +900,67 @@ exit:
     return -1;
 }
 
-//Loads PKIX related information from SRM
-static int InitPKIX(CATransportAdapter_t adapter)
+/**
+ * Frees a stored client session.
+ *
+ * @param[in]  entry    stored session
+ */
+static void FreeClientSession(SslClientSession_t * entry)
+{
+    if (0 != entry->expires)
+    {
+        mbedtls_ssl_session_free(&entry->session);
+        memset(entry, 0, sizeof(*entry));
+    }
+}
+/**
+ * Frees all stored client sessions.
+ */
+static void DeleteClientSessions()
+{
+    for (size_t i = 0; i < SSL_SESSION_CACHE_SIZE; i++)
+    {
+        FreeClientSession(&g_caSslContext->clientSessions[i]);
+    }
+}
+/**
+ * Forgets all resumable sessions, so that peers are verified again against new credentials.
+ * Caller must hold g_sslContextMutex.
+ */
+static void ResetSessionCache()
+{
+    DeleteClientSessions();
+#ifdef MBEDTLS_SSL_CACHE_C
+    mbedtls_ssl_cache_free(&g_caSslContext->sessionCache);
+    mbedtls_ssl_cache_init(&g_caSslContext->sessionCache);
+    mbedtls_ssl_cache_set_timeout(&g_caSslContext->sessionCache, SSL_SESSION_LIFETIME);
+    mbedtls_ssl_cache_set_max_entries(&g_caSslContext->sessionCache, SSL_SESSION_CACHE_SIZE);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+    // new keys invalidate the tickets issued so far
+    mbedtls_ssl_ticket_free(&g_caSslContext->ticketCtx);
+    mbedtls_ssl_ticket_init(&g_caSslContext->ticketCtx);
+    if (0 != mbedtls_ssl_ticket_setup(&g_caSslContext->ticketCtx, SslRandom, &g_caSslContext->rnd,
+                                      MBEDTLS_CIPHER_AES_256_GCM, SSL_SESSION_LIFETIME))
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Session ticket initialization failed!");
+    }
+#endif
+}
+/**
+ * Parses PKIX related information from SRM.  Caller must hold g_sslContextMutex.
+ *
+ * @param[in]  generation    value of g_pkixGeneration before the info is read
+ */
+static void LoadPKIX(uint32_t generation)
 {
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
-    VERIFY_NON_NULL_RET(g_getPkixInfoCallback, NET_SSL_TAG, "PKIX info callback is NULL", -1);
     // load pk key, cert, trust chain and crl
     if (g_getPkixInfoCallback)
     {
         g_getPkixInfoCallback(&g_pkiInfo);
     }
 
-    VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", -1);
-
     mbedtls_x509_crt_free(&g_caSslContext->ca);
     mbedtls_x509_crt_free(&g_caSslContext->crt);
     mbedtls_pk_free(&g_caSslContext->pkey);
@@ -751,12 +971,15 @@ static int InitPKIX(CATransportAdapter_t adapter)
     mbedtls_pk_init(&g_caSslContext->pkey);
     mbedtls_x509_crl_init(&g_caSslContext->crl);
 
-    mbedtls_ssl_config * serverConf = (adapter == CA_ADAPTER_IP ||
-                                   adapter == CA_ADAPTER_GATT_BTLE ?
-                                   &g_caSslContext->serverDtlsConf : &g_caSslContext->serverTlsConf);
-    mbedtls_ssl_config * clientConf = (adapter == CA_ADAPTER_IP ||
-                                   adapter == CA_ADAPTER_GATT_BTLE ?
-                                   &g_caSslContext->clientDtlsConf : &g_caSslContext->clientTlsConf);
+    if (0 != g_caSslContext->pkixGeneration)
+    {
+        ResetSessionCache();
+    }
+    g_caSslContext->pkixGeneration = generation;
+    g_caSslContext->ownCertLoaded = false;
+    g_caSslContext->caLoaded = false;
+    g_caSslContext->crlLoaded = false;
+
     // optional
     int ret;
     int errNum;
@@ -778,19 +1001,7 @@ static int InitPKIX(CATransportAdapter_t adapter)
         OIC_LOG(WARNING, NET_SSL_TAG, "Key parsing error");
         goto required;
     }
-
-    ret = mbedtls_ssl_conf_own_cert(serverConf, &g_caSslContext->crt, &g_caSslContext->pkey);
-    if (0 != ret)
-    {
-        OIC_LOG(WARNING, NET_SSL_TAG, "Own certificate parsing error");
-        goto required;
-    }
-    ret = mbedtls_ssl_conf_own_cert(clientConf, &g_caSslContext->crt, &g_caSslContext->pkey);
-    if(0 != ret)
-    {
-        OIC_LOG(WARNING, NET_SSL_TAG, "Own certificate configuration error");
-        goto required;
-    }
+    g_caSslContext->ownCertLoaded = true;
 
     required:
     count = ParseChain(&g_caSslContext->ca, g_pkiInfo.ca.data, g_pkiInfo.ca.len, &errNum);
@@ -798,24 +1009,107 @@ static int InitPKIX(CATransportAdapter_t adapter)
     {
         OIC_LOG(ERROR, NET_SSL_TAG, "CA chain parsing error");
         OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
-        return -1;
+        return;
     }
     if(0 != errNum)
     {
         OIC_LOG_V(WARNING, NET_SSL_TAG, "CA chain parsing warning: %d certs failed to parse", errNum);
     }
+    g_caSslContext->caLoaded = true;
 
     ret = mbedtls_x509_crl_parse_der(&g_caSslContext->crl, g_pkiInfo.crl.data, g_pkiInfo.crl.len);
     if(0 != ret)
     {
         OIC_LOG(WARNING, NET_SSL_TAG, "CRL parsing error");
-        CONF_SSL(clientConf, serverConf, mbedtls_ssl_conf_ca_chain, &g_caSslContext->ca, NULL);
     }
     else
+    {
+        g_caSslContext->crlLoaded = true;
+    }
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+}
+
+/**
+ * Drop the own certificates of a configuration.
+ *
+ * mbedtls_ssl_conf_own_cert() appends to conf->key_cert, so the list is
+ * emptied before the certificate of a new PKIX generation is set.  The
+ * certificates and keys themselves belong to g_caSslContext.
+ *
+ * @param[in]  conf  mbedTLS configuration
+ */
+static void ResetOwnCert(mbedtls_ssl_config * conf)
+{
+    mbedtls_ssl_key_cert * cur = conf->key_cert;
+    while (NULL != cur)
+    {
+        mbedtls_ssl_key_cert * next = cur->next;
+        mbedtls_free(cur);
+        cur = next;
+    }
+    conf->key_cert = NULL;
+}
+
+//Loads PKIX related information from SRM
+static int InitPKIX(CATransportAdapter_t adapter)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+    VERIFY_NON_NULL_RET(g_getPkixInfoCallback, NET_SSL_TAG, "PKIX info callback is NULL", -1);
+    VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", -1);
+
+    bool isDtls = (adapter == CA_ADAPTER_IP || adapter == CA_ADAPTER_GATT_BTLE);
+    uint32_t * confGeneration = (isDtls ? &g_caSslContext->dtlsPkixGeneration
+                                        : &g_caSslContext->tlsPkixGeneration);
+
+    // Read before loading: a change made meanwhile causes another reload next time
+    uint32_t generation = CAAtomicLoad32(&g_pkixGeneration);
+    if (generation == *confGeneration)
+    {
+        OIC_LOG(DEBUG, NET_SSL_TAG, "PKIX info unchanged");
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+        return g_caSslContext->caLoaded ? 0 : -1;
+    }
+    if (generation != g_caSslContext->pkixGeneration)
+    {
+        LoadPKIX(generation);
+    }
+
+    mbedtls_ssl_config * serverConf = (isDtls ? &g_caSslContext->serverDtlsConf
+                                              : &g_caSslContext->serverTlsConf);
+    mbedtls_ssl_config * clientConf = (isDtls ? &g_caSslContext->clientDtlsConf
+                                              : &g_caSslContext->clientTlsConf);
+    *confGeneration = generation;
+
+    ResetOwnCert(serverConf);
+    ResetOwnCert(clientConf);
+    if (g_caSslContext->ownCertLoaded)
+    {
+        int ret = mbedtls_ssl_conf_own_cert(serverConf, &g_caSslContext->crt, &g_caSslContext->pkey);
+        if (0 != ret)
+        {
+            OIC_LOG(WARNING, NET_SSL_TAG, "Own certificate parsing error");
+        }
+        else if (0 != mbedtls_ssl_conf_own_cert(clientConf, &g_caSslContext->crt,
+                                                &g_caSslContext->pkey))
+        {
+            OIC_LOG(WARNING, NET_SSL_TAG, "Own certificate configuration error");
+        }
+    }
+
+    if (!g_caSslContext->caLoaded)
+    {
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+        return -1;
+    }
+    if (g_caSslContext->crlLoaded)
     {
         CONF_SSL(clientConf, serverConf, mbedtls_ssl_conf_ca_chain,
                  &g_caSslContext->ca, &g_caSslContext->crl);
     }
+    else
+    {
+        CONF_SSL(clientConf, serverConf, mbedtls_ssl_conf_ca_chain, &g_caSslContext->ca, NULL);
+    }
 
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
     return 0;
@@ -862,47 +1156,131 @@ static int GetPskCredentialsCallback(void * notUsed, mbedtls_ssl_context * ssl,
     return -1;
 }
 /**
- * Gets session corresponding for endpoint.
+ * Computes the peer table hash of an endpoint.
  *
  * @param[in]  peer    remote address
  *
- * @return  TLS session or NULL
+ * @return  hash value
  */
-static SslEndPoint_t *GetSslPeer(const CAEndpoint_t *peer)
+static uint32_t HashSslPeer(const CAEndpoint_t *peer)
 {
-    uint32_t listIndex = 0;
-    uint32_t listLength = 0;
-    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
-    VERIFY_NON_NULL_RET(peer, NET_SSL_TAG, "TLS peer is NULL", NULL);
-    VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", NULL);
-
-    SslEndPoint_t *tep = NULL;
-    listLength = u_arraylist_length(g_caSslContext->peerList);
-    for (listIndex = 0; listIndex < listLength; listIndex++)
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < MAX_ADDR_STR_SIZE_CA && '\0' != peer->addr[i]; i++)
     {
-        tep = (SslEndPoint_t *) u_arraylist_get(g_caSslContext->peerList, listIndex);
-        if (NULL == tep)
-        {
-            continue;
-        }
+        hash = (hash ^ (uint8_t) peer->addr[i]) * 16777619u;
+    }
+    hash = (hash ^ (uint32_t) peer->adapter) * 16777619u;
+    // BLE peers are matched by address only
+    if (CA_ADAPTER_GATT_BTLE != peer->adapter)
+    {
+        hash = (hash ^ peer->port) * 16777619u;
+    }
+    return hash;
+}
 
-        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Compare [%s:%d] and [%s:%d] for %d adapter",
-                  peer->addr, peer->port, tep->sep.endpoint.addr, tep->sep.endpoint.port,
-                  peer->adapter);
+/**
+ * Gets the lock of the peer table bucket for hash.
+ */
+static oc_mutex GetPeerTableMutex(uint32_t hash)
+{
+    return g_sslPeerTableMutex[(hash & (SSL_PEER_HASH_SIZE - 1)) % SSL_PEER_LOCK_COUNT];
+}
 
-        if((peer->adapter == tep->sep.endpoint.adapter)
+/**
+ * Looks up the peer table.  The caller holds the lock of the bucket.
+ *
+ * @param[in]  peer    remote address
+ * @param[in]  hash    hash of peer
+ *
+ * @return  TLS session or NULL
+ */
+static SslEndPoint_t *FindSslPeer(const CAEndpoint_t *peer, uint32_t hash)
+{
+    SslEndPoint_t *tep = g_sslPeerTable[hash & (SSL_PEER_HASH_SIZE - 1)];
+    for (; NULL != tep; tep = tep->hashNext)
+    {
+        if (hash == tep->hash
+                && (peer->adapter == tep->sep.endpoint.adapter)
                 && (0 == strncmp(peer->addr, tep->sep.endpoint.addr, MAX_ADDR_STR_SIZE_CA))
                 && (peer->port == tep->sep.endpoint.port || CA_ADAPTER_GATT_BTLE == peer->adapter))
         {
-            OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
             return tep;
         }
     }
-    OIC_LOG(DEBUG, NET_SSL_TAG, "Return NULL");
-    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
     return NULL;
 }
 
+/**
+ * Gets session corresponding for endpoint and takes a reference on it.
+ * Does not need g_sslContextMutex.
+ *
+ * @param[in]  peer    remote address
+ *
+ * @return  TLS session, to be released with ReleaseSslPeer(), or NULL
+ */
+static SslEndPoint_t *AcquireSslPeer(const CAEndpoint_t *peer)
+{
+    VERIFY_NON_NULL_RET(peer, NET_SSL_TAG, "TLS peer is NULL", NULL);
+
+    uint32_t hash = HashSslPeer(peer);
+    oc_mutex mutex = GetPeerTableMutex(hash);
+    if (NULL == mutex)
+    {
+        return NULL;
+    }
+
+    oc_mutex_lock(mutex);
+    SslEndPoint_t *tep = FindSslPeer(peer, hash);
+    if (NULL != tep)
+    {
+        tep->refCount++;
+    }
+    oc_mutex_unlock(mutex);
+    return tep;
+}
+
+/**
+ * Takes another reference on a session.
+ *
+ * @param[in]  tep    TLS session
+ */
+static void RetainSslPeer(SslEndPoint_t *tep)
+{
+    oc_mutex mutex = GetPeerTableMutex(tep->hash);
+    oc_mutex_lock(mutex);
+    tep->refCount++;
+    oc_mutex_unlock(mutex);
+}
+
+/**
+ * Gets session corresponding for endpoint.  The caller holds
+ * g_sslContextMutex, which keeps the session in the table.
+ *
+ * @param[in]  peer    remote address
+ *
+ * @return  TLS session or NULL
+ */
+static SslEndPoint_t *GetSslPeer(const CAEndpoint_t *peer)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+    VERIFY_NON_NULL_RET(peer, NET_SSL_TAG, "TLS peer is NULL", NULL);
+    VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", NULL);
+
+    uint32_t hash = HashSslPeer(peer);
+    oc_mutex mutex = GetPeerTableMutex(hash);
+    oc_mutex_lock(mutex);
+    SslEndPoint_t *tep = FindSslPeer(peer, hash);
+    oc_mutex_unlock(mutex);
+
+    if (NULL == tep)
+    {
+        OIC_LOG(DEBUG, NET_SSL_TAG, "Return NULL");
+    }
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+    return tep;
+}
+
 #ifdef MULTIPLE_OWNER
 /**
  * Gets CA secure endpoint info corresponding for endpoint.
@@ -1078,37 +1456,122 @@ static void DeleteSslEndPoint(SslEndPoint_t * tep)
     mbedtls_ssl_cookie_free(&tep->cookieCtx);
 #endif
     DeleteCacheList(tep->cacheList);
+    if (NULL != tep->mutex)
+    {
+        oc_mutex_free(tep->mutex);
+    }
     OICFree(tep);
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
 }
 /**
- * Removes endpoint session from list.
+ * Drops a reference on a session and deletes it with the last one.
+ * The caller must not hold the mutex of the session.
  *
- * @param[in]  endpoint    remote address
+ * @param[in]  tep    TLS session
  */
-static void RemovePeerFromList(CAEndpoint_t * endpoint)
+static void ReleaseSslPeer(SslEndPoint_t * tep)
 {
-    VERIFY_NON_NULL_VOID(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL");
-    VERIFY_NON_NULL_VOID(endpoint, NET_SSL_TAG, "endpoint");
-    uint32_t listLength = u_arraylist_length(g_caSslContext->peerList);
-    for (uint32_t listIndex = 0; listIndex < listLength; listIndex++)
+    VERIFY_NON_NULL_VOID(tep, NET_SSL_TAG, "tep");
+
+    oc_mutex mutex = GetPeerTableMutex(tep->hash);
+    oc_mutex_lock(mutex);
+    uint32_t refCount = --tep->refCount;
+    oc_mutex_unlock(mutex);
+
+    if (0 == refCount)
     {
-        SslEndPoint_t * tep = (SslEndPoint_t *)u_arraylist_get(g_caSslContext->peerList,listIndex);
-        if (NULL == tep)
-        {
-            continue;
-        }
-        if(0 == strncmp(endpoint->addr, tep->sep.endpoint.addr, MAX_ADDR_STR_SIZE_CA)
-                && (endpoint->port == tep->sep.endpoint.port))
-        {
-            u_arraylist_remove(g_caSslContext->peerList, listIndex);
-            DeleteSslEndPoint(tep);
-            return;
-        }
+        DeleteSslEndPoint(tep);
     }
 }
 /**
- * Deletes session list.
+ * Adds endpoint session to the list and the peer table.
+ * The caller holds g_sslContextMutex.
+ *
+ * @param[in]  tep    TLS session
+ *
+ * @return  true on success
+ */
+static bool AddPeerToList(SslEndPoint_t * tep)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Add %s:%d", tep->sep.endpoint.addr, tep->sep.endpoint.port);
+    if (!u_arraylist_add(g_caSslContext->peerList, (void *) tep))
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
+        return false;
+    }
+
+    SslEndPoint_t ** bucket = &g_sslPeerTable[tep->hash & (SSL_PEER_HASH_SIZE - 1)];
+    oc_mutex mutex = GetPeerTableMutex(tep->hash);
+    oc_mutex_lock(mutex);
+    tep->hashNext = *bucket;
+    *bucket = tep;
+    tep->refCount++;
+    oc_mutex_unlock(mutex);
+    return true;
+}
+/**
+ * Takes endpoint session out of the peer table and drops the table reference.
+ * The caller holds g_sslContextMutex, the mutex of the session and a reference,
+ * and has already removed the session from the peer list.
+ *
+ * @param[in]  tep    TLS session
+ */
+static void UnlinkSslPeer(SslEndPoint_t * tep)
+{
+    SslEndPoint_t ** link = &g_sslPeerTable[tep->hash & (SSL_PEER_HASH_SIZE - 1)];
+    oc_mutex mutex = GetPeerTableMutex(tep->hash);
+    oc_mutex_lock(mutex);
+    while (NULL != *link && tep != *link)
+    {
+        link = &(*link)->hashNext;
+    }
+    if (NULL != *link)
+    {
+        *link = tep->hashNext;
+    }
+    tep->hashNext = NULL;
+    tep->refCount--;
+    oc_mutex_unlock(mutex);
+
+    tep->removed = true;
+}
+/**
+ * Removes endpoint session from list.
+ * The caller holds g_sslContextMutex, the mutex of the session and a reference.
+ *
+ * @param[in]  tep    TLS session
+ */
+static void RemovePeerFromList(SslEndPoint_t * tep)
+{
+    VERIFY_NON_NULL_VOID(tep, NET_SSL_TAG, "tep");
+    if (tep->removed)
+    {
+        return;
+    }
+    VERIFY_NON_NULL_VOID(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL");
+
+    uint32_t listIndex = 0;
+    if (u_arraylist_get_index(g_caSslContext->peerList, tep, &listIndex))
+    {
+        u_arraylist_remove(g_caSslContext->peerList, listIndex);
+    }
+    UnlinkSslPeer(tep);
+}
+/**
+ * Removes endpoint session from list.  For callers that only hold a reference.
+ *
+ * @param[in]  tep    TLS session
+ */
+static void RemoveSslPeer(SslEndPoint_t * tep)
+{
+    oc_mutex_lock(g_sslContextMutex);
+    oc_mutex_lock(tep->mutex);
+    RemovePeerFromList(tep);
+    oc_mutex_unlock(tep->mutex);
+    oc_mutex_unlock(g_sslContextMutex);
+}
+/**
+ * Deletes session list.
  */
 static void DeletePeerList()
 {
@@ -1122,6 +1585,9 @@ static void DeletePeerList()
         {
             continue;
         }
+        RetainSslPeer(tep);
+        // waits for records in progress on this session
+        oc_mutex_lock(tep->mutex);
         if (MBEDTLS_SSL_HANDSHAKE_OVER == tep->ssl.state)
         {
             int ret = 0;
@@ -1131,7 +1597,9 @@ static void DeletePeerList()
             }
             while (MBEDTLS_ERR_SSL_WANT_WRITE == ret);
         }
-        DeleteSslEndPoint(tep);
+        UnlinkSslPeer(tep);
+        oc_mutex_unlock(tep->mutex);
+        ReleaseSslPeer(tep);
     }
     u_arraylist_free(&g_caSslContext->peerList);
 }
@@ -1148,13 +1616,14 @@ CAResult_t CAcloseSslConnection(const CAEndpoint_t *endpoint)
         oc_mutex_unlock(g_sslContextMutex);
         return CA_STATUS_FAILED;
     }
-    SslEndPoint_t * tep = GetSslPeer(endpoint);
+    SslEndPoint_t * tep = AcquireSslPeer(endpoint);
     if (NULL == tep)
     {
         OIC_LOG(ERROR, NET_SSL_TAG, "Session does not exist");
         oc_mutex_unlock(g_sslContextMutex);
         return CA_STATUS_FAILED;
     }
+    oc_mutex_lock(tep->mutex);
     /* No error checking, the connection might be closed already */
     int ret = 0;
     do
@@ -1163,8 +1632,10 @@ CAResult_t CAcloseSslConnection(const CAEndpoint_t *endpoint)
     }
     while (MBEDTLS_ERR_SSL_WANT_WRITE == ret);
 
-    RemovePeerFromList(&tep->sep.endpoint);
+    RemovePeerFromList(tep);
+    oc_mutex_unlock(tep->mutex);
     oc_mutex_unlock(g_sslContextMutex);
+    ReleaseSslPeer(tep);
 
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
     return CA_STATUS_OK;
@@ -1210,8 +1681,12 @@ void CAcloseSslConnectionAll(CATransportAdapter_t transportType)
         while (MBEDTLS_ERR_SSL_WANT_WRITE == ret);*/
 
         // delete from list
+        RetainSslPeer(tep);
+        oc_mutex_lock(tep->mutex);
         u_arraylist_remove(g_caSslContext->peerList, i - 1);
-        DeleteSslEndPoint(tep);
+        UnlinkSslPeer(tep);
+        oc_mutex_unlock(tep->mutex);
+        ReleaseSslPeer(tep);
     }
     oc_mutex_unlock(g_sslContextMutex);
 
@@ -1259,7 +1734,7 @@ static SslEndPoint_t * NewSslEndPoint(const CAEndpoint_t * endpoint, mbedtls_ssl
                                   mbedtls_timing_set_delay, mbedtls_timing_get_delay);
         if (MBEDTLS_SSL_IS_SERVER == config->endpoint)
         {
-            if (0 != mbedtls_ssl_cookie_setup(&tep->cookieCtx, mbedtls_ctr_drbg_random,
+            if (0 != mbedtls_ssl_cookie_setup(&tep->cookieCtx, SslRandom,
                                               &g_caSslContext->rnd))
             {
                 OIC_LOG(ERROR, NET_SSL_TAG, "Cookie setup failed!");
@@ -1288,6 +1763,15 @@ static SslEndPoint_t * NewSslEndPoint(const CAEndpoint_t * endpoint, mbedtls_ssl
         OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
         return NULL;
     }
+    tep->mutex = oc_mutex_new();
+    if (NULL == tep->mutex)
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "mutex initialization failed!");
+        DeleteSslEndPoint(tep);
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+        return NULL;
+    }
+    tep->hash = HashSslPeer(endpoint);
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
     return tep;
 }
@@ -1369,12 +1853,168 @@ static void SetupCipher(mbedtls_ssl_config * config, CATransportAdapter_t adapte
 
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
 }
+/**
+ * Checks whether a session may be resumed later.
+ * With PSK and anonymous suites the peer's identity is only learned during a full
+ * handshake, so only certificate based sessions are resumed.
+ *
+ * @param[in] session  negotiated session
+ *
+ * @return  true if the session can be cached
+ */
+static bool IsResumableSession(const mbedtls_ssl_session * session)
+{
+    return MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256 != session->ciphersuite &&
+           MBEDTLS_TLS_ECDH_ANON_WITH_AES_128_CBC_SHA256 != session->ciphersuite;
+}
+#ifdef MBEDTLS_SSL_CACHE_C
+/**
+ * Server session cache store callback, skipping sessions that cannot be resumed.
+ */
+static int SslCacheSet(void * data, const mbedtls_ssl_session * session)
+{
+    if (!IsResumableSession(session))
+    {
+        return -1;
+    }
+    return mbedtls_ssl_cache_set(data, session);
+}
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+/**
+ * Session ticket write callback.  An error makes mbedTLS send an empty ticket.
+ */
+static int SslTicketWrite(void * p_ticket, const mbedtls_ssl_session * session,
+                          unsigned char * start, const unsigned char * end,
+                          size_t * tlen, uint32_t * lifetime)
+{
+    if (!IsResumableSession(session))
+    {
+        return -1;
+    }
+    return mbedtls_ssl_ticket_write(p_ticket, session, start, end, tlen, lifetime);
+}
+#endif
+/**
+ * Looks up the stored client session for a server endpoint.
+ * Servers are matched by device ID when it is known, by address otherwise.
+ * Caller must hold g_sslContextMutex.
+ *
+ * @param[in]  endpoint    remote address
+ *
+ * @return  stored session or NULL
+ */
+static SslClientSession_t * GetClientSession(const CAEndpoint_t * endpoint)
+{
+    for (size_t i = 0; i < SSL_SESSION_CACHE_SIZE; i++)
+    {
+        SslClientSession_t * entry = &g_caSslContext->clientSessions[i];
+        if (0 == entry->expires || endpoint->adapter != entry->adapter)
+        {
+            continue;
+        }
+        if ('\0' != endpoint->remoteId[0])
+        {
+            if (0 == strncmp(endpoint->remoteId, entry->remoteId, CA_MAX_IDENTITY_SIZE))
+            {
+                return entry;
+            }
+        }
+        else if (0 == strncmp(endpoint->addr, entry->addr, MAX_ADDR_STR_SIZE_CA)
+                 && (CA_ADAPTER_GATT_BTLE == endpoint->adapter || endpoint->port == entry->port))
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+/**
+ * Drops the stored client session for a server endpoint, if any.
+ * Caller must hold g_sslContextMutex.
+ *
+ * @param[in]  endpoint    remote address
+ */
+static void DeleteClientSession(const CAEndpoint_t * endpoint)
+{
+    SslClientSession_t * entry = GetClientSession(endpoint);
+    if (NULL != entry)
+    {
+        FreeClientSession(entry);
+    }
+}
+/**
+ * Offers the stored session of the server to the new handshake.
+ * Caller must hold g_sslContextMutex.
+ *
+ * @param[in]  tep    TLS endpoint, not yet handshaking
+ */
+static void LoadClientSession(SslEndPoint_t * tep)
+{
+    SslClientSession_t * entry = GetClientSession(&tep->sep.endpoint);
+    if (NULL == entry)
+    {
+        return;
+    }
+    if (entry->expires <= OICGetCurrentTime(TIME_IN_MS))
+    {
+        FreeClientSession(entry);
+        return;
+    }
+    if (0 != mbedtls_ssl_set_session(&tep->ssl, &entry->session))
+    {
+        OIC_LOG(WARNING, NET_SSL_TAG, "Failed to set stored session");
+        return;
+    }
+    OIC_LOG(DEBUG, NET_SSL_TAG, "Resuming stored session");
+}
+/**
+ * Stores the session of a completed client handshake for later resumption.
+ * The oldest entry is replaced when the store is full.
+ * Caller must hold g_sslContextMutex.
+ *
+ * @param[in]  tep    TLS endpoint, handshake over
+ */
+static void SaveClientSession(SslEndPoint_t * tep)
+{
+    if (!IsResumableSession(tep->ssl.session))
+    {
+        return;
+    }
+    const CAEndpoint_t * endpoint = &tep->sep.endpoint;
+    SslClientSession_t * entry = GetClientSession(endpoint);
+    if (NULL == entry)
+    {
+        entry = &g_caSslContext->clientSessions[0];
+        for (size_t i = 1; i < SSL_SESSION_CACHE_SIZE && 0 != entry->expires; i++)
+        {
+            SslClientSession_t * candidate = &g_caSslContext->clientSessions[i];
+            if (candidate->expires < entry->expires)
+            {
+                entry = candidate;
+            }
+        }
+    }
+    FreeClientSession(entry);
+
+    mbedtls_ssl_session_init(&entry->session);
+    if (0 != mbedtls_ssl_get_session(&tep->ssl, &entry->session))
+    {
+        OIC_LOG(WARNING, NET_SSL_TAG, "Failed to store session");
+        mbedtls_ssl_session_free(&entry->session);
+        return;
+    }
+    entry->adapter = endpoint->adapter;
+    OICStrcpy(entry->addr, sizeof(entry->addr), endpoint->addr);
+    entry->port = endpoint->port;
+    OICStrcpy(entry->remoteId, sizeof(entry->remoteId), endpoint->remoteId);
+    entry->expires = OICGetCurrentTime(TIME_IN_MS) + (uint64_t) SSL_SESSION_LIFETIME * 1000;
+}
 /**
  * Initiate TLS handshake with endpoint.
  *
  * @param[in]  endpoint    remote address
  *
- * @return  TLS endpoint or NULL
+ * @return  TLS endpoint, locked and with a reference for the caller, or NULL
  */
 static SslEndPoint_t * InitiateTlsHandshake(const CAEndpoint_t *endpoint)
 {
@@ -1397,15 +2037,15 @@ static SslEndPoint_t * InitiateTlsHandshake(const CAEndpoint_t *endpoint)
 
     //Load allowed SVR suites from SVR DB
     SetupCipher(config, endpoint->adapter);
+    LoadClientSession(tep);
 
-    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Add %s:%d", tep->sep.endpoint.addr, tep->sep.endpoint.port);
-    ret = u_arraylist_add(g_caSslContext->peerList, (void *) tep);
-    if (!ret)
+    if (!AddPeerToList(tep))
     {
-        OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
         DeleteSslEndPoint(tep);
         return NULL;
     }
+    RetainSslPeer(tep);
+    oc_mutex_lock(tep->mutex);
 
     while (MBEDTLS_SSL_HANDSHAKE_OVER > tep->ssl.state)
     {
@@ -1417,7 +2057,9 @@ static SslEndPoint_t * InitiateTlsHandshake(const CAEndpoint_t *endpoint)
         else if (-1 == ret)
         {
             OIC_LOG(ERROR, NET_SSL_TAG, "Handshake failed due to socket error");
-            RemovePeerFromList(&tep->sep.endpoint);
+            RemovePeerFromList(tep);
+            oc_mutex_unlock(tep->mutex);
+            ReleaseSslPeer(tep);
             return NULL;
         }
         SSL_CHECK_FAIL(tep, ret, "Handshake error", 0, NULL, MBEDTLS_SSL_ALERT_MSG_HANDSHAKE_FAILURE);
@@ -1438,6 +2080,76 @@ static void StopRetransmit()
     }
 }
 #endif
+/**
+ * Frees the RNG, peer table and handshake thread locks.
+ */
+static void FreePeerTableLocks()
+{
+    for (size_t i = 0; i < SSL_PEER_LOCK_COUNT; i++)
+    {
+        if (NULL != g_sslPeerTableMutex[i])
+        {
+            oc_mutex_free(g_sslPeerTableMutex[i]);
+            g_sslPeerTableMutex[i] = NULL;
+        }
+    }
+    if (NULL != g_sslRngMutex)
+    {
+        oc_mutex_free(g_sslRngMutex);
+        g_sslRngMutex = NULL;
+    }
+    if (NULL != g_sslHandshakeMutex)
+    {
+        oc_mutex_free(g_sslHandshakeMutex);
+        g_sslHandshakeMutex = NULL;
+    }
+}
+/**
+ * Creates the RNG, peer table and handshake thread locks.
+ *
+ * @return  true on success
+ */
+static bool NewPeerTableLocks()
+{
+    g_sslRngMutex = oc_mutex_new();
+    if (NULL == g_sslRngMutex)
+    {
+        return false;
+    }
+    g_sslHandshakeMutex = oc_mutex_new();
+    if (NULL == g_sslHandshakeMutex)
+    {
+        FreePeerTableLocks();
+        return false;
+    }
+    for (size_t i = 0; i < SSL_PEER_LOCK_COUNT; i++)
+    {
+        g_sslPeerTableMutex[i] = oc_mutex_new();
+        if (NULL == g_sslPeerTableMutex[i])
+        {
+            FreePeerTableLocks();
+            return false;
+        }
+    }
+    return true;
+}
+/**
+ * Stops the handshake thread.  Queued records are dropped.
+ */
+static void StopHandshakeThread()
+{
+    oc_mutex_lock(g_sslHandshakeMutex);
+    CAAtomicStore32(&g_sslAsyncHandshake, 0);
+    if (NULL != g_sslHandshakePool)
+    {
+        // the thread may be waiting for g_sslContextMutex, which must not be held here
+        CAQueueingThreadStop(&g_sslHandshakeThread);
+        CAQueueingThreadDestroy(&g_sslHandshakeThread);
+        ca_thread_pool_free(g_sslHandshakePool);
+        g_sslHandshakePool = NULL;
+    }
+    oc_mutex_unlock(g_sslHandshakeMutex);
+}
 void CAdeinitSslAdapter()
 {
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
@@ -1445,6 +2157,8 @@ void CAdeinitSslAdapter()
     VERIFY_NON_NULL_VOID(g_caSslContext, NET_SSL_TAG, "context is NULL");
     VERIFY_NON_NULL_VOID(g_sslContextMutex, NET_SSL_TAG, "context mutex is NULL");
 
+    StopHandshakeThread();
+
     //Lock tlsContext mutex
     oc_mutex_lock(g_sslContextMutex);
 
@@ -1462,6 +2176,13 @@ void CAdeinitSslAdapter()
     mbedtls_ssl_config_free(&g_caSslContext->clientDtlsConf);
     mbedtls_ssl_config_free(&g_caSslContext->serverDtlsConf);
 #endif // __WITH_DTLS__
+    DeleteClientSessions();
+#ifdef MBEDTLS_SSL_CACHE_C
+    mbedtls_ssl_cache_free(&g_caSslContext->sessionCache);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+    mbedtls_ssl_ticket_free(&g_caSslContext->ticketCtx);
+#endif
     mbedtls_ctr_drbg_free(&g_caSslContext->rnd);
     mbedtls_entropy_free(&g_caSslContext->entropy);
 #ifdef __WITH_DTLS__
@@ -1475,6 +2196,7 @@ void CAdeinitSslAdapter()
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
     g_sslContextMutex = NULL;
+    FreePeerTableLocks();
 
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s ", __func__);
 }
@@ -1496,13 +2218,32 @@ static int InitConfig(mbedtls_ssl_config * conf, int transport, int mode)
      * time, see extlibs/mbedtls/config-iotivity.h
      */
     mbedtls_ssl_conf_psk_cb(conf, GetPskCredentialsCallback, NULL);
-    mbedtls_ssl_conf_rng(conf, mbedtls_ctr_drbg_random, &g_caSslContext->rnd);
+    mbedtls_ssl_conf_rng(conf, SslRandom, &g_caSslContext->rnd);
     mbedtls_ssl_conf_curves(conf, curve[ADAPTER_CURVE_SECP256R1]);
     mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_REQUIRED);
 
     /* Set TLS 1.2 as the minimum allowed version. */
     mbedtls_ssl_conf_min_version(conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
 
+    /* Session resumption: session ID cache and tickets on the server side. */
+    if (MBEDTLS_SSL_IS_SERVER == mode)
+    {
+#ifdef MBEDTLS_SSL_CACHE_C
+        mbedtls_ssl_conf_session_cache(conf, &g_caSslContext->sessionCache,
+                                       mbedtls_ssl_cache_get, SslCacheSet);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+        mbedtls_ssl_conf_session_tickets_cb(conf, SslTicketWrite, mbedtls_ssl_ticket_parse,
+                                            &g_caSslContext->ticketCtx);
+#endif
+    }
+#ifdef MBEDTLS_SSL_SESSION_TICKETS
+    else
+    {
+        mbedtls_ssl_conf_session_tickets(conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    }
+#endif
+
 #if !defined(NDEBUG) || defined(TB_LOG)
     mbedtls_ssl_conf_dbg(conf, DebugSsl, NULL);
 #if defined(MBEDTLS_DEBUG_C)
@@ -1540,9 +2281,16 @@ static int StartRetransmit()
         {
             tep = (SslEndPoint_t *) u_arraylist_get(g_caSslContext->peerList, listIndex);
             if (NULL == tep
-                || (tep->ssl.conf && MBEDTLS_SSL_TRANSPORT_STREAM == tep->ssl.conf->transport)
-                || MBEDTLS_SSL_HANDSHAKE_OVER == tep->ssl.state)
+                || (tep->ssl.conf && MBEDTLS_SSL_TRANSPORT_STREAM == tep->ssl.conf->transport))
+            {
+                continue;
+            }
+            RetainSslPeer(tep);
+            oc_mutex_lock(tep->mutex);
+            if (MBEDTLS_SSL_HANDSHAKE_OVER == tep->ssl.state)
             {
+                oc_mutex_unlock(tep->mutex);
+                ReleaseSslPeer(tep);
                 continue;
             }
             int ret = mbedtls_ssl_handshake_step(&tep->ssl);
@@ -1555,6 +2303,8 @@ static int StartRetransmit()
                 SSL_CHECK_FAIL(tep, ret, "Retransmission", 1, CA_STATUS_FAILED,
                 MBEDTLS_SSL_ALERT_MSG_HANDSHAKE_FAILURE);
             }
+            oc_mutex_unlock(tep->mutex);
+            ReleaseSslPeer(tep);
         }
     }
     //start new timer
@@ -1572,6 +2322,13 @@ CAResult_t CAinitSslAdapter()
     {
         g_sslContextMutex = oc_mutex_new();
         VERIFY_NON_NULL_RET(g_sslContextMutex, NET_SSL_TAG, "malloc failed", CA_MEMORY_ALLOC_FAILED);
+        if (!NewPeerTableLocks())
+        {
+            OIC_LOG(ERROR, NET_SSL_TAG, "Peer table locks initialization failed!");
+            oc_mutex_free(g_sslContextMutex);
+            g_sslContextMutex = NULL;
+            return CA_MEMORY_ALLOC_FAILED;
+        }
     }
     else
     {
@@ -1589,6 +2346,7 @@ CAResult_t CAinitSslAdapter()
         oc_mutex_unlock(g_sslContextMutex);
         oc_mutex_free(g_sslContextMutex);
         g_sslContextMutex = NULL;
+        FreePeerTableLocks();
         return CA_MEMORY_ALLOC_FAILED;
     }
 
@@ -1603,6 +2361,7 @@ CAResult_t CAinitSslAdapter()
         oc_mutex_unlock(g_sslContextMutex);
         oc_mutex_free(g_sslContextMutex);
         g_sslContextMutex = NULL;
+        FreePeerTableLocks();
         return CA_STATUS_FAILED;
     }
 
@@ -1634,6 +2393,25 @@ CAResult_t CAinitSslAdapter()
     }
     mbedtls_ctr_drbg_set_prediction_resistance(&g_caSslContext->rnd, MBEDTLS_CTR_DRBG_PR_ON);
 
+    /* Session resumption
+     */
+#ifdef MBEDTLS_SSL_CACHE_C
+    mbedtls_ssl_cache_init(&g_caSslContext->sessionCache);
+    mbedtls_ssl_cache_set_timeout(&g_caSslContext->sessionCache, SSL_SESSION_LIFETIME);
+    mbedtls_ssl_cache_set_max_entries(&g_caSslContext->sessionCache, SSL_SESSION_CACHE_SIZE);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+    mbedtls_ssl_ticket_init(&g_caSslContext->ticketCtx);
+    if (0 != mbedtls_ssl_ticket_setup(&g_caSslContext->ticketCtx, SslRandom, &g_caSslContext->rnd,
+                                      MBEDTLS_CIPHER_AES_256_GCM, SSL_SESSION_LIFETIME))
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Session ticket initialization failed!");
+        oc_mutex_unlock(g_sslContextMutex);
+        CAdeinitSslAdapter();
+        return CA_STATUS_FAILED;
+    }
+#endif
+
 #ifdef __WITH_TLS__
     if (0 != InitConfig(&g_caSslContext->clientTlsConf,
                         MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_IS_CLIENT))
@@ -1731,13 +2509,44 @@ SslCacheMessage_t *  NewCacheMessage(uint8_t * data, size_t dataLen)
     return message;
 }
 
+/**
+ * Writes data to an established session.  The caller holds the mutex of tep.
+ *
+ * @param[in]  tep    remote address with session info
+ * @param[in]  data    data to be encrypted
+ * @param[in]  dataLen    length of data
+ *
+ * @return  CA_STATUS_OK or CA_STATUS_FAILED
+ */
+static CAResult_t SslWrite(SslEndPoint_t * tep, const unsigned char * data, size_t dataLen)
+{
+    size_t written = 0;
+
+    do
+    {
+        int ret = mbedtls_ssl_write(&tep->ssl, data + written, dataLen - written);
+        if (ret < 0)
+        {
+            if (MBEDTLS_ERR_SSL_WANT_WRITE != ret)
+            {
+                OIC_LOG_V(ERROR, NET_SSL_TAG, "mbedTLS write failed! returned -0x%x", -ret);
+                return CA_STATUS_FAILED;
+            }
+            continue;
+        }
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "mbedTLS write returned with sent bytes[%d]", ret);
+
+        written += ret;
+    } while (dataLen > written);
+
+    return CA_STATUS_OK;
+}
+
 /* Send data via TLS connection.
  */
 CAResult_t CAencryptSsl(const CAEndpoint_t *endpoint,
                         void *data, uint32_t dataLen)
 {
-    int ret = 0;
-
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s ", __func__);
 
     VERIFY_NON_NULL_RET(endpoint, NET_SSL_TAG,"Remote address is NULL", CA_STATUS_INVALID_PARAM);
@@ -1752,6 +2561,27 @@ CAResult_t CAencryptSsl(const CAEndpoint_t *endpoint,
 
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Data to be encrypted dataLen [%d]", dataLen);
 
+    // Established session: only its own mutex is needed
+    SslEndPoint_t * tep = AcquireSslPeer(endpoint);
+    if (NULL != tep)
+    {
+        oc_mutex_lock(tep->mutex);
+        if (!tep->removed && MBEDTLS_SSL_HANDSHAKE_OVER == tep->ssl.state)
+        {
+            CAResult_t res = SslWrite(tep, (const unsigned char *) data, dataLen);
+            oc_mutex_unlock(tep->mutex);
+            if (CA_STATUS_OK != res)
+            {
+                RemoveSslPeer(tep);
+            }
+            ReleaseSslPeer(tep);
+            OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+            return res;
+        }
+        oc_mutex_unlock(tep->mutex);
+        ReleaseSslPeer(tep);
+    }
+
     oc_mutex_lock(g_sslContextMutex);
     if(NULL == g_caSslContext)
     {
@@ -1760,8 +2590,12 @@ CAResult_t CAencryptSsl(const CAEndpoint_t *endpoint,
         return CA_STATUS_FAILED;
     }
 
-    SslEndPoint_t * tep = GetSslPeer(endpoint);
-    if (NULL == tep)
+    tep = AcquireSslPeer(endpoint);
+    if (NULL != tep)
+    {
+        oc_mutex_lock(tep->mutex);
+    }
+    else
     {
         tep = InitiateTlsHandshake(endpoint);
     }
@@ -1772,31 +2606,14 @@ CAResult_t CAencryptSsl(const CAEndpoint_t *endpoint,
         return CA_STATUS_FAILED;
     }
 
+    CAResult_t res = CA_STATUS_OK;
     if (MBEDTLS_SSL_HANDSHAKE_OVER == tep->ssl.state)
     {
-        unsigned char *dataBuf = (unsigned char *)data;
-        size_t written = 0;
-
-        do
+        res = SslWrite(tep, (const unsigned char *) data, dataLen);
+        if (CA_STATUS_OK != res)
         {
-            ret = mbedtls_ssl_write(&tep->ssl, dataBuf, dataLen - written);
-            if (ret < 0)
-            {
-                if (MBEDTLS_ERR_SSL_WANT_WRITE != ret)
-                {
-                    OIC_LOG_V(ERROR, NET_SSL_TAG, "mbedTLS write failed! returned 0x%x", -ret);
-                    RemovePeerFromList(&tep->sep.endpoint);
-                    oc_mutex_unlock(g_sslContextMutex);
-                    return CA_STATUS_FAILED;
-                }
-                continue;
-            }
-            OIC_LOG_V(DEBUG, NET_SSL_TAG, "mbedTLS write returned with sent bytes[%d]", ret);
-
-            dataBuf += ret;
-            written += ret;
-        } while (dataLen > written);
-
+            RemovePeerFromList(tep);
+        }
     }
     else
     {
@@ -1804,15 +2621,16 @@ CAResult_t CAencryptSsl(const CAEndpoint_t *endpoint,
         if (NULL == msg || !u_arraylist_add(tep->cacheList, (void *) msg))
         {
             OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
-            oc_mutex_unlock(g_sslContextMutex);
-            return CA_STATUS_FAILED;
+            res = CA_STATUS_FAILED;
         }
     }
 
+    oc_mutex_unlock(tep->mutex);
     oc_mutex_unlock(g_sslContextMutex);
+    ReleaseSslPeer(tep);
 
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
-    return CA_STATUS_OK;
+    return res;
 }
 /**
  * Sends cached messages via TLS connection.
@@ -1829,30 +2647,10 @@ static void SendCacheMessages(SslEndPoint_t * tep)
     listLength = u_arraylist_length(tep->cacheList);
     for (listIndex = 0; listIndex < listLength;)
     {
-        int ret = 0;
         SslCacheMessage_t * msg = (SslCacheMessage_t *) u_arraylist_get(tep->cacheList, listIndex);
         if (NULL != msg && NULL != msg->data && 0 != msg->len)
         {
-            unsigned char *dataBuf = (unsigned char *)msg->data;
-            size_t written = 0;
-
-            do
-            {
-                ret = mbedtls_ssl_write(&tep->ssl, dataBuf, msg->len - written);
-                if (ret < 0)
-                {
-                    if (MBEDTLS_ERR_SSL_WANT_WRITE != ret)
-                    {
-                        OIC_LOG_V(ERROR, NET_SSL_TAG, "mbedTLS write failed! returned -0x%x", -ret);
-                        break;
-                    }
-                    continue;
-                }
-                OIC_LOG_V(DEBUG, NET_SSL_TAG, "mbedTLS write returned with sent bytes[%d]", ret);
-
-                dataBuf += ret;
-                written += ret;
-            } while (msg->len > written);
+            SslWrite(tep, msg->data, msg->len);
 
             if (u_arraylist_remove(tep->cacheList, listIndex))
             {
@@ -1882,14 +2680,74 @@ void CAsetSslHandshakeCallback(CAErrorCallback tlsHandshakeCallback)
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s(%p)", __func__, tlsHandshakeCallback);
 }
 
-/* Read data from TLS connection
+/**
+ * Reads a record of an established session and passes the data to the adapter.
+ * The caller holds the mutex of peer and has loaded recBuf.
+ *
+ * @param[in]  peer    remote address with session info
+ * @param[out] remove    set if the session has to be removed
+ *
+ * @return  CA_STATUS_OK or CA_STATUS_FAILED
  */
-CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, uint32_t dataLen)
+static CAResult_t DecryptSslRecord(SslEndPoint_t * peer, bool * remove)
 {
+    uint8_t decryptBuffer[TLS_MSG_BUF_LEN] = {0};
     int ret = 0;
-    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
-    VERIFY_NON_NULL_RET(sep, NET_SSL_TAG, "endpoint is NULL" , CA_STATUS_INVALID_PARAM);
-    VERIFY_NON_NULL_RET(data, NET_SSL_TAG, "Param data is NULL" , CA_STATUS_INVALID_PARAM);
+    do
+    {
+        ret = mbedtls_ssl_read(&peer->ssl, decryptBuffer, TLS_MSG_BUF_LEN);
+    } while (MBEDTLS_ERR_SSL_WANT_READ == ret);
+
+    if (MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY == ret ||
+        // TinyDTLS sends fatal close_notify alert
+        (MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE == ret &&
+         MBEDTLS_SSL_ALERT_LEVEL_FATAL == peer->ssl.in_msg[0] &&
+         MBEDTLS_SSL_ALERT_MSG_CLOSE_NOTIFY == peer->ssl.in_msg[1]))
+    {
+        OIC_LOG(INFO, NET_SSL_TAG, "Connection was closed gracefully");
+        *remove = true;
+        return CA_STATUS_OK;
+    }
+
+    if (0 > ret)
+    {
+        OIC_LOG_V(ERROR, NET_SSL_TAG, "mbedtls_ssl_read returned -0x%x", -ret);
+        //SSL_RES(peer, CA_STATUS_FAILED);
+        *remove = true;
+        return CA_STATUS_FAILED;
+    }
+    else if (0 < ret)
+    {
+        int adapterIndex = GetAdapterIndex(peer->sep.endpoint.adapter);
+        if (0 <= adapterIndex && MAX_SUPPORTED_ADAPTERS > adapterIndex)
+        {
+            g_caSslContext->adapterCallbacks[adapterIndex].recvCallback(&peer->sep, decryptBuffer, ret);
+        }
+        else
+        {
+            OIC_LOG(ERROR, NET_SSL_TAG, "Unsuported adapter");
+            *remove = true;
+            return CA_STATUS_FAILED;
+        }
+    }
+    return CA_STATUS_OK;
+}
+
+/**
+ * Feeds a record to a session in handshake, creating the session for a new peer.
+ * Handshakes are serialized by g_sslContextMutex.
+ *
+ * @param[in]  sep         remote address
+ * @param[in]  data        received record
+ * @param[in]  dataLen     record length
+ *
+ * @return  CA_STATUS_OK or an error code
+ */
+static CAResult_t DecryptSslHandshake(const CASecureEndpoint_t *sep, uint8_t *data,
+                                      uint32_t dataLen)
+{
+    int ret = 0;
+    SslEndPoint_t * peer = NULL;
 
     oc_mutex_lock(g_sslContextMutex);
     if (NULL == g_caSslContext)
@@ -1899,8 +2757,7 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, uint32_t d
         return CA_STATUS_FAILED;
     }
 
-
-    SslEndPoint_t * peer = GetSslPeer(&sep->endpoint);
+    peer = AcquireSslPeer(&sep->endpoint);
     if (NULL == peer)
     {
         mbedtls_ssl_config * config = (sep->endpoint.adapter == CA_ADAPTER_IP ||
@@ -1916,16 +2773,16 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, uint32_t d
         //Load allowed TLS suites from SVR DB
         SetupCipher(config, sep->endpoint.adapter);
 
-        ret = u_arraylist_add(g_caSslContext->peerList, (void *) peer);
-        if (!ret)
+        if (!AddPeerToList(peer))
         {
-            OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
-            OICFree(peer);
+            DeleteSslEndPoint(peer);
             oc_mutex_unlock(g_sslContextMutex);
             return CA_STATUS_FAILED;
         }
+        RetainSslPeer(peer);
     }
 
+    oc_mutex_lock(peer->mutex);
     peer->recBuf.buff = data;
     peer->recBuf.len = dataLen;
     peer->recBuf.loaded = 0;
@@ -1959,6 +2816,12 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, uint32_t d
         {
             memcpy(peer->master, peer->ssl.session_negotiate->master, sizeof(peer->master));
             g_caSslContext->selectedCipher = peer->ssl.session_negotiate->ciphersuite;
+            if (peer->ssl.handshake->resume)
+            {
+                // No key exchange when resuming; the randoms have been swapped by now
+                memcpy(peer->random, peer->ssl.handshake->randbytes + RANDOM_LEN, RANDOM_LEN);
+                memcpy(peer->random + RANDOM_LEN, peer->ssl.handshake->randbytes, RANDOM_LEN);
+            }
         }
         if (MBEDTLS_SSL_CLIENT_KEY_EXCHANGE == peer->ssl.state)
         {
@@ -2015,61 +2878,189 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, uint32_t d
                     OIC_LOG(WARNING, NET_SSL_TAG, "Subject alternative name not found");
                 }
             }
+            if (MBEDTLS_SSL_IS_CLIENT == peer->ssl.conf->endpoint)
+            {
+                SaveClientSession(peer);
+            }
 
+            oc_mutex_unlock(peer->mutex);
             oc_mutex_unlock(g_sslContextMutex);
+            ReleaseSslPeer(peer);
             OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
             return CA_STATUS_OK;
         }
     }
 
+    CAResult_t res = CA_STATUS_OK;
     if (MBEDTLS_SSL_HANDSHAKE_OVER == peer->ssl.state)
     {
-        uint8_t decryptBuffer[TLS_MSG_BUF_LEN] = {0};
-        do
+        bool remove = false;
+        res = DecryptSslRecord(peer, &remove);
+        if (remove)
         {
-            ret = mbedtls_ssl_read(&peer->ssl, decryptBuffer, TLS_MSG_BUF_LEN);
-        } while (MBEDTLS_ERR_SSL_WANT_READ == ret);
-
-        if (MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY == ret ||
-            // TinyDTLS sends fatal close_notify alert
-            (MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE == ret &&
-             MBEDTLS_SSL_ALERT_LEVEL_FATAL == peer->ssl.in_msg[0] &&
-             MBEDTLS_SSL_ALERT_MSG_CLOSE_NOTIFY == peer->ssl.in_msg[1]))
-        {
-            OIC_LOG(INFO, NET_SSL_TAG, "Connection was closed gracefully");
-            RemovePeerFromList(&peer->sep.endpoint);
-            oc_mutex_unlock(g_sslContextMutex);
-            return CA_STATUS_OK;
+            RemovePeerFromList(peer);
         }
+    }
 
-        if (0 > ret)
-        {
-            OIC_LOG_V(ERROR, NET_SSL_TAG, "mbedtls_ssl_read returned -0x%x", -ret);
-            //SSL_RES(peer, CA_STATUS_FAILED);
-            RemovePeerFromList(&peer->sep.endpoint);
-            oc_mutex_unlock(g_sslContextMutex);
-            return CA_STATUS_FAILED;
-        }
-        else if (0 < ret)
+    oc_mutex_unlock(peer->mutex);
+    oc_mutex_unlock(g_sslContextMutex);
+    ReleaseSslPeer(peer);
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+    return res;
+}
+
+/**
+ * Handshake thread task.
+ *
+ * @param[in]  data    queued SslHandshakeRecord_t
+ */
+static void SslHandshakeTask(void * data)
+{
+    SslHandshakeRecord_t * record = (SslHandshakeRecord_t *) data;
+    CAResult_t res = DecryptSslHandshake(&record->sep, record->data, record->dataLen);
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Queued handshake record processed: %d", res);
+}
+/**
+ * Frees a record queued to the handshake thread.
+ */
+static void FreeSslHandshakeRecord(void * data, uint32_t size)
+{
+    (void) size;
+    OICFree(data);
+}
+/**
+ * Hands a DTLS record over to the handshake thread when asynchronous handshakes are on.
+ * A full queue drops the record; the peer retransmits it.
+ *
+ * @param[in]  sep         remote address
+ * @param[in]  data        received record
+ * @param[in]  dataLen     record length
+ *
+ * @return  true if the record is taken care of, false to process it in place
+ */
+static bool QueueSslHandshake(const CASecureEndpoint_t *sep, const uint8_t *data,
+                              uint32_t dataLen)
+{
+    // TLS stays inline: the TCP adapter closes the connection on a failed handshake
+    if (0 == CAAtomicLoad32(&g_sslAsyncHandshake) ||
+        (CA_ADAPTER_IP != sep->endpoint.adapter && CA_ADAPTER_GATT_BTLE != sep->endpoint.adapter))
+    {
+        return false;
+    }
+
+    SslHandshakeRecord_t * record =
+        (SslHandshakeRecord_t *) OICMalloc(sizeof(SslHandshakeRecord_t) + dataLen);
+    if (NULL == record)
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Malloc failed!");
+        return false;
+    }
+    record->sep = *sep;
+    record->data = (uint8_t *) (record + 1);
+    record->dataLen = dataLen;
+    memcpy(record->data, data, dataLen);
+
+    CAResult_t res = CA_STATUS_FAILED;
+    oc_mutex_lock(g_sslHandshakeMutex);
+    if (0 != CAAtomicLoad32(&g_sslAsyncHandshake))
+    {
+        res = CAQueueingThreadAddData(&g_sslHandshakeThread, record, sizeof(SslHandshakeRecord_t));
+    }
+    oc_mutex_unlock(g_sslHandshakeMutex);
+
+    if (CA_STATUS_OK != res)
+    {
+        OICFree(record);
+        return false;
+    }
+    return true;
+}
+
+CAResult_t CAsetSslAsyncHandshake(bool enable)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+    VERIFY_NON_NULL_RET(g_sslHandshakeMutex, NET_SSL_TAG, "SSL adapter is not initialized",
+                        CA_STATUS_NOT_INITIALIZED);
+
+    CAResult_t res = CA_STATUS_OK;
+    oc_mutex_lock(g_sslHandshakeMutex);
+    if (enable && NULL == g_sslHandshakePool)
+    {
+        res = ca_thread_pool_init(1, &g_sslHandshakePool);
+        if (CA_STATUS_OK == res)
         {
-            int adapterIndex = GetAdapterIndex(peer->sep.endpoint.adapter);
-            if (0 <= adapterIndex && MAX_SUPPORTED_ADAPTERS > adapterIndex)
+            res = CAQueueingThreadInitializeBounded(&g_sslHandshakeThread, g_sslHandshakePool,
+                                                    SslHandshakeTask, FreeSslHandshakeRecord,
+                                                    SSL_HANDSHAKE_QUEUE_SIZE, CA_QUEUE_FULL_DROP);
+            if (CA_STATUS_OK == res)
             {
-                g_caSslContext->adapterCallbacks[adapterIndex].recvCallback(&peer->sep, decryptBuffer, ret);
+                res = CAQueueingThreadStart(&g_sslHandshakeThread);
+                if (CA_STATUS_OK != res)
+                {
+                    CAQueueingThreadDestroy(&g_sslHandshakeThread);
+                }
             }
-            else
+            if (CA_STATUS_OK != res)
             {
-                OIC_LOG(ERROR, NET_SSL_TAG, "Unsuported adapter");
-                RemovePeerFromList(&peer->sep.endpoint);
-                oc_mutex_unlock(g_sslContextMutex);
-                return CA_STATUS_FAILED;
+                ca_thread_pool_free(g_sslHandshakePool);
+                g_sslHandshakePool = NULL;
             }
         }
     }
+    if (CA_STATUS_OK == res)
+    {
+        CAAtomicStore32(&g_sslAsyncHandshake, enable ? 1 : 0);
+    }
+    else
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Failed to start the handshake thread");
+    }
+    oc_mutex_unlock(g_sslHandshakeMutex);
 
-    oc_mutex_unlock(g_sslContextMutex);
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
-    return CA_STATUS_OK;
+    return res;
+}
+
+/* Read data from TLS connection
+ */
+CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, uint32_t dataLen)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+    VERIFY_NON_NULL_RET(sep, NET_SSL_TAG, "endpoint is NULL" , CA_STATUS_INVALID_PARAM);
+    VERIFY_NON_NULL_RET(data, NET_SSL_TAG, "Param data is NULL" , CA_STATUS_INVALID_PARAM);
+
+    // Established session: only its own mutex is needed
+    SslEndPoint_t * peer = AcquireSslPeer(&sep->endpoint);
+    if (NULL != peer)
+    {
+        oc_mutex_lock(peer->mutex);
+        if (!peer->removed && MBEDTLS_SSL_HANDSHAKE_OVER == peer->ssl.state)
+        {
+            bool remove = false;
+            peer->recBuf.buff = data;
+            peer->recBuf.len = dataLen;
+            peer->recBuf.loaded = 0;
+            CAResult_t res = DecryptSslRecord(peer, &remove);
+            oc_mutex_unlock(peer->mutex);
+            if (remove)
+            {
+                RemoveSslPeer(peer);
+            }
+            ReleaseSslPeer(peer);
+            OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+            return res;
+        }
+        oc_mutex_unlock(peer->mutex);
+        ReleaseSslPeer(peer);
+    }
+
+    // Handshake: on the handshake thread if enabled, in place otherwise
+    if (QueueSslHandshake(sep, data, dataLen))
+    {
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+        return CA_STATUS_OK;
+    }
+    return DecryptSslHandshake(sep, data, dataLen);
 }
 
 void CAsetSslAdapterCallbacks(CAPacketReceivedCallback recvCallback,
@@ -2206,11 +3197,17 @@ CAResult_t CAinitiateSslHandshake(const CAEndpoint_t *endpoint)
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
     VERIFY_NON_NULL_RET(endpoint, NET_SSL_TAG, "Param endpoint is NULL" , CA_STATUS_INVALID_PARAM);
     oc_mutex_lock(g_sslContextMutex);
-    if (NULL == InitiateTlsHandshake(endpoint))
+    SslEndPoint_t * tep = InitiateTlsHandshake(endpoint);
+    if (NULL == tep)
     {
         OIC_LOG(ERROR, NET_SSL_TAG, "TLS handshake failed");
         res = CA_STATUS_FAILED;
     }
+    else
+    {
+        oc_mutex_unlock(tep->mutex);
+        ReleaseSslPeer(tep);
+    }
     oc_mutex_unlock(g_sslContextMutex);
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
     return res;
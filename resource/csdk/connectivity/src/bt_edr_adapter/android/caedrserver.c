@@ -500,7 +500,8 @@ CAResult_t CAEDRServerStartAcceptThread()
     }
 
     ctx->stopFlag = &g_stopAccept;
-    if (CA_STATUS_OK != ca_thread_pool_add_task(g_threadPoolHandle, CAAcceptHandler, (void *) ctx))
+    if (CA_STATUS_OK != ca_thread_pool_add_dedicated_task(g_threadPoolHandle, CAAcceptHandler,
+                                                          (void *) ctx))
     {
         OIC_LOG(ERROR, TAG, "Failed to create read thread!");
         OICFree((void *) ctx);
@@ -573,7 +574,8 @@ CAResult_t CAEDRStartReceiveThread(bool isSecured)
     g_stopUnicast = false;
     ctx->stopFlag = &g_stopUnicast;
     ctx->type = isSecured ? CA_SECURED_UNICAST_SERVER : CA_UNICAST_SERVER;
-    if (CA_STATUS_OK != ca_thread_pool_add_task(g_threadPoolHandle, CAReceiveHandler, (void *) ctx))
+    if (CA_STATUS_OK != ca_thread_pool_add_dedicated_task(g_threadPoolHandle, CAReceiveHandler,
+                                                          (void *) ctx))
     {
         OIC_LOG(ERROR, TAG, "Failed to create read thread!");
         oc_mutex_unlock(g_mutexReceiveServer);
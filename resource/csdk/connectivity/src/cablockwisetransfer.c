@@ -57,7 +57,120 @@
 // context for block-wise transfer
 static CABlockWiseContext_t g_context = { .sendThreadFunc = NULL,
                                           .receivedThreadFunc = NULL,
-                                          .dataList = NULL };
+                                          .dataTable = NULL };
+
+/**
+ * @brief   FNV-1a hash of the block data ID
+ */
+static uint32_t CAHashBlockDataID(const CABlockDataID_t *blockID)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < blockID->idLength; i++)
+    {
+        hash = (hash ^ blockID->id[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief   find the table link which points to the block data of the given ID.
+ *          The caller holds blockDataListMutex.
+ * @return  pointer to the link, NULL if no such block data exists
+ */
+static CABlockData_t **CAFindBlockDataLink(const CABlockDataID_t *blockID)
+{
+    if (!g_context.dataTable || !blockID->id)
+    {
+        return NULL;
+    }
+
+    uint32_t hash = CAHashBlockDataID(blockID);
+    CABlockData_t **link = &g_context.dataTable[hash & (CA_BLOCK_DATA_TABLE_SIZE - 1)];
+    for (; NULL != *link; link = &(*link)->next)
+    {
+        if ((*link)->hash == hash && CABlockidMatches(*link, blockID))
+        {
+            return link;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief   find the block data of the given ID. The caller holds blockDataListMutex.
+ */
+static CABlockData_t *CAFindBlockData(const CABlockDataID_t *blockID)
+{
+    CABlockData_t **link = CAFindBlockDataLink(blockID);
+    return link ? *link : NULL;
+}
+
+static void CADestroyBlockData(CABlockData_t *data)
+{
+    if (data->sentData)
+    {
+        CADestroyDataSet(data->sentData);
+    }
+    CADestroyBlockID(data->blockDataId);
+    OICFree(data->payload);
+    OICFree(data);
+}
+
+/**
+ * @brief   get the part of the payload in the block of the given number, as coap_add_block
+ * @return  false if the data ends before the block
+ */
+static bool CAGetBlockPayloadRange(size_t dataLength, unsigned int num, unsigned char szx,
+                                   size_t *offset, size_t *length)
+{
+    size_t start = (size_t) num << (szx + 4);
+    if (dataLength <= start)
+    {
+        return false;
+    }
+
+    *offset = start;
+    *length = dataLength - start;
+    if (*length > (size_t) BLOCK_SIZE(szx))
+    {
+        *length = BLOCK_SIZE(szx);
+    }
+    return true;
+}
+
+/**
+ * @brief   encode the message again with the options of info, the block options and
+ *          length bytes of the payload from offset, and replace pdu with it. A streamed
+ *          payload is produced into the new pdu, so only that part is ever in memory.
+ */
+static CAResult_t CAWriteBlockPDU(coap_pdu_t **pdu, const CAInfo_t *info,
+                                  coap_list_t **options, size_t offset, size_t length)
+{
+    coap_pdu_t *blockPdu = CAGenerateBlockPDU(*pdu, info, options, length);
+    if (!blockPdu)
+    {
+        return CA_STATUS_FAILED;
+    }
+
+    if (0 < length)
+    {
+        if (info->payload)
+        {
+            memcpy(blockPdu->data, (const uint8_t *) info->payload + offset, length);
+        }
+        else if (CA_STATUS_OK != CAReadPayloadStream(info->payloadStream, offset,
+                                                     blockPdu->data, length))
+        {
+            OIC_LOG(ERROR, TAG, "failed to read payload");
+            coap_delete_pdu(blockPdu);
+            return CA_STATUS_FAILED;
+        }
+    }
+
+    coap_delete_pdu(*pdu);
+    *pdu = blockPdu;
+    return CA_STATUS_OK;
+}
 
 static bool CACheckPayloadLength(const CAData_t *sendData)
 {
@@ -92,16 +205,23 @@ CAResult_t CAInitializeBlockWiseTransfer(CASendThreadFunc sendThreadFunc,
         g_context.receivedThreadFunc = receivedThreadFunc;
     }
 
-    if (!g_context.dataList)
+    if (!g_context.dataTable)
     {
-        g_context.dataList = u_arraylist_create();
+        g_context.dataTable = (CABlockData_t **) OICCalloc(CA_BLOCK_DATA_TABLE_SIZE,
+                                                           sizeof(*g_context.dataTable));
     }
 
     CAResult_t res = CAInitBlockWiseMutexVariables();
+    if (!g_context.dataTable)
+    {
+        OIC_LOG(ERROR, TAG, "memory alloc has failed");
+        res = CA_MEMORY_ALLOC_FAILED;
+    }
+
     if (CA_STATUS_OK != res)
     {
-        u_arraylist_free(&g_context.dataList);
-        g_context.dataList = NULL;
+        OICFree(g_context.dataTable);
+        g_context.dataTable = NULL;
         OIC_LOG(ERROR, TAG, "init has failed");
     }
 
@@ -112,12 +232,14 @@ CAResult_t CATerminateBlockWiseTransfer()
 {
     OIC_LOG(DEBUG, TAG, "CATerminateBlockWiseTransfer");
 
-    if (g_context.dataList)
+    if (g_context.dataTable)
     {
         CARemoveAllBlockDataFromList();
-        u_arraylist_free(&g_context.dataList);
     }
 
+    OICFree(g_context.dataTable);
+    g_context.dataTable = NULL;
+
     CATerminateBlockWiseMutexVariables();
 
     return CA_STATUS_OK;
@@ -777,6 +899,7 @@ CAResult_t CASendErrorMessage(const coap_pdu_t *pdu, uint8_t status,
         data->payload = NULL;
         data->payloadLength = 0;
         data->receivedPayloadLen = 0;
+        data->payloadCapacity = 0;
         data->block1.num = 0;
         data->block2.num = 0;
     }
@@ -1398,7 +1521,7 @@ CAResult_t CAAddBlockOption(coap_pdu_t **pdu, const CAInfo_t *info,
 
     CAResult_t res = CA_STATUS_OK;
     size_t dataLength = 0;
-    if (info->payload)
+    if (info->payload || info->payloadStream)
     {
         dataLength = info->payloadSize;
         OIC_LOG_V(DEBUG, TAG, "dataLength - %zu", dataLength);
@@ -1446,38 +1569,15 @@ CAResult_t CAAddBlockOption(coap_pdu_t **pdu, const CAInfo_t *info,
     {
         OIC_LOG(DEBUG, TAG, "no BLOCK option");
 
-        // in case it is not large data, add option list to pdu.
-        if (*options)
-        {
-            for (coap_list_t *opt = *options; opt; opt = opt->next)
-            {
-                OIC_LOG_V(DEBUG, TAG, "[%s] opt will be added.",
-                          COAP_OPTION_DATA(*(coap_option *) opt->data));
-                OIC_LOG_V(DEBUG, TAG, "[%d] pdu length", (*pdu)->length);
-
-                if (0 == coap_add_option(*pdu, COAP_OPTION_KEY(*(coap_option *) opt->data),
-                                         COAP_OPTION_LENGTH(*(coap_option *) opt->data),
-                                         COAP_OPTION_DATA(*(coap_option *) opt->data)))
-                {
-                    OIC_LOG(ERROR, TAG, "coap_add_option has failed");
-                    res = CA_STATUS_FAILED;
-                    goto exit;
-                }
-            }
-        }
-        OIC_LOG_V(DEBUG, TAG, "[%d] pdu length after option", (*pdu)->length);
-
+        // in case it is not large data, encode the options and the payload.
         // if response data is so large. it have to send as block transfer
-        if (!coap_add_data(*pdu, dataLength, (const unsigned char *) info->payload))
+        res = CAWriteBlockPDU(pdu, info, options, 0, dataLength);
+        if (CA_STATUS_OK != res)
         {
             OIC_LOG(INFO, TAG, "it has to use block");
-            res = CA_STATUS_FAILED;
             goto exit;
         }
-        else
-        {
-            OIC_LOG(INFO, TAG, "not Blockwise Transfer");
-        }
+        OIC_LOG(INFO, TAG, "not Blockwise Transfer");
     }
 
     uint32_t code = (*pdu)->transport_hdr->udp.code;
@@ -1560,18 +1660,19 @@ CAResult_t CAAddBlockOption2(coap_pdu_t **pdu, const CAInfo_t *info, size_t data
             block1->num = 0;
         }
 
-        res = CAAddOptionToPDU(*pdu, options);
-        if (CA_STATUS_OK != res)
+        size_t offset = 0;
+        size_t length = 0;
+        if (!CAGetBlockPayloadRange(dataLength, block2->num, block2->szx, &offset, &length))
         {
-            OIC_LOG(ERROR, TAG, "add has failed");
-            goto exit;
+            OIC_LOG(ERROR, TAG, "Data length is smaller than the start index");
+            return CA_STATUS_FAILED;
         }
 
-        if (!coap_add_block(*pdu, dataLength, (const unsigned char *) info->payload,
-                            block2->num, block2->szx))
+        res = CAWriteBlockPDU(pdu, info, options, offset, length);
+        if (CA_STATUS_OK != res)
         {
-            OIC_LOG(ERROR, TAG, "Data length is smaller than the start index");
-            return CA_STATUS_FAILED;
+            OIC_LOG(ERROR, TAG, "add has failed");
+            goto exit;
         }
 
         CALogBlockInfo(block2);
@@ -1592,7 +1693,7 @@ CAResult_t CAAddBlockOption2(coap_pdu_t **pdu, const CAInfo_t *info, size_t data
             goto exit;
         }
 
-        res = CAAddOptionToPDU(*pdu, options);
+        res = CAWriteBlockPDU(pdu, info, options, 0, 0);
         if (CA_STATUS_OK != res)
         {
             OIC_LOG(ERROR, TAG, "add has failed");
@@ -1653,20 +1754,21 @@ CAResult_t CAAddBlockOption1(coap_pdu_t **pdu, const CAInfo_t *info, size_t data
             goto exit;
         }
 
-        // add option list to pdu.
-        res = CAAddOptionToPDU(*pdu, options);
-        if (CA_STATUS_OK != res)
+        // the payload data as the block size.
+        size_t offset = 0;
+        size_t length = 0;
+        if (!CAGetBlockPayloadRange(dataLength, block1->num, block1->szx, &offset, &length))
         {
-            OIC_LOG(ERROR, TAG, "add has failed");
-            goto exit;
+            OIC_LOG(ERROR, TAG, "Data length is smaller than the start index");
+            return CA_STATUS_FAILED;
         }
 
-        // add the payload data as the block size.
-        if (!coap_add_block(*pdu, dataLength, (const unsigned char *) info->payload, block1->num,
-                            block1->szx))
+        // encode the options and the payload.
+        res = CAWriteBlockPDU(pdu, info, options, offset, length);
+        if (CA_STATUS_OK != res)
         {
-            OIC_LOG(ERROR, TAG, "Data length is smaller than the start index");
-            return CA_STATUS_FAILED;
+            OIC_LOG(ERROR, TAG, "add has failed");
+            goto exit;
         }
     }
     else
@@ -1681,19 +1783,12 @@ CAResult_t CAAddBlockOption1(coap_pdu_t **pdu, const CAInfo_t *info, size_t data
             goto exit;
         }
 
-        // add option list to pdu.
-        res = CAAddOptionToPDU(*pdu, options);
+        // encode the options and the payload.
+        res = CAWriteBlockPDU(pdu, info, options, 0, dataLength);
         if (CA_STATUS_OK != res)
-        {
-            OIC_LOG(ERROR, TAG, "add has failed");
-            goto exit;
-        }
-
-        // add the payload data as the block size.
-        if (!coap_add_data(*pdu, dataLength, (const unsigned char *) info->payload))
         {
             OIC_LOG(ERROR, TAG, "failed to add payload");
-            return CA_STATUS_FAILED;
+            goto exit;
         }
 
         // if it is last block message, remove block data from list.
@@ -1972,46 +2067,41 @@ CAResult_t CAUpdatePayloadData(CABlockData_t *currData, const CAData_t *received
     size_t prePayloadLen = currData->receivedPayloadLen;
     if (blockPayload)
     {
-        if (currData->payloadLength)
+        size_t totalPayloadLen = prePayloadLen + blockPayloadLen;
+        if (totalPayloadLen > currData->payloadCapacity)
         {
-            // in case the block message has the size option
-            // allocate the memory for the total payload
-            if (isSizeOption)
+            // in case the block message has the size option, allocate the memory
+            // for the total payload at once. Otherwise the buffer is doubled so
+            // that each byte is copied a constant number of times on average.
+            size_t capacity = 0;
+            if (isSizeOption && currData->payloadLength >= totalPayloadLen)
             {
-                CAPayload_t prePayload = currData->payload;
-
                 OIC_LOG(DEBUG, TAG, "allocate memory for the total payload");
-                currData->payload = (CAPayload_t) OICCalloc(1, currData->payloadLength);
-                if (NULL == currData->payload)
+                capacity = currData->payloadLength;
+            }
+            else
+            {
+                OIC_LOG(DEBUG, TAG, "allocate memory for the received block payload");
+                capacity = currData->payloadCapacity * 2;
+                if (capacity < totalPayloadLen)
                 {
-                    OIC_LOG(ERROR, TAG, "out of memory");
-                    return CA_MEMORY_ALLOC_FAILED;
+                    capacity = totalPayloadLen;
                 }
-                memcpy(currData->payload, prePayload, prePayloadLen);
-                OICFree(prePayload);
             }
 
-            // update the total payload
-            memcpy(currData->payload + prePayloadLen, blockPayload, blockPayloadLen);
-        }
-        else
-        {
-            OIC_LOG(DEBUG, TAG, "allocate memory for the received block payload");
-
-            size_t totalPayloadLen = prePayloadLen + blockPayloadLen;
-            CAPayload_t newPayload = OICRealloc(currData->payload, totalPayloadLen);
+            CAPayload_t newPayload = OICRealloc(currData->payload, capacity);
             if (NULL == newPayload)
             {
                 OIC_LOG(ERROR, TAG, "out of memory");
                 return CA_MEMORY_ALLOC_FAILED;
             }
-
-            // update the total payload
-            memset(newPayload + prePayloadLen, 0, blockPayloadLen);
             currData->payload = newPayload;
-            memcpy(currData->payload + prePayloadLen, blockPayload, blockPayloadLen);
+            currData->payloadCapacity = capacity;
         }
 
+        // update the total payload
+        memcpy(currData->payload + prePayloadLen, blockPayload, blockPayloadLen);
+
         // update received payload length
         currData->receivedPayloadLen += blockPayloadLen;
 
@@ -2201,21 +2291,21 @@ CAPayload_t CAGetPayloadInfo(const CAData_t *data, size_t *payloadLen)
     VERIFY_NON_NULL_RET(data, TAG, "data", NULL);
     VERIFY_NON_NULL_RET(payloadLen, TAG, "payloadLen", NULL);
 
+    const CAInfo_t *info = NULL;
     if (data->requestInfo)
     {
-        if (data->requestInfo->info.payload)
-        {
-            *payloadLen = data->requestInfo->info.payloadSize;
-            return data->requestInfo->info.payload;
-        }
+        info = &data->requestInfo->info;
     }
     else if (data->responseInfo)
     {
-        if (data->responseInfo->info.payload)
-        {
-            *payloadLen = data->responseInfo->info.payloadSize;
-            return data->responseInfo->info.payload;
-        }
+        info = &data->responseInfo->info;
+    }
+
+    if (info && (info->payload || info->payloadStream))
+    {
+        // a streamed payload has its length, but no buffer
+        *payloadLen = info->payloadSize;
+        return info->payload;
     }
 
     return NULL;
@@ -2256,17 +2346,13 @@ CAResult_t CAUpdateBlockOptionType(const CABlockDataID_t *blockID, uint8_t block
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            currData->type = blockType;
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            OIC_LOG(DEBUG, TAG, "OUT-UpdateBlockOptionType");
-            return CA_STATUS_OK;
-        }
+        currData->type = blockType;
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        OIC_LOG(DEBUG, TAG, "OUT-UpdateBlockOptionType");
+        return CA_STATUS_OK;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2281,16 +2367,13 @@ uint8_t CAGetBlockOptionType(const CABlockDataID_t *blockID)
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            OIC_LOG(DEBUG, TAG, "OUT-GetBlockOptionType");
-            return currData->type;
-        }
+        uint8_t type = currData->type;
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        OIC_LOG(DEBUG, TAG, "OUT-GetBlockOptionType");
+        return type;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2304,19 +2387,12 @@ CAData_t *CAGetDataSetFromBlockDataList(const CABlockDataID_t *blockID)
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
-    {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            return currData->sentData;
-        }
-    }
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    CAData_t *sentData = currData ? currData->sentData : NULL;
+
     oc_mutex_unlock(g_context.blockDataListMutex);
 
-    return NULL;
+    return sentData;
 }
 
 CABlockData_t *CAUpdateDataSetFromBlockDataList(const CABlockDataID_t *blockID,
@@ -2327,21 +2403,15 @@ CABlockData_t *CAUpdateDataSetFromBlockDataList(const CABlockDataID_t *blockID,
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            CADestroyDataSet(currData->sentData);
-            currData->sentData = CACloneCAData(sendData);
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            return currData;
-        }
+        CADestroyDataSet(currData->sentData);
+        currData->sentData = CACloneCAData(sendData);
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
-    return NULL;
+    return currData;
 }
 
 CAResult_t CAGetTokenFromBlockDataList(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
@@ -2354,38 +2424,34 @@ CAResult_t CAGetTokenFromBlockDataList(const coap_pdu_t *pdu, const CAEndpoint_t
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    for (size_t i = 0; g_context.dataTable && i < CA_BLOCK_DATA_TABLE_SIZE; i++)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (NULL == currData)
+        for (CABlockData_t *currData = g_context.dataTable[i]; currData; currData = currData->next)
         {
-            continue;
-        }
+            if (NULL == currData->sentData || NULL == currData->sentData->requestInfo
+                || NULL == currData->sentData->requestInfo->info.token)
+            {
+                continue;
+            }
 
-        if (NULL != currData->sentData && NULL != currData->sentData->requestInfo)
-        {
             if (pdu->transport_hdr->udp.id == currData->sentData->requestInfo->info.messageId &&
                     endpoint->adapter == currData->sentData->remoteEndpoint->adapter)
             {
-                if (NULL != currData->sentData->requestInfo->info.token)
+                uint8_t length = currData->sentData->requestInfo->info.tokenLength;
+                responseInfo->info.tokenLength = length;
+                responseInfo->info.token = (char *) OICMalloc(length);
+                if (NULL == responseInfo->info.token)
                 {
-                    uint8_t length = currData->sentData->requestInfo->info.tokenLength;
-                    responseInfo->info.tokenLength = length;
-                    responseInfo->info.token = (char *) OICMalloc(length);
-                    if (NULL == responseInfo->info.token)
-                    {
-                        OIC_LOG(ERROR, TAG, "out of memory");
-                        oc_mutex_unlock(g_context.blockDataListMutex);
-                        return CA_MEMORY_ALLOC_FAILED;
-                    }
-                    memcpy(responseInfo->info.token, currData->sentData->requestInfo->info.token,
-                           responseInfo->info.tokenLength);
-
+                    OIC_LOG(ERROR, TAG, "out of memory");
                     oc_mutex_unlock(g_context.blockDataListMutex);
-                    OIC_LOG(DEBUG, TAG, "OUT-CAGetTokenFromBlockDataList");
-                    return CA_STATUS_OK;
+                    return CA_MEMORY_ALLOC_FAILED;
                 }
+                memcpy(responseInfo->info.token, currData->sentData->requestInfo->info.token,
+                       responseInfo->info.tokenLength);
+
+                oc_mutex_unlock(g_context.blockDataListMutex);
+                OIC_LOG(DEBUG, TAG, "OUT-CAGetTokenFromBlockDataList");
+                return CA_STATUS_OK;
             }
         }
     }
@@ -2434,19 +2500,11 @@ CABlockData_t *CAGetBlockDataFromBlockDataList(const CABlockDataID_t *blockID)
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
-    {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            return currData;
-        }
-    }
+    CABlockData_t *currData = CAFindBlockData(blockID);
+
     oc_mutex_unlock(g_context.blockDataListMutex);
 
-    return NULL;
+    return currData;
 }
 
 coap_block_t *CAGetBlockOption(const CABlockDataID_t *blockID, uint16_t blockType)
@@ -2456,23 +2514,20 @@ coap_block_t *CAGetBlockOption(const CABlockDataID_t *blockID, uint16_t blockTyp
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        OIC_LOG(DEBUG, TAG, "OUT-GetBlockOption");
+        if (COAP_OPTION_BLOCK2 == blockType)
         {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            OIC_LOG(DEBUG, TAG, "OUT-GetBlockOption");
-            if (COAP_OPTION_BLOCK2 == blockType)
-            {
-                return &currData->block2;
-            }
-            else if (COAP_OPTION_BLOCK1 == blockType)
-            {
-                return &currData->block1;
-            }
+            return &currData->block2;
+        }
+        else if (COAP_OPTION_BLOCK1 == blockType)
+        {
+            return &currData->block1;
         }
+        return NULL;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2489,17 +2544,13 @@ CAPayload_t CAGetPayloadFromBlockDataList(const CABlockDataID_t *blockID,
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            *fullPayloadLen = currData->receivedPayloadLen;
-            OIC_LOG(DEBUG, TAG, "OUT-GetFullPayload");
-            return currData->payload;
-        }
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        *fullPayloadLen = currData->receivedPayloadLen;
+        OIC_LOG(DEBUG, TAG, "OUT-GetFullPayload");
+        return currData->payload;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2564,11 +2615,11 @@ CABlockData_t *CACreateNewBlockData(const CAData_t *sendData)
         return NULL;
     }
     data->blockDataId = blockDataID;
+    data->hash = CAHashBlockDataID(blockDataID);
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    bool res = u_arraylist_add(g_context.dataList, (void *) data);
-    if (!res)
+    if (!g_context.dataTable)
     {
         OIC_LOG(ERROR, TAG, "add has failed");
         CADestroyBlockID(data->blockDataId);
@@ -2577,6 +2628,10 @@ CABlockData_t *CACreateNewBlockData(const CAData_t *sendData)
         oc_mutex_unlock(g_context.blockDataListMutex);
         return NULL;
     }
+
+    CABlockData_t **bucket = &g_context.dataTable[data->hash & (CA_BLOCK_DATA_TABLE_SIZE - 1)];
+    data->next = *bucket;
+    *bucket = data;
     oc_mutex_unlock(g_context.blockDataListMutex);
 
     OIC_LOG(DEBUG, TAG, "OUT-CreateBlockData");
@@ -2590,28 +2645,14 @@ CAResult_t CARemoveBlockDataFromList(const CABlockDataID_t *blockID)
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t **link = CAFindBlockDataLink(blockID);
+    if (link)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            CABlockData_t *removedData = u_arraylist_remove(g_context.dataList, i);
-            if (!removedData)
-            {
-                OIC_LOG(ERROR, TAG, "data is NULL");
-                oc_mutex_unlock(g_context.blockDataListMutex);
-                return CA_STATUS_FAILED;
-            }
+        CABlockData_t *removedData = *link;
+        *link = removedData->next;
 
-            // destroy memory
-            CADestroyDataSet(removedData->sentData);
-            CADestroyBlockID(removedData->blockDataId);
-            OICFree(removedData->payload);
-            OICFree(removedData);
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            return CA_STATUS_OK;
-        }
+        // destroy memory
+        CADestroyBlockData(removedData);
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2624,20 +2665,15 @@ CAResult_t CARemoveAllBlockDataFromList()
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = len; i > 0; i--)
+    for (size_t i = 0; g_context.dataTable && i < CA_BLOCK_DATA_TABLE_SIZE; i++)
     {
-        CABlockData_t *removedData = u_arraylist_remove(g_context.dataList, i - 1);
-        if (removedData)
+        while (g_context.dataTable[i])
         {
+            CABlockData_t *removedData = g_context.dataTable[i];
+            g_context.dataTable[i] = removedData->next;
+
             // destroy memory
-            if (removedData->sentData)
-            {
-                CADestroyDataSet(removedData->sentData);
-            }
-            CADestroyBlockID(removedData->blockDataId);
-            OICFree(removedData->payload);
-            OICFree(removedData);
+            CADestroyBlockData(removedData);
         }
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
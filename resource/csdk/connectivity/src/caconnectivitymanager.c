@@ -52,6 +52,7 @@ static bool g_isInitialized = false;
 extern void CAsetPkixInfoCallback(CAgetPkixInfoHandler infCallback);
 extern void CAsetPskCredentialsCallback(CAgetPskCredentialsHandler credCallback);
 extern void CAsetCredentialTypesCallback(CAgetCredentialTypesHandler credCallback);
+extern void CAinvalidatePkixInfoCache();
 #endif // __WITH_DTLS__ or __WITH_TLS__
 
 
@@ -230,6 +231,19 @@ CAResult_t CAregisterPkixInfoHandler(CAgetPkixInfoHandler getPkixInfoHandler)
     return CA_STATUS_OK;
 }
 
+CAResult_t CAinvalidatePkixInfo()
+{
+    OIC_LOG_V(DEBUG, TAG, "In %s", __func__);
+
+    if (!g_isInitialized)
+    {
+        return CA_STATUS_NOT_INITIALIZED;
+    }
+    CAinvalidatePkixInfoCache();
+    OIC_LOG_V(DEBUG, TAG, "Out %s", __func__);
+    return CA_STATUS_OK;
+}
+
 CAResult_t CAregisterGetCredentialTypesHandler(CAgetCredentialTypesHandler getCredTypesHandler)
 {
     OIC_LOG_V(DEBUG, TAG, "In %s", __func__);
@@ -288,6 +302,32 @@ void CADestroyToken(CAToken_t token)
     OIC_LOG(DEBUG, TAG, "OUT");
 }
 
+CAResult_t CACreatePayloadStream(CAPayloadProducer_t producer, CAPayloadRelease_t release,
+                                 void *context, CAPayloadStream_t **stream)
+{
+    OIC_LOG(DEBUG, TAG, "CACreatePayloadStream");
+
+    if (!producer || !stream)
+    {
+        OIC_LOG(ERROR, TAG, "Invalid Parameter");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    *stream = CACreatePayloadStreamObject(producer, release, context);
+    if (!*stream)
+    {
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+    return CA_STATUS_OK;
+}
+
+void CADestroyPayloadStream(CAPayloadStream_t *stream)
+{
+    OIC_LOG(DEBUG, TAG, "CADestroyPayloadStream");
+
+    CAFreePayloadStream(stream);
+}
+
 CAResult_t CAGetNetworkInformation(CAEndpoint_t **info, uint32_t *size)
 {
     OIC_LOG(DEBUG, TAG, "CAGetNetworkInformation");
@@ -507,6 +547,47 @@ CAResult_t CAHandleRequestResponse()
     return CA_STATUS_OK;
 }
 
+CAResult_t CAHandleRequestResponseBatch(uint32_t maxCount, uint32_t *remaining)
+{
+    if (!g_isInitialized)
+    {
+        OIC_LOG(ERROR, TAG, "not initialized");
+        return CA_STATUS_NOT_INITIALIZED;
+    }
+
+    uint32_t left = CAHandleRequestResponseCallbacksBatch(maxCount);
+    if (remaining)
+    {
+        *remaining = left;
+    }
+
+    return CA_STATUS_OK;
+}
+
+CAResult_t CAWaitForRequestResponse(uint32_t timeoutMs)
+{
+    if (!g_isInitialized)
+    {
+        OIC_LOG(ERROR, TAG, "not initialized");
+        return CA_STATUS_NOT_INITIALIZED;
+    }
+
+    return CAWaitForReceivedData((uint64_t) timeoutMs * 1000);
+}
+
+CAResult_t CAWakeUpRequestResponse()
+{
+    if (!g_isInitialized)
+    {
+        OIC_LOG(ERROR, TAG, "not initialized");
+        return CA_STATUS_NOT_INITIALIZED;
+    }
+
+    CAWakeUpReceivedDataWait();
+
+    return CA_STATUS_OK;
+}
+
 CAResult_t CASelectCipherSuite(const uint16_t cipher, CATransportAdapter_t adapter)
 {
     (void)(adapter); // prevent unused-parameter warning when building release variant
@@ -546,6 +627,24 @@ CAResult_t CAEnableAnonECDHCipherSuite(const bool enable)
     return res;
 }
 
+CAResult_t CAEnableAsyncHandshake(const bool enable)
+{
+    OIC_LOG_V(DEBUG, TAG, "In %s", __func__);
+    CAResult_t res = CA_STATUS_FAILED;
+#ifdef __WITH_DTLS__
+    res = CAsetSslAsyncHandshake(enable);
+    if (CA_STATUS_OK != res)
+    {
+        OIC_LOG_V(ERROR, TAG, "Failed to CAsetSslAsyncHandshake : %d", res);
+    }
+#else
+    (void)(enable); // prevent unused-parameter compiler warning
+    OIC_LOG(ERROR, TAG, "Method not supported");
+#endif
+    OIC_LOG_V(DEBUG, TAG, "Out %s", __func__);
+    return res;
+}
+
 CAResult_t CAGenerateOwnerPSK(const CAEndpoint_t* endpoint,
                     const uint8_t* label, const size_t labelLen,
                     const uint8_t* rsrcServerDeviceID, const size_t rsrcServerDeviceIDLen,
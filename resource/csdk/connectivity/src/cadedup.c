@@ -0,0 +1,409 @@
+/******************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <coap/pdu.h>
+#include "cadedup.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+#include "oic_time.h"
+#include "logger.h"
+
+#define TAG "OIC_CA_DEDUP"
+
+struct CADedupEntry
+{
+    CADedupEntry_t *next;               /**< next entry in the same bucket */
+    CADedupEntry_t *newer;              /**< entry added after this one */
+    CADedupEntry_t *older;              /**< entry added before this one */
+    uint64_t expires;                   /**< end of lifetime. milliseconds */
+    uint32_t hash;                      /**< hash of endpoint and message id */
+    uint16_t messageId;                 /**< coap PDU message id */
+    uint16_t port;                      /**< remote port */
+    CATransportAdapter_t adapter;       /**< remote adapter */
+    char addr[MAX_ADDR_STR_SIZE_CA];    /**< remote address */
+    uint8_t tokenLength;                /**< token length */
+    uint8_t token[CA_MAX_TOKEN_LEN];    /**< token of the request */
+    void *response;                     /**< ACK or reset sent for the request */
+    uint32_t responseLength;            /**< response length */
+};
+
+static const uint64_t MSECS_PER_SEC = 1000;
+
+/** length of an empty message, the CoAP header only. */
+#define CA_DEDUP_EMPTY_ACK_LENGTH 4
+
+/**
+ * @brief   FNV-1a hash of the remote address, port and message id
+ */
+static uint32_t CADedupHash(const CAEndpoint_t *endpoint, uint16_t messageId)
+{
+    uint32_t hash = 2166136261u;
+    for (const char *c = endpoint->addr; '\0' != *c; c++)
+    {
+        hash = (hash ^ (uint8_t) *c) * 16777619u;
+    }
+    hash = (hash ^ (endpoint->port & 0xFF)) * 16777619u;
+    hash = (hash ^ (endpoint->port >> 8)) * 16777619u;
+    hash = (hash ^ (messageId & 0xFF)) * 16777619u;
+    hash = (hash ^ (messageId >> 8)) * 16777619u;
+    return hash;
+}
+
+/**
+ * @brief   time a message id of the given type is remembered
+ * @return  milliseconds
+ */
+static uint64_t CADedupLifetime(CAMessageType_t type)
+{
+    return MSECS_PER_SEC * (CA_MSG_CONFIRM == type ? CA_EXCHANGE_LIFETIME_SEC
+                                                   : CA_NON_LIFETIME_SEC);
+}
+
+/**
+ * @brief   find the table link which points to the entry of the given message
+ * @return  pointer to the link, NULL if no such entry exists
+ */
+static CADedupEntry_t **CADedupFindLink(CADedup_t *context, const CAEndpoint_t *endpoint,
+                                        uint16_t messageId, uint32_t hash)
+{
+    CADedupEntry_t **link = &context->table[hash & (CA_DEDUP_TABLE_SIZE - 1)];
+    for (; NULL != *link; link = &(*link)->next)
+    {
+        CADedupEntry_t *entry = *link;
+        if (entry->hash == hash && entry->messageId == messageId
+            && entry->adapter == endpoint->adapter && entry->port == endpoint->port
+            && 0 == strcmp(entry->addr, endpoint->addr))
+        {
+            return link;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief   link the entry as the most recently added one
+ */
+static void CADedupAppendNewest(CADedup_t *context, CADedupEntry_t *entry)
+{
+    entry->newer = NULL;
+    entry->older = context->newest;
+    if (NULL != context->newest)
+    {
+        context->newest->newer = entry;
+    }
+    else
+    {
+        context->oldest = entry;
+    }
+    context->newest = entry;
+}
+
+/**
+ * @brief   take the entry out of the order entries were added in
+ */
+static void CADedupUnlinkAge(CADedup_t *context, CADedupEntry_t *entry)
+{
+    if (NULL != entry->older)
+    {
+        entry->older->newer = entry->newer;
+    }
+    else
+    {
+        context->oldest = entry->newer;
+    }
+    if (NULL != entry->newer)
+    {
+        entry->newer->older = entry->older;
+    }
+    else
+    {
+        context->newest = entry->older;
+    }
+    entry->newer = NULL;
+    entry->older = NULL;
+}
+
+/**
+ * @brief   empty ACK for a confirmable request, as CoAP over UDP encodes it
+ * @return  allocated message, NULL if out of memory
+ */
+static void *CADedupCreateEmptyAck(uint16_t messageId)
+{
+    uint8_t *ack = (uint8_t *) OICMalloc(CA_DEDUP_EMPTY_ACK_LENGTH);
+    if (NULL == ack)
+    {
+        OIC_LOG(ERROR, TAG, "memory error");
+        return NULL;
+    }
+    ack[0] = (COAP_DEFAULT_VERSION << 6) | (CA_MSG_ACKNOWLEDGE << 4);
+    ack[1] = CA_EMPTY;
+    // the message id is kept as it was read from the header
+    memcpy(&ack[2], &messageId, sizeof(messageId));
+    return ack;
+}
+
+static void CADedupDestroyEntry(CADedupEntry_t *entry)
+{
+    OICFree(entry->response);
+    OICFree(entry);
+}
+
+/**
+ * @brief   forget the oldest entry. The caller holds the lock.
+ */
+static void CADedupRemoveOldest(CADedup_t *context)
+{
+    CADedupEntry_t *entry = context->oldest;
+    CADedupEntry_t **link = &context->table[entry->hash & (CA_DEDUP_TABLE_SIZE - 1)];
+    while (*link != entry)
+    {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+
+    CADedupUnlinkAge(context, entry);
+    context->count--;
+    CADedupDestroyEntry(entry);
+}
+
+/**
+ * @brief   forget entries whose lifetime ended. Entries are checked in the order
+ *          they were added, so an entry with a shorter lifetime may stay until the
+ *          older entries expire.
+ */
+static void CADedupPurge(CADedup_t *context, uint64_t now)
+{
+    while (NULL != context->oldest && context->oldest->expires <= now)
+    {
+        CADedupRemoveOldest(context);
+    }
+}
+
+CAResult_t CADedupInitialize(CADedup_t *context)
+{
+    if (NULL == context)
+    {
+        OIC_LOG(ERROR, TAG, "context is empty");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    memset(context, 0, sizeof(CADedup_t));
+
+    context->table = (CADedupEntry_t **) OICCalloc(CA_DEDUP_TABLE_SIZE,
+                                                   sizeof(*context->table));
+    if (NULL == context->table)
+    {
+        OIC_LOG(ERROR, TAG, "memory error");
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+
+    context->lock = oc_mutex_new();
+    if (NULL == context->lock)
+    {
+        OIC_LOG(ERROR, TAG, "oc_mutex_new has failed");
+        OICFree(context->table);
+        context->table = NULL;
+        return CA_STATUS_FAILED;
+    }
+
+    return CA_STATUS_OK;
+}
+
+void CADedupTerminate(CADedup_t *context)
+{
+    if (NULL == context || NULL == context->table)
+    {
+        return;
+    }
+
+    oc_mutex_lock(context->lock);
+    while (NULL != context->oldest)
+    {
+        CADedupRemoveOldest(context);
+    }
+    OICFree(context->table);
+    context->table = NULL;
+    oc_mutex_unlock(context->lock);
+
+    oc_mutex_free(context->lock);
+    context->lock = NULL;
+}
+
+bool CADedupCheckRequest(CADedup_t *context, const CAEndpoint_t *endpoint,
+                         const CAInfo_t *info, void **response, uint32_t *responseLength)
+{
+    if (NULL == context || NULL == endpoint || NULL == info || NULL == response
+        || NULL == responseLength)
+    {
+        OIC_LOG(ERROR, TAG, "invalid parameter");
+        return false;
+    }
+
+    *response = NULL;
+    *responseLength = 0;
+
+    uint8_t tokenLength = info->tokenLength;
+    if (tokenLength > CA_MAX_TOKEN_LEN)
+    {
+        // compare the first CA_MAX_TOKEN_LEN bytes only, as CADropSecondMessage does.
+        tokenLength = CA_MAX_TOKEN_LEN;
+    }
+
+    uint64_t now = OICGetCurrentTime(TIME_IN_MS);
+    uint32_t hash = CADedupHash(endpoint, info->messageId);
+    bool ret = false;
+
+    oc_mutex_lock(context->lock);
+    if (NULL == context->table)
+    {
+        oc_mutex_unlock(context->lock);
+        return false;
+    }
+
+    CADedupPurge(context, now);
+
+    CADedupEntry_t **link = CADedupFindLink(context, endpoint, info->messageId, hash);
+    if (NULL != link)
+    {
+        CADedupEntry_t *entry = *link;
+        if (entry->expires > now && entry->tokenLength == tokenLength
+            && 0 == memcmp(entry->token, info->token, tokenLength))
+        {
+            ret = true;
+            if (NULL != entry->response)
+            {
+                *response = OICMalloc(entry->responseLength);
+                if (NULL != *response)
+                {
+                    memcpy(*response, entry->response, entry->responseLength);
+                    *responseLength = entry->responseLength;
+                }
+            }
+            else if (CA_MSG_CONFIRM == info->type)
+            {
+                // no response yet, stop the retransmissions (RFC 7252, section 4.5).
+                *response = CADedupCreateEmptyAck(info->messageId);
+                if (NULL != *response)
+                {
+                    *responseLength = CA_DEDUP_EMPTY_ACK_LENGTH;
+                }
+            }
+        }
+        else
+        {
+            // the message id was reused for another request, start over
+            // as the most recently added entry.
+            CADedupUnlinkAge(context, entry);
+            CADedupAppendNewest(context, entry);
+            entry->tokenLength = tokenLength;
+            if (tokenLength)
+            {
+                memcpy(entry->token, info->token, tokenLength);
+            }
+            entry->expires = now + CADedupLifetime(info->type);
+            OICFree(entry->response);
+            entry->response = NULL;
+            entry->responseLength = 0;
+        }
+    }
+    else
+    {
+        if (context->count >= CA_DEDUP_MAX_ENTRIES)
+        {
+            CADedupRemoveOldest(context);
+        }
+
+        CADedupEntry_t *entry = (CADedupEntry_t *) OICCalloc(1, sizeof(CADedupEntry_t));
+        if (NULL == entry)
+        {
+            // not remembering the request only means duplicates pass.
+            OIC_LOG(ERROR, TAG, "memory error");
+            oc_mutex_unlock(context->lock);
+            return false;
+        }
+        entry->hash = hash;
+        entry->messageId = info->messageId;
+        entry->port = endpoint->port;
+        entry->adapter = endpoint->adapter;
+        OICStrcpy(entry->addr, sizeof(entry->addr), endpoint->addr);
+        entry->tokenLength = tokenLength;
+        if (tokenLength)
+        {
+            memcpy(entry->token, info->token, tokenLength);
+        }
+        entry->expires = now + CADedupLifetime(info->type);
+
+        CADedupEntry_t **bucket = &context->table[hash & (CA_DEDUP_TABLE_SIZE - 1)];
+        entry->next = *bucket;
+        *bucket = entry;
+
+        CADedupAppendNewest(context, entry);
+        context->count++;
+    }
+    oc_mutex_unlock(context->lock);
+
+    if (ret)
+    {
+        OIC_LOG_V(INFO, TAG, "duplicate message id %u, %s response", info->messageId,
+                  *response ? "repeating the" : "no");
+    }
+    return ret;
+}
+
+void CADedupSaveResponse(CADedup_t *context, const CAEndpoint_t *endpoint,
+                         uint16_t messageId, const void *pdu, uint32_t size)
+{
+    if (NULL == context || NULL == endpoint || NULL == pdu || 0 == size)
+    {
+        OIC_LOG(ERROR, TAG, "invalid parameter");
+        return;
+    }
+
+    uint32_t hash = CADedupHash(endpoint, messageId);
+
+    oc_mutex_lock(context->lock);
+    if (NULL == context->table)
+    {
+        oc_mutex_unlock(context->lock);
+        return;
+    }
+
+    CADedupEntry_t **link = CADedupFindLink(context, endpoint, messageId, hash);
+    if (NULL != link)
+    {
+        CADedupEntry_t *entry = *link;
+        void *response = OICMalloc(size);
+        if (NULL != response)
+        {
+            memcpy(response, pdu, size);
+            OICFree(entry->response);
+            entry->response = response;
+            entry->responseLength = size;
+        }
+        else
+        {
+            OIC_LOG(ERROR, TAG, "memory error");
+        }
+    }
+    oc_mutex_unlock(context->lock);
+}
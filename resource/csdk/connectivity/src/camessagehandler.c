@@ -47,6 +47,7 @@
 #include "uqueue.h"
 #include "cathreadpool.h" /* for thread pool */
 #include "caqueueingthread.h"
+#include "cadedup.h"
 
 #if defined(TCP_ADAPTER) && defined(WITH_CLOUD)
 #include "caconnectionmanager.h"
@@ -54,6 +55,19 @@
 #define SINGLE_HANDLE
 #define MAX_THREAD_POOL_SIZE    20
 
+/** Capacity of the send queue; producers wait for room when it is full. */
+#ifndef CA_SEND_QUEUE_SIZE
+#define CA_SEND_QUEUE_SIZE      1024
+#endif
+
+/** Capacity of the receive queue; new data is dropped when it is full. */
+#ifndef CA_RECEIVE_QUEUE_SIZE
+#define CA_RECEIVE_QUEUE_SIZE   1024
+#endif
+
+/** Number of received data taken from the receive queue at once. */
+#define CA_RECEIVE_BATCH_SIZE   16
+
 // thread pool handle
 static ca_thread_pool_t g_threadPoolHandle = NULL;
 
@@ -61,6 +75,12 @@ static ca_thread_pool_t g_threadPoolHandle = NULL;
 static CAQueueingThread_t g_sendThread;
 static CAQueueingThread_t g_receiveThread;
 
+// received requests and the responses sent for them
+static CADedup_t g_dedupContext;
+
+// guards caglobals.ca.requestHistory, which every IP receive thread updates
+static oc_mutex g_historyMutex = NULL;
+
 #else
 #define CA_MAX_RT_ARRAY_SIZE    3
 #endif  // SINGLE_THREAD
@@ -69,6 +89,12 @@ static CAQueueingThread_t g_receiveThread;
 
 static CARetransmission_t g_retransmissionContext;
 
+// NSTART the retransmission context is initialized with
+static uint8_t g_retransmissionNStart = DEFAULT_NSTART;
+
+// free CAData_t kept for reuse
+static u_mempool_t *g_dataPool = NULL;
+
 // handler field
 static CARequestCallback g_requestHandler = NULL;
 static CAResponseCallback g_responseHandler = NULL;
@@ -101,13 +127,94 @@ static bool CADropSecondMessage(CAHistory_t *history, const CAEndpoint_t *endpoi
  */
 static void CALogPDUInfo(const CAData_t *data, const coap_pdu_t *pdu);
 
+static CAData_t *CAAllocData()
+{
+    return g_dataPool ? (CAData_t *) u_mempool_alloc(g_dataPool)
+                      : (CAData_t *) OICCalloc(1, sizeof(CAData_t));
+}
+
+static void CAFreeData(CAData_t *data)
+{
+    u_mempool_free(g_dataPool, data);
+}
+
+#ifndef SINGLE_THREAD
+/**
+ * add data to the queueing thread, destroying it if the queue refuses it.
+ * @param[in] thread    queueing thread.
+ * @param[in] data      data to add. ownership always passes to this function.
+ * @return ::CA_STATUS_OK or an error code from ::CAQueueingThreadAddData.
+ */
+static CAResult_t CAQueueData(CAQueueingThread_t *thread, CAData_t *data)
+{
+    CAResult_t res = CAQueueingThreadAddData(thread, data, sizeof(CAData_t));
+    if (CA_STATUS_OK != res)
+    {
+        OIC_LOG_V(ERROR, TAG, "failed to add data to queue [%d]", res);
+        CADestroyData(data, sizeof(CAData_t));
+    }
+    return res;
+}
+
+/**
+ * check the request against the dedup table. A duplicate is answered with the ACK
+ * or reset sent for the original request, if there is one, and dropped.
+ * @param[in] endpoint  endpoint the request came from.
+ * @param[in] info      information of the received request.
+ * @return true if the request must not be passed to the application.
+ */
+static bool CAIsDuplicateRequest(const CAEndpoint_t *endpoint, const CAInfo_t *info)
+{
+#ifdef WITH_TCP
+    if (CAIsSupportedCoAPOverTCP(endpoint->adapter))
+    {
+        // the transport does not repeat messages
+        return false;
+    }
+#endif
+
+    void *response = NULL;
+    uint32_t responseLength = 0;
+    if (!CADedupCheckRequest(&g_dedupContext, endpoint, info, &response, &responseLength))
+    {
+        return false;
+    }
+
+    if (NULL != response)
+    {
+        // the adapter may hold locks while it passes up received data, send from the
+        // send thread like any other response.
+        CAData_t *cadata = CAAllocData();
+        if (!cadata)
+        {
+            OIC_LOG(ERROR, TAG, "memory allocation failed");
+            OICFree(response);
+            return true;
+        }
+        cadata->type = SEND_TYPE_UNICAST;
+        cadata->dataType = CA_RESPONSE_DATA;
+        cadata->pdu = response;
+        cadata->pduLength = responseLength;
+        cadata->remoteEndpoint = CACloneEndpoint(endpoint);
+        if (!cadata->remoteEndpoint)
+        {
+            OIC_LOG(ERROR, TAG, "endpoint clone failed");
+            CADestroyData(cadata, sizeof(CAData_t));
+            return true;
+        }
+        CAQueueData(&g_sendThread, cadata);
+    }
+    return true;
+}
+#endif
+
 #ifdef WITH_BWT
 void CAAddDataToSendThread(CAData_t *data)
 {
     VERIFY_NON_NULL_VOID(data, TAG, "data");
 
     // add thread
-    CAQueueingThreadAddData(&g_sendThread, data, sizeof(CAData_t));
+    CAQueueData(&g_sendThread, data);
 }
 
 void CAAddDataToReceiveThread(CAData_t *data)
@@ -115,7 +222,7 @@ void CAAddDataToReceiveThread(CAData_t *data)
     VERIFY_NON_NULL_VOID(data, TAG, "data");
 
     // add thread
-    CAQueueingThreadAddData(&g_receiveThread, data, sizeof(CAData_t));
+    CAQueueData(&g_receiveThread, data);
 }
 #endif
 
@@ -137,7 +244,7 @@ static CAData_t* CAGenerateHandlerData(const CAEndpoint_t *endpoint,
 {
     OIC_LOG(DEBUG, TAG, "CAGenerateHandlerData IN");
     CAInfo_t *info = NULL;
-    CAData_t *cadata = (CAData_t *) OICCalloc(1, sizeof(CAData_t));
+    CAData_t *cadata = CAAllocData();
     if (!cadata)
     {
         OIC_LOG(ERROR, TAG, "memory allocation failed");
@@ -158,7 +265,7 @@ static CAData_t* CAGenerateHandlerData(const CAEndpoint_t *endpoint,
 
     if (CA_RESPONSE_DATA == dataType)
     {
-        CAResponseInfo_t* resInfo = (CAResponseInfo_t*)OICCalloc(1, sizeof(CAResponseInfo_t));
+        CAResponseInfo_t* resInfo = CAAllocResponseInfo();
         if (!resInfo)
         {
             OIC_LOG(ERROR, TAG, "memory allocation failed");
@@ -183,7 +290,7 @@ static CAData_t* CAGenerateHandlerData(const CAEndpoint_t *endpoint,
     }
     else if (CA_REQUEST_DATA == dataType)
     {
-        CARequestInfo_t* reqInfo = (CARequestInfo_t*)OICCalloc(1, sizeof(CARequestInfo_t));
+        CARequestInfo_t* reqInfo = CAAllocRequestInfo();
         if (!reqInfo)
         {
             OIC_LOG(ERROR, TAG, "memory allocation failed");
@@ -206,6 +313,14 @@ static CAData_t* CAGenerateHandlerData(const CAEndpoint_t *endpoint,
             goto exit;
         }
 
+#ifndef SINGLE_THREAD
+        if (CAIsDuplicateRequest(endpoint, &reqInfo->info))
+        {
+            CADestroyRequestInfoInternal(reqInfo);
+            goto exit;
+        }
+#endif
+
         cadata->requestInfo = reqInfo;
         info = &reqInfo->info;
         if (identity)
@@ -217,7 +332,7 @@ static CAData_t* CAGenerateHandlerData(const CAEndpoint_t *endpoint,
    }
     else if (CA_ERROR_DATA == dataType)
     {
-        CAErrorInfo_t *errorInfo = (CAErrorInfo_t *)OICCalloc(1, sizeof (CAErrorInfo_t));
+        CAErrorInfo_t *errorInfo = CAAllocErrorInfo();
         if (!errorInfo)
         {
             OIC_LOG(ERROR, TAG, "Memory allocation failed!");
@@ -249,7 +364,7 @@ static CAData_t* CAGenerateHandlerData(const CAEndpoint_t *endpoint,
     return cadata;
 
 exit:
-    OICFree(cadata);
+    CAFreeData(cadata);
 #ifndef SINGLE_THREAD
     CAFreeEndpoint(ep);
 #endif
@@ -271,7 +386,7 @@ static void CATimeoutCallback(const CAEndpoint_t *endpoint, const void *pdu, uin
     }
 #endif
 
-    CAResponseInfo_t* resInfo = (CAResponseInfo_t*)OICCalloc(1, sizeof(CAResponseInfo_t));
+    CAResponseInfo_t* resInfo = CAAllocResponseInfo();
 
     if (!resInfo)
     {
@@ -298,7 +413,7 @@ static void CATimeoutCallback(const CAEndpoint_t *endpoint, const void *pdu, uin
         return;
     }
 
-    CAData_t *cadata = (CAData_t *) OICCalloc(1, sizeof(CAData_t));
+    CAData_t *cadata = CAAllocData();
     if (NULL == cadata)
     {
         OIC_LOG(ERROR, TAG, "memory allocation failed !");
@@ -329,7 +444,7 @@ static void CATimeoutCallback(const CAEndpoint_t *endpoint, const void *pdu, uin
 #ifdef SINGLE_THREAD
     CAProcessReceivedData(cadata);
 #else
-    CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+    CAQueueData(&g_receiveThread, cadata);
 #endif
 }
 
@@ -369,7 +484,8 @@ static void CADestroyData(void *data, uint32_t size)
         CADestroyErrorInfoInternal(cadata->errorInfo);
     }
 
-    OICFree(cadata);
+    OICFree(cadata->pdu);
+    CAFreeData(cadata);
     OIC_LOG(DEBUG, TAG, "CADestroyData OUT");
 }
 
@@ -526,7 +642,20 @@ static CAResult_t CAProcessSendData(const CAData_t *data)
         bool skipRetransmission = false;
 #endif
 
-        if (NULL != data->requestInfo)
+        if (NULL != data->pdu)
+        {
+            // a response repeated for a duplicate request, already encoded
+            OIC_LOG(DEBUG, TAG, "encoded pdu is available..");
+            res = CASendUnicastData(data->remoteEndpoint, data->pdu, data->pduLength,
+                                    data->dataType);
+            if (CA_STATUS_OK != res)
+            {
+                OIC_LOG_V(ERROR, TAG, "send failed:%d", res);
+            }
+            OIC_TRACE_END();
+            return res;
+        }
+        else if (NULL != data->requestInfo)
         {
             OIC_LOG(DEBUG, TAG, "requestInfo is available..");
 
@@ -581,18 +710,8 @@ static CAResult_t CAProcessSendData(const CAData_t *data)
 #endif // WITH_BWT
             CALogPDUInfo(data, pdu);
 
-            OIC_LOG_V(INFO, TAG, "CASendUnicastData type : %d", data->dataType);
-            res = CASendUnicastData(data->remoteEndpoint, pdu->transport_hdr, pdu->length, data->dataType);
-            if (CA_STATUS_OK != res)
-            {
-                OIC_LOG_V(ERROR, TAG, "send failed:%d", res);
-                CAErrorHandler(data->remoteEndpoint, pdu->transport_hdr, pdu->length, res);
-                coap_delete_list(options);
-                coap_delete_pdu(pdu);
-                OIC_TRACE_END();
-                return res;
-            }
-
+            // CON messages go through the retransmission, which may hold them back (NSTART)
+            res = CA_NOT_SUPPORTED;
 #ifdef WITH_TCP
             if (CAIsSupportedCoAPOverTCP(data->remoteEndpoint->adapter))
             {
@@ -604,22 +723,40 @@ static CAResult_t CAProcessSendData(const CAData_t *data)
             if (!skipRetransmission)
 #endif
             {
-                // for retransmission
-                res = CARetransmissionSentData(&g_retransmissionContext,
+                res = CARetransmissionSendData(&g_retransmissionContext,
                                                data->remoteEndpoint,
                                                data->dataType,
                                                pdu->transport_hdr, pdu->length);
-                if ((CA_STATUS_OK != res) && (CA_NOT_SUPPORTED != res))
-                {
-                    //when retransmission not supported this will return CA_NOT_SUPPORTED, ignore
-                    OIC_LOG_V(INFO, TAG, "retransmission is not enabled due to error, res : %d", res);
-                    coap_delete_list(options);
-                    coap_delete_pdu(pdu);
-                    OIC_TRACE_END();
-                    return res;
-                }
             }
 
+            if (CA_NOT_SUPPORTED == res)
+            {
+                OIC_LOG_V(INFO, TAG, "CASendUnicastData type : %d", data->dataType);
+                res = CASendUnicastData(data->remoteEndpoint, pdu->transport_hdr, pdu->length,
+                                        data->dataType);
+            }
+            if (CA_STATUS_OK != res)
+            {
+                OIC_LOG_V(ERROR, TAG, "send failed:%d", res);
+                CAErrorHandler(data->remoteEndpoint, pdu->transport_hdr, pdu->length, res);
+                coap_delete_list(options);
+                coap_delete_pdu(pdu);
+                OIC_TRACE_END();
+                return res;
+            }
+
+#ifndef SINGLE_THREAD
+            // keep the answer to a request for its retransmissions
+            if (NULL != data->responseInfo
+                && (CA_MSG_ACKNOWLEDGE == info->type || CA_MSG_RESET == info->type))
+            {
+                CADedupSaveResponse(&g_dedupContext, data->remoteEndpoint,
+                                    CAGetMessageIdFromPduBinaryData(pdu->transport_hdr,
+                                                                    pdu->length),
+                                    pdu->transport_hdr, pdu->length);
+            }
+#endif
+
             coap_delete_list(options);
             coap_delete_pdu(pdu);
         }
@@ -709,6 +846,9 @@ static bool CADropSecondMessage(CAHistory_t *history, const CAEndpoint_t *ep, ui
     bool ret = false;
     CATransportFlags_t familyFlags = ep->flags & CA_IPFAMILY_MASK;
 
+#ifndef SINGLE_THREAD
+    oc_mutex_lock(g_historyMutex);
+#endif
     for (size_t i = 0; i < sizeof(history->items) / sizeof(history->items[0]); i++)
     {
         CAHistoryItem_t *item = &(history->items[i]);
@@ -735,6 +875,9 @@ static bool CADropSecondMessage(CAHistory_t *history, const CAEndpoint_t *ep, ui
     {
         history->nextIndex = 0;
     }
+#ifndef SINGLE_THREAD
+    oc_mutex_unlock(g_historyMutex);
+#endif
 
     return ret;
 }
@@ -833,7 +976,7 @@ static void CAReceivedPacketCallback(const CASecureEndpoint_t *sep,
         if (CA_NOT_SUPPORTED == res || CA_REQUEST_TIMEOUT == res)
         {
             OIC_LOG(DEBUG, TAG, "this message does not have block option");
-            CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+            CAQueueData(&g_receiveThread, cadata);
         }
         else
         {
@@ -843,7 +986,7 @@ static void CAReceivedPacketCallback(const CASecureEndpoint_t *sep,
     else
 #endif
     {
-        CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+        CAQueueData(&g_receiveThread, cadata);
     }
 #endif // SINGLE_THREAD
 
@@ -856,31 +999,9 @@ exit:
     OIC_TRACE_END();
 }
 
-void CAHandleRequestResponseCallbacks()
+#if !defined(SINGLE_THREAD) && defined(SINGLE_HANDLE)
+static void CADispatchReceivedData(CAData_t *td)
 {
-#ifdef SINGLE_THREAD
-    CAReadData();
-    CARetransmissionBaseRoutine((void *)&g_retransmissionContext);
-#else
-#ifdef SINGLE_HANDLE
-    // parse the data and call the callbacks.
-    // #1 parse the data
-    // #2 get endpoint
-
-    oc_mutex_lock(g_receiveThread.threadMutex);
-
-    u_queue_message_t *item = u_queue_get_element(g_receiveThread.dataQueue);
-
-    oc_mutex_unlock(g_receiveThread.threadMutex);
-
-    if (NULL == item || NULL == item->msg)
-    {
-        return;
-    }
-
-    // get endpoint
-    CAData_t *td = (CAData_t *) item->msg;
-
     if (td->requestInfo && g_requestHandler)
     {
         OIC_LOG_V(DEBUG, TAG, "request callback : %d", td->requestInfo->info.numOptions);
@@ -897,19 +1018,88 @@ void CAHandleRequestResponseCallbacks()
         g_errorHandler(td->remoteEndpoint, td->errorInfo);
     }
 
-    CADestroyData(item->msg, sizeof(CAData_t));
-    OICFree(item);
+    CADestroyData(td, sizeof(CAData_t));
+}
+#endif
 
+uint32_t CAHandleRequestResponseCallbacksBatch(uint32_t maxCount)
+{
+#ifdef SINGLE_THREAD
+    (void)maxCount;
+    CAReadData();
+    CARetransmissionBaseRoutine((void *)&g_retransmissionContext);
+    return 0;
+#else
+#ifdef SINGLE_HANDLE
+    // parse the data and call the callbacks.
+    // #1 parse the data
+    // #2 get endpoint
+
+    u_queue_message_t items[CA_RECEIVE_BATCH_SIZE];
+    uint32_t handled = 0;
+    while (handled < maxCount)
+    {
+        uint32_t want = maxCount - handled;
+        if (want > CA_RECEIVE_BATCH_SIZE)
+        {
+            want = CA_RECEIVE_BATCH_SIZE;
+        }
+
+        uint32_t count = CAQueueingThreadGetDataBatch(&g_receiveThread, items, want);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (NULL != items[i].msg)
+            {
+                CADispatchReceivedData((CAData_t *) items[i].msg);
+            }
+        }
+
+        handled += count;
+        if (count < want)
+        {
+            // queue is drained
+            return 0;
+        }
+    }
+
+    return CAQueueingThreadGetSize(&g_receiveThread);
+#else
+    (void)maxCount;
+    return 0;
 #endif // SINGLE_HANDLE
 #endif // SINGLE_THREAD
 }
 
+void CAHandleRequestResponseCallbacks()
+{
+    CAHandleRequestResponseCallbacksBatch(1);
+}
+
+CAResult_t CAWaitForReceivedData(uint64_t timeoutUs)
+{
+#if !defined(SINGLE_THREAD) && defined(SINGLE_HANDLE)
+    return CAQueueingThreadWaitForData(&g_receiveThread, timeoutUs) ?
+           CA_STATUS_OK : CA_REQUEST_TIMEOUT;
+#else
+    // data is read (SINGLE_THREAD) or dispatched by the receive thread itself
+    (void)timeoutUs;
+    return CA_NOT_SUPPORTED;
+#endif
+}
+
+void CAWakeUpReceivedDataWait()
+{
+#if !defined(SINGLE_THREAD) && defined(SINGLE_HANDLE)
+    CAQueueingThreadWakeUp(&g_receiveThread);
+#endif
+}
+
 static CAData_t* CAPrepareSendData(const CAEndpoint_t *endpoint, const void *sendData,
                                    CADataType_t dataType)
 {
     OIC_LOG(DEBUG, TAG, "CAPrepareSendData IN");
 
-    CAData_t *cadata = (CAData_t *) OICCalloc(1, sizeof(CAData_t));
+    CAData_t *cadata = CAAllocData();
     if (!cadata)
     {
         OIC_LOG(ERROR, TAG, "memory allocation failed");
@@ -972,11 +1162,57 @@ exit:
 #ifndef SINGLE_THREAD
     CADestroyData(cadata, sizeof(CAData_t));
 #else
-    OICFree(cadata);
+    CAFreeData(cadata);
 #endif
     return NULL;
 }
 
+#ifndef SINGLE_THREAD
+/**
+ * produce a streamed payload at once, for a message which is not sent block by block.
+ */
+static CAResult_t CAFlattenPayloadStream(CAData_t *data)
+{
+    CAInfo_t *info = NULL;
+    if (data->requestInfo)
+    {
+        info = &data->requestInfo->info;
+    }
+    else if (data->responseInfo)
+    {
+        info = &data->responseInfo->info;
+    }
+
+    if (!info || !info->payloadStream || info->payload)
+    {
+        return CA_STATUS_OK;
+    }
+
+    if (info->payloadSize)
+    {
+        uint8_t *payload = (uint8_t *) OICMalloc(info->payloadSize);
+        if (!payload)
+        {
+            OIC_LOG(ERROR, TAG, "out of memory");
+            return CA_MEMORY_ALLOC_FAILED;
+        }
+
+        CAResult_t res = CAReadPayloadStream(info->payloadStream, 0, payload,
+                                             info->payloadSize);
+        if (CA_STATUS_OK != res)
+        {
+            OICFree(payload);
+            return res;
+        }
+        info->payload = payload;
+    }
+
+    CAFreePayloadStream(info->payloadStream);
+    info->payloadStream = NULL;
+    return CA_STATUS_OK;
+}
+#endif
+
 CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg,
                                CADataType_t dataType)
 {
@@ -990,7 +1226,7 @@ CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg
 
 #ifdef ARDUINO
     // If max retransmission queue is reached, then don't handle new request
-    if (CA_MAX_RT_ARRAY_SIZE == u_arraylist_length(g_retransmissionContext.dataList))
+    if (CA_MAX_RT_ARRAY_SIZE == g_retransmissionContext.dataCount)
     {
         OIC_LOG(ERROR, TAG, "max RT queue size reached!");
         return CA_SEND_FAILED;
@@ -1006,6 +1242,23 @@ CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg
 
     OIC_LOG_V(DEBUG, TAG, "device ID of endpoint of this message is %s", endpoint->remoteId);
 
+    // a streamed payload is produced block by block only by the block-wise transfer
+#ifndef SINGLE_THREAD
+#ifdef WITH_BWT
+    if (!CAIsSupportedBlockwiseTransfer(endpoint->adapter)
+        || (SEND_TYPE_UNICAST == data->type && CAIsLocalEndpoint(data->remoteEndpoint)))
+#endif
+    {
+        CAResult_t res = CAFlattenPayloadStream(data);
+        if (CA_STATUS_OK != res)
+        {
+            OIC_LOG(ERROR, TAG, "CAFlattenPayloadStream failed");
+            CADestroyData(data, sizeof(CAData_t));
+            return res;
+        }
+    }
+#endif
+
 #if defined(TCP_ADAPTER) && defined(WITH_CLOUD)
     CAResult_t ret = CACMGetMessageData(data);
     if (CA_STATUS_OK != ret)
@@ -1015,23 +1268,33 @@ CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg
 #endif
 
 #ifdef SINGLE_THREAD
+    // the infos of the caller are sent as they are, with nothing to produce a payload into
+    if ((data->requestInfo && data->requestInfo->info.payloadStream
+         && !data->requestInfo->info.payload)
+        || (data->responseInfo && data->responseInfo->info.payloadStream
+            && !data->responseInfo->info.payload))
+    {
+        OIC_LOG(ERROR, TAG, "streamed payload is not supported");
+        CAFreeData(data);
+        return CA_NOT_SUPPORTED;
+    }
+
     CAResult_t result = CAProcessSendData(data);
     if (CA_STATUS_OK != result)
     {
         OIC_LOG(ERROR, TAG, "CAProcessSendData failed");
-        OICFree(data);
+        CAFreeData(data);
         return result;
     }
 
-    OICFree(data);
+    CAFreeData(data);
 
 #else
     if (SEND_TYPE_UNICAST == data->type && CAIsLocalEndpoint(data->remoteEndpoint))
     {
         OIC_LOG(DEBUG, TAG,
                 "This is a loopback message. Transfer it to the receive queue directly");
-        CAQueueingThreadAddData(&g_receiveThread, data, sizeof(CAData_t));
-        return CA_STATUS_OK;
+        return CAQueueData(&g_receiveThread, data);
     }
 #ifdef WITH_BWT
     if (CAIsSupportedBlockwiseTransfer(endpoint->adapter))
@@ -1040,9 +1303,9 @@ CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg
         CAResult_t res = CASendBlockWiseData(data);
         if (CA_NOT_SUPPORTED == res)
         {
+            // a streamed payload is produced into the pdu by CAAddBlockOption
             OIC_LOG(DEBUG, TAG, "normal msg will be sent");
-            CAQueueingThreadAddData(&g_sendThread, data, sizeof(CAData_t));
-            return CA_STATUS_OK;
+            return CAQueueData(&g_sendThread, data);
         }
         else
         {
@@ -1053,7 +1316,7 @@ CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg
     else
 #endif // WITH_BWT
     {
-        CAQueueingThreadAddData(&g_sendThread, data, sizeof(CAData_t));
+        return CAQueueData(&g_sendThread, data);
     }
 #endif // SINGLE_THREAD
 
@@ -1075,10 +1338,31 @@ void CASetNetworkMonitorCallback(CANetworkMonitorCallback nwMonitorHandler)
 
 CAResult_t CAInitializeMessageHandler(CATransportAdapter_t transportType)
 {
+    // objects are taken from the heap if a pool is missing
+    if (CA_STATUS_OK != CAInitializeObjectPools())
+    {
+        OIC_LOG(WARNING, TAG, "Failed to Initialize object pools.");
+    }
+    if (NULL == g_dataPool)
+    {
+        g_dataPool = u_mempool_create(sizeof(CAData_t), CA_OBJECT_POOL_PREALLOC,
+                                      CA_OBJECT_POOL_SIZE);
+    }
+
     CASetPacketReceivedCallback(CAReceivedPacketCallback);
     CASetErrorHandleCallback(CAErrorHandler);
 
 #ifndef SINGLE_THREAD
+    if (NULL == g_historyMutex)
+    {
+        g_historyMutex = oc_mutex_new();
+        if (NULL == g_historyMutex)
+        {
+            OIC_LOG(ERROR, TAG, "history mutex create error.");
+            return CA_MEMORY_ALLOC_FAILED;
+        }
+    }
+
     // create thread pool
     CAResult_t res = ca_thread_pool_init(MAX_THREAD_POOL_SIZE, &g_threadPoolHandle);
     if (CA_STATUS_OK != res)
@@ -1088,8 +1372,9 @@ CAResult_t CAInitializeMessageHandler(CATransportAdapter_t transportType)
     }
 
     // send thread initialize
-    res = CAQueueingThreadInitialize(&g_sendThread, g_threadPoolHandle,
-                                     CASendThreadProcess, CADestroyData);
+    res = CAQueueingThreadInitializeBounded(&g_sendThread, g_threadPoolHandle,
+                                            CASendThreadProcess, CADestroyData,
+                                            CA_SEND_QUEUE_SIZE, CA_QUEUE_FULL_BLOCK);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "Failed to Initialize send queue thread");
@@ -1105,8 +1390,9 @@ CAResult_t CAInitializeMessageHandler(CATransportAdapter_t transportType)
     }
 
     // receive thread initialize
-    res = CAQueueingThreadInitialize(&g_receiveThread, g_threadPoolHandle,
-                                     CAReceiveThreadProcess, CADestroyData);
+    res = CAQueueingThreadInitializeBounded(&g_receiveThread, g_threadPoolHandle,
+                                            CAReceiveThreadProcess, CADestroyData,
+                                            CA_RECEIVE_QUEUE_SIZE, CA_QUEUE_FULL_DROP);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "Failed to Initialize receive queue thread");
@@ -1124,8 +1410,11 @@ CAResult_t CAInitializeMessageHandler(CATransportAdapter_t transportType)
 #endif // SINGLE_HANDLE
 
     // retransmission initialize
+    CARetransmissionConfig_t config = { .supportType = DEFAULT_RETRANSMISSION_TYPE,
+                                        .tryingCount = DEFAULT_RETRANSMISSION_COUNT,
+                                        .nstart = g_retransmissionNStart };
     res = CARetransmissionInitialize(&g_retransmissionContext, g_threadPoolHandle,
-                                     CASendUnicastData, CATimeoutCallback, NULL);
+                                     CASendUnicastData, CATimeoutCallback, &config);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "Failed to Initialize Retransmission.");
@@ -1150,12 +1439,23 @@ CAResult_t CAInitializeMessageHandler(CATransportAdapter_t transportType)
         return res;
     }
 
+    // duplicate detection initialize
+    res = CADedupInitialize(&g_dedupContext);
+    if (CA_STATUS_OK != res)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to Initialize duplicate detection.");
+        return res;
+    }
+
     // initialize interface adapters by controller
     CAInitializeAdapters(g_threadPoolHandle, transportType);
 #else
     // retransmission initialize
+    CARetransmissionConfig_t config = { .supportType = DEFAULT_RETRANSMISSION_TYPE,
+                                        .tryingCount = DEFAULT_RETRANSMISSION_COUNT,
+                                        .nstart = g_retransmissionNStart };
     CAResult_t res = CARetransmissionInitialize(&g_retransmissionContext, NULL, CASendUnicastData,
-                                                CATimeoutCallback, NULL);
+                                                CATimeoutCallback, &config);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "Failed to Initialize Retransmission.");
@@ -1227,6 +1527,11 @@ void CATerminateMessageHandler()
 
     // terminate interface adapters by controller
     CATerminateAdapters();
+
+    CADedupTerminate(&g_dedupContext);
+
+    oc_mutex_free(g_historyMutex);
+    g_historyMutex = NULL;
 #else
     // terminate interface adapters by controller
     CATerminateAdapters();
@@ -1235,6 +1540,31 @@ void CATerminateMessageHandler()
     CARetransmissionStop(&g_retransmissionContext);
     CARetransmissionDestroy(&g_retransmissionContext);
 #endif // SINGLE_THREAD
+
+    CAMessagePoolStats_t stats;
+    CAGetMessagePoolStats(&stats);
+    OIC_LOG_V(INFO, TAG, "data pool hits %u misses %u, endpoint pool hits %u misses %u",
+              stats.data.hits, stats.data.misses,
+              stats.objects.endpoint.hits, stats.objects.endpoint.misses);
+
+    u_mempool_t *dataPool = g_dataPool;
+    g_dataPool = NULL;
+    u_mempool_delete(dataPool);
+    CATerminateObjectPools();
+}
+
+CAResult_t CASetRetransmissionNStart(uint8_t nstart)
+{
+    g_retransmissionNStart = nstart;
+    return CA_STATUS_OK;
+}
+
+void CAGetMessagePoolStats(CAMessagePoolStats_t *stats)
+{
+    VERIFY_NON_NULL_VOID(stats, TAG, "stats");
+
+    u_mempool_get_stats(g_dataPool, &stats->data);
+    CAGetObjectPoolStats(&stats->objects);
 }
 
 static void CALogPayloadInfo(CAInfo_t *info)
@@ -1277,11 +1607,12 @@ void CAErrorHandler(const CAEndpoint_t *endpoint,
 {
     OIC_LOG(DEBUG, TAG, "CAErrorHandler IN");
     VERIFY_NON_NULL_VOID(endpoint, TAG, "remoteEndpoint");
-    VERIFY_NON_NULL_VOID(data, TAG, "data");
 
-    if (0 == dataLen)
+    if (NULL == data || 0 == dataLen)
     {
-        OIC_LOG(ERROR, TAG, "dataLen is zero");
+        // the error is not about one message, e.g. a TLS session failed
+        CAInfo_t info = { .type = CA_MSG_NONCONFIRM };
+        CASendErrorInfo(endpoint, &info, result);
         return;
     }
 
@@ -1306,7 +1637,7 @@ void CAErrorHandler(const CAEndpoint_t *endpoint,
 
     cadata->errorInfo->result = result;
 
-    CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+    CAQueueData(&g_receiveThread, cadata);
     coap_delete_pdu(pdu);
 #else
     (void)result;
@@ -1320,7 +1651,7 @@ static void CASendErrorInfo(const CAEndpoint_t *endpoint, const CAInfo_t *info,
 {
     OIC_LOG(DEBUG, TAG, "CASendErrorInfo IN");
 #ifndef SINGLE_THREAD
-    CAData_t *cadata = (CAData_t *) OICCalloc(1, sizeof(CAData_t));
+    CAData_t *cadata = CAAllocData();
     if (!cadata)
     {
         OIC_LOG(ERROR, TAG, "cadata memory allocation failed");
@@ -1331,15 +1662,15 @@ static void CASendErrorInfo(const CAEndpoint_t *endpoint, const CAInfo_t *info,
     if (!ep)
     {
         OIC_LOG(ERROR, TAG, "endpoint clone failed");
-        OICFree(cadata);
+        CAFreeData(cadata);
         return;
     }
 
-    CAErrorInfo_t *errorInfo = (CAErrorInfo_t *)OICCalloc(1, sizeof (CAErrorInfo_t));
+    CAErrorInfo_t *errorInfo = CAAllocErrorInfo();
     if (!errorInfo)
     {
         OIC_LOG(ERROR, TAG, "errorInfo memory allocation failed");
-        OICFree(cadata);
+        CAFreeData(cadata);
         CAFreeEndpoint(ep);
         return;
     }
@@ -1348,8 +1679,8 @@ static void CASendErrorInfo(const CAEndpoint_t *endpoint, const CAInfo_t *info,
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "info clone failed");
-        OICFree(cadata);
-        OICFree(errorInfo);
+        CAFreeData(cadata);
+        CADestroyErrorInfoInternal(errorInfo);
         CAFreeEndpoint(ep);
         return;
     }
@@ -1359,7 +1690,7 @@ static void CASendErrorInfo(const CAEndpoint_t *endpoint, const CAInfo_t *info,
     cadata->errorInfo = errorInfo;
     cadata->dataType = CA_ERROR_DATA;
 
-    CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+    CAQueueData(&g_receiveThread, cadata);
 #endif
     OIC_LOG(DEBUG, TAG, "CASendErrorInfo OUT");
 }
@@ -43,12 +43,50 @@
 #include "oic_string.h"
 #include "ocrandom.h"
 #include "cacommonutil.h"
+#include "caremotehandler.h"
 
 #define TAG "OIC_CA_PRTCL_MSG"
 
 #define CA_PDU_MIN_SIZE (4)
 #define CA_ENCODE_BUFFER_SIZE (4)
 
+/** option delta and length nibbles followed by an extended value (RFC 7252, section 3.1). */
+#define CA_OPTION_EXT_8_BIT (13)
+#define CA_OPTION_EXT_16_BIT (14)
+#define CA_OPTION_EXT_RESERVED (15)
+#define CA_OPTION_EXT_16_BIT_BASE (269)
+
+/** most options CAEncodePDU takes, messages with more are built with an option list. */
+#define CA_ENCODE_MAX_OPTIONS (32)
+
+/** option of a message to be encoded. */
+typedef struct
+{
+    uint16_t key;                           /**< option number */
+    uint16_t length;                        /**< length of the value */
+    const uint8_t *value;                   /**< value, NULL if it is in buf */
+    uint8_t buf[CA_ENCODE_BUFFER_SIZE];     /**< uint values and other short values */
+} CAEncodeOption_t;
+
+/** options of a message to be encoded, sorted by option number. */
+typedef struct
+{
+    CAEncodeOption_t options[CA_ENCODE_MAX_OPTIONS];
+    uint32_t count;
+    unsigned char pathBuffer[CA_MAX_URI_LENGTH];    /**< values of the Uri-Path options */
+    unsigned char queryBuffer[CA_MAX_URI_LENGTH];   /**< values of the Uri-Query options */
+} CAEncodeOptions_t;
+
+static bool CAIsOptionListNeeded(const CAEndpoint_t *endpoint);
+static CAResult_t CAParseInfoOptions(code_t code, const CAInfo_t *info, coap_list_t **optlist);
+static coap_pdu_t *CAGenerateEncodedPDU(code_t code, const CAInfo_t *info,
+                                        const CAEndpoint_t *endpoint,
+                                        coap_transport_t *transport, CAResult_t *result);
+#ifdef WITH_BWT
+static coap_pdu_t *CAGenerateBlockHeaderPDU(code_t code, const CAInfo_t *info,
+                                            coap_transport_t *transport);
+#endif
+
 static const char COAP_URI_HEADER[] = "coap://[::]/";
 
 static char g_chproxyUri[CA_MAX_URI_LENGTH];
@@ -107,6 +145,25 @@ coap_pdu_t *CAGeneratePDU(uint32_t code, const CAInfo_t *info, const CAEndpoint_
     OIC_LOG_V(DEBUG, TAG, "generate pdu for [%d]adapter, [%d]flags",
               endpoint->adapter, endpoint->flags);
 
+#ifdef WITH_BWT
+    if (CAIsSupportedBlockwiseTransfer(endpoint->adapter))
+    {
+        // options and payload are added with the block options by CAAddBlockOption
+        return CAGenerateBlockHeaderPDU((code_t) code, info, transport);
+    }
+#endif
+
+    if (!CAIsOptionListNeeded(endpoint))
+    {
+        CAResult_t res = CA_STATUS_OK;
+        coap_pdu_t *pdu = CAGenerateEncodedPDU((code_t) code, info, endpoint, transport, &res);
+        if (CA_NOT_SUPPORTED != res)
+        {
+            return pdu;
+        }
+        OIC_LOG(DEBUG, TAG, "too many options, use option list");
+    }
+
     coap_pdu_t *pdu = NULL;
 
     // RESET have to use only 4byte (empty message)
@@ -134,40 +191,7 @@ coap_pdu_t *CAGeneratePDU(uint32_t code, const CAInfo_t *info, const CAEndpoint_
     }
     else
     {
-        if (info->resourceUri)
-        {
-            OIC_LOG_V(DEBUG, TAG, "uri : %s", info->resourceUri);
-
-            uint32_t length = strlen(info->resourceUri);
-            if (CA_MAX_URI_LENGTH < length)
-            {
-                OIC_LOG(ERROR, TAG, "URI len err");
-                return NULL;
-            }
-
-            uint32_t uriLength = length + sizeof(COAP_URI_HEADER);
-            char *coapUri = (char *) OICCalloc(1, uriLength);
-            if (NULL == coapUri)
-            {
-                OIC_LOG(ERROR, TAG, "out of memory");
-                return NULL;
-            }
-            OICStrcat(coapUri, uriLength, COAP_URI_HEADER);
-            OICStrcat(coapUri, uriLength, info->resourceUri);
-
-            // parsing options in URI
-            CAResult_t res = CAParseURI(coapUri, optlist);
-            if (CA_STATUS_OK != res)
-            {
-                OICFree(coapUri);
-                return NULL;
-            }
-
-            OICFree(coapUri);
-        }
-        // parsing options in HeadOption
-        CAResult_t ret = CAParseHeadOption(code, info, optlist);
-        if (CA_STATUS_OK != ret)
+        if (CA_STATUS_OK != CAParseInfoOptions((code_t) code, info, optlist))
         {
             return NULL;
         }
@@ -184,6 +208,45 @@ coap_pdu_t *CAGeneratePDU(uint32_t code, const CAInfo_t *info, const CAEndpoint_
     return pdu;
 }
 
+/**
+ * add the options of the resource URI and the header options of info to optlist.
+ */
+static CAResult_t CAParseInfoOptions(code_t code, const CAInfo_t *info, coap_list_t **optlist)
+{
+    if (info->resourceUri)
+    {
+        OIC_LOG_V(DEBUG, TAG, "uri : %s", info->resourceUri);
+
+        uint32_t length = strlen(info->resourceUri);
+        if (CA_MAX_URI_LENGTH < length)
+        {
+            OIC_LOG(ERROR, TAG, "URI len err");
+            return CA_STATUS_INVALID_PARAM;
+        }
+
+        uint32_t uriLength = length + sizeof(COAP_URI_HEADER);
+        char *coapUri = (char *) OICCalloc(1, uriLength);
+        if (NULL == coapUri)
+        {
+            OIC_LOG(ERROR, TAG, "out of memory");
+            return CA_MEMORY_ALLOC_FAILED;
+        }
+        OICStrcat(coapUri, uriLength, COAP_URI_HEADER);
+        OICStrcat(coapUri, uriLength, info->resourceUri);
+
+        // parsing options in URI
+        CAResult_t res = CAParseURI(coapUri, optlist);
+        OICFree(coapUri);
+        if (CA_STATUS_OK != res)
+        {
+            return res;
+        }
+    }
+
+    // parsing options in HeadOption
+    return CAParseHeadOption(code, info, optlist);
+}
+
 coap_pdu_t *CAParsePDU(const char *data, size_t length, uint32_t *outCode,
                        const CAEndpoint_t *endpoint)
 {
@@ -402,6 +465,681 @@ coap_pdu_t *CAGeneratePDUImpl(code_t code, const CAInfo_t *info,
     return pdu;
 }
 
+/**
+ * whether the options have to be passed as a list. Messages of the blockwise transfer
+ * adapters are encoded by CAGenerateBlockPDU, other messages are encoded in one pass.
+ */
+static bool CAIsOptionListNeeded(const CAEndpoint_t *endpoint)
+{
+#ifdef WITH_BWT
+    // CAGeneratePDUImpl leaves the options of these messages to CAAddBlockOption.
+    return CA_ADAPTER_GATT_BTLE != endpoint->adapter
+#ifdef WITH_TCP
+           && !CAIsSupportedCoAPOverTCP(endpoint->adapter)
+#endif
+           ;
+#else
+    (void) endpoint;
+    return false;
+#endif
+}
+
+/**
+ * add an option in order of option number, after options with the same number.
+ * uint options are shortened as CACreateNewOptionNode does.
+ * @return CA_NOT_SUPPORTED if there is no room for the option.
+ */
+static CAResult_t CAAddEncodeOption(CAEncodeOptions_t *opts, uint16_t key, uint32_t length,
+                                    const uint8_t *value)
+{
+    VERIFY_NON_NULL(value, TAG, "value");
+
+    if (CA_ENCODE_MAX_OPTIONS <= opts->count || UINT16_MAX < length)
+    {
+        return CA_NOT_SUPPORTED;
+    }
+
+    uint32_t index = opts->count;
+    while (index > 0 && opts->options[index - 1].key > key)
+    {
+        opts->options[index] = opts->options[index - 1];
+        index--;
+    }
+
+    CAEncodeOption_t *option = &opts->options[index];
+    option->key = key;
+
+    coap_option_def_t* def = coap_opt_def(key);
+    if (NULL != def && coap_is_var_bytes(def))
+    {
+        if (length > def->max)
+        {
+            value = &(value[length - def->max]);
+            length = def->max;
+        }
+        option->length = coap_encode_var_bytes(option->buf,
+                                               coap_decode_var_bytes((unsigned char *) value,
+                                                                     length));
+        option->value = NULL;
+    }
+    else if (length <= sizeof(option->buf))
+    {
+        // short values may live on the stack of the caller, as the version options do
+        memcpy(option->buf, value, length);
+        option->length = length;
+        option->value = NULL;
+    }
+    else
+    {
+        option->length = length;
+        option->value = value;
+    }
+
+    opts->count++;
+    return CA_STATUS_OK;
+}
+
+static CAResult_t CAAddEncodeUriOptions(CAEncodeOptions_t *opts, const unsigned char *str,
+                                        size_t length, uint16_t target,
+                                        unsigned char *buf, size_t buflen)
+{
+    int res = (COAP_OPTION_URI_PATH == target) ? coap_split_path(str, length, buf, &buflen) :
+                                                 coap_split_query(str, length, buf, &buflen);
+    if (res <= 0)
+    {
+        OIC_LOG_V(ERROR, TAG, "Problem parsing URI : %d for %d", res, target);
+        return CA_STATUS_FAILED;
+    }
+
+    size_t prevIdx = 0;
+    while (res--)
+    {
+        CAResult_t ret = CAAddEncodeOption(opts, target, COAP_OPT_LENGTH(buf),
+                                           COAP_OPT_VALUE(buf));
+        if (CA_STATUS_OK != ret)
+        {
+            return ret;
+        }
+
+        size_t optSize = COAP_OPT_SIZE(buf);
+        if ((prevIdx + optSize) < buflen)
+        {
+            buf += optSize;
+            prevIdx += optSize;
+        }
+    }
+    return CA_STATUS_OK;
+}
+
+static CAResult_t CAAddEncodeFormatOptions(CAEncodeOptions_t *opts, CAPayloadFormat_t format,
+                                           uint16_t formatOption, uint16_t versionOption,
+                                           uint16_t version)
+{
+    uint8_t encodeBuf[CA_ENCODE_BUFFER_SIZE] = { 0 };
+    uint8_t versionBuf[CA_ENCODE_BUFFER_SIZE] = { 0 };
+
+    switch (format)
+    {
+        case CA_FORMAT_APPLICATION_CBOR:
+            return CAAddEncodeOption(opts, formatOption,
+                    coap_encode_var_bytes(encodeBuf,
+                            (unsigned short) COAP_MEDIATYPE_APPLICATION_CBOR), encodeBuf);
+        case CA_FORMAT_APPLICATION_VND_OCF_CBOR:
+        {
+            CAResult_t res = CAAddEncodeOption(opts, formatOption,
+                    coap_encode_var_bytes(encodeBuf,
+                            (unsigned short) COAP_MEDIATYPE_APPLICATION_VND_OCF_CBOR),
+                    encodeBuf);
+            if (CA_STATUS_OK != res)
+            {
+                return res;
+            }
+            // Include payload version information for this format.
+            return CAAddEncodeOption(opts, versionOption,
+                    coap_encode_var_bytes(versionBuf, version), versionBuf);
+        }
+        default:
+            OIC_LOG_V(ERROR, TAG, "Format option:[%d] not supported", format);
+            return CA_STATUS_INVALID_PARAM;
+    }
+}
+
+/**
+ * collect the options CAParseURI and CAParseHeadOption would put in the option list.
+ */
+static CAResult_t CACollectEncodeOptions(const CAInfo_t *info, CAEncodeOptions_t *opts)
+{
+    opts->count = 0;
+
+    if (info->resourceUri)
+    {
+        OIC_LOG_V(DEBUG, TAG, "uri : %s", info->resourceUri);
+
+        if (CA_MAX_URI_LENGTH < strlen(info->resourceUri))
+        {
+            OIC_LOG(ERROR, TAG, "URI len err");
+            return CA_STATUS_INVALID_PARAM;
+        }
+
+        char coapUri[sizeof(COAP_URI_HEADER) + CA_MAX_URI_LENGTH] = { 0 };
+        OICStrcpy(coapUri, sizeof(coapUri), COAP_URI_HEADER);
+        OICStrcat(coapUri, sizeof(coapUri), info->resourceUri);
+
+        /* split arg into Uri-* options */
+        coap_uri_t uri;
+        coap_split_uri((unsigned char *) coapUri, strlen(coapUri), &uri);
+
+        if (uri.port != COAP_DEFAULT_PORT)
+        {
+            unsigned char portbuf[CA_ENCODE_BUFFER_SIZE] = { 0 };
+            CAResult_t res = CAAddEncodeOption(opts, COAP_OPTION_URI_PORT,
+                                               coap_encode_var_bytes(portbuf, uri.port),
+                                               portbuf);
+            if (CA_STATUS_OK != res)
+            {
+                return res;
+            }
+        }
+
+        if (uri.path.s && uri.path.length)
+        {
+            CAResult_t res = CAAddEncodeUriOptions(opts, uri.path.s, uri.path.length,
+                                                   COAP_OPTION_URI_PATH, opts->pathBuffer,
+                                                   sizeof(opts->pathBuffer));
+            if (CA_STATUS_OK != res)
+            {
+                OIC_LOG(ERROR, TAG, "CAAddEncodeUriOptions failed(uri path)");
+                return res;
+            }
+        }
+
+        if (uri.query.s && uri.query.length)
+        {
+            CAResult_t res = CAAddEncodeUriOptions(opts, uri.query.s, uri.query.length,
+                                                   COAP_OPTION_URI_QUERY, opts->queryBuffer,
+                                                   sizeof(opts->queryBuffer));
+            if (CA_STATUS_OK != res)
+            {
+                OIC_LOG(ERROR, TAG, "CAAddEncodeUriOptions failed(uri query)");
+                return res;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < info->numOptions; i++)
+    {
+        const CAHeaderOption_t *option = &info->options[i];
+        if (COAP_OPTION_URI_PATH == option->optionID || COAP_OPTION_URI_QUERY == option->optionID)
+        {
+            OIC_LOG_V(DEBUG, TAG, "not Head Opt: %d", option->optionID);
+            continue;
+        }
+
+        CAResult_t res = CAAddEncodeOption(opts, option->optionID, option->optionLength,
+                                           (const uint8_t *) option->optionData);
+        if (CA_STATUS_OK != res)
+        {
+            return res;
+        }
+    }
+
+    // same options as CAParseHeadOption inserts, a format that is not supported is skipped.
+    if (CA_FORMAT_UNDEFINED != info->payloadFormat)
+    {
+        CAResult_t res = CAAddEncodeFormatOptions(opts, info->payloadFormat,
+                                                  COAP_OPTION_CONTENT_FORMAT,
+                                                  COAP_OPTION_CONTENT_VERSION,
+                                                  info->payloadVersion);
+        if (CA_NOT_SUPPORTED == res)
+        {
+            return res;
+        }
+    }
+
+    if (CA_FORMAT_UNDEFINED != info->acceptFormat)
+    {
+        CAResult_t res = CAAddEncodeFormatOptions(opts, info->acceptFormat, COAP_OPTION_ACCEPT,
+                                                  info->acceptVersion,
+                                                  COAP_OPTION_ACCEPT_VERSION);
+        if (CA_NOT_SUPPORTED == res)
+        {
+            return res;
+        }
+    }
+
+    return CA_STATUS_OK;
+}
+
+/**
+ * check the information of a message without code, which consists of the header only.
+ * @param[out]  isEmpty     set if the message is an empty RESET or ACKNOWLEDGE.
+ */
+static CAResult_t CACheckEmptyMessage(code_t code, const CAInfo_t *info, bool *isEmpty)
+{
+    // RESET have to use only 4byte (empty message)
+    // and ACKNOWLEDGE can use empty message when code is empty.
+    *isEmpty = CA_MSG_RESET == info->type
+               || (CA_EMPTY == code && CA_MSG_ACKNOWLEDGE == info->type);
+    if (!*isEmpty)
+    {
+        return CA_STATUS_OK;
+    }
+
+    if (CA_EMPTY != code)
+    {
+        OIC_LOG(ERROR, TAG, "reset is not empty message");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    if (info->payloadSize > 0 || info->payload || info->token || info->tokenLength > 0)
+    {
+        OIC_LOG(ERROR, TAG, "Empty message has unnecessary data after messageID");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    return CA_STATUS_OK;
+}
+
+/**
+ * bytes of extended option delta or length, as coap_opt_setheader writes them.
+ */
+static size_t CAGetOptionExtLength(uint32_t value)
+{
+    return value < 13 ? 0 : (value < 270 ? 1 : 2);
+}
+
+/**
+ * calculate the length of the encoded message and choose its header format.
+ * @param[in]   endpoint        endpoint, NULL for a blockwise transfer message over UDP.
+ * @param[out]  transport       header format.
+ * @param[out]  tokenLength     length of the token to write.
+ * @param[out]  msgLength       length of the options and the payload.
+ * @return  length of the message.
+ */
+static size_t CAGetEncodedLength(code_t code, const CAInfo_t *info,
+                                 const CAEndpoint_t *endpoint, const CAEncodeOptions_t *opts,
+                                 size_t payloadLength, coap_transport_t *transport,
+                                 uint8_t *tokenLength, size_t *msgLength)
+{
+    *tokenLength = 0;
+    if (info->token && CA_EMPTY != code)
+    {
+        if (CA_MAX_TOKEN_LEN < info->tokenLength)
+        {
+            OIC_LOG(ERROR, TAG, "can't add token");
+        }
+        else
+        {
+            *tokenLength = info->tokenLength;
+        }
+    }
+
+    size_t length = 0;
+    uint16_t prevKey = 0;
+    for (uint32_t i = 0; i < opts->count; i++)
+    {
+        const CAEncodeOption_t *option = &opts->options[i];
+        length += 1 + CAGetOptionExtLength(option->key - prevKey)
+                  + CAGetOptionExtLength(option->length) + option->length;
+        prevKey = option->key;
+    }
+
+    if (0 < payloadLength)
+    {
+        length += PAYLOAD_MARKER + payloadLength;
+    }
+    *msgLength = length;
+
+#ifdef WITH_TCP
+    if (endpoint && CAIsSupportedCoAPOverTCP(endpoint->adapter))
+    {
+        *transport = coap_get_tcp_header_type_from_size(length);
+        return coap_get_tcp_header_length_for_transport(*transport) + *tokenLength + length;
+    }
+#else
+    (void) endpoint;
+#endif
+
+    *transport = COAP_UDP;
+    return sizeof(coap_hdr_t) + *tokenLength + length;
+}
+
+/**
+ * write the message into buffer, which has room for the length CAGetEncodedLength returned.
+ * if payload is NULL, the caller writes the payloadLength bytes of payload.
+ * @return  the payload in buffer, NULL if there is none.
+ */
+static uint8_t *CAWriteEncodedPDU(code_t code, const CAInfo_t *info, uint16_t messageId,
+                                  const CAEncodeOptions_t *opts, const uint8_t *payload,
+                                  size_t payloadLength, coap_transport_t transport,
+                                  uint8_t tokenLength, size_t msgLength, uint8_t *buffer)
+{
+    uint8_t *p = buffer;
+
+#ifdef WITH_TCP
+    if (COAP_UDP != transport)
+    {
+        size_t headerLength = coap_get_tcp_header_length_for_transport(transport);
+        size_t extLength = 0;
+        switch (transport)
+        {
+            case COAP_TCP_8BIT:
+                p[0] = COAP_TCP_LENGTH_FIELD_NUM_8_BIT << 4;
+                extLength = msgLength - COAP_TCP_LENGTH_FIELD_8_BIT;
+                break;
+            case COAP_TCP_16BIT:
+                p[0] = COAP_TCP_LENGTH_FIELD_NUM_16_BIT << 4;
+                extLength = msgLength - COAP_TCP_LENGTH_FIELD_16_BIT;
+                break;
+            case COAP_TCP_32BIT:
+                p[0] = COAP_TCP_LENGTH_FIELD_NUM_32_BIT << 4;
+                extLength = msgLength - COAP_TCP_LENGTH_FIELD_32_BIT;
+                break;
+            default:
+                p[0] = msgLength << 4;
+                break;
+        }
+        p[0] |= tokenLength;
+
+        // extended length in network byte order, then the code.
+        for (size_t i = headerLength - 2; i > 0; i--)
+        {
+            p[i] = extLength & 0xFF;
+            extLength >>= 8;
+        }
+        p[headerLength - 1] = COAP_RESPONSE_CODE(code);
+        p += headerLength;
+    }
+    else
+#else
+    (void) transport;
+    (void) msgLength;
+#endif
+    {
+        if (0 == messageId)
+        {
+            /* initialize message id */
+            prng((uint8_t *) &messageId, sizeof(messageId));
+            OIC_LOG_V(DEBUG, TAG, "gen msg id=%d", messageId);
+        }
+
+        p[0] = (COAP_DEFAULT_VERSION << 6) | ((info->type & 0x03) << 4) | tokenLength;
+        p[1] = COAP_RESPONSE_CODE(code);
+        // the same bytes as an assignment to coap_hdr_t.id
+        memcpy(&p[2], &messageId, sizeof(messageId));
+        p += sizeof(coap_hdr_t);
+    }
+
+    if (tokenLength)
+    {
+        memcpy(p, info->token, tokenLength);
+        p += tokenLength;
+    }
+
+    uint16_t prevKey = 0;
+    for (uint32_t i = 0; i < opts->count; i++)
+    {
+        const CAEncodeOption_t *option = &opts->options[i];
+        const uint8_t *value = option->value ? option->value : option->buf;
+        size_t optionSize = 1 + CAGetOptionExtLength(option->key - prevKey)
+                            + CAGetOptionExtLength(option->length) + option->length;
+        p += coap_opt_encode(p, optionSize, option->key - prevKey, value, option->length);
+        prevKey = option->key;
+    }
+
+    if (0 < payloadLength)
+    {
+        *p++ = COAP_PAYLOAD_START;
+        if (payload)
+        {
+            memcpy(p, payload, payloadLength);
+        }
+        return p;
+    }
+    return NULL;
+}
+
+CAResult_t CAEncodePDU(code_t code, const CAInfo_t *info, const CAEndpoint_t *endpoint,
+                       uint8_t *buffer, size_t bufferSize, size_t *outLength,
+                       coap_transport_t *transport)
+{
+    VERIFY_NON_NULL(info, TAG, "info");
+    VERIFY_NON_NULL(endpoint, TAG, "endpoint");
+    VERIFY_NON_NULL(outLength, TAG, "outLength");
+    VERIFY_NON_NULL(transport, TAG, "transport");
+
+    bool isEmpty = false;
+    CAResult_t res = CACheckEmptyMessage(code, info, &isEmpty);
+    if (CA_STATUS_OK != res)
+    {
+        return res;
+    }
+
+    CAEncodeOptions_t opts;
+    opts.count = 0;
+    if (!isEmpty)
+    {
+        res = CACollectEncodeOptions(info, &opts);
+        if (CA_STATUS_OK != res)
+        {
+            return res;
+        }
+    }
+
+    uint8_t tokenLength = 0;
+    size_t msgLength = 0;
+    size_t payloadLength = info->payload ? info->payloadSize : 0;
+    *outLength = CAGetEncodedLength(code, info, endpoint, &opts, payloadLength, transport,
+                                    &tokenLength, &msgLength);
+    if (NULL == buffer)
+    {
+        return CA_STATUS_OK;
+    }
+
+    if (bufferSize < *outLength)
+    {
+        OIC_LOG_V(ERROR, TAG, "buffer too small, %zu needed", *outLength);
+        return CA_STATUS_FAILED;
+    }
+
+    CAWriteEncodedPDU(code, info, info->messageId, &opts, (const uint8_t *) info->payload,
+                      payloadLength, *transport, tokenLength, msgLength, buffer);
+    return CA_STATUS_OK;
+}
+
+/**
+ * generate a pdu of the exact message length from the collected options.
+ * if payload is NULL, the caller writes the payloadLength bytes of payload to the data
+ * of the pdu.
+ * @param[in]   endpoint    endpoint, NULL for a blockwise transfer message over UDP.
+ */
+static coap_pdu_t *CAEncodeToPDU(code_t code, const CAInfo_t *info, uint16_t messageId,
+                                 const CAEndpoint_t *endpoint, const CAEncodeOptions_t *opts,
+                                 const uint8_t *payload, size_t payloadLength,
+                                 coap_transport_t *transport, CAResult_t *result)
+{
+    uint8_t tokenLength = 0;
+    size_t msgLength = 0;
+    size_t length = CAGetEncodedLength(code, info, endpoint, opts, payloadLength, transport,
+                                       &tokenLength, &msgLength);
+    if (COAP_UDP == *transport && COAP_MAX_PDU_SIZE < length)
+    {
+        OIC_LOG_V(ERROR, TAG, "message too large for pdu: %zu", length);
+        *result = CA_STATUS_FAILED;
+        return NULL;
+    }
+
+    coap_pdu_t *pdu = coap_pdu_init2(0, 0, ntohs(COAP_INVALID_TID), length, *transport);
+    if (NULL == pdu)
+    {
+        OIC_LOG(ERROR, TAG, "malloc failed");
+        *result = CA_MEMORY_ALLOC_FAILED;
+        return NULL;
+    }
+
+    pdu->data = CAWriteEncodedPDU(code, info, messageId, opts, payload, payloadLength,
+                                  *transport, tokenLength, msgLength,
+                                  (uint8_t *) pdu->transport_hdr);
+    pdu->length = length;
+    pdu->max_delta = opts->count ? opts->options[opts->count - 1].key : 0;
+
+    OIC_LOG_V(DEBUG, TAG, "transport type: %d, pdu length: %zu", *transport, length);
+    *result = CA_STATUS_OK;
+    return pdu;
+}
+
+/**
+ * generate a pdu of the exact message length with CAEncodePDU.
+ * @param[out]  result      CA_NOT_SUPPORTED if the message needs an option list.
+ */
+static coap_pdu_t *CAGenerateEncodedPDU(code_t code, const CAInfo_t *info,
+                                        const CAEndpoint_t *endpoint,
+                                        coap_transport_t *transport, CAResult_t *result)
+{
+    bool isEmpty = false;
+    *result = CACheckEmptyMessage(code, info, &isEmpty);
+    if (CA_STATUS_OK != *result)
+    {
+        return NULL;
+    }
+
+    CAEncodeOptions_t opts;
+    opts.count = 0;
+    if (!isEmpty)
+    {
+        *result = CACollectEncodeOptions(info, &opts);
+        if (CA_STATUS_OK != *result)
+        {
+            return NULL;
+        }
+    }
+
+    return CAEncodeToPDU(code, info, info->messageId, endpoint, &opts,
+                         (const uint8_t *) info->payload,
+                         info->payload ? info->payloadSize : 0, transport, result);
+}
+
+#ifdef WITH_BWT
+/**
+ * generate the header and the token of a blockwise transfer message.
+ */
+static coap_pdu_t *CAGenerateBlockHeaderPDU(code_t code, const CAInfo_t *info,
+                                            coap_transport_t *transport)
+{
+    bool isEmpty = false;
+    if (CA_STATUS_OK != CACheckEmptyMessage(code, info, &isEmpty))
+    {
+        return NULL;
+    }
+
+    CAEncodeOptions_t opts;
+    opts.count = 0;
+    CAResult_t res = CA_STATUS_OK;
+    return CAEncodeToPDU(code, info, info->messageId, NULL, &opts, NULL, 0, transport, &res);
+}
+
+/**
+ * generate a blockwise transfer message with an option list, for a message with more
+ * options than CAEncodePDU takes.
+ */
+static coap_pdu_t *CAGenerateBlockPDUWithList(const coap_pdu_t *pdu, code_t code,
+                                              const CAInfo_t *info, coap_list_t **optlist,
+                                              size_t payloadLength)
+{
+    if (CA_STATUS_OK != CAParseInfoOptions(code, info, optlist))
+    {
+        return NULL;
+    }
+
+    coap_pdu_t *blockPdu = coap_pdu_init2(pdu->transport_hdr->udp.type,
+                                          pdu->transport_hdr->udp.code,
+                                          pdu->transport_hdr->udp.id,
+                                          COAP_MAX_PDU_SIZE, COAP_UDP);
+    if (NULL == blockPdu)
+    {
+        OIC_LOG(ERROR, TAG, "malloc failed");
+        return NULL;
+    }
+
+    if (!coap_add_token2(blockPdu, pdu->transport_hdr->udp.token_length,
+                         pdu->transport_hdr->udp.token, COAP_UDP))
+    {
+        OIC_LOG(ERROR, TAG, "can't add token");
+        coap_delete_pdu(blockPdu);
+        return NULL;
+    }
+
+    for (coap_list_t *opt = *optlist; opt; opt = opt->next)
+    {
+        if (0 == coap_add_option(blockPdu, COAP_OPTION_KEY(*(coap_option *) opt->data),
+                                 COAP_OPTION_LENGTH(*(coap_option *) opt->data),
+                                 COAP_OPTION_DATA(*(coap_option *) opt->data)))
+        {
+            OIC_LOG(ERROR, TAG, "coap_add_option has failed");
+            coap_delete_pdu(blockPdu);
+            return NULL;
+        }
+    }
+
+    if (0 < payloadLength)
+    {
+        if (blockPdu->length + payloadLength + PAYLOAD_MARKER > blockPdu->max_size)
+        {
+            OIC_LOG(ERROR, TAG, "message too large for pdu");
+            coap_delete_pdu(blockPdu);
+            return NULL;
+        }
+        blockPdu->data = (unsigned char *) blockPdu->transport_hdr + blockPdu->length;
+        *blockPdu->data++ = COAP_PAYLOAD_START;
+        blockPdu->length += payloadLength + PAYLOAD_MARKER;
+    }
+    return blockPdu;
+}
+
+coap_pdu_t *CAGenerateBlockPDU(const coap_pdu_t *pdu, const CAInfo_t *info,
+                               coap_list_t **optlist, size_t payloadLength)
+{
+    VERIFY_NON_NULL_RET(pdu, TAG, "pdu", NULL);
+    VERIFY_NON_NULL_RET(info, TAG, "info", NULL);
+    VERIFY_NON_NULL_RET(optlist, TAG, "optlist", NULL);
+
+    code_t code = (code_t) CA_RESPONSE_CODE(pdu->transport_hdr->udp.code);
+    bool isEmpty = false;
+    CAResult_t res = CACheckEmptyMessage(code, info, &isEmpty);
+    if (CA_STATUS_OK != res)
+    {
+        return NULL;
+    }
+
+    CAEncodeOptions_t opts;
+    opts.count = 0;
+    if (!isEmpty)
+    {
+        res = CACollectEncodeOptions(info, &opts);
+        for (coap_list_t *opt = *optlist; CA_STATUS_OK == res && opt; opt = opt->next)
+        {
+            res = CAAddEncodeOption(&opts, COAP_OPTION_KEY(*(coap_option *) opt->data),
+                                    COAP_OPTION_LENGTH(*(coap_option *) opt->data),
+                                    COAP_OPTION_DATA(*(coap_option *) opt->data));
+        }
+
+        if (CA_NOT_SUPPORTED == res)
+        {
+            OIC_LOG(DEBUG, TAG, "too many options, use option list");
+            return CAGenerateBlockPDUWithList(pdu, code, info, optlist, payloadLength);
+        }
+        if (CA_STATUS_OK != res)
+        {
+            return NULL;
+        }
+    }
+
+    coap_transport_t transport = COAP_UDP;
+    return CAEncodeToPDU(code, info, pdu->transport_hdr->udp.id, NULL, &opts, NULL,
+                         payloadLength, &transport, &res);
+}
+#endif
+
 CAResult_t CAParseURI(const char *uriInfo, coap_list_t **optlist)
 {
     VERIFY_NON_NULL(uriInfo, TAG, "uriInfo");
@@ -693,6 +1431,24 @@ int CAOrderOpts(void *a, void *b)
     return COAP_OPTION_KEY(*(coap_option *) a) == COAP_OPTION_KEY(*(coap_option * ) b);
 }
 
+/**
+ * options that are handed to the application as CAHeaderOption_t, the others
+ * are consumed by CAGetInfoFromPDU.
+ */
+static bool CAIsHeaderOption(uint16_t number)
+{
+    return COAP_OPTION_URI_PATH != number && COAP_OPTION_URI_QUERY != number
+        && COAP_OPTION_BLOCK1 != number && COAP_OPTION_BLOCK2 != number
+        && COAP_OPTION_SIZE1 != number && COAP_OPTION_SIZE2 != number
+        && COAP_OPTION_CONTENT_FORMAT != number
+        && COAP_OPTION_ACCEPT != number
+        && COAP_OPTION_CONTENT_VERSION != number
+        && COAP_OPTION_ACCEPT_VERSION != number
+        && COAP_OPTION_URI_HOST != number && COAP_OPTION_URI_PORT != number
+        && COAP_OPTION_ETAG != number && COAP_OPTION_MAXAGE != number
+        && COAP_OPTION_PROXY_SCHEME != number;
+}
+
 uint32_t CAGetOptionCount(coap_opt_iterator_t opt_iter)
 {
     uint32_t count = 0;
@@ -700,16 +1456,7 @@ uint32_t CAGetOptionCount(coap_opt_iterator_t opt_iter)
 
     while ((option = coap_option_next(&opt_iter)))
     {
-        if (COAP_OPTION_URI_PATH != opt_iter.type && COAP_OPTION_URI_QUERY != opt_iter.type
-            && COAP_OPTION_BLOCK1 != opt_iter.type && COAP_OPTION_BLOCK2 != opt_iter.type
-            && COAP_OPTION_SIZE1 != opt_iter.type && COAP_OPTION_SIZE2 != opt_iter.type
-            && COAP_OPTION_CONTENT_FORMAT != opt_iter.type
-            && COAP_OPTION_ACCEPT != opt_iter.type
-            && COAP_OPTION_CONTENT_VERSION != opt_iter.type
-            && COAP_OPTION_ACCEPT_VERSION != opt_iter.type
-            && COAP_OPTION_URI_HOST != opt_iter.type && COAP_OPTION_URI_PORT != opt_iter.type
-            && COAP_OPTION_ETAG != opt_iter.type && COAP_OPTION_MAXAGE != opt_iter.type
-            && COAP_OPTION_PROXY_SCHEME != opt_iter.type)
+        if (CAIsHeaderOption(opt_iter.type))
         {
             count++;
         }
@@ -738,8 +1485,13 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
         transport = COAP_UDP;
     }
 
-    coap_opt_iterator_t opt_iter;
-    coap_option_iterator_init2((coap_pdu_t *) pdu, &opt_iter, COAP_OPT_ALL, transport);
+    // the options are read in place, only header options are copied to outInfo
+    CAOptionIterator_t optIter;
+    CAResult_t res = CAOptionIteratorInit(&optIter, pdu->transport_hdr, pdu->length, endpoint);
+    if (CA_STATUS_OK != res)
+    {
+        return res;
+    }
 
     if (outCode)
     {
@@ -747,7 +1499,18 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
     }
 
     // init HeaderOption list
-    uint32_t count = CAGetOptionCount(opt_iter);
+    uint32_t count = 0;
+    uint16_t number = 0;
+    const uint8_t *value = NULL;
+    uint16_t valueLength = 0;
+    CAOptionIterator_t countIter = optIter;
+    while (CAOptionIteratorNext(&countIter, &number, &value, &valueLength))
+    {
+        if (CAIsHeaderOption(number))
+        {
+            count++;
+        }
+    }
     memset(outInfo, 0, sizeof(*outInfo));
 
     outInfo->numOptions = count;
@@ -760,8 +1523,6 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
         outInfo->payloadFormat = CA_FORMAT_UNDEFINED;
     }
     else
-#else
-    (void) endpoint;
 #endif
     {
         // set type
@@ -783,7 +1544,6 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
         }
     }
 
-    coap_opt_t *option = NULL;
     char optionResult[CA_MAX_URI_LENGTH] = {0};
     uint32_t idx = 0;
     uint32_t optionLength = 0;
@@ -791,16 +1551,26 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
     bool isQueryBeingProcessed = false;
     bool isProxyRequest = false;
 
-    while ((option = coap_option_next(&opt_iter)))
+    while (CAOptionIteratorNext(&optIter, &number, &value, &valueLength))
     {
-        char buf[COAP_MAX_PDU_SIZE] = {0};
-        uint32_t bufLength =
-            CAGetOptionData(opt_iter.type, (uint8_t *)(COAP_OPT_VALUE(option)),
-                    COAP_OPT_LENGTH(option), (uint8_t *)buf, sizeof(buf));
+        // A 0 length option is permitted in CoAP but the rest of the stack is
+        // unaware of variable byte encoding, so it reads as a 0 byte of length 1.
+        static const uint8_t zeroByte = 0;
+        uint32_t bufLength = valueLength;
+        if (0 == valueLength)
+        {
+            coap_option_def_t *def = coap_opt_def(number);
+            if (NULL != def && coap_is_var_bytes(def))
+            {
+                value = &zeroByte;
+                bufLength = 1;
+            }
+        }
+
         if (bufLength)
         {
-            OIC_LOG_V(DEBUG, TAG, "COAP URI element : %s", buf);
-            if (COAP_OPTION_URI_PATH == opt_iter.type || COAP_OPTION_URI_QUERY == opt_iter.type)
+            OIC_LOG_V(DEBUG, TAG, "COAP URI element : %.*s", (int) bufLength, (const char *) value);
+            if (COAP_OPTION_URI_PATH == number || COAP_OPTION_URI_QUERY == number)
             {
                 if (false == isfirstsetflag)
                 {
@@ -810,7 +1580,7 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
                     // Make sure there is enough room in the optionResult buffer
                     if ((optionLength + bufLength) < sizeof(optionResult))
                     {
-                        memcpy(&optionResult[optionLength], buf, bufLength);
+                        memcpy(&optionResult[optionLength], value, bufLength);
                         optionLength += bufLength;
                     }
                     else
@@ -820,7 +1590,7 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
                 }
                 else
                 {
-                    if (COAP_OPTION_URI_PATH == opt_iter.type)
+                    if (COAP_OPTION_URI_PATH == number)
                     {
                         // Make sure there is enough room in the optionResult buffer
                         if (optionLength < sizeof(optionResult))
@@ -833,7 +1603,7 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
                             goto exit;
                         }
                     }
-                    else if (COAP_OPTION_URI_QUERY == opt_iter.type)
+                    else if (COAP_OPTION_URI_QUERY == number)
                     {
                         if (false == isQueryBeingProcessed)
                         {
@@ -866,7 +1636,7 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
                     // Make sure there is enough room in the optionResult buffer
                     if ((optionLength + bufLength) < sizeof(optionResult))
                     {
-                        memcpy(&optionResult[optionLength], buf, bufLength);
+                        memcpy(&optionResult[optionLength], value, bufLength);
                         optionLength += bufLength;
                     }
                     else
@@ -875,21 +1645,17 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
                     }
                 }
             }
-            else if (COAP_OPTION_BLOCK1 == opt_iter.type || COAP_OPTION_BLOCK2 == opt_iter.type
-                    || COAP_OPTION_SIZE1 == opt_iter.type || COAP_OPTION_SIZE2 == opt_iter.type)
+            else if (COAP_OPTION_BLOCK1 == number || COAP_OPTION_BLOCK2 == number
+                    || COAP_OPTION_SIZE1 == number || COAP_OPTION_SIZE2 == number)
             {
-                OIC_LOG_V(DEBUG, TAG, "option[%d] will be filtering", opt_iter.type);
+                OIC_LOG_V(DEBUG, TAG, "option[%d] will be filtering", number);
             }
-            else if (COAP_OPTION_CONTENT_FORMAT == opt_iter.type)
+            else if (COAP_OPTION_CONTENT_FORMAT == number)
             {
-                if (1 == COAP_OPT_LENGTH(option))
-                {
-                    outInfo->payloadFormat = CAConvertFormat((uint8_t)buf[0]);
-                }
-                else if (2 == COAP_OPT_LENGTH(option))
+                if (1 == bufLength || 2 == bufLength)
                 {
                     outInfo->payloadFormat = CAConvertFormat(
-                            coap_decode_var_bytes(COAP_OPT_VALUE(option), COAP_OPT_LENGTH(option)));
+                            coap_decode_var_bytes((unsigned char *) value, bufLength));
                 }
                 else
                 {
@@ -897,11 +1663,11 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
                     OIC_LOG(DEBUG, TAG, "option has an unsupported format");
                 }
             }
-            else if (COAP_OPTION_CONTENT_VERSION == opt_iter.type)
+            else if (COAP_OPTION_CONTENT_VERSION == number)
             {
-                if (2 == COAP_OPT_LENGTH(option))
+                if (2 == bufLength)
                 {
-                    outInfo->payloadVersion =  coap_decode_var_bytes(COAP_OPT_VALUE(option), COAP_OPT_LENGTH(option));
+                    outInfo->payloadVersion = coap_decode_var_bytes((unsigned char *) value, bufLength);
                 }
                 else
                 {
@@ -910,11 +1676,11 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
 
                 }
             }
-            else if (COAP_OPTION_ACCEPT_VERSION == opt_iter.type)
+            else if (COAP_OPTION_ACCEPT_VERSION == number)
             {
-                if (2 == COAP_OPT_LENGTH(option))
+                if (2 == bufLength)
                 {
-                    outInfo->acceptVersion = coap_decode_var_bytes(COAP_OPT_VALUE(option), COAP_OPT_LENGTH(option));
+                    outInfo->acceptVersion = coap_decode_var_bytes((unsigned char *) value, bufLength);
                 }
                 else
                 {
@@ -922,16 +1688,12 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
                     outInfo->acceptVersion = DEFAULT_ACCEPT_VERSION_VALUE;
                 }
             }
-            else if (COAP_OPTION_ACCEPT == opt_iter.type)
+            else if (COAP_OPTION_ACCEPT == number)
             {
-                if (1 == COAP_OPT_LENGTH(option))
-                {
-                    outInfo->acceptFormat = CAConvertFormat((uint8_t)buf[0]);
-                }
-                else if (2 == COAP_OPT_LENGTH(option))
+                if (1 == bufLength || 2 == bufLength)
                 {
                     outInfo->acceptFormat = CAConvertFormat(
-                            coap_decode_var_bytes(COAP_OPT_VALUE(option), COAP_OPT_LENGTH(option)));
+                            coap_decode_var_bytes((unsigned char *) value, bufLength));
                 }
                 else
                 {
@@ -939,18 +1701,18 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
                     OIC_LOG(DEBUG, TAG, "option has an unsupported accept format");
                 }
             }
-            else if (COAP_OPTION_URI_PORT == opt_iter.type ||
-                    COAP_OPTION_URI_HOST == opt_iter.type ||
-                    COAP_OPTION_ETAG == opt_iter.type ||
-                    COAP_OPTION_MAXAGE == opt_iter.type ||
-                    COAP_OPTION_PROXY_SCHEME== opt_iter.type)
+            else if (COAP_OPTION_URI_PORT == number ||
+                    COAP_OPTION_URI_HOST == number ||
+                    COAP_OPTION_ETAG == number ||
+                    COAP_OPTION_MAXAGE == number ||
+                    COAP_OPTION_PROXY_SCHEME== number)
             {
                 OIC_LOG_V(INFO, TAG, "option[%d] has an unsupported format [%d]",
-                          opt_iter.type, (uint8_t)buf[0]);
+                          number, value[0]);
             }
             else
             {
-                if (COAP_OPTION_PROXY_URI == opt_iter.type)
+                if (COAP_OPTION_PROXY_URI == number)
                 {
                     isProxyRequest = true;
                 }
@@ -958,10 +1720,10 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
                 {
                     if (bufLength <= sizeof(outInfo->options[0].optionData))
                     {
-                        outInfo->options[idx].optionID = opt_iter.type;
+                        outInfo->options[idx].optionID = number;
                         outInfo->options[idx].optionLength = bufLength;
                         outInfo->options[idx].protocolID = CA_COAP_ID;
-                        memcpy(outInfo->options[idx].optionData, buf, bufLength);
+                        memcpy(outInfo->options[idx].optionData, value, bufLength);
                         idx++;
                     }
                 }
@@ -977,7 +1739,8 @@ CAResult_t CAGetInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endpoint,
     if (token_length > 0)
     {
         OIC_LOG_V(DEBUG, TAG, "inside token length : %d", token_length);
-        outInfo->token = (char *) OICMalloc(token_length);
+        outInfo->token = (token_length <= CA_MAX_TOKEN_LEN) ? CAAllocToken()
+                                                             : (char *) OICMalloc(token_length);
         if (NULL == outInfo->token)
         {
             OIC_LOG(ERROR, TAG, "Out of memory");
@@ -1067,7 +1830,8 @@ CAResult_t CAGetTokenFromPDU(const coap_hdr_transport_t *pdu_hdr,
     if (token_length > 0)
     {
         OIC_LOG_V(DEBUG, TAG, "token len:%d", token_length);
-        outInfo->token = (char *) OICMalloc(token_length);
+        outInfo->token = (token_length <= CA_MAX_TOKEN_LEN) ? CAAllocToken()
+                                                             : (char *) OICMalloc(token_length);
         if (NULL == outInfo->token)
         {
             OIC_LOG(ERROR, TAG, "Out of memory");
@@ -1152,6 +1916,108 @@ uint32_t CAGetOptionData(uint16_t key, const uint8_t *data, uint32_t len,
     return len;
 }
 
+CAResult_t CAOptionIteratorInit(CAOptionIterator_t *iter, const void *pdu, size_t size,
+                                const CAEndpoint_t *endpoint)
+{
+    VERIFY_NON_NULL(iter, TAG, "iter");
+    VERIFY_NON_NULL(pdu, TAG, "pdu");
+    VERIFY_NON_NULL(endpoint, TAG, "endpoint");
+
+    const uint8_t *data = (const uint8_t *) pdu;
+    if (0 == size)
+    {
+        OIC_LOG(ERROR, TAG, "pdu is empty");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    size_t headerLength = sizeof(coap_hdr_t);
+#ifdef WITH_TCP
+    if (CAIsSupportedCoAPOverTCP(endpoint->adapter))
+    {
+        coap_transport_t transport = coap_get_tcp_header_type_from_initbyte(data[0] >> 4);
+        headerLength = coap_get_tcp_header_length_for_transport(transport);
+    }
+#endif
+
+    size_t tokenLength = data[0] & 0x0F;
+    if (size < headerLength + tokenLength)
+    {
+        OIC_LOG(ERROR, TAG, "pdu is truncated");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    iter->next = data + headerLength + tokenLength;
+    iter->end = data + size;
+    iter->number = 0;
+    return CA_STATUS_OK;
+}
+
+/**
+ * read the extended option delta or length following the option header.
+ * @return  false if the value is reserved or the pdu ends.
+ */
+static bool CAReadOptionExtValue(CAOptionIterator_t *iter, uint8_t nibble, uint32_t *value)
+{
+    switch (nibble)
+    {
+        case CA_OPTION_EXT_8_BIT:
+            if (iter->end - iter->next < 1)
+            {
+                return false;
+            }
+            *value = CA_OPTION_EXT_8_BIT + iter->next[0];
+            iter->next += 1;
+            return true;
+        case CA_OPTION_EXT_16_BIT:
+            if (iter->end - iter->next < 2)
+            {
+                return false;
+            }
+            *value = CA_OPTION_EXT_16_BIT_BASE + ((iter->next[0] << 8) | iter->next[1]);
+            iter->next += 2;
+            return true;
+        case CA_OPTION_EXT_RESERVED:
+            return false;
+        default:
+            *value = nibble;
+            return true;
+    }
+}
+
+bool CAOptionIteratorNext(CAOptionIterator_t *iter, uint16_t *number,
+                          const uint8_t **value, uint16_t *length)
+{
+    VERIFY_NON_NULL_RET(iter, TAG, "iter", false);
+    VERIFY_NON_NULL_RET(number, TAG, "number", false);
+    VERIFY_NON_NULL_RET(value, TAG, "value", false);
+    VERIFY_NON_NULL_RET(length, TAG, "length", false);
+
+    if (iter->next >= iter->end || COAP_PAYLOAD_START == *iter->next)
+    {
+        return false;
+    }
+
+    uint8_t header = *iter->next++;
+    uint32_t delta = 0;
+    uint32_t optionLength = 0;
+    if (!CAReadOptionExtValue(iter, header >> 4, &delta)
+        || !CAReadOptionExtValue(iter, header & 0x0F, &optionLength)
+        || (size_t) (iter->end - iter->next) < optionLength
+        || UINT16_MAX < iter->number + delta)
+    {
+        OIC_LOG(ERROR, TAG, "malformed option");
+        iter->next = iter->end;
+        return false;
+    }
+
+    iter->number += delta;
+    *number = iter->number;
+    *value = iter->next;
+    *length = (uint16_t) optionLength;
+    iter->next += optionLength;
+    return true;
+}
+
 CAMessageType_t CAGetMessageTypeFromPduBinaryData(const void *pdu, uint32_t size)
 {
     VERIFY_NON_NULL_RET(pdu, TAG, "pdu", CA_MSG_NONCONFIRM);
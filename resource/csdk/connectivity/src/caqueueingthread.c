@@ -30,11 +30,88 @@
 #endif
 
 #include "caqueueingthread.h"
+#include "caatomic.h"
 #include "oic_malloc.h"
+#include "oic_time.h"
 #include "logger.h"
 
 #define TAG PCF("OIC_CA_QING")
 
+/** Number of data the thread takes from a bounded queue per wakeup. **/
+#define CA_QUEUE_BATCH_SIZE 16
+
+/** Longest time CA_QUEUE_FULL_BLOCK waits for room, in microseconds. **/
+#ifndef CA_QUEUE_BLOCK_TIMEOUT_US
+#define CA_QUEUE_BLOCK_TIMEOUT_US (1000 * 1000)
+#endif
+
+/** Interval at which blocked producers re-check the queue, in microseconds. **/
+#define CA_QUEUE_BLOCK_INTERVAL_US (10 * 1000)
+
+static void CAQueueingThreadDestroyMessage(CAQueueingThread_t *thread, void *msg, uint32_t size)
+{
+    if (NULL != thread->destroy)
+    {
+        thread->destroy(msg, size);
+    }
+    else
+    {
+        OICFree(msg);
+    }
+}
+
+// wake producers blocked on a full ring
+static void CAQueueingThreadNotifySpace(CAQueueingThread_t *thread)
+{
+    if (CAAtomicLoad32(&thread->producersWaiting))
+    {
+        oc_mutex_lock(thread->threadMutex);
+        oc_cond_broadcast(thread->spaceCond);
+        oc_mutex_unlock(thread->threadMutex);
+    }
+}
+
+static void CAQueueingThreadRingRoutine(CAQueueingThread_t *thread)
+{
+    u_queue_message_t messages[CA_QUEUE_BATCH_SIZE];
+
+    while (!thread->isStop)
+    {
+        uint32_t count = u_ringbuffer_pop_batch(thread->ring, messages, CA_QUEUE_BATCH_SIZE);
+        if (0 == count)
+        {
+            oc_mutex_lock(thread->threadMutex);
+
+            // Producers only signal while consumerWaiting is set; the fence
+            // orders the flag before the emptiness check so that a concurrent
+            // producer either sees the flag or its data is seen here.
+            CAAtomicAdd32(&thread->consumerWaiting, 1);
+            CAAtomicFence();
+            if (!thread->isStop && 0 == u_ringbuffer_get_size(thread->ring))
+            {
+                OIC_LOG(DEBUG, TAG, "wait..");
+                oc_cond_wait(thread->threadCond, thread->threadMutex);
+                OIC_LOG(DEBUG, TAG, "wake up..");
+            }
+            CAAtomicAdd32(&thread->consumerWaiting, (uint32_t)-1);
+
+            oc_mutex_unlock(thread->threadMutex);
+            continue;
+        }
+
+        CAQueueingThreadNotifySpace(thread);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            // process data
+            thread->threadTask(messages[i].msg);
+
+            // free
+            CAQueueingThreadDestroyMessage(thread, messages[i].msg, messages[i].size);
+        }
+    }
+}
+
 static void CAQueueingThreadBaseRoutine(void *threadValue)
 {
     OIC_LOG(DEBUG, TAG, "message handler main thread start..");
@@ -47,6 +124,11 @@ static void CAQueueingThreadBaseRoutine(void *threadValue)
         return;
     }
 
+    if (thread->ring)
+    {
+        CAQueueingThreadRingRoutine(thread);
+    }
+
     while (!thread->isStop)
     {
         // mutex lock
@@ -84,20 +166,15 @@ static void CAQueueingThreadBaseRoutine(void *threadValue)
         thread->threadTask(message->msg);
 
         // free
-        if (NULL != thread->destroy)
-        {
-            thread->destroy(message->msg, message->size);
-        }
-        else
-        {
-            OICFree(message->msg);
-        }
+        CAQueueingThreadDestroyMessage(thread, message->msg, message->size);
 
         OICFree(message);
     }
 
+    // threadCond is shared with producers and waiters, so wake them all
     oc_mutex_lock(thread->threadMutex);
-    oc_cond_signal(thread->threadCond);
+    thread->isStopped = true;
+    oc_cond_broadcast(thread->threadCond);
     oc_mutex_unlock(thread->threadMutex);
 
     OIC_LOG(DEBUG, TAG, "message handler main thread end..");
@@ -126,8 +203,18 @@ CAResult_t CAQueueingThreadInitialize(CAQueueingThread_t *thread, ca_thread_pool
     thread->threadMutex = oc_mutex_new();
     thread->threadCond = oc_cond_new();
     thread->isStop = true;
+    thread->isStopped = true;
     thread->threadTask = task;
     thread->destroy = destroy;
+    thread->ring = NULL;
+    thread->fullPolicy = CA_QUEUE_FULL_ERROR;
+    thread->spaceCond = NULL;
+    thread->consumerWaiting = 0;
+    thread->producersWaiting = 0;
+    thread->droppedCount = 0;
+    thread->wakeRequested = false;
+    thread->wakeGeneration = 0;
+    thread->dataWaiters = 0;
     if (NULL == thread->dataQueue || NULL == thread->threadMutex || NULL == thread->threadCond)
     {
         goto ERROR_MEM_FAILURE;
@@ -154,6 +241,39 @@ ERROR_MEM_FAILURE:
     return CA_MEMORY_ALLOC_FAILED;
 }
 
+CAResult_t CAQueueingThreadInitializeBounded(CAQueueingThread_t *thread,
+                                             ca_thread_pool_t handle,
+                                             CAThreadTask task,
+                                             CADataDestroyFunction destroy,
+                                             uint32_t capacity,
+                                             CAQueueFullPolicy_t policy)
+{
+    CAResult_t res = CAQueueingThreadInitialize(thread, handle, task, destroy);
+    if (CA_STATUS_OK != res)
+    {
+        return res;
+    }
+
+    thread->ring = u_ringbuffer_create(capacity);
+    thread->spaceCond = oc_cond_new();
+    thread->fullPolicy = policy;
+    if (NULL == thread->ring || NULL == thread->spaceCond)
+    {
+        OIC_LOG(ERROR, TAG, "bounded queue initialize failed");
+        u_ringbuffer_delete(thread->ring);
+        thread->ring = NULL;
+        if (thread->spaceCond)
+        {
+            oc_cond_free(thread->spaceCond);
+            thread->spaceCond = NULL;
+        }
+        CAQueueingThreadDestroy(thread);
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+
+    return CA_STATUS_OK;
+}
+
 CAResult_t CAQueueingThreadStart(CAQueueingThread_t *thread)
 {
     if (NULL == thread)
@@ -177,16 +297,18 @@ CAResult_t CAQueueingThreadStart(CAQueueingThread_t *thread)
     // mutex lock
     oc_mutex_lock(thread->threadMutex);
     thread->isStop = false;
+    thread->isStopped = false;
     // mutex unlock
     oc_mutex_unlock(thread->threadMutex);
 
-    CAResult_t res = ca_thread_pool_add_task(thread->threadPool, CAQueueingThreadBaseRoutine,
-                                             thread);
+    CAResult_t res = ca_thread_pool_add_dedicated_task(thread->threadPool,
+                                                       CAQueueingThreadBaseRoutine, thread);
     if (res != CA_STATUS_OK)
     {
         // update thread status.
         oc_mutex_lock(thread->threadMutex);
         thread->isStop = true;
+        thread->isStopped = true;
         oc_mutex_unlock(thread->threadMutex);
 
         OIC_LOG(ERROR, TAG, "thread pool add task error(send thread).");
@@ -195,6 +317,61 @@ CAResult_t CAQueueingThreadStart(CAQueueingThread_t *thread)
     return res;
 }
 
+static CAResult_t CAQueueingThreadAddRingData(CAQueueingThread_t *thread, void *data,
+                                              uint32_t size)
+{
+    if (!u_ringbuffer_push(thread->ring, data, size))
+    {
+        if (CA_QUEUE_FULL_DROP == thread->fullPolicy)
+        {
+            uint32_t dropped = CAAtomicAdd32(&thread->droppedCount, 1);
+            OIC_LOG_V(DEBUG, TAG, "queue full, data dropped (%u total)", dropped);
+            CAQueueingThreadDestroyMessage(thread, data, size);
+            return CA_STATUS_OK;
+        }
+        if (CA_QUEUE_FULL_ERROR == thread->fullPolicy)
+        {
+            OIC_LOG(ERROR, TAG, "queue full!!");
+            return CA_STATUS_FAILED;
+        }
+
+        // CA_QUEUE_FULL_BLOCK
+        bool added = false;
+        uint64_t waited = 0;
+        oc_mutex_lock(thread->threadMutex);
+        CAAtomicAdd32(&thread->producersWaiting, 1);
+        while (!thread->isStop && waited < CA_QUEUE_BLOCK_TIMEOUT_US)
+        {
+            oc_cond_wait_for(thread->spaceCond, thread->threadMutex, CA_QUEUE_BLOCK_INTERVAL_US);
+            waited += CA_QUEUE_BLOCK_INTERVAL_US;
+            added = u_ringbuffer_push(thread->ring, data, size);
+            if (added)
+            {
+                break;
+            }
+        }
+        CAAtomicAdd32(&thread->producersWaiting, (uint32_t)-1);
+        oc_mutex_unlock(thread->threadMutex);
+
+        if (!added)
+        {
+            OIC_LOG(ERROR, TAG, "queue full, timed out waiting for room!!");
+            return CA_STATUS_FAILED;
+        }
+    }
+
+    // notify the thread (or CAQueueingThreadWaitForData callers) waiting for data
+    CAAtomicFence();
+    if (CAAtomicLoad32(&thread->consumerWaiting))
+    {
+        oc_mutex_lock(thread->threadMutex);
+        oc_cond_broadcast(thread->threadCond);
+        oc_mutex_unlock(thread->threadMutex);
+    }
+
+    return CA_STATUS_OK;
+}
+
 CAResult_t CAQueueingThreadAddData(CAQueueingThread_t *thread, void *data, uint32_t size)
 {
     if (NULL == thread)
@@ -209,6 +386,11 @@ CAResult_t CAQueueingThreadAddData(CAQueueingThread_t *thread, void *data, uint3
         return CA_STATUS_INVALID_PARAM;
     }
 
+    if (thread->ring)
+    {
+        return CAQueueingThreadAddRingData(thread, data, size);
+    }
+
     // create thread data
     u_queue_message_t *message = (u_queue_message_t *) OICMalloc(sizeof(u_queue_message_t));
 
@@ -236,6 +418,145 @@ CAResult_t CAQueueingThreadAddData(CAQueueingThread_t *thread, void *data, uint3
     return CA_STATUS_OK;
 }
 
+uint32_t CAQueueingThreadGetDataBatch(CAQueueingThread_t *thread,
+                                      u_queue_message_t *messages, uint32_t max)
+{
+    if (NULL == thread || NULL == messages)
+    {
+        OIC_LOG(ERROR, TAG, "invalid parameter..");
+        return 0;
+    }
+
+    uint32_t count = 0;
+    if (thread->ring)
+    {
+        // the ring allows a single consumer at a time
+        oc_mutex_lock(thread->threadMutex);
+        count = u_ringbuffer_pop_batch(thread->ring, messages, max);
+        if (count && CAAtomicLoad32(&thread->producersWaiting))
+        {
+            oc_cond_broadcast(thread->spaceCond);
+        }
+        oc_mutex_unlock(thread->threadMutex);
+        return count;
+    }
+
+    oc_mutex_lock(thread->threadMutex);
+    while (count < max)
+    {
+        u_queue_message_t *message = u_queue_get_element(thread->dataQueue);
+        if (NULL == message)
+        {
+            break;
+        }
+        messages[count++] = *message;
+        OICFree(message);
+    }
+    oc_mutex_unlock(thread->threadMutex);
+
+    return count;
+}
+
+uint32_t CAQueueingThreadGetSize(CAQueueingThread_t *thread)
+{
+    if (NULL == thread)
+    {
+        OIC_LOG(ERROR, TAG, "thread instance is empty..");
+        return 0;
+    }
+
+    if (thread->ring)
+    {
+        return u_ringbuffer_get_size(thread->ring);
+    }
+
+    oc_mutex_lock(thread->threadMutex);
+    uint32_t size = u_queue_get_size(thread->dataQueue);
+    oc_mutex_unlock(thread->threadMutex);
+
+    return size;
+}
+
+static bool CAQueueingThreadHasData(CAQueueingThread_t *thread)
+{
+    if (thread->ring)
+    {
+        return (0 < u_ringbuffer_get_size(thread->ring));
+    }
+    return (0 < u_queue_get_size(thread->dataQueue));
+}
+
+bool CAQueueingThreadWaitForData(CAQueueingThread_t *thread, uint64_t timeoutUs)
+{
+    if (NULL == thread)
+    {
+        OIC_LOG(ERROR, TAG, "thread instance is empty..");
+        return false;
+    }
+
+    uint64_t deadline = timeoutUs ? OICGetCurrentTime(TIME_IN_US) + timeoutUs : 0;
+
+    oc_mutex_lock(thread->threadMutex);
+
+    if (thread->ring)
+    {
+        // see CAQueueingThreadRingRoutine
+        CAAtomicAdd32(&thread->consumerWaiting, 1);
+        CAAtomicFence();
+    }
+
+    // a wakeup requested before we got here must not be lost
+    bool woken = thread->wakeRequested;
+    thread->wakeRequested = false;
+
+    // a wakeup while waiting releases all callers, not just the first to run
+    uint32_t generation = thread->wakeGeneration;
+    thread->dataWaiters++;
+    while (!woken && generation == thread->wakeGeneration && !CAQueueingThreadHasData(thread))
+    {
+        uint64_t waitUs = 0;
+        if (deadline)
+        {
+            uint64_t now = OICGetCurrentTime(TIME_IN_US);
+            if (now >= deadline)
+            {
+                break;
+            }
+            waitUs = deadline - now;
+        }
+        oc_cond_wait_for(thread->threadCond, thread->threadMutex, waitUs);
+    }
+    thread->dataWaiters--;
+
+    if (thread->ring)
+    {
+        CAAtomicAdd32(&thread->consumerWaiting, (uint32_t)-1);
+    }
+    bool hasData = CAQueueingThreadHasData(thread);
+
+    oc_mutex_unlock(thread->threadMutex);
+
+    return hasData;
+}
+
+void CAQueueingThreadWakeUp(CAQueueingThread_t *thread)
+{
+    if (NULL == thread)
+    {
+        OIC_LOG(ERROR, TAG, "thread instance is empty..");
+        return;
+    }
+
+    oc_mutex_lock(thread->threadMutex);
+    thread->wakeGeneration++;
+    if (0 == thread->dataWaiters)
+    {
+        thread->wakeRequested = true;
+    }
+    oc_cond_broadcast(thread->threadCond);
+    oc_mutex_unlock(thread->threadMutex);
+}
+
 CAResult_t CAQueueingThreadDestroy(CAQueueingThread_t *thread)
 {
     if (NULL == thread)
@@ -258,14 +579,7 @@ CAResult_t CAQueueingThreadDestroy(CAQueueingThread_t *thread)
         // free
         if (NULL != message)
         {
-            if (NULL != thread->destroy)
-            {
-                thread->destroy(message->msg, message->size);
-            }
-            else
-            {
-                OICFree(message->msg);
-            }
+            CAQueueingThreadDestroyMessage(thread, message->msg, message->size);
 
             OICFree(message);
         }
@@ -274,12 +588,32 @@ CAResult_t CAQueueingThreadDestroy(CAQueueingThread_t *thread)
     u_queue_delete(thread->dataQueue);
     thread->dataQueue = NULL;
 
+    if (thread->ring)
+    {
+        u_queue_message_t messages[CA_QUEUE_BATCH_SIZE];
+        uint32_t count = 0;
+        while ((count = u_ringbuffer_pop_batch(thread->ring, messages, CA_QUEUE_BATCH_SIZE)))
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                CAQueueingThreadDestroyMessage(thread, messages[i].msg, messages[i].size);
+            }
+        }
+        u_ringbuffer_delete(thread->ring);
+        thread->ring = NULL;
+    }
+
     // mutex unlock
     oc_mutex_unlock(thread->threadMutex);
 
     oc_mutex_free(thread->threadMutex);
     thread->threadMutex = NULL;
     oc_cond_free(thread->threadCond);
+    if (thread->spaceCond)
+    {
+        oc_cond_free(thread->spaceCond);
+        thread->spaceCond = NULL;
+    }
 
     return CA_STATUS_OK;
 }
@@ -303,9 +637,17 @@ CAResult_t CAQueueingThreadStop(CAQueueingThread_t *thread)
         thread->isStop = true;
 
         // notify the thread
-        oc_cond_signal(thread->threadCond);
+        oc_cond_broadcast(thread->threadCond);
+        if (thread->spaceCond)
+        {
+            oc_cond_broadcast(thread->spaceCond);
+        }
 
-        oc_cond_wait(thread->threadCond, thread->threadMutex);
+        // threadCond is also broadcast by producers, so wait for the thread to leave
+        while (!thread->isStopped)
+        {
+            oc_cond_wait(thread->threadCond, thread->threadMutex);
+        }
 
         // mutex unlock
         oc_mutex_unlock(thread->threadMutex);
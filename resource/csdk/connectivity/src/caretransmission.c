@@ -74,36 +74,87 @@
 #include "oic_malloc.h"
 #include "oic_time.h"
 #include "ocrandom.h"
+#include "oic_string.h"
 #include "logger.h"
 
 #define TAG "OIC_CA_RETRANS"
 
-typedef struct
+struct CARetransmissionData
 {
     uint64_t timeStamp;                 /**< last sent time. microseconds */
 #ifndef SINGLE_THREAD
     uint64_t timeout;                   /**< timeout value. microseconds */
+    uint64_t firstSent;                 /**< first sent time. microseconds */
+    CARetransmissionPeer_t *peer;       /**< estimation of the endpoint, may be NULL */
+    uint8_t backoff;                    /**< timeout factor per retransmission, in halves */
 #endif
+    uint64_t deadline;                  /**< next retransmission time. microseconds */
+    uint32_t heapIndex;                 /**< position in dataHeap */
+    CARetransmissionData_t *next;       /**< next data in the same idTable bucket,
+                                             or held back for the same peer */
     uint8_t triedCount;                 /**< retransmission count */
     uint16_t messageId;                 /**< coap PDU message id */
     CADataType_t dataType;              /**< data Type (Request/Response) */
     CAEndpoint_t *endpoint;             /**< remote endpoint */
     void *pdu;                          /**< coap PDU */
     uint32_t size;                      /**< coap PDU size */
-} CARetransmissionData_t;
+};
+
+/** initial number of idTable buckets. **/
+#define RETRANSMISSION_ID_TABLE_SIZE    64
+
+/** message ids are 16 bits, more buckets than this never help. **/
+#define RETRANSMISSION_ID_TABLE_MAX     (UINT16_MAX + 1)
+
+/** number of peerTable buckets (power of two). **/
+#define RETRANSMISSION_PEER_TABLE_SIZE  64
 
 static const uint64_t USECS_PER_SEC = 1000000;
 static const uint64_t MSECS_PER_SEC = 1000;
 
 #ifndef SINGLE_THREAD
+/**
+ * round trip time estimator of RFC 6298, in microseconds.
+ */
+typedef struct
+{
+    uint64_t srtt;                      /**< smoothed round trip time, 0 before any sample */
+    uint64_t rttvar;                    /**< round trip time variation */
+} CARttEstimator_t;
+
+/**
+ * Round trip times of an endpoint, estimated as in CoCoA
+ * (draft-ietf-core-cocoa): a strong estimator fed by exchanges which were
+ * not retransmitted, and a weak one fed by exchanges retransmitted once or
+ * twice, measured from the first transmission.  Ambiguous samples of the
+ * weak estimator only move the overall RTO a little (Karn's rule).
+ */
+struct CARetransmissionPeer
+{
+    CARetransmissionPeer_t *next;       /**< next peer in the same peerTable bucket */
+    uint32_t hash;                      /**< hash of adapter, address and port */
+    CATransportAdapter_t adapter;       /**< remote adapter */
+    uint16_t port;                      /**< remote port */
+    char addr[MAX_ADDR_STR_SIZE_CA];    /**< remote address */
+    CARttEstimator_t strong;            /**< exchanges without retransmission */
+    CARttEstimator_t weak;              /**< exchanges with one or two retransmissions */
+    uint64_t rto;                       /**< overall RTO. microseconds */
+    uint64_t rtoUpdated;                /**< time rto was last changed. microseconds */
+    uint64_t lastUsed;                  /**< time an exchange last started. microseconds */
+    uint32_t outstanding;               /**< exchanges sent and not ended yet */
+    uint32_t deferredCount;             /**< data held back by NSTART */
+    CARetransmissionData_t *deferred;   /**< oldest data held back */
+    CARetransmissionData_t *deferredLast;   /**< newest data held back */
+};
+
 /**
  * @brief   timeout value is
- *          between DEFAULT_ACK_TIMEOUT_SEC and
- *          (DEFAULT_ACK_TIMEOUT_SEC * DEFAULT_RANDOM_FACTOR) second.
+ *          between rto and (rto * DEFAULT_RANDOM_FACTOR).
  *          DEFAULT_RANDOM_FACTOR       1.5 (CoAP)
+ * @param   rto             [IN]retransmission timeout. microseconds
  * @return  microseconds.
  */
-static uint64_t CAGetTimeoutValue()
+static uint64_t CAGetTimeoutValue(uint64_t rto)
 {
     uint8_t randomValue = 0;
     if (!OCGetRandomBytes(&randomValue, sizeof(randomValue)))
@@ -111,8 +162,218 @@ static uint64_t CAGetTimeoutValue()
         OIC_LOG(ERROR, TAG, "OCGetRandomBytes failed");
     }
 
-    return ((DEFAULT_ACK_TIMEOUT_SEC * MSECS_PER_SEC) + ((MSECS_PER_SEC * (uint64_t)randomValue) >> 8)) *
-             MSECS_PER_SEC;
+    return rto + (((rto / 2) * (uint64_t)randomValue) >> 8);
+}
+
+/**
+ * @brief   variable back-off factor of CoCoA, a short RTO backs off faster
+ * @return  factor in halves
+ */
+static uint8_t CAGetBackoff(uint64_t rto)
+{
+    if (rto < 1 * USECS_PER_SEC)
+    {
+        return 6;
+    }
+    if (rto > 3 * USECS_PER_SEC)
+    {
+        return 3;
+    }
+    return 4;
+}
+
+static uint64_t CAClampRto(uint64_t rto)
+{
+    if (rto < RETRANSMISSION_MIN_RTO_MSEC * MSECS_PER_SEC)
+    {
+        return RETRANSMISSION_MIN_RTO_MSEC * MSECS_PER_SEC;
+    }
+    if (rto > RETRANSMISSION_MAX_RTO_MSEC * MSECS_PER_SEC)
+    {
+        return RETRANSMISSION_MAX_RTO_MSEC * MSECS_PER_SEC;
+    }
+    return rto;
+}
+
+/**
+ * @brief   feed a sample to an estimator
+ * @param   k               [IN]weight of the variation, 4 for strong and 1 for weak
+ * @return  the RTO of the estimator. microseconds
+ */
+static uint64_t CAUpdateEstimator(CARttEstimator_t *estimator, uint64_t rtt, uint64_t k)
+{
+    if (0 == estimator->srtt)
+    {
+        estimator->srtt = rtt ? rtt : 1;
+        estimator->rttvar = rtt / 2;
+    }
+    else
+    {
+        uint64_t delta = estimator->srtt > rtt ? estimator->srtt - rtt : rtt - estimator->srtt;
+        estimator->rttvar = (3 * estimator->rttvar + delta) / 4;
+        estimator->srtt = (7 * estimator->srtt + rtt) / 8;
+    }
+    return estimator->srtt + k * estimator->rttvar;
+}
+
+/**
+ * @brief   learn from an acknowledged exchange
+ * @param   now             [IN]time the acknowledgement was received. microseconds
+ */
+static void CAUpdatePeerRto(CARetransmissionPeer_t *peer, const CARetransmissionData_t *retData,
+                            uint64_t now)
+{
+    if (0 == retData->triedCount)
+    {
+        uint64_t rto = CAUpdateEstimator(&peer->strong, now - retData->firstSent, 4);
+        peer->rto = CAClampRto((rto + peer->rto) / 2);
+    }
+    else if (retData->triedCount <= 2)
+    {
+        uint64_t rto = CAUpdateEstimator(&peer->weak, now - retData->firstSent, 1);
+        peer->rto = CAClampRto((rto + 3 * peer->rto) / 4);
+    }
+    else
+    {
+        return;
+    }
+    peer->rtoUpdated = now;
+
+    OIC_LOG_V(DEBUG, TAG, "rto of %s:%d is %" PRIu64 " microseconds",
+              peer->addr, peer->port, peer->rto);
+}
+
+/**
+ * @brief   let an RTO which was not updated for long drift back to the default
+ */
+static void CAAgePeerRto(CARetransmissionPeer_t *peer, uint64_t now)
+{
+    uint64_t idle = now - peer->rtoUpdated;
+    if (peer->rto < 1 * USECS_PER_SEC && idle > 16 * peer->rto)
+    {
+        peer->rto = CAClampRto(2 * peer->rto);
+        peer->rtoUpdated = now;
+    }
+    else if (peer->rto > 3 * USECS_PER_SEC && idle > 4 * peer->rto)
+    {
+        peer->rto = CAClampRto(1 * USECS_PER_SEC + peer->rto / 2);
+        peer->rtoUpdated = now;
+    }
+}
+
+/**
+ * @brief   FNV-1a hash of the remote adapter, address and port
+ */
+static uint32_t CAPeerHash(const CAEndpoint_t *endpoint)
+{
+    uint32_t hash = 2166136261u;
+    for (const char *c = endpoint->addr; '\0' != *c; c++)
+    {
+        hash = (hash ^ (uint8_t) *c) * 16777619u;
+    }
+    hash = (hash ^ (endpoint->port & 0xFF)) * 16777619u;
+    hash = (hash ^ (endpoint->port >> 8)) * 16777619u;
+    hash = (hash ^ (uint8_t) endpoint->adapter) * 16777619u;
+    return hash;
+}
+
+static bool CAIsPeerIdle(const CARetransmissionPeer_t *peer)
+{
+    return 0 == peer->outstanding && 0 == peer->deferredCount;
+}
+
+/**
+ * @brief   forget the idle peer which was used least recently
+ */
+static void CAEvictPeer(CARetransmission_t *context)
+{
+    CARetransmissionPeer_t **oldest = NULL;
+    for (uint32_t i = 0; i < RETRANSMISSION_PEER_TABLE_SIZE; i++)
+    {
+        for (CARetransmissionPeer_t **link = &context->peerTable[i]; NULL != *link;
+             link = &(*link)->next)
+        {
+            if (CAIsPeerIdle(*link) && (NULL == oldest || (*link)->lastUsed < (*oldest)->lastUsed))
+            {
+                oldest = link;
+            }
+        }
+    }
+
+    if (NULL != oldest)
+    {
+        CARetransmissionPeer_t *peer = *oldest;
+        *oldest = peer->next;
+        context->peerCount--;
+        OICFree(peer);
+    }
+}
+
+/**
+ * @brief   find the peer of the endpoint. The caller holds the lock.
+ * @return  the peer, NULL if the endpoint is unknown
+ */
+static CARetransmissionPeer_t *CAFindPeer(CARetransmission_t *context,
+                                          const CAEndpoint_t *endpoint, uint32_t hash)
+{
+    CARetransmissionPeer_t *peer =
+        context->peerTable[hash & (RETRANSMISSION_PEER_TABLE_SIZE - 1)];
+    for (; NULL != peer; peer = peer->next)
+    {
+        if (peer->hash == hash && peer->adapter == endpoint->adapter
+            && peer->port == endpoint->port && 0 == strcmp(peer->addr, endpoint->addr))
+        {
+            return peer;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief   find the peer of the endpoint, adding it if it is unknown.
+ *          The caller holds the lock.
+ * @return  the peer, NULL if it could not be added
+ */
+static CARetransmissionPeer_t *CAGetPeer(CARetransmission_t *context,
+                                         const CAEndpoint_t *endpoint, uint64_t now)
+{
+    if (NULL == context->peerTable)
+    {
+        return NULL;
+    }
+
+    uint32_t hash = CAPeerHash(endpoint);
+    CARetransmissionPeer_t *peer = CAFindPeer(context, endpoint, hash);
+    if (NULL != peer)
+    {
+        return peer;
+    }
+
+    if (context->peerCount >= RETRANSMISSION_MAX_PEERS)
+    {
+        CAEvictPeer(context);
+    }
+
+    peer = (CARetransmissionPeer_t *) OICCalloc(1, sizeof(*peer));
+    if (NULL == peer)
+    {
+        // the exchange just goes with the default timeout and no NSTART.
+        OIC_LOG(ERROR, TAG, "memory error");
+        return NULL;
+    }
+    peer->hash = hash;
+    peer->adapter = endpoint->adapter;
+    peer->port = endpoint->port;
+    OICStrcpy(peer->addr, sizeof(peer->addr), endpoint->addr);
+    peer->rto = DEFAULT_ACK_TIMEOUT_SEC * USECS_PER_SEC;
+    peer->rtoUpdated = now;
+
+    CARetransmissionPeer_t **bucket =
+        &context->peerTable[hash & (RETRANSMISSION_PEER_TABLE_SIZE - 1)];
+    peer->next = *bucket;
+    *bucket = peer;
+    context->peerCount++;
+    return peer;
 }
 
 CAResult_t CARetransmissionStart(CARetransmission_t *context)
@@ -129,8 +390,8 @@ CAResult_t CARetransmissionStart(CARetransmission_t *context)
         return CA_STATUS_INVALID_PARAM;
     }
 
-    CAResult_t res = ca_thread_pool_add_task(context->threadPool, CARetransmissionBaseRoutine,
-                                             context);
+    CAResult_t res = ca_thread_pool_add_dedicated_task(context->threadPool,
+                                                       CARetransmissionBaseRoutine, context);
 
     if (CA_STATUS_OK != res)
     {
@@ -143,37 +404,281 @@ CAResult_t CARetransmissionStart(CARetransmission_t *context)
 #endif
 
 /**
- * @brief   check timeout routine
- * @param   currentTime     [IN]microseconds
+ * @brief   calculate the time the data is next due for retransmission
  * @param   retData         [IN]retransmission data
- * @return  true if the timeout period has elapsed, false otherwise
+ * @return  microseconds
  */
-static bool CACheckTimeout(uint64_t currentTime, CARetransmissionData_t *retData)
+static uint64_t CAGetNextDeadline(const CARetransmissionData_t *retData)
 {
 #ifndef SINGLE_THREAD
-    // #1. calculate timeout
-    uint32_t milliTimeoutValue = retData->timeout * 0.001;
-    uint64_t timeout = ((uint64_t) milliTimeoutValue << retData->triedCount) * MSECS_PER_SEC;
+    uint64_t timeout = retData->timeout;
+#else
+    uint64_t timeout = (2 << retData->triedCount) * (uint64_t) USECS_PER_SEC;
+#endif
+    return retData->timeStamp + timeout;
+}
+
+static void CAHeapSet(CARetransmission_t *context, uint32_t index,
+                      CARetransmissionData_t *retData)
+{
+    context->dataHeap[index] = retData;
+    retData->heapIndex = index;
+}
 
-    if (currentTime >= retData->timeStamp + timeout)
+static void CAHeapSiftUp(CARetransmission_t *context, uint32_t index)
+{
+    CARetransmissionData_t *retData = context->dataHeap[index];
+    while (index > 0)
     {
-        OIC_LOG_V(DEBUG, TAG, "%" PRIu64 " microseconds time out!!, tried count(%d)",
-                  timeout, retData->triedCount);
-        return true;
+        uint32_t parent = (index - 1) / 2;
+        if (context->dataHeap[parent]->deadline <= retData->deadline)
+        {
+            break;
+        }
+        CAHeapSet(context, index, context->dataHeap[parent]);
+        index = parent;
     }
-#else
-    // #1. calculate timeout
-    uint64_t timeOut = (2 << retData->triedCount) * (uint64_t) USECS_PER_SEC;
+    CAHeapSet(context, index, retData);
+}
+
+static void CAHeapSiftDown(CARetransmission_t *context, uint32_t index)
+{
+    CARetransmissionData_t *retData = context->dataHeap[index];
+    while (true)
+    {
+        uint32_t child = index * 2 + 1;
+        if (child >= context->dataCount)
+        {
+            break;
+        }
+        if (child + 1 < context->dataCount
+            && context->dataHeap[child + 1]->deadline < context->dataHeap[child]->deadline)
+        {
+            child++;
+        }
+        if (retData->deadline <= context->dataHeap[child]->deadline)
+        {
+            break;
+        }
+        CAHeapSet(context, index, context->dataHeap[child]);
+        index = child;
+    }
+    CAHeapSet(context, index, retData);
+}
+
+static void CAHeapRemove(CARetransmission_t *context, CARetransmissionData_t *retData)
+{
+    uint32_t index = retData->heapIndex;
+    CARetransmissionData_t *last = context->dataHeap[--context->dataCount];
+    if (last == retData)
+    {
+        return;
+    }
+
+    CAHeapSet(context, index, last);
+    CAHeapSiftDown(context, index);
+    CAHeapSiftUp(context, last->heapIndex);
+}
+
+/**
+ * @brief   find the idTable link which points to the data of the given message
+ * @return  pointer to the link, NULL if no such data is registered
+ */
+static CARetransmissionData_t **CAFindIdLink(CARetransmission_t *context, uint16_t messageId,
+                                             CATransportAdapter_t adapter)
+{
+    CARetransmissionData_t **link = &context->idTable[messageId & (context->idTableSize - 1)];
+    for (; NULL != *link; link = &(*link)->next)
+    {
+        CARetransmissionData_t *retData = *link;
+        if (retData->messageId == messageId && NULL != retData->endpoint
+            && retData->endpoint->adapter == adapter)
+        {
+            return link;
+        }
+    }
+    return NULL;
+}
+
+static void CAGrowIdTable(CARetransmission_t *context)
+{
+    uint32_t size = context->idTableSize * 2;
+    CARetransmissionData_t **table = (CARetransmissionData_t **) OICCalloc(size,
+                                                                         sizeof(*table));
+    if (NULL == table)
+    {
+        // keep the current table, lookups just get longer chains.
+        OIC_LOG(ERROR, TAG, "memory error");
+        return;
+    }
+
+    for (uint32_t i = 0; i < context->dataCount; i++)
+    {
+        CARetransmissionData_t *retData = context->dataHeap[i];
+        CARetransmissionData_t **bucket = &table[retData->messageId & (size - 1)];
+        retData->next = *bucket;
+        *bucket = retData;
+    }
+
+    OICFree(context->idTable);
+    context->idTable = table;
+    context->idTableSize = size;
+}
+
+static CAResult_t CAAddRetransmissionData(CARetransmission_t *context,
+                                          CARetransmissionData_t *retData)
+{
+    if (context->dataCount == context->heapCapacity)
+    {
+        uint32_t capacity = context->heapCapacity ? context->heapCapacity * 2
+                                                  : RETRANSMISSION_ID_TABLE_SIZE;
+        CARetransmissionData_t **heap = (CARetransmissionData_t **) OICRealloc(
+                context->dataHeap, capacity * sizeof(*heap));
+        if (NULL == heap)
+        {
+            OIC_LOG(ERROR, TAG, "memory error");
+            return CA_MEMORY_ALLOC_FAILED;
+        }
+        context->dataHeap = heap;
+        context->heapCapacity = capacity;
+    }
+
+    context->dataHeap[context->dataCount] = retData;
+    retData->heapIndex = context->dataCount++;
+    CAHeapSiftUp(context, retData->heapIndex);
+
+    CARetransmissionData_t **bucket =
+        &context->idTable[retData->messageId & (context->idTableSize - 1)];
+    retData->next = *bucket;
+    *bucket = retData;
+
+    // keep chains short
+    if (context->dataCount > context->idTableSize
+        && context->idTableSize < RETRANSMISSION_ID_TABLE_MAX)
+    {
+        CAGrowIdTable(context);
+    }
+
+    return CA_STATUS_OK;
+}
+
+/**
+ * @brief   unlink retransmission data from the heap and the idTable
+ * @param   link            [IN]idTable link pointing to the data
+ * @return  the unlinked data
+ */
+static CARetransmissionData_t *CARemoveRetransmissionData(CARetransmission_t *context,
+                                                          CARetransmissionData_t **link)
+{
+    CARetransmissionData_t *retData = *link;
+    *link = retData->next;
+    retData->next = NULL;
+    CAHeapRemove(context, retData);
+    return retData;
+}
+
+static void CADestroyRetransmissionData(CARetransmissionData_t *retData)
+{
+    CAFreeEndpoint(retData->endpoint);
+    OICFree(retData->pdu);
+    OICFree(retData);
+}
 
-    if (currentTime >= retData->timeStamp + timeOut)
+/**
+ * @brief   register data sent now for retransmission. The caller holds the lock.
+ */
+static CAResult_t CAStartRetransmissionData(CARetransmission_t *context,
+                                            CARetransmissionData_t *retData)
+{
+    if (NULL != CAFindIdLink(context, retData->messageId, retData->endpoint->adapter))
     {
-        OIC_LOG_V(DEBUG, TAG, "timeout=%d, tried cnt=%d",
-                  (2 << retData->triedCount), retData->triedCount);
-        return true;
+        OIC_LOG(ERROR, TAG, "Duplicate message ID");
+        return CA_STATUS_FAILED;
+    }
+
+    retData->timeStamp = OICGetCurrentTime(TIME_IN_US);
+    retData->triedCount = 0;
+#ifndef SINGLE_THREAD
+    uint64_t rto = DEFAULT_ACK_TIMEOUT_SEC * USECS_PER_SEC;
+    if (NULL != retData->peer)
+    {
+        CAAgePeerRto(retData->peer, retData->timeStamp);
+        rto = retData->peer->rto;
+        retData->peer->lastUsed = retData->timeStamp;
+    }
+    retData->firstSent = retData->timeStamp;
+    retData->timeout = CAGetTimeoutValue(rto);
+    retData->backoff = CAGetBackoff(rto);
+#endif
+    retData->deadline = CAGetNextDeadline(retData);
+
+    CAResult_t res = CAAddRetransmissionData(context, retData);
+    if (CA_STATUS_OK != res)
+    {
+        return res;
+    }
+
+#ifndef SINGLE_THREAD
+    if (NULL != retData->peer)
+    {
+        retData->peer->outstanding++;
+    }
+
+    // notify the thread if its next deadline moved forward
+    if (0 == retData->heapIndex)
+    {
+        oc_cond_signal(context->threadCond);
     }
 #endif
-    return false;
+    return CA_STATUS_OK;
+}
+
+#ifndef SINGLE_THREAD
+/**
+ * @brief   account the end of an exchange with the peer and send the data
+ *          held back for it as far as NSTART allows. The caller holds the lock.
+ */
+static void CAEndExchange(CARetransmission_t *context, CARetransmissionPeer_t *peer)
+{
+    if (NULL == peer)
+    {
+        return;
+    }
+
+    if (0 < peer->outstanding)
+    {
+        peer->outstanding--;
+    }
+
+    while (NULL != peer->deferred
+           && (0 == context->config.nstart || peer->outstanding < context->config.nstart))
+    {
+        CARetransmissionData_t *retData = peer->deferred;
+        peer->deferred = retData->next;
+        if (NULL == peer->deferred)
+        {
+            peer->deferredLast = NULL;
+        }
+        retData->next = NULL;
+        peer->deferredCount--;
+
+        bool started = (CA_STATUS_OK == CAStartRetransmissionData(context, retData));
+
+        OIC_LOG_V(DEBUG, TAG, "send held back CON data, msgid=%d", retData->messageId);
+        if (NULL != context->dataSendMethod)
+        {
+            context->dataSendMethod(retData->endpoint, retData->pdu,
+                                    retData->size, retData->dataType);
+        }
+
+        // the data is still sent once if it can't be retransmitted
+        if (!started)
+        {
+            CADestroyRetransmissionData(retData);
+        }
+    }
 }
+#endif
 
 static void CACheckRetransmissionList(CARetransmission_t *context)
 {
@@ -186,65 +691,69 @@ static void CACheckRetransmissionList(CARetransmission_t *context)
     // mutex lock
     oc_mutex_lock(context->threadMutex);
 
-    uint32_t i = 0;
-    uint32_t len = u_arraylist_length(context->dataList);
+    uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
 
-    for (i = 0; i < len; i++)
+    while (0 < context->dataCount)
     {
-        CARetransmissionData_t *retData = u_arraylist_get(context->dataList, i);
-
-        if (NULL == retData)
+        // #1. the heap root is the data due first
+        CARetransmissionData_t *retData = context->dataHeap[0];
+        if (currentTime < retData->deadline)
         {
-            continue;
+            break;
         }
 
-        uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
+        OIC_LOG_V(DEBUG, TAG, "%" PRIu64 " microseconds time out!!, tried count(%d)",
+                  retData->deadline - retData->timeStamp, retData->triedCount);
 
-        if (CACheckTimeout(currentTime, retData))
+        // #2. if time's up, send the data.
+        if (NULL != context->dataSendMethod)
         {
-            // #2. if time's up, send the data.
-            if (NULL != context->dataSendMethod)
-            {
-                OIC_LOG_V(DEBUG, TAG, "retransmission CON data!!, msgid=%d",
-                          retData->messageId);
-                context->dataSendMethod(retData->endpoint, retData->pdu,
-                                        retData->size, retData->dataType);
-            }
-
-            // #3. increase the retransmission count and update timestamp.
-            retData->timeStamp = currentTime;
-            retData->triedCount++;
+            OIC_LOG_V(DEBUG, TAG, "retransmission CON data!!, msgid=%d",
+                      retData->messageId);
+            context->dataSendMethod(retData->endpoint, retData->pdu,
+                                    retData->size, retData->dataType);
         }
 
+        // #3. increase the retransmission count and update timestamp.
+        retData->timeStamp = currentTime;
+        retData->triedCount++;
+#ifndef SINGLE_THREAD
+        retData->timeout = retData->timeout * retData->backoff / 2;
+#endif
+
         // #4. if tried count is max, remove the retransmission data from list.
         if (retData->triedCount >= context->config.tryingCount)
         {
-            CARetransmissionData_t *removedData = u_arraylist_remove(context->dataList, i);
-            if (NULL == removedData)
+            CARetransmissionData_t **link = CAFindIdLink(context, retData->messageId,
+                                                         retData->endpoint->adapter);
+            if (NULL == link)
             {
-                OIC_LOG(ERROR, TAG, "Removed data is NULL");
-                // mutex unlock
-                oc_mutex_unlock(context->threadMutex);
-                return;
+                OIC_LOG(ERROR, TAG, "retransmission data is not in the id table");
+                CAHeapRemove(context, retData);
+            }
+            else
+            {
+                CARemoveRetransmissionData(context, link);
             }
             OIC_LOG_V(DEBUG, TAG, "max trying count, remove RTCON data,"
-                      "msgid=%d", removedData->messageId);
+                      "msgid=%d", retData->messageId);
 
             // callback for retransmit timeout
             if (NULL != context->timeoutCallback)
             {
-                context->timeoutCallback(removedData->endpoint, removedData->pdu,
-                                         removedData->size);
+                context->timeoutCallback(retData->endpoint, retData->pdu,
+                                         retData->size);
             }
 
-            CAFreeEndpoint(removedData->endpoint);
-            OICFree(removedData->pdu);
-
-            OICFree(removedData);
-
-            // modify loop value.
-            len = u_arraylist_length(context->dataList);
-            --i;
+#ifndef SINGLE_THREAD
+            CAEndExchange(context, retData->peer);
+#endif
+            CADestroyRetransmissionData(retData);
+        }
+        else
+        {
+            retData->deadline = CAGetNextDeadline(retData);
+            CAHeapSiftDown(context, 0);
         }
     }
 
@@ -279,7 +788,7 @@ void CARetransmissionBaseRoutine(void *threadValue)
         // mutex lock
         oc_mutex_lock(context->threadMutex);
 
-        if (!context->isStop && u_arraylist_length(context->dataList) <= 0)
+        if (!context->isStop && 0 == context->dataCount)
         {
             // if list is empty, thread will wait
             OIC_LOG(DEBUG, TAG, "wait..there is no retransmission data.");
@@ -291,13 +800,18 @@ void CARetransmissionBaseRoutine(void *threadValue)
         }
         else if (!context->isStop)
         {
-            // check each RETRANSMISSION_CHECK_PERIOD_SEC time.
-            OIC_LOG_V(DEBUG, TAG, "wait..(%" PRIu64 ")microseconds",
-                      RETRANSMISSION_CHECK_PERIOD_SEC * (uint64_t) USECS_PER_SEC);
+            // sleep until the earliest deadline, new earlier data wakes us up.
+            uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
+            uint64_t deadline = context->dataHeap[0]->deadline;
+            if (deadline > currentTime)
+            {
+                OIC_LOG_V(DEBUG, TAG, "wait..(%" PRIu64 ")microseconds",
+                          deadline - currentTime);
 
-            // wait
-            uint64_t absTime = RETRANSMISSION_CHECK_PERIOD_SEC * (uint64_t) USECS_PER_SEC;
-            oc_cond_wait_for(context->threadCond, context->threadMutex, absTime );
+                // wait
+                oc_cond_wait_for(context->threadCond, context->threadMutex,
+                                 deadline - currentTime);
+            }
         }
         else
         {
@@ -348,7 +862,8 @@ CAResult_t CARetransmissionInitialize(CARetransmission_t *context,
     memset(context, 0, sizeof(CARetransmission_t));
 
     CARetransmissionConfig_t cfg = { .supportType = DEFAULT_RETRANSMISSION_TYPE,
-                                     .tryingCount = DEFAULT_RETRANSMISSION_COUNT };
+                                     .tryingCount = DEFAULT_RETRANSMISSION_COUNT,
+                                     .nstart = DEFAULT_NSTART };
 
     if (config)
     {
@@ -363,22 +878,39 @@ CAResult_t CARetransmissionInitialize(CARetransmission_t *context,
     context->timeoutCallback = timeoutCallback;
     context->config = cfg;
     context->isStop = false;
-    context->dataList = u_arraylist_create();
+    context->idTable = (CARetransmissionData_t **) OICCalloc(RETRANSMISSION_ID_TABLE_SIZE,
+                                                             sizeof(CARetransmissionData_t *));
+    if (NULL == context->idTable)
+    {
+        OIC_LOG(ERROR, TAG, "memory error");
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+    context->idTableSize = RETRANSMISSION_ID_TABLE_SIZE;
+#ifndef SINGLE_THREAD
+    context->peerTable = (CARetransmissionPeer_t **) OICCalloc(RETRANSMISSION_PEER_TABLE_SIZE,
+                                                               sizeof(CARetransmissionPeer_t *));
+    if (NULL == context->peerTable)
+    {
+        OIC_LOG(ERROR, TAG, "memory error");
+        OICFree(context->idTable);
+        context->idTable = NULL;
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+#endif
 
     return CA_STATUS_OK;
 }
 
-CAResult_t CARetransmissionSentData(CARetransmission_t *context,
-                                    const CAEndpoint_t *endpoint,
-                                    CADataType_t dataType,
-                                    const void *pdu, uint32_t size)
+/**
+ * @brief   copy a CON pdu into new retransmission data
+ * @return  ::CA_NOT_SUPPORTED if the pdu is not retransmitted
+ */
+static CAResult_t CACreateRetransmissionData(CARetransmission_t *context,
+                                             const CAEndpoint_t *endpoint,
+                                             CADataType_t dataType,
+                                             const void *pdu, uint32_t size,
+                                             CARetransmissionData_t **retData)
 {
-    if (NULL == context || NULL == endpoint || NULL == pdu)
-    {
-        OIC_LOG(ERROR, TAG, "invalid parameter");
-        return CA_STATUS_INVALID_PARAM;
-    }
-
     // #0. check support transport type
     if (!(context->config.supportType & endpoint->adapter))
     {
@@ -399,10 +931,10 @@ CAResult_t CARetransmissionSentData(CARetransmission_t *context,
     }
 
     // create retransmission data
-    CARetransmissionData_t *retData = (CARetransmissionData_t *) OICCalloc(
-                                          1, sizeof(CARetransmissionData_t));
+    CARetransmissionData_t *data = (CARetransmissionData_t *) OICCalloc(
+                                       1, sizeof(CARetransmissionData_t));
 
-    if (NULL == retData)
+    if (NULL == data)
     {
         OIC_LOG(ERROR, TAG, "memory error");
         return CA_MEMORY_ALLOC_FAILED;
@@ -412,7 +944,7 @@ CAResult_t CARetransmissionSentData(CARetransmission_t *context,
     void *pduData = (void *) OICMalloc(size);
     if (NULL == pduData)
     {
-        OICFree(retData);
+        OICFree(data);
         OIC_LOG(ERROR, TAG, "memory error");
         return CA_MEMORY_ALLOC_FAILED;
     }
@@ -422,72 +954,160 @@ CAResult_t CARetransmissionSentData(CARetransmission_t *context,
     CAEndpoint_t *remoteEndpoint = CACloneEndpoint(endpoint);
     if (NULL == remoteEndpoint)
     {
-        OICFree(retData);
+        OICFree(data);
         OICFree(pduData);
         OIC_LOG(ERROR, TAG, "memory error");
         return CA_MEMORY_ALLOC_FAILED;
     }
 
-    // #2. add additional information. (time stamp, retransmission count...)
-    retData->timeStamp = OICGetCurrentTime(TIME_IN_US);
-#ifndef SINGLE_THREAD
-    retData->timeout = CAGetTimeoutValue();
-#endif
-    retData->triedCount = 0;
-    retData->messageId = messageId;
-    retData->endpoint = remoteEndpoint;
-    retData->pdu = pduData;
-    retData->size = size;
-    retData->dataType = dataType;
-#ifndef SINGLE_THREAD
+    // #2. add additional information.
+    data->messageId = messageId;
+    data->endpoint = remoteEndpoint;
+    data->pdu = pduData;
+    data->size = size;
+    data->dataType = dataType;
+
+    *retData = data;
+    return CA_STATUS_OK;
+}
+
+CAResult_t CARetransmissionSendData(CARetransmission_t *context,
+                                    const CAEndpoint_t *endpoint,
+                                    CADataType_t dataType,
+                                    const void *pdu, uint32_t size)
+{
+    if (NULL == context || NULL == endpoint || NULL == pdu)
+    {
+        OIC_LOG(ERROR, TAG, "invalid parameter");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    if (NULL == context->dataSendMethod)
+    {
+        return CA_NOT_SUPPORTED;
+    }
+
+    CARetransmissionData_t *retData = NULL;
+    CAResult_t res = CACreateRetransmissionData(context, endpoint, dataType, pdu, size,
+                                                &retData);
+    if (CA_STATUS_OK != res)
+    {
+        return res;
+    }
+
+    // retData may be freed by the retransmission thread once the lock is dropped
+    uint16_t messageId = retData->messageId;
+
     // mutex lock
     oc_mutex_lock(context->threadMutex);
 
-    uint32_t i = 0;
-    uint32_t len = u_arraylist_length(context->dataList);
+#ifndef SINGLE_THREAD
+    CARetransmissionPeer_t *peer = CAGetPeer(context, endpoint, OICGetCurrentTime(TIME_IN_US));
+    retData->peer = peer;
 
-    // #3. add data into list
-    for (i = 0; i < len; i++)
+    // #3. hold the data back while NSTART exchanges with the endpoint are outstanding
+    if (NULL != peer && 0 != context->config.nstart
+        && peer->outstanding >= context->config.nstart)
     {
-        CARetransmissionData_t *currData = u_arraylist_get(context->dataList, i);
-
-        if (NULL == currData)
+        if (peer->deferredCount >= RETRANSMISSION_MAX_DEFERRED)
         {
-            continue;
+            // mutex unlock
+            oc_mutex_unlock(context->threadMutex);
+
+            OIC_LOG_V(ERROR, TAG, "too many CON data held back for %s", endpoint->addr);
+            CADestroyRetransmissionData(retData);
+            return CA_SEND_FAILED;
         }
 
-        // found index
-        if (NULL != currData->endpoint && currData->messageId == messageId
-            && (currData->endpoint->adapter == endpoint->adapter))
+        if (NULL != peer->deferredLast)
+        {
+            peer->deferredLast->next = retData;
+        }
+        else
         {
-            OIC_LOG(ERROR, TAG, "Duplicate message ID");
+            peer->deferred = retData;
+        }
+        peer->deferredLast = retData;
+        peer->deferredCount++;
 
-            // mutex unlock
-            oc_mutex_unlock(context->threadMutex);
+        // mutex unlock
+        oc_mutex_unlock(context->threadMutex);
 
-            OICFree(retData);
-            OICFree(pduData);
-            OICFree(remoteEndpoint);
-            return CA_STATUS_FAILED;
-        }
+        OIC_LOG_V(DEBUG, TAG, "hold back CON data, msgid=%d", messageId);
+        return CA_STATUS_OK;
     }
+#endif
 
-    u_arraylist_add(context->dataList, (void *) retData);
-
-    // notify the thread
-    oc_cond_signal(context->threadCond);
+    // #4. add data into list
+    res = CAStartRetransmissionData(context, retData);
 
     // mutex unlock
     oc_mutex_unlock(context->threadMutex);
 
-#else
-    u_arraylist_add(context->dataList, (void *) retData);
+    if (CA_STATUS_OK != res)
+    {
+        // send the data once without retransmission, e.g. on a duplicate message id
+        OIC_LOG_V(ERROR, TAG, "CON data not retransmitted, msgid=%d", messageId);
+        CADestroyRetransmissionData(retData);
+        return context->dataSendMethod(endpoint, pdu, size, dataType);
+    }
+
+    // #5. send the data
+    res = context->dataSendMethod(endpoint, pdu, size, dataType);
+    if (CA_STATUS_OK != res)
+    {
+        // mutex lock
+        oc_mutex_lock(context->threadMutex);
 
+        // the data is gone if it was acknowledged meanwhile
+        CARetransmissionData_t **link = CAFindIdLink(context, messageId, endpoint->adapter);
+        if (NULL != link && *link == retData)
+        {
+            CARemoveRetransmissionData(context, link);
+#ifndef SINGLE_THREAD
+            CAEndExchange(context, retData->peer);
+#endif
+            CADestroyRetransmissionData(retData);
+        }
+
+        // mutex unlock
+        oc_mutex_unlock(context->threadMutex);
+        return res;
+    }
+
+#ifdef SINGLE_THREAD
     CACheckRetransmissionList(context);
 #endif
     return CA_STATUS_OK;
 }
 
+uint64_t CARetransmissionGetTimeout(CARetransmission_t *context,
+                                    const CAEndpoint_t *endpoint)
+{
+    uint64_t rto = DEFAULT_ACK_TIMEOUT_SEC * USECS_PER_SEC;
+    if (NULL == context || NULL == endpoint)
+    {
+        OIC_LOG(ERROR, TAG, "invalid parameter");
+        return rto / MSECS_PER_SEC;
+    }
+
+#ifndef SINGLE_THREAD
+    oc_mutex_lock(context->threadMutex);
+    if (NULL != context->peerTable)
+    {
+        CARetransmissionPeer_t *peer = CAFindPeer(context, endpoint, CAPeerHash(endpoint));
+        if (NULL != peer)
+        {
+            CAAgePeerRto(peer, OICGetCurrentTime(TIME_IN_US));
+            rto = peer->rto;
+        }
+    }
+    oc_mutex_unlock(context->threadMutex);
+#endif
+
+    return rto / MSECS_PER_SEC;
+}
+
 CAResult_t CARetransmissionReceivedData(CARetransmission_t *context,
                                         const CAEndpoint_t *endpoint, const void *pdu,
                                         uint32_t size, void **retransmissionPdu)
@@ -523,75 +1143,56 @@ CAResult_t CARetransmissionReceivedData(CARetransmission_t *context,
 
     // mutex lock
     oc_mutex_lock(context->threadMutex);
-    uint32_t len = u_arraylist_length(context->dataList);
 
-    // find index
-    uint32_t i;
-    for (i = 0; i < len; i++)
+    // find data
+    CARetransmissionData_t **link = CAFindIdLink(context, messageId, endpoint->adapter);
+    if (NULL != link)
     {
-        CARetransmissionData_t *retData = (CARetransmissionData_t *) u_arraylist_get(
-                context->dataList, i);
+        CARetransmissionData_t *retData = *link;
 
-        if (NULL == retData)
+        // get pdu data for getting token when CA_EMPTY(RST/ACK) is received from remote device
+        // if retransmission was finish..token will be unavailable.
+        if (CA_EMPTY == code)
         {
-            continue;
-        }
+            OIC_LOG(DEBUG, TAG, "code is CA_EMPTY");
 
-        // found index
-        if (NULL != retData->endpoint && retData->messageId == messageId
-            && (retData->endpoint->adapter == endpoint->adapter))
-        {
-            // get pdu data for getting token when CA_EMPTY(RST/ACK) is received from remote device
-            // if retransmission was finish..token will be unavailable.
-            if (CA_EMPTY == CAGetCodeFromPduBinaryData(pdu, size))
+            if (NULL == retData->pdu)
             {
-                OIC_LOG(DEBUG, TAG, "code is CA_EMPTY");
-
-                if (NULL == retData->pdu)
-                {
-                    OIC_LOG(ERROR, TAG, "retData->pdu is null");
-                    OICFree(retData);
-                    // mutex unlock
-                    oc_mutex_unlock(context->threadMutex);
-
-                    return CA_STATUS_FAILED;
-                }
-
-                // copy PDU data
-                (*retransmissionPdu) = (void *) OICCalloc(1, retData->size);
-                if ((*retransmissionPdu) == NULL)
-                {
-                    OICFree(retData);
-                    OIC_LOG(ERROR, TAG, "memory error");
-
-                    // mutex unlock
-                    oc_mutex_unlock(context->threadMutex);
-
-                    return CA_MEMORY_ALLOC_FAILED;
-                }
-                memcpy((*retransmissionPdu), retData->pdu, retData->size);
+                OIC_LOG(ERROR, TAG, "retData->pdu is null");
+                // mutex unlock
+                oc_mutex_unlock(context->threadMutex);
+
+                return CA_STATUS_FAILED;
             }
 
-            // #2. remove data from list
-            CARetransmissionData_t *removedData = u_arraylist_remove(context->dataList, i);
-            if (NULL == removedData)
+            // copy PDU data
+            (*retransmissionPdu) = (void *) OICCalloc(1, retData->size);
+            if ((*retransmissionPdu) == NULL)
             {
-                OIC_LOG(ERROR, TAG, "Removed data is NULL");
+                OIC_LOG(ERROR, TAG, "memory error");
 
                 // mutex unlock
                 oc_mutex_unlock(context->threadMutex);
 
-                return CA_STATUS_FAILED;
+                return CA_MEMORY_ALLOC_FAILED;
             }
+            memcpy((*retransmissionPdu), retData->pdu, retData->size);
+        }
 
-            OIC_LOG_V(DEBUG, TAG, "remove RTCON data!!, msgid=%d", messageId);
+        // #2. remove data from list
+        CARemoveRetransmissionData(context, link);
 
-            CAFreeEndpoint(removedData->endpoint);
-            OICFree(removedData->pdu);
-            OICFree(removedData);
+        OIC_LOG_V(DEBUG, TAG, "remove RTCON data!!, msgid=%d", messageId);
 
-            break;
+#ifndef SINGLE_THREAD
+        // #3. learn the round trip time and start the exchanges held back
+        if (NULL != retData->peer)
+        {
+            CAUpdatePeerRto(retData->peer, retData, OICGetCurrentTime(TIME_IN_US));
+            CAEndExchange(context, retData->peer);
         }
+#endif
+        CADestroyRetransmissionData(retData);
     }
 
     // mutex unlock
@@ -639,23 +1240,42 @@ CAResult_t CARetransmissionDestroy(CARetransmission_t *context)
     OIC_LOG(DEBUG, TAG, "retransmission context destroy..");
 
     oc_mutex_lock(context->threadMutex);
-    uint32_t len = u_arraylist_length(context->dataList);
-    for (uint32_t i = 0; i < len; i++)
+    for (uint32_t i = 0; i < context->dataCount; i++)
     {
-        CARetransmissionData_t *data = u_arraylist_get(context->dataList, i);
-        if (NULL == data)
+        CADestroyRetransmissionData(context->dataHeap[i]);
+    }
+    context->dataCount = 0;
+#ifndef SINGLE_THREAD
+    for (uint32_t i = 0; NULL != context->peerTable && i < RETRANSMISSION_PEER_TABLE_SIZE; i++)
+    {
+        while (NULL != context->peerTable[i])
         {
-            continue;
+            CARetransmissionPeer_t *peer = context->peerTable[i];
+            context->peerTable[i] = peer->next;
+            while (NULL != peer->deferred)
+            {
+                CARetransmissionData_t *retData = peer->deferred;
+                peer->deferred = retData->next;
+                CADestroyRetransmissionData(retData);
+            }
+            OICFree(peer);
         }
-        CAFreeEndpoint(data->endpoint);
-        OICFree(data->pdu);
     }
+    OICFree(context->peerTable);
+    context->peerTable = NULL;
+    context->peerCount = 0;
+#endif
     oc_mutex_unlock(context->threadMutex);
 
     oc_mutex_free(context->threadMutex);
     context->threadMutex = NULL;
     oc_cond_free(context->threadCond);
-    u_arraylist_free(&context->dataList);
+    OICFree(context->dataHeap);
+    context->dataHeap = NULL;
+    context->heapCapacity = 0;
+    OICFree(context->idTable);
+    context->idTable = NULL;
+    context->idTableSize = 0;
 
     return CA_STATUS_OK;
 }
@@ -290,6 +290,9 @@ static void CAInitializeIPGlobals()
     caglobals.ip.m6s.fd = -1;
     caglobals.ip.m4.fd  = -1;
     caglobals.ip.m4s.fd = -1;
+#if defined(HAVE_SYS_EPOLL_H)
+    caglobals.ip.epollFd = -1;
+#endif
     caglobals.ip.u6.port  = 0;
     caglobals.ip.u6s.port = 0;
     caglobals.ip.u4.port  = 0;
@@ -46,6 +46,14 @@
 #ifdef HAVE_SYS_SELECT_H
 #include <sys/select.h>
 #endif
+#if defined(HAVE_SYS_EPOLL_H) && !defined(WSA_WAIT_EVENT_0)
+#include <sys/epoll.h>
+#define USE_EPOLL           // wait with epoll instead of select
+#endif
+#if defined(HAVE_SYS_EVENTFD_H) && !defined(WSA_WAIT_EVENT_0)
+#include <sys/eventfd.h>
+#define USE_EVENTFD         // shutdownFds[0] and shutdownFds[1] share one eventfd
+#endif
 #ifdef HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif
@@ -77,6 +85,14 @@
 #undef USE_IP_MREQN
 #endif
 
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define USE_MMSG            // batch datagram I/O with recvmmsg/sendmmsg
+#endif
+#if defined(USE_EPOLL) && defined(USE_EVENTFD) && defined(SO_REUSEPORT)
+#define USE_RECEIVE_SHARDS  // SO_REUSEPORT unicast sockets read by several threads
+#include <sched.h>
+#endif
+
 /*
  * Logging tag for module name
  */
@@ -84,6 +100,11 @@
 
 #define SELECT_TIMEOUT 1     // select() seconds (and termination latency)
 
+#define EPOLL_MAX_EVENTS 16  // ready fds handled per epoll_wait() wakeup
+
+#define RECV_BATCH_SIZE 8    // datagrams drained per recvmmsg() call
+#define SEND_BATCH_SIZE 16   // multicast interfaces served per sendmmsg() call
+
 #define IPv4_MULTICAST     "224.0.1.187"
 static struct in_addr IPv4MulticastAddress = { 0 };
 
@@ -142,23 +163,94 @@ static CAIPErrorHandleCallback g_ipErrorHandler = NULL;
 
 static CAIPPacketReceivedCallback g_packetReceivedCallback = NULL;
 
+#if defined(USE_EVENTFD)
+/*
+ * Guards caglobals.ip.shutdownFds against the receive thread closing the
+ * eventfd while CAWakeUpForChange() writes to it.  It lives as long as the
+ * process because the receive thread may outlive CATerminateIP().
+ */
+static oc_mutex g_shutdownFdMutex = NULL;
+#endif
+
 static void CAFindReadyMessage();
 #if !defined(WSA_WAIT_EVENT_0)
 static void CASelectReturned(fd_set *readFds, int ret);
+static void CAProcessInterfaceChanges();
 #else
 static void CAEventReturned(CASocketFd_t socket);
 #endif
+#if defined(USE_EPOLL)
+static void CAFindReadyMessageEpoll(int epollFd);
+static void CAEpollReturned(struct epoll_event *events, int count);
+#endif
 
 static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags);
+static CAResult_t CAReceiveMessages(CASocketFd_t fd, CATransportFlags_t flags);
+static void CAProcessReceivedPacket(CATransportFlags_t flags, struct sockaddr_storage *srcAddr,
+                                    int namelen, unsigned char *pktinfo,
+                                    char *data, size_t dataLen);
+#if defined(USE_RECEIVE_SHARDS)
+static void CASetReceiveAffinity(uint32_t shard);
+static CASocketFd_t CACreateSocket(int family, uint16_t *port, bool isMulticast);
+#endif
+
+/*
+ * Number of receive threads, each reading its own SO_REUSEPORT unicast
+ * sockets.  The first one is CAReceiveHandler, which reads the sockets in
+ * caglobals.ip and the multicast sockets.
+ */
+static uint8_t g_receiveShardCount = 1;
 
 static void CAReceiveHandler(void *data)
 {
     (void)data;
 
-    while (!caglobals.ip.terminate)
+#if defined(USE_RECEIVE_SHARDS)
+    if (caglobals.ip.receiveAffinity)
+    {
+        CASetReceiveAffinity(0);
+    }
+#endif
+
+#if defined(USE_EVENTFD)
+    int shutdownFd = caglobals.ip.shutdownFds[0];
+#endif
+#if defined(USE_EPOLL)
+    // The epoll instance is owned by this thread; the globals may be
+    // re-initialized by CAStopIP() before the thread notices termination.
+    int epollFd = caglobals.ip.epollFd;
+    if (-1 != epollFd)
     {
-        CAFindReadyMessage();
+        while (!caglobals.ip.terminate)
+        {
+            CAFindReadyMessageEpoll(epollFd);
+        }
+        close(epollFd);
+    }
+    else
+#endif
+    {
+        while (!caglobals.ip.terminate)
+        {
+            CAFindReadyMessage();
+        }
+    }
+#if defined(USE_EVENTFD)
+    if (-1 != shutdownFd)
+    {
+        // Retire the eventfd before closing it so CAWakeUpForChange() can
+        // not write to its number once the kernel hands it out again.
+        // A restarted server may already have installed a new one.
+        oc_mutex_lock(g_shutdownFdMutex);
+        if (caglobals.ip.shutdownFds[0] == shutdownFd)
+        {
+            caglobals.ip.shutdownFds[0] = -1;
+            caglobals.ip.shutdownFds[1] = -1;
+        }
+        close(shutdownFd);
+        oc_mutex_unlock(g_shutdownFdMutex);
     }
+#endif
 }
 
 #define CLOSE_SOCKET(TYPE) \
@@ -253,42 +345,355 @@ static void CASelectReturned(fd_set *readFds, int ret)
         else ISSET(m4s, readFds, CA_MULTICAST | CA_IPV4 | CA_SECURE)
         else if ((caglobals.ip.netlinkFd != OC_INVALID_SOCKET) && FD_ISSET(caglobals.ip.netlinkFd, readFds))
         {
-            OIC_LOG_V(DEBUG, TAG, "Netlink event detacted");
-            u_arraylist_t *iflist = CAFindInterfaceChange();
-            if (iflist)
-            {
-                uint32_t listLength = u_arraylist_length(iflist);
-                for (uint32_t i = 0; i < listLength; i++)
-                {
-                    CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
-                    if (ifitem)
-                    {
-                        CAProcessNewInterface(ifitem);
-                    }
-                }
-                u_arraylist_destroy(iflist);
-            }
+            CAProcessInterfaceChanges();
             break;
         }
         else if (FD_ISSET(caglobals.ip.shutdownFds[0], readFds))
         {
             char buf[10] = {0};
             ssize_t len = read(caglobals.ip.shutdownFds[0], buf, sizeof (buf));
-            if (-1 == len)
+            if ((-1 == len) && (EINTR == errno))
             {
                 continue;
             }
+            // EAGAIN: the non-blocking eventfd was already drained, no data.
             break;
         }
         else
         {
             break;
         }
-        (void)CAReceiveMessage(fd, flags);
+        (void)CAReceiveMessages(fd, flags);
         FD_CLR(fd, readFds);
     }
 }
 
+static void CAProcessInterfaceChanges()
+{
+    OIC_LOG_V(DEBUG, TAG, "Netlink event detacted");
+    u_arraylist_t *iflist = CAFindInterfaceChange();
+    if (iflist)
+    {
+        uint32_t listLength = u_arraylist_length(iflist);
+        for (uint32_t i = 0; i < listLength; i++)
+        {
+            CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
+            if (ifitem)
+            {
+                CAProcessNewInterface(ifitem);
+            }
+        }
+        u_arraylist_destroy(iflist);
+    }
+}
+
+#if defined(USE_EPOLL)
+
+/*
+ * Each registered fd carries its transport flags in the upper half of the
+ * epoll user data, so a wakeup needs no lookup to dispatch the socket.
+ */
+#define EPOLL_DATA(FD, FLAGS) (((uint64_t)(uint32_t)(FLAGS) << 32) | (uint32_t)(FD))
+#define EPOLL_DATA_FD(DATA) ((CASocketFd_t)(uint32_t)((DATA) & 0xFFFFFFFF))
+#define EPOLL_DATA_FLAGS(DATA) ((CATransportFlags_t)((DATA) >> 32))
+
+#define EPOLL_ADD(TYPE, FLAGS) \
+    if (caglobals.ip.TYPE.fd != OC_INVALID_SOCKET) \
+    { \
+        CAEpollAddFd(caglobals.ip.TYPE.fd, FLAGS); \
+    }
+
+static void CAEpollAddFd(int fd, CATransportFlags_t flags)
+{
+    struct epoll_event event = { .events = EPOLLIN, .data.u64 = EPOLL_DATA(fd, flags) };
+    if (-1 == epoll_ctl(caglobals.ip.epollFd, EPOLL_CTL_ADD, fd, &event))
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_ctl(%d) failed: %s", fd, strerror(errno));
+    }
+}
+
+/**
+ * Register every socket with a new epoll instance once, instead of rebuilding
+ * an fd_set on each wait.  On failure epollFd stays -1 and the receive thread
+ * falls back to select().
+ */
+static void CAInitializeEpoll()
+{
+    caglobals.ip.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == caglobals.ip.epollFd)
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_create1 failed: %s (using select)", strerror(errno));
+        return;
+    }
+
+    EPOLL_ADD(u6,  CA_IPV6)
+    EPOLL_ADD(u6s, CA_IPV6 | CA_SECURE)
+    EPOLL_ADD(u4,  CA_IPV4)
+    EPOLL_ADD(u4s, CA_IPV4 | CA_SECURE)
+    EPOLL_ADD(m6,  CA_MULTICAST | CA_IPV6)
+    EPOLL_ADD(m6s, CA_MULTICAST | CA_IPV6 | CA_SECURE)
+    EPOLL_ADD(m4,  CA_MULTICAST | CA_IPV4)
+    EPOLL_ADD(m4s, CA_MULTICAST | CA_IPV4 | CA_SECURE)
+
+    if (caglobals.ip.shutdownFds[0] != -1)
+    {
+        CAEpollAddFd(caglobals.ip.shutdownFds[0], CA_DEFAULT_FLAGS);
+    }
+    if (caglobals.ip.netlinkFd != OC_INVALID_SOCKET)
+    {
+        CAEpollAddFd(caglobals.ip.netlinkFd, CA_DEFAULT_FLAGS);
+    }
+}
+
+static void CAFindReadyMessageEpoll(int epollFd)
+{
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    int timeout = caglobals.ip.selectTimeout == -1 ? -1 : caglobals.ip.selectTimeout * 1000;
+
+    int ret = epoll_wait(epollFd, events, EPOLL_MAX_EVENTS, timeout);
+
+    if (caglobals.ip.terminate)
+    {
+        OIC_LOG_V(DEBUG, TAG, "Packet receiver Stop request received.");
+        return;
+    }
+
+    if (0 == ret)
+    {
+        return;
+    }
+    else if (0 < ret)
+    {
+        CAEpollReturned(events, ret);
+    }
+    else if (EINTR != errno)
+    {
+        OIC_LOG_V(FATAL, TAG, "epoll_wait error %s", strerror(errno));
+    }
+}
+
+static void CAEpollReturned(struct epoll_event *events, int count)
+{
+    for (int i = 0; i < count && !caglobals.ip.terminate; i++)
+    {
+        CASocketFd_t fd = EPOLL_DATA_FD(events[i].data.u64);
+
+        if ((caglobals.ip.netlinkFd != OC_INVALID_SOCKET) && (fd == caglobals.ip.netlinkFd))
+        {
+            CAProcessInterfaceChanges();
+        }
+        else if (fd == caglobals.ip.shutdownFds[0])
+        {
+            char buf[10] = {0};
+            (void)read(fd, buf, sizeof (buf));
+        }
+        else if (CA_DEFAULT_FLAGS == EPOLL_DATA_FLAGS(events[i].data.u64))
+        {
+            // the shard wakeup fd stays readable so that every shard sees it.
+        }
+        else
+        {
+            (void)CAReceiveMessages(fd, EPOLL_DATA_FLAGS(events[i].data.u64));
+        }
+    }
+}
+
+#if defined(USE_RECEIVE_SHARDS)
+
+/*
+ * Written once when the server stops and never read, so that it wakes up
+ * every shard thread.
+ */
+static int g_receiveShardWakeFd = -1;
+
+/*
+ * Sockets and epoll instance of a shard, owned by its thread.
+ */
+typedef struct
+{
+    uint32_t index;
+    int epollFd;
+    CASocketFd_t fds[4];
+} CAReceiveShard_t;
+
+static void CASetReceiveAffinity(uint32_t shard)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+    {
+        return;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(shard % cpus, &set);
+    if (-1 == sched_setaffinity(0, sizeof (set), &set))
+    {
+        OIC_LOG_V(ERROR, TAG, "sched_setaffinity(%u) failed: %s", shard, strerror(errno));
+    }
+}
+
+static void CACloseReceiveShard(CAReceiveShard_t *shard)
+{
+    for (size_t i = 0; i < sizeof (shard->fds) / sizeof (shard->fds[0]); i++)
+    {
+        if (OC_INVALID_SOCKET != shard->fds[i])
+        {
+            OC_CLOSE_SOCKET(shard->fds[i]);
+        }
+    }
+    if (-1 != shard->epollFd)
+    {
+        close(shard->epollFd);
+    }
+    OICFree(shard);
+}
+
+static void CAReceiveShardHandler(void *data)
+{
+    CAReceiveShard_t *shard = (CAReceiveShard_t *)data;
+
+    if (caglobals.ip.receiveAffinity)
+    {
+        CASetReceiveAffinity(shard->index);
+    }
+
+    while (!caglobals.ip.terminate)
+    {
+        CAFindReadyMessageEpoll(shard->epollFd);
+    }
+
+    CACloseReceiveShard(shard);
+}
+
+/**
+ * Open one more unicast socket on the port of the given one, for a shard.
+ */
+static CASocketFd_t CAAddShardSocket(CAReceiveShard_t *shard, size_t slot, int family,
+                                     const CASocket_t *socket, CATransportFlags_t flags)
+{
+    shard->fds[slot] = OC_INVALID_SOCKET;
+    if (OC_INVALID_SOCKET == socket->fd)
+    {
+        return OC_INVALID_SOCKET;
+    }
+
+    uint16_t port = socket->port;
+    shard->fds[slot] = CACreateSocket(family, &port, false);
+    if (OC_INVALID_SOCKET == shard->fds[slot])
+    {
+        return OC_INVALID_SOCKET;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN,
+                                 .data.u64 = EPOLL_DATA(shard->fds[slot], flags) };
+    if (-1 == epoll_ctl(shard->epollFd, EPOLL_CTL_ADD, shard->fds[slot], &event))
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_ctl(%d) failed: %s", shard->fds[slot], strerror(errno));
+        OC_CLOSE_SOCKET(shard->fds[slot]);
+        shard->fds[slot] = OC_INVALID_SOCKET;
+    }
+    return shard->fds[slot];
+}
+
+/**
+ * Start the receive threads beyond CAReceiveHandler.  A shard whose socket
+ * could not be opened is given up as a whole, since the kernel would pass it
+ * the traffic of some peers nobody reads.
+ */
+static void CAStartReceiveShards(const ca_thread_pool_t threadPool)
+{
+    if (g_receiveShardCount < 2 || -1 == caglobals.ip.epollFd)
+    {
+        return;
+    }
+
+    g_receiveShardWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (-1 == g_receiveShardWakeFd)
+    {
+        OIC_LOG_V(ERROR, TAG, "eventfd failed: %s (one receive thread)", strerror(errno));
+        return;
+    }
+
+    for (uint32_t i = 1; i < g_receiveShardCount; i++)
+    {
+        CAReceiveShard_t *shard = (CAReceiveShard_t *)OICCalloc(1, sizeof (*shard));
+        if (!shard)
+        {
+            OIC_LOG(ERROR, TAG, "Malloc failed");
+            return;
+        }
+        shard->index = i;
+        for (size_t j = 0; j < sizeof (shard->fds) / sizeof (shard->fds[0]); j++)
+        {
+            shard->fds[j] = OC_INVALID_SOCKET;
+        }
+
+        shard->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (-1 == shard->epollFd)
+        {
+            OIC_LOG_V(ERROR, TAG, "epoll_create1 failed: %s", strerror(errno));
+            CACloseReceiveShard(shard);
+            return;
+        }
+
+        struct epoll_event event = { .events = EPOLLIN,
+                                     .data.u64 = EPOLL_DATA(g_receiveShardWakeFd,
+                                                            CA_DEFAULT_FLAGS) };
+        if (-1 == epoll_ctl(shard->epollFd, EPOLL_CTL_ADD, g_receiveShardWakeFd, &event)
+            || (OC_INVALID_SOCKET != caglobals.ip.u6.fd
+                && OC_INVALID_SOCKET == CAAddShardSocket(shard, 0, AF_INET6, &caglobals.ip.u6,
+                                                         CA_IPV6))
+            || (OC_INVALID_SOCKET != caglobals.ip.u6s.fd
+                && OC_INVALID_SOCKET == CAAddShardSocket(shard, 1, AF_INET6, &caglobals.ip.u6s,
+                                                         CA_IPV6 | CA_SECURE))
+            || (OC_INVALID_SOCKET != caglobals.ip.u4.fd
+                && OC_INVALID_SOCKET == CAAddShardSocket(shard, 2, AF_INET, &caglobals.ip.u4,
+                                                         CA_IPV4))
+            || (OC_INVALID_SOCKET != caglobals.ip.u4s.fd
+                && OC_INVALID_SOCKET == CAAddShardSocket(shard, 3, AF_INET, &caglobals.ip.u4s,
+                                                         CA_IPV4 | CA_SECURE)))
+        {
+            OIC_LOG_V(ERROR, TAG, "receive shard %u failed", i);
+            CACloseReceiveShard(shard);
+            return;
+        }
+
+        if (CA_STATUS_OK != ca_thread_pool_add_dedicated_task(threadPool, CAReceiveShardHandler,
+                                                              shard))
+        {
+            OIC_LOG_V(ERROR, TAG, "receive shard %u thread failed", i);
+            CACloseReceiveShard(shard);
+            return;
+        }
+        OIC_LOG_V(DEBUG, TAG, "receive shard %u started", i);
+    }
+}
+
+static void CAStopReceiveShards()
+{
+    if (-1 != g_receiveShardWakeFd)
+    {
+        uint64_t value = 1;
+        if (-1 == write(g_receiveShardWakeFd, &value, sizeof (value)))
+        {
+            OIC_LOG_V(DEBUG, TAG, "write failed: %s", strerror(errno));
+        }
+    }
+}
+
+static void CACloseReceiveShardWakeFd()
+{
+    if (-1 != g_receiveShardWakeFd)
+    {
+        close(g_receiveShardWakeFd);
+        g_receiveShardWakeFd = -1;
+    }
+}
+#endif // USE_RECEIVE_SHARDS
+
+#endif // USE_EPOLL
+
 #else // if defined(WSA_WAIT_EVENT_0)
 
 #define PUSH_HANDLE(HANDLE, ARRAY, INDEX) \
@@ -495,7 +900,7 @@ static void CAEventReturned(CASocketFd_t socket)
         {
             break;
         }
-        (void)CAReceiveMessage(socket, flags);
+        (void)CAReceiveMessages(socket, flags);
         // We will never get more than one match per socket, so always break.
         break;
     }
@@ -532,6 +937,9 @@ void CADeInitializeIPGlobals()
     CLOSE_SOCKET(m4s);
 
     CAUnregisterForAddressChanges();
+#if defined(USE_RECEIVE_SHARDS)
+    CACloseReceiveShardWakeFd();
+#endif
 }
 
 static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
@@ -641,6 +1049,14 @@ static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
         return CA_STATUS_FAILED;
     }
 
+    CAProcessReceivedPacket(flags, &srcAddr, namelen, pktinfo, recvBuffer, recvLen);
+    return CA_STATUS_OK;
+}
+
+static void CAProcessReceivedPacket(CATransportFlags_t flags, struct sockaddr_storage *srcAddr,
+                                    int namelen, unsigned char *pktinfo,
+                                    char *data, size_t dataLen)
+{
     CASecureEndpoint_t sep = {.endpoint = {.adapter = CA_ADAPTER_IP, .flags = flags}};
 
     if (flags & CA_IPV6)
@@ -673,14 +1089,16 @@ static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
         }
     }
 
-    CAConvertAddrToName(&srcAddr, namelen, sep.endpoint.addr, &sep.endpoint.port);
+    CAConvertAddrToName(srcAddr, namelen, sep.endpoint.addr, &sep.endpoint.port);
 
     if (flags & CA_SECURE)
     {
 #ifdef __WITH_DTLS__
-        int ret = CAdecryptSsl(&sep, (uint8_t *)recvBuffer, recvLen);
+        int ret = CAdecryptSsl(&sep, (uint8_t *)data, dataLen);
         OIC_LOG_V(DEBUG, TAG, "CAdecryptSsl returns [%d]", ret);
 #else
+        (void)data;
+        (void)dataLen;
         OIC_LOG(ERROR, TAG, "Encrypted message but no DTLS");
 #endif
     }
@@ -688,12 +1106,105 @@ static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
     {
         if (g_packetReceivedCallback)
         {
-            g_packetReceivedCallback(&sep, recvBuffer, recvLen);
+            g_packetReceivedCallback(&sep, data, dataLen);
+        }
+    }
+}
+
+#if defined(USE_MMSG)
+/*
+ * Set when the kernel lacks recvmmsg(); receiving then falls back to one
+ * recvmsg() per readiness event.
+ */
+static bool g_recvmmsgUnsupported = false;
+
+/**
+ * Drain up to RECV_BATCH_SIZE datagrams from a readable socket with a single
+ * recvmmsg() call and pass each of them up in arrival order.
+ */
+static CAResult_t CAReceiveMessageBatch(CASocketFd_t fd, CATransportFlags_t flags)
+{
+    char recvBuffers[RECV_BATCH_SIZE][COAP_MAX_PDU_SIZE];
+    struct sockaddr_storage srcAddrs[RECV_BATCH_SIZE];
+    struct iovec iovs[RECV_BATCH_SIZE];
+    union control
+    {
+        struct cmsghdr cmsg;
+        unsigned char data[CMSG_SPACE(sizeof (struct in6_pktinfo))];
+    } cmsgs[RECV_BATCH_SIZE];
+    struct mmsghdr msgs[RECV_BATCH_SIZE];
+
+    int namelen = (flags & CA_IPV6) ? sizeof (struct sockaddr_in6) : sizeof (struct sockaddr_in);
+    int level = (flags & CA_IPV6) ? IPPROTO_IPV6 : IPPROTO_IP;
+    int type = (flags & CA_IPV6) ? IPV6_PKTINFO : IP_PKTINFO;
+
+    memset(msgs, 0, sizeof (msgs));
+    for (int i = 0; i < RECV_BATCH_SIZE; i++)
+    {
+        iovs[i].iov_base = recvBuffers[i];
+        iovs[i].iov_len = sizeof (recvBuffers[i]);
+        msgs[i].msg_hdr.msg_name = &srcAddrs[i];
+        msgs[i].msg_hdr.msg_namelen = namelen;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = &cmsgs[i];
+        msgs[i].msg_hdr.msg_controllen = CMSG_SPACE(sizeof (struct in6_pktinfo));
+    }
+
+    int count = recvmmsg(fd, msgs, RECV_BATCH_SIZE, MSG_DONTWAIT, NULL);
+    if (OC_SOCKET_ERROR == count)
+    {
+        if (ENOSYS == errno)
+        {
+            OIC_LOG(INFO, TAG, "recvmmsg not supported, using recvmsg");
+            g_recvmmsgUnsupported = true;
+            return CAReceiveMessage(fd, flags);
+        }
+        if (EAGAIN != errno && EWOULDBLOCK != errno)
+        {
+            OIC_LOG_V(ERROR, TAG, "recvmmsg failed %s", strerror(errno));
+            return CA_STATUS_FAILED;
+        }
+        return CA_STATUS_OK;
+    }
+
+    OIC_LOG_V(DEBUG, TAG, "recvmmsg received %d datagrams", count);
+
+    for (int i = 0; i < count && !caglobals.ip.terminate; i++)
+    {
+        unsigned char *pktinfo = NULL;
+        for (struct cmsghdr *cmp = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmp != NULL;
+             cmp = CMSG_NXTHDR(&msgs[i].msg_hdr, cmp))
+        {
+            if (cmp->cmsg_level == level && cmp->cmsg_type == type)
+            {
+                pktinfo = CMSG_DATA(cmp);
+            }
         }
+        if (!pktinfo)
+        {
+            OIC_LOG(ERROR, TAG, "pktinfo is null");
+            continue;
+        }
+
+        CAProcessReceivedPacket(flags, &srcAddrs[i], namelen, pktinfo,
+                                recvBuffers[i], msgs[i].msg_len);
     }
 
     return CA_STATUS_OK;
 }
+#endif // USE_MMSG
+
+static CAResult_t CAReceiveMessages(CASocketFd_t fd, CATransportFlags_t flags)
+{
+#if defined(USE_MMSG)
+    if (!g_recvmmsgUnsupported)
+    {
+        return CAReceiveMessageBatch(fd, flags);
+    }
+#endif
+    return CAReceiveMessage(fd, flags);
+}
 
 void CAIPPullData()
 {
@@ -759,6 +1270,19 @@ static CASocketFd_t CACreateSocket(int family, uint16_t *port, bool isMulticast)
         socklen = sizeof (struct sockaddr_in);
     }
 
+#if defined(USE_RECEIVE_SHARDS)
+    if (!isMulticast && g_receiveShardCount > 1) // shards share the unicast ports
+    {
+        int on = 1;
+        if (OC_SOCKET_ERROR == setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, OPTVAL_T(&on), sizeof (on)))
+        {
+            OIC_LOG_V(ERROR, TAG, "SO_REUSEPORT failed: %s", CAIPS_GET_ERROR);
+            OC_CLOSE_SOCKET(fd);
+            return OC_INVALID_SOCKET;
+        }
+    }
+#endif
+
     if (isMulticast && *port) // use the given port
     {
         int on = 1;
@@ -858,6 +1382,20 @@ static void CAInitializeFastShutdownMechanism()
     {
         ret = 0;
     }
+#elif defined(USE_EVENTFD)
+    if (!g_shutdownFdMutex)
+    {
+        g_shutdownFdMutex = oc_mutex_new();
+    }
+    if (g_shutdownFdMutex)
+    {
+        ret = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        oc_mutex_lock(g_shutdownFdMutex);
+        caglobals.ip.shutdownFds[0] = ret;
+        caglobals.ip.shutdownFds[1] = ret;
+        oc_mutex_unlock(g_shutdownFdMutex);
+        CHECKFD(caglobals.ip.shutdownFds[0]);
+    }
 #elif defined(HAVE_PIPE2)
     ret = pipe2(caglobals.ip.shutdownFds, O_CLOEXEC);
     CHECKFD(caglobals.ip.shutdownFds[0]);
@@ -933,6 +1471,21 @@ CAResult_t CAIPStartServer(const ca_thread_pool_t threadPool)
         caglobals.ip.ipv4enabled = true;  // only needed to run CA tests
     }
 
+    g_receiveShardCount = 1;
+#if defined(USE_RECEIVE_SHARDS)
+    CACloseReceiveShardWakeFd();
+    if (caglobals.ip.receiveShards > 1)
+    {
+        g_receiveShardCount = caglobals.ip.receiveShards > CA_IP_MAX_RECEIVE_SHARDS ?
+                              CA_IP_MAX_RECEIVE_SHARDS : caglobals.ip.receiveShards;
+    }
+#else
+    if (caglobals.ip.receiveShards > 1)
+    {
+        OIC_LOG(INFO, TAG, "receive shards are not supported, using one receive thread");
+    }
+#endif
+
     if (caglobals.ip.ipv6enabled)
     {
         NEWSOCKET(AF_INET6, u6, false)
@@ -980,6 +1533,10 @@ CAResult_t CAIPStartServer(const ca_thread_pool_t threadPool)
 
     caglobals.ip.selectTimeout = CAGetPollingInterval(caglobals.ip.selectTimeout);
 
+#if defined(USE_EPOLL)
+    CAInitializeEpoll();
+#endif
+
     res = CAIPStartListenServer();
     if (CA_STATUS_OK != res)
     {
@@ -988,7 +1545,7 @@ CAResult_t CAIPStartServer(const ca_thread_pool_t threadPool)
     }
 
     caglobals.ip.terminate = false;
-    res = ca_thread_pool_add_task(threadPool, CAReceiveHandler, NULL);
+    res = ca_thread_pool_add_dedicated_task(threadPool, CAReceiveHandler, NULL);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "thread_pool_add_task failed");
@@ -996,6 +1553,10 @@ CAResult_t CAIPStartServer(const ca_thread_pool_t threadPool)
     }
     OIC_LOG(DEBUG, TAG, "CAReceiveHandler thread started successfully.");
 
+#if defined(USE_RECEIVE_SHARDS)
+    CAStartReceiveShards(threadPool);
+#endif
+
     caglobals.ip.started = true;
     return CA_STATUS_OK;
 }
@@ -1005,7 +1566,14 @@ void CAIPStopServer()
     caglobals.ip.started = false;
     caglobals.ip.terminate = true;
 
-#if !defined(WSA_WAIT_EVENT_0)
+#if defined(USE_RECEIVE_SHARDS)
+    CAStopReceiveShards();
+#endif
+#if defined(USE_EVENTFD)
+    // receive thread will stop immediately, close the eventfd and reset
+    // shutdownFds under g_shutdownFdMutex
+    CAWakeUpForChange();
+#elif !defined(WSA_WAIT_EVENT_0)
     if (caglobals.ip.shutdownFds[1] != -1)
     {
         close(caglobals.ip.shutdownFds[1]);
@@ -1027,18 +1595,33 @@ void CAIPStopServer()
 void CAWakeUpForChange()
 {
 #if !defined(WSA_WAIT_EVENT_0)
+#if defined(USE_EVENTFD)
+    if (!g_shutdownFdMutex)
+    {
+        return;
+    }
+    oc_mutex_lock(g_shutdownFdMutex);
+#endif
     if (caglobals.ip.shutdownFds[1] != -1)
     {
         ssize_t len = 0;
         do
         {
+#if defined(USE_EVENTFD)
+            uint64_t value = 1;
+            len = write(caglobals.ip.shutdownFds[1], &value, sizeof (value));
+#else
             len = write(caglobals.ip.shutdownFds[1], "w", 1);
+#endif
         } while ((len == -1) && (errno == EINTR));
         if ((len == -1) && (errno != EINTR) && (errno != EPIPE))
         {
             OIC_LOG_V(DEBUG, TAG, "write failed: %s", strerror(errno));
         }
     }
+#if defined(USE_EVENTFD)
+    oc_mutex_unlock(g_shutdownFdMutex);
+#endif
 #else
     if (!WSASetEvent(caglobals.ip.shutdownEvent))
     {
@@ -1354,6 +1937,94 @@ static void sendData(int fd, const CAEndpoint_t *endpoint,
 #endif
 }
 
+#if defined(USE_MMSG)
+/**
+ * Send one datagram to the multicast group of endpoint on each of the given
+ * interfaces with as few sendmmsg() calls as possible.  The outgoing
+ * interface of every copy is selected with an IP_PKTINFO / IPV6_PKTINFO
+ * control message instead of a setsockopt() per interface.
+ */
+static void sendMulticastBatch(int fd, const CAEndpoint_t *endpoint,
+                               const uint32_t *ifindexes, uint32_t count,
+                               const void *data, uint32_t dlen, const char *fam)
+{
+    struct sockaddr_storage sock = { .ss_family = 0 };
+    CAConvertNameToAddr(endpoint->addr, endpoint->port, &sock);
+    socklen_t socklen = (sock.ss_family == AF_INET6) ? sizeof (struct sockaddr_in6)
+                                                     : sizeof (struct sockaddr_in);
+
+    struct iovec iov = { .iov_base = (void *)data, .iov_len = dlen };
+    union control
+    {
+        struct cmsghdr cmsg;
+        unsigned char data[CMSG_SPACE(sizeof (struct in6_pktinfo))];
+    } cmsgs[SEND_BATCH_SIZE];
+    struct mmsghdr msgs[SEND_BATCH_SIZE];
+
+    while (count)
+    {
+        uint32_t batch = (count < SEND_BATCH_SIZE) ? count : SEND_BATCH_SIZE;
+
+        memset(msgs, 0, sizeof (msgs));
+        memset(cmsgs, 0, sizeof (cmsgs));
+        for (uint32_t i = 0; i < batch; i++)
+        {
+            struct msghdr *hdr = &msgs[i].msg_hdr;
+            hdr->msg_name = &sock;
+            hdr->msg_namelen = socklen;
+            hdr->msg_iov = &iov;
+            hdr->msg_iovlen = 1;
+            hdr->msg_control = &cmsgs[i];
+
+            struct cmsghdr *cmp = &cmsgs[i].cmsg;
+            if (sock.ss_family == AF_INET6)
+            {
+                hdr->msg_controllen = CMSG_SPACE(sizeof (struct in6_pktinfo));
+                cmp->cmsg_level = IPPROTO_IPV6;
+                cmp->cmsg_type = IPV6_PKTINFO;
+                cmp->cmsg_len = CMSG_LEN(sizeof (struct in6_pktinfo));
+                ((struct in6_pktinfo *)CMSG_DATA(cmp))->ipi6_ifindex = ifindexes[i];
+            }
+            else
+            {
+                hdr->msg_controllen = CMSG_SPACE(sizeof (struct in_pktinfo));
+                cmp->cmsg_level = IPPROTO_IP;
+                cmp->cmsg_type = IP_PKTINFO;
+                cmp->cmsg_len = CMSG_LEN(sizeof (struct in_pktinfo));
+                ((struct in_pktinfo *)CMSG_DATA(cmp))->ipi_ifindex = ifindexes[i];
+            }
+        }
+
+        // a partial send leaves the rest to the next call, which reports their own error.
+        int sent = sendmmsg(fd, msgs, batch, 0);
+        if (0 >= sent)
+        {
+            // skip the datagram which failed and carry on with the rest
+            const char *error = (OC_SOCKET_ERROR == sent) ? strerror(errno) : "nothing sent";
+            if (g_ipErrorHandler)
+            {
+                g_ipErrorHandler(endpoint, data, dlen, CA_SEND_FAILED);
+            }
+            OIC_LOG_V(ERROR, TAG, "multicast %s sendmmsg failed on interface %u: %s",
+                      fam, ifindexes[0], error);
+            CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                               -1, false, error);
+            sent = 1;
+        }
+        else
+        {
+            OIC_LOG_V(INFO, TAG, "multicast %s sendmmsg is successful: %d x %u bytes",
+                      fam, sent, dlen);
+            CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                               dlen, true, NULL);
+        }
+
+        ifindexes += sent;
+        count -= sent;
+    }
+}
+#endif // USE_MMSG
+
 static void sendMulticastData6(const u_arraylist_t *iflist,
                                CAEndpoint_t *endpoint,
                                const void *data, uint32_t datalen)
@@ -1375,6 +2046,10 @@ static void sendMulticastData6(const u_arraylist_t *iflist,
     int fd = caglobals.ip.u6.fd;
 
     uint32_t len = u_arraylist_length(iflist);
+#if defined(USE_MMSG)
+    uint32_t ifindexes[SEND_BATCH_SIZE];
+    uint32_t count = 0;
+#endif
     for (uint32_t i = 0; i < len; i++)
     {
         CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
@@ -1391,6 +2066,14 @@ static void sendMulticastData6(const u_arraylist_t *iflist,
             continue;
         }
 
+#if defined(USE_MMSG)
+        ifindexes[count++] = ifitem->index;
+        if (SEND_BATCH_SIZE == count)
+        {
+            sendMulticastBatch(fd, endpoint, ifindexes, count, data, datalen, "ipv6");
+            count = 0;
+        }
+#else
         int index = ifitem->index;
         if (setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_IF, OPTVAL_T(&index), sizeof (index)))
         {
@@ -1398,7 +2081,14 @@ static void sendMulticastData6(const u_arraylist_t *iflist,
             return;
         }
         sendData(fd, endpoint, data, datalen, "multicast", "ipv6");
+#endif
+    }
+#if defined(USE_MMSG)
+    if (count)
+    {
+        sendMulticastBatch(fd, endpoint, ifindexes, count, data, datalen, "ipv6");
     }
+#endif
 }
 
 static void sendMulticastData4(const u_arraylist_t *iflist,
@@ -1407,6 +2097,7 @@ static void sendMulticastData4(const u_arraylist_t *iflist,
 {
     VERIFY_NON_NULL_VOID(endpoint, TAG, "endpoint is NULL");
 
+#if !defined(USE_MMSG)
 #if defined(USE_IP_MREQN)
     struct ip_mreqn mreq = { .imr_multiaddr = IPv4MulticastAddress,
                              .imr_address.s_addr = htonl(INADDR_ANY),
@@ -1414,12 +2105,17 @@ static void sendMulticastData4(const u_arraylist_t *iflist,
 #else
     struct ip_mreq mreq  = { .imr_multiaddr.s_addr = IPv4MulticastAddress.s_addr,
                              .imr_interface = {0}};
+#endif
 #endif
 
     OICStrcpy(endpoint->addr, sizeof(endpoint->addr), IPv4_MULTICAST);
     int fd = caglobals.ip.u4.fd;
 
     uint32_t len = u_arraylist_length(iflist);
+#if defined(USE_MMSG)
+    uint32_t ifindexes[SEND_BATCH_SIZE];
+    uint32_t count = 0;
+#endif
     for (uint32_t i = 0; i < len; i++)
     {
         CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
@@ -1435,6 +2131,14 @@ static void sendMulticastData4(const u_arraylist_t *iflist,
         {
             continue;
         }
+#if defined(USE_MMSG)
+        ifindexes[count++] = ifitem->index;
+        if (SEND_BATCH_SIZE == count)
+        {
+            sendMulticastBatch(fd, endpoint, ifindexes, count, data, datalen, "ipv4");
+            count = 0;
+        }
+#else
 #if defined(USE_IP_MREQN)
         mreq.imr_ifindex = ifitem->index;
 #else
@@ -1446,7 +2150,14 @@ static void sendMulticastData4(const u_arraylist_t *iflist,
                     CAIPS_GET_ERROR);
         }
         sendData(fd, endpoint, data, datalen, "multicast", "ipv4");
+#endif
+    }
+#if defined(USE_MMSG)
+    if (count)
+    {
+        sendMulticastBatch(fd, endpoint, ifindexes, count, data, datalen, "ipv4");
     }
+#endif
 }
 
 void CAIPSendData(CAEndpoint_t *endpoint, const void *data, uint32_t datalen,
@@ -1461,11 +2172,20 @@ void CAIPSendData(CAEndpoint_t *endpoint, const void *data, uint32_t datalen,
     {
         endpoint->port = isSecure ? CA_SECURE_COAP : CA_COAP;
 
-        u_arraylist_t *iflist = CAIPGetInterfaceInformation(0);
+        const u_arraylist_t *iflist = NULL;
+        u_arraylist_t *ownList = NULL;
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+        iflist = CAIPAcquireInterfaceSnapshot();
+#endif
         if (!iflist)
         {
-            OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
-            return;
+            ownList = CAIPGetInterfaceInformation(0);
+            if (!ownList)
+            {
+                OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
+                return;
+            }
+            iflist = ownList;
         }
 
         if ((endpoint->flags & CA_IPV6) && caglobals.ip.ipv6enabled)
@@ -1477,7 +2197,16 @@ void CAIPSendData(CAEndpoint_t *endpoint, const void *data, uint32_t datalen,
             sendMulticastData4(iflist, endpoint, data, datalen);
         }
 
-        u_arraylist_destroy(iflist);
+        if (ownList)
+        {
+            u_arraylist_destroy(ownList);
+        }
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+        else
+        {
+            CAIPReleaseInterfaceSnapshot();
+        }
+#endif
     }
     else
     {
@@ -27,6 +27,7 @@
 #include <sys/select.h>
 #include <ifaddrs.h>
 #include <unistd.h>
+#include <sched.h>
 #include <fcntl.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -40,6 +41,7 @@
 #endif
 
 #include "caipnwmonitor.h"
+#include "caatomic.h"
 #include "octhread.h"
 #include "caadapterutils.h"
 #include "logger.h"
@@ -64,6 +66,28 @@ static u_arraylist_t *g_netInterfaceList = NULL;
  */
 static struct CAIPCBData_t *g_adapterCallbackList = NULL;
 
+/**
+ * List of CAInterface_t items shared with the senders.  It is replaced, never
+ * modified, when netlink reports a change, so senders read it without a lock.
+ */
+static void * volatile g_interfaceSnapshot = NULL;
+
+/**
+ * Number of senders reading g_interfaceSnapshot.
+ */
+static volatile uint32_t g_interfaceSnapshotReaders = 0;
+
+/**
+ * Replaced interface lists, freed once no sender reads a snapshot.
+ */
+typedef struct CARetiredInterfaceList
+{
+    struct CARetiredInterfaceList *next;
+    u_arraylist_t *iflist;
+} CARetiredInterfaceList_t;
+
+static CARetiredInterfaceList_t *g_retiredInterfaceLists = NULL;
+
 /**
  * Initialize the network interface monitoring list.
  */
@@ -94,12 +118,124 @@ static void CARemoveNetworkMonitorList(int ifiindex);
  */
 static void CAIPPassNetworkChangesToAdapter(CANetworkStatus_t status);
 
+/**
+ * Free the replaced interface lists once no sender reads a snapshot.
+ */
+static void CAIPFreeRetiredInterfaceLists(bool wait);
+
+/**
+ * Publish a new interface snapshot.
+ */
+static void CAIPSetInterfaceSnapshot(u_arraylist_t *iflist);
+
+/**
+ * Rebuild the interface snapshot.
+ */
+static void CAIPRefreshInterfaceSnapshot();
+
 /**
  * Create new interface item.
  */
 static CAInterface_t *CANewInterfaceItem(int index, const char *name, int family,
                                          const char *addr, int flags);
 
+/**
+ * The caller holds g_networkMonitorContextMutex.
+ * @param[in]  wait     wait for the senders instead of keeping the lists.
+ */
+static void CAIPFreeRetiredInterfaceLists(bool wait)
+{
+    CAAtomicFence();
+    while (0 != CAAtomicLoad32(&g_interfaceSnapshotReaders))
+    {
+        if (!wait)
+        {
+            return;
+        }
+        sched_yield();
+    }
+
+    while (g_retiredInterfaceLists)
+    {
+        CARetiredInterfaceList_t *retired = g_retiredInterfaceLists;
+        g_retiredInterfaceLists = retired->next;
+        u_arraylist_destroy(retired->iflist);
+        OICFree(retired);
+    }
+}
+
+static void CAIPSetInterfaceSnapshot(u_arraylist_t *iflist)
+{
+    if (!g_networkMonitorContextMutex)
+    {
+        u_arraylist_destroy(iflist);
+        return;
+    }
+
+    oc_mutex_lock(g_networkMonitorContextMutex);
+    u_arraylist_t *old = (u_arraylist_t *)CAAtomicExchangePtr(&g_interfaceSnapshot, iflist);
+    if (old)
+    {
+        CARetiredInterfaceList_t *retired =
+            (CARetiredInterfaceList_t *)OICMalloc(sizeof(*retired));
+        if (retired)
+        {
+            retired->iflist = old;
+            retired->next = g_retiredInterfaceLists;
+            g_retiredInterfaceLists = retired;
+        }
+        else
+        {
+            // nowhere to keep it, wait for the senders still reading it.
+            CAIPFreeRetiredInterfaceLists(true);
+            u_arraylist_destroy(old);
+        }
+    }
+    // the last snapshot is dropped when the monitor stops, nothing may stay behind.
+    CAIPFreeRetiredInterfaceLists(NULL == iflist);
+    oc_mutex_unlock(g_networkMonitorContextMutex);
+}
+
+static void CAIPRefreshInterfaceSnapshot()
+{
+    u_arraylist_t *iflist = CAIPGetInterfaceInformation(0);
+    if (!iflist)
+    {
+        // keep the former snapshot, it is still the best we know.
+        OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
+        return;
+    }
+    CAIPSetInterfaceSnapshot(iflist);
+}
+
+const u_arraylist_t *CAIPAcquireInterfaceSnapshot()
+{
+    if (OC_INVALID_SOCKET == caglobals.ip.netlinkFd || !g_networkMonitorContextMutex)
+    {
+        // without change notifications a cached list could go stale.
+        return NULL;
+    }
+
+    if (!CAAtomicLoadPtr(&g_interfaceSnapshot))
+    {
+        CAIPRefreshInterfaceSnapshot();
+    }
+
+    CAAtomicAdd32(&g_interfaceSnapshotReaders, 1);
+    CAAtomicFence();
+    const u_arraylist_t *iflist = (const u_arraylist_t *)CAAtomicLoadPtr(&g_interfaceSnapshot);
+    if (!iflist)
+    {
+        CAAtomicAdd32(&g_interfaceSnapshotReaders, UINT32_MAX);
+    }
+    return iflist;
+}
+
+void CAIPReleaseInterfaceSnapshot()
+{
+    CAAtomicAdd32(&g_interfaceSnapshotReaders, UINT32_MAX);
+}
+
 static CAResult_t CAIPInitializeNetworkMonitorList()
 {
     if (!g_networkMonitorContextMutex)
@@ -127,6 +263,8 @@ static CAResult_t CAIPInitializeNetworkMonitorList()
 
 static void CAIPDestroyNetworkMonitorList()
 {
+    CAIPSetInterfaceSnapshot(NULL);
+
     if (g_netInterfaceList)
     {
         u_arraylist_destroy(g_netInterfaceList);
@@ -327,13 +465,22 @@ u_arraylist_t *CAFindInterfaceChange()
                           .msg_iovlen = 1 };
 
     ssize_t len = recvmsg(caglobals.ip.netlinkFd, &msg, 0);
+    bool changed = false;
 
     for (nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len))
     {
+        if (nh != NULL && (RTM_NEWLINK == nh->nlmsg_type || RTM_DELLINK == nh->nlmsg_type))
+        {
+            // interface flags changed
+            changed = true;
+            continue;
+        }
+
         if (nh != NULL && (nh->nlmsg_type != RTM_DELADDR && nh->nlmsg_type != RTM_NEWADDR))
         {
             continue;
         }
+        changed = true;
 
         if (RTM_DELADDR == nh->nlmsg_type)
         {
@@ -356,14 +503,23 @@ u_arraylist_t *CAFindInterfaceChange()
         if (ifa)
         {
             int ifiIndex = ifa->ifa_index;
+            if (iflist)
+            {
+                u_arraylist_destroy(iflist);
+            }
             iflist = CAIPGetInterfaceInformation(ifiIndex);
             if (!iflist)
             {
                 OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
-                return NULL;
+                break;
             }
         }
     }
+
+    if (changed && CAAtomicLoadPtr(&g_interfaceSnapshot))
+    {
+        CAIPRefreshInterfaceSnapshot();
+    }
 #endif
     return iflist;
 }
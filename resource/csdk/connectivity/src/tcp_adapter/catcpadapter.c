@@ -62,6 +62,14 @@ typedef struct
 
 #define CA_TCP_LISTEN_BACKLOG  3
 
+/**
+ * Bytes a session may have queued for a slow peer before new messages for
+ * it are refused with CA_SEND_FAILED.
+ */
+#ifndef CA_TCP_SEND_HIGH_WATER_MARK
+#define CA_TCP_SEND_HIGH_WATER_MARK (64 * 1024)
+#endif
+
 #define CA_TCP_SELECT_TIMEOUT 10
 
 /**
@@ -189,6 +197,23 @@ void CATCPPacketReceivedCB(const CASecureEndpoint_t *sep, const void *data,
     //totalLen filled only when header fully read and parsed
     while (0 != bufferLen)
     {
+        // complete messages are passed up from the receive buffer itself,
+        // only a message split across reads is copied to svritem->data.
+        if (0 == svritem->len)
+        {
+            size_t messageLen = CAGetMessageLengthFromBuffer(buffer, bufferLen);
+            if (0 < messageLen && messageLen <= bufferLen)
+            {
+                if (g_networkPacketCallback)
+                {
+                    g_networkPacketCallback(sep, buffer, messageLen);
+                }
+                buffer += messageLen;
+                bufferLen -= messageLen;
+                continue;
+            }
+        }
+
         CAResult_t res = CAConstructCoAP(svritem, &buffer, &bufferLen);
         if (CA_STATUS_OK != res)
         {
@@ -234,7 +259,6 @@ static void CATCPErrorHandler(const CAEndpoint_t *endpoint, const void *data,
                               size_t dataLength, CAResult_t result)
 {
     VERIFY_NON_NULL_VOID(endpoint, TAG, "endpoint is NULL");
-    VERIFY_NON_NULL_VOID(data, TAG, "data is NULL");
 
     if (g_errorCallback)
     {
@@ -297,6 +321,9 @@ static void CAInitializeTCPGlobals()
     caglobals.tcp.ipv4s.fd = -1;
     caglobals.tcp.ipv6.fd = -1;
     caglobals.tcp.ipv6s.fd = -1;
+#if defined(HAVE_SYS_EPOLL_H)
+    caglobals.tcp.epollFd = -1;
+#endif
 
     // Set the port number received from application.
     caglobals.tcp.ipv4.port = caglobals.ports.tcp.u4;
@@ -306,6 +333,7 @@ static void CAInitializeTCPGlobals()
 
     caglobals.tcp.selectTimeout = CA_TCP_SELECT_TIMEOUT;
     caglobals.tcp.listenBacklog = CA_TCP_LISTEN_BACKLOG;
+    caglobals.tcp.sendHighWaterMark = CA_TCP_SEND_HIGH_WATER_MARK;
 
     CATransportFlags_t flags = 0;
     if (caglobals.client)
@@ -582,6 +610,15 @@ void CATCPSendDataThread(void *threadData)
             return;
         }
 
+        // the peer is not keeping up; refuse the message but keep the session.
+        if (CATCPIsSendQueueFull(tcpData->remoteEndpoint))
+        {
+            OIC_LOG(WARNING, TAG, "send queue above high-water mark, message refused");
+            CATCPErrorHandler(tcpData->remoteEndpoint, tcpData->data, tcpData->dataLen,
+                              CA_SEND_FAILED);
+            return;
+        }
+
 #ifdef __WITH_TLS__
          if (tcpData->remoteEndpoint && tcpData->remoteEndpoint->flags & CA_SECURE)
          {
@@ -30,12 +30,19 @@
 #ifdef HAVE_SYS_SELECT_H
 #include <sys/select.h>
 #endif
+#if defined(HAVE_SYS_EPOLL_H) && !defined(WSA_WAIT_EVENT_0)
+#include <sys/epoll.h>
+#define USE_EPOLL           // wait with epoll instead of select
+#endif
 #ifdef HAVE_SYS_IOCTL_H
 #include <sys/ioctl.h>
 #endif
 #ifdef HAVE_SYS_POLL_H
 #include <sys/poll.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 #include <stdio.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -63,6 +70,7 @@
 #include "octhread.h"
 #include "oic_malloc.h"
 #include "oic_string.h"
+#include "oic_time.h"
 
 #include <coap/pdu.h>
 #include <coap/utlist.h>
@@ -82,11 +90,43 @@
  */
 #define COAP_MAX_HEADER_SIZE  6
 
+/**
+ * Reassembly buffer a session keeps between messages, larger ones are freed
+ * once their message is complete.
+ */
+#ifndef CA_TCP_KEEP_BUFFER_SIZE
+#define CA_TCP_KEEP_BUFFER_SIZE  COAP_MAX_PDU_SIZE
+#endif
+
 /**
  * TLS header size
  */
 #define TLS_HEADER_SIZE 5
 
+/**
+ * Number of buckets in each session hash table (power of two).
+ */
+#ifndef CA_TCP_SESSION_HASH_SIZE
+#define CA_TCP_SESSION_HASH_SIZE 1024
+#endif
+
+/**
+ * Ready fds handled per epoll_wait() wakeup.
+ */
+#define EPOLL_MAX_EVENTS 64
+
+/**
+ * Queued frames coalesced into one writev() call.
+ */
+#define CA_TCP_SEND_IOV_MAX 16
+
+/**
+ * Seconds a non-blocking connect may take before the session is dropped.
+ */
+#ifndef CA_TCP_CONNECT_TIMEOUT
+#define CA_TCP_CONNECT_TIMEOUT 10
+#endif
+
 /**
  * Mutex to synchronize device object list.
  */
@@ -117,6 +157,21 @@ static CATCPConnectionHandleCallback g_connectionCallback = NULL;
  */
 static CATCPSessionInfo_t *g_sessionList = NULL;
 
+/**
+ * Sessions in g_sessionList indexed by socket fd (receive path).
+ */
+static CATCPSessionInfo_t *g_sessionFdTable[CA_TCP_SESSION_HASH_SIZE];
+
+/**
+ * Sessions in g_sessionList indexed by remote address and port (send path).
+ */
+static CATCPSessionInfo_t *g_sessionEndpointTable[CA_TCP_SESSION_HASH_SIZE];
+
+/**
+ * Sessions whose connect is still in progress (chained by connectNext).
+ */
+static CATCPSessionInfo_t *g_connectingList = NULL;
+
 static CAResult_t CATCPCreateMutex();
 static void CATCPDestroyMutex();
 static CAResult_t CATCPCreateCond();
@@ -125,13 +180,22 @@ static CASocketFd_t CACreateAcceptSocket(int family, CASocket_t *sock);
 static void CAAcceptConnection(CATransportFlags_t flag, CASocket_t *sock);
 static void CAFindReadyMessage();
 #if !defined(WSA_WAIT_EVENT_0)
-static void CASelectReturned(fd_set *readFds);
+static void CASelectReturned(fd_set *readFds, fd_set *writeFds);
+static ssize_t CAWakeUpForReadFdsUpdate(const char *host);
 #else
 static void CASocketEventReturned(CASocketFd_t socket, long networkEvents);
 #endif
 static void CAReceiveMessage(CASocketFd_t fd);
 static void CAReceiveHandler(void *data);
-static CAResult_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem);
+static CASocketFd_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem);
+static bool CASendPendingData(CASocketFd_t fd);
+static int CACheckConnectTimeouts();
+#if defined(USE_EPOLL)
+static void CAInitializeEpoll();
+static void CAEpollAddFd(CASocketFd_t fd, uint32_t events);
+static void CAFindReadyMessageEpoll(int epollFd);
+static void CAEpollReturned(struct epoll_event *events, int count);
+#endif
 
 #if defined(WSA_WAIT_EVENT_0)
 #define CHECKFD(FD)
@@ -201,14 +265,367 @@ static CAResult_t CATCPCreateCond()
     return CA_STATUS_OK;
 }
 
+/*
+ * The session tables below are only accessed with g_mutexObjectList held.
+ * g_sessionList keeps every session in creation order; the two hash tables
+ * make the per-packet lookups independent of the number of sessions.
+ */
+
+static size_t CAHashSessionFd(CASocketFd_t fd)
+{
+    return (size_t)fd & (CA_TCP_SESSION_HASH_SIZE - 1);
+}
+
+/*
+ * A session matches an endpoint whose flags merely overlap its own, so only
+ * the address and port are hashed (FNV-1a); flags are compared on the chain.
+ */
+static size_t CAHashSessionEndpoint(const char *addr, uint16_t port)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < MAX_ADDR_STR_SIZE_CA && addr[i]; i++)
+    {
+        hash = (hash ^ (uint8_t)addr[i]) * 16777619u;
+    }
+    hash = (hash ^ (port & 0xFF)) * 16777619u;
+    hash = (hash ^ (port >> 8)) * 16777619u;
+    return hash & (CA_TCP_SESSION_HASH_SIZE - 1);
+}
+
+static bool CASessionMatchesEndpoint(const CATCPSessionInfo_t *session,
+                                     const CAEndpoint_t *endpoint)
+{
+    return !strncmp(session->sep.endpoint.addr, endpoint->addr,
+                    sizeof(session->sep.endpoint.addr))
+           && (session->sep.endpoint.port == endpoint->port)
+           && (session->sep.endpoint.flags & endpoint->flags);
+}
+
+static void CAIndexSessionFd(CATCPSessionInfo_t *session)
+{
+    size_t bucket = CAHashSessionFd(session->fd);
+    session->fdNext = g_sessionFdTable[bucket];
+    g_sessionFdTable[bucket] = session;
+}
+
+static void CAUnindexSessionFd(CATCPSessionInfo_t *session)
+{
+    CATCPSessionInfo_t **link = &g_sessionFdTable[CAHashSessionFd(session->fd)];
+    while (*link && *link != session)
+    {
+        link = &(*link)->fdNext;
+    }
+    if (*link)
+    {
+        *link = session->fdNext;
+    }
+    session->fdNext = NULL;
+}
+
+/**
+ * Add a session to the list and both indexes.
+ * A session without a socket yet is indexed by fd in CATCPCreateSocket().
+ */
+static void CAAddSession(CATCPSessionInfo_t *session)
+{
+    DL_APPEND(g_sessionList, session);
+
+    // append so the oldest matching session is found first, as in the list
+    CATCPSessionInfo_t **link = &g_sessionEndpointTable[
+            CAHashSessionEndpoint(session->sep.endpoint.addr, session->sep.endpoint.port)];
+    while (*link)
+    {
+        link = &(*link)->epNext;
+    }
+    session->epNext = NULL;
+    *link = session;
+
+    if (OC_INVALID_SOCKET != session->fd)
+    {
+        CAIndexSessionFd(session);
+    }
+}
+
+static void CARemoveConnecting(CATCPSessionInfo_t *session)
+{
+    CATCPSessionInfo_t **link = &g_connectingList;
+    while (*link && *link != session)
+    {
+        link = &(*link)->connectNext;
+    }
+    if (*link)
+    {
+        *link = session->connectNext;
+    }
+    session->connectNext = NULL;
+    session->connectDeadline = 0;
+}
+
+/**
+ * Remove a session from the list and both indexes (the session is not freed).
+ */
+static void CARemoveSession(CATCPSessionInfo_t *session)
+{
+    DL_DELETE(g_sessionList, session);
+    if (session->connectDeadline)
+    {
+        CARemoveConnecting(session);
+    }
+
+    CATCPSessionInfo_t **link = &g_sessionEndpointTable[
+            CAHashSessionEndpoint(session->sep.endpoint.addr, session->sep.endpoint.port)];
+    while (*link && *link != session)
+    {
+        link = &(*link)->epNext;
+    }
+    if (*link)
+    {
+        *link = session->epNext;
+    }
+    session->epNext = NULL;
+
+    if (OC_INVALID_SOCKET != session->fd)
+    {
+        CAUnindexSessionFd(session);
+    }
+}
+
+static CATCPSessionInfo_t *CAFindSessionByEndpoint(const CAEndpoint_t *endpoint)
+{
+    CATCPSessionInfo_t *session = g_sessionEndpointTable[
+            CAHashSessionEndpoint(endpoint->addr, endpoint->port)];
+    while (session && !CASessionMatchesEndpoint(session, endpoint))
+    {
+        session = session->epNext;
+    }
+    return session;
+}
+
+static CATCPSessionInfo_t *CAFindSessionByFd(CASocketFd_t fd)
+{
+    CATCPSessionInfo_t *session = g_sessionFdTable[CAHashSessionFd(fd)];
+    while (session && session->fd != fd)
+    {
+        session = session->fdNext;
+    }
+    return session;
+}
+
+static void CASetNonBlocking(CASocketFd_t fd)
+{
+#if !defined(WSA_WAIT_EVENT_0)
+    int flags = fcntl(fd, F_GETFL);
+    if (-1 == flags || -1 == fcntl(fd, F_SETFL, flags | O_NONBLOCK))
+    {
+        OIC_LOG_V(ERROR, TAG, "set O_NONBLOCK failed: %s", strerror(errno));
+    }
+#else
+    (void)fd;
+#endif
+}
+
+/*
+ * Data a session socket does not take immediately is copied to the session's
+ * send queue, and the receive thread writes it once the socket is writable,
+ * so a slow peer never stalls the send thread.  The queue is only accessed
+ * with g_mutexObjectList held.
+ */
+
+static bool CAQueuePendingData(CATCPSessionInfo_t *session, const void *data, size_t len)
+{
+    CATCPPendingData_t *item = (CATCPPendingData_t *) OICMalloc(sizeof(*item) + len);
+    if (!item)
+    {
+        OIC_LOG(ERROR, TAG, "Out of memory");
+        return false;
+    }
+
+    item->next = NULL;
+    item->len = len;
+    item->data = (unsigned char *)(item + 1);
+    memcpy(item->data, data, len);
+
+    if (session->sendTail)
+    {
+        session->sendTail->next = item;
+    }
+    else
+    {
+        session->sendHead = item;
+    }
+    session->sendTail = item;
+    session->sendQueued += len;
+    return true;
+}
+
+static void CAConsumePendingData(CATCPSessionInfo_t *session, size_t len)
+{
+    session->sendQueued -= len;
+    while (len > 0 && session->sendHead)
+    {
+        CATCPPendingData_t *item = session->sendHead;
+        size_t left = item->len - session->sendOffset;
+        if (len < left)
+        {
+            session->sendOffset += len;
+            return;
+        }
+
+        len -= left;
+        session->sendHead = item->next;
+        if (!session->sendHead)
+        {
+            session->sendTail = NULL;
+        }
+        session->sendOffset = 0;
+        OICFree(item);
+    }
+}
+
+static void CAClearPendingData(CATCPSessionInfo_t *session)
+{
+    while (session->sendHead)
+    {
+        CATCPPendingData_t *item = session->sendHead;
+        session->sendHead = item->next;
+        OICFree(item);
+    }
+    session->sendTail = NULL;
+    session->sendOffset = 0;
+    session->sendQueued = 0;
+}
+
+/**
+ * Have the receive thread watch the session socket for output while data is
+ * queued, and stop once the queue is empty.
+ */
+static void CAUpdateWriteInterest(CATCPSessionInfo_t *session)
+{
+    bool waitWritable = (NULL != session->sendHead);
+    if (waitWritable == session->waitWritable)
+    {
+        return;
+    }
+    session->waitWritable = waitWritable;
+
+#if defined(USE_EPOLL)
+    if (-1 != caglobals.tcp.epollFd)
+    {
+        struct epoll_event event = { 0 };
+        event.events = EPOLLIN | (waitWritable ? EPOLLOUT : 0);
+        event.data.fd = session->fd;
+        if (-1 == epoll_ctl(caglobals.tcp.epollFd, EPOLL_CTL_MOD, session->fd, &event))
+        {
+            OIC_LOG_V(ERROR, TAG, "epoll_ctl(%d) failed: %s", session->fd, strerror(errno));
+        }
+        return;
+    }
+#endif
+#if !defined(WSA_WAIT_EVENT_0)
+    if (waitWritable)
+    {
+        // select() only picks up the new write fd on its next round.
+        (void)CAWakeUpForReadFdsUpdate(session->sep.endpoint.addr);
+    }
+#endif
+}
+
+/**
+ * Write to a session socket without blocking.
+ * @return bytes written (0 if the socket is full) or -1 on error.
+ */
+static ssize_t CAWriteSocket(CASocketFd_t fd, const void *data, size_t len)
+{
+    ssize_t ret = 0;
+    do
+    {
+        ret = send(fd, data, len, 0);
+    } while (-1 == ret && EINTR == errno);
+
+    if (-1 == ret && (EWOULDBLOCK == errno || EAGAIN == errno))
+    {
+        return 0;
+    }
+    return ret;
+}
+
+/**
+ * Write as much of the send queue as the socket takes, several frames per
+ * writev() call.
+ * @return false if the socket failed.
+ */
+static bool CAFlushPendingData(CATCPSessionInfo_t *session)
+{
+    while (session->sendHead)
+    {
+#ifdef HAVE_SYS_UIO_H
+        struct iovec iov[CA_TCP_SEND_IOV_MAX];
+        int count = 0;
+        size_t total = 0;
+        size_t offset = session->sendOffset;
+        for (CATCPPendingData_t *item = session->sendHead;
+             item && count < CA_TCP_SEND_IOV_MAX; item = item->next)
+        {
+            iov[count].iov_base = item->data + offset;
+            iov[count].iov_len = item->len - offset;
+            total += iov[count].iov_len;
+            offset = 0;
+            count++;
+        }
+
+        ssize_t len = 0;
+        do
+        {
+            len = writev(session->fd, iov, count);
+        } while (-1 == len && EINTR == errno);
+
+        if (-1 == len && (EWOULDBLOCK == errno || EAGAIN == errno))
+        {
+            len = 0;
+        }
+#else
+        size_t total = session->sendHead->len - session->sendOffset;
+        ssize_t len = CAWriteSocket(session->fd, session->sendHead->data + session->sendOffset,
+                                    total);
+#endif
+        if (-1 == len)
+        {
+            OIC_LOG_V(ERROR, TAG, "send queued data failed: %s", strerror(errno));
+            return false;
+        }
+
+        CAConsumePendingData(session, (size_t)len);
+        if ((size_t)len < total)
+        {
+            break;  // the socket is full again
+        }
+    }
+
+    CAUpdateWriteInterest(session);
+    return true;
+}
+
 static void CAReceiveHandler(void *data)
 {
     (void)data;
     OIC_LOG(DEBUG, TAG, "IN - CAReceiveHandler");
 
-    while (!caglobals.tcp.terminate)
+#if defined(USE_EPOLL)
+    int epollFd = caglobals.tcp.epollFd;
+    if (-1 != epollFd)
+    {
+        while (!caglobals.tcp.terminate)
+        {
+            CAFindReadyMessageEpoll(epollFd);
+        }
+    }
+    else
+#endif
     {
-        CAFindReadyMessage();
+        while (!caglobals.tcp.terminate)
+        {
+            CAFindReadyMessage();
+        }
     }
 
     oc_mutex_lock(g_mutexObjectList);
@@ -223,9 +640,22 @@ static void CAReceiveHandler(void *data)
 static void CAFindReadyMessage()
 {
     fd_set readFds;
+    fd_set writeFds;
     struct timeval timeout = { .tv_sec = caglobals.tcp.selectTimeout };
+    struct timeval *tv = caglobals.tcp.selectTimeout == -1 ? NULL : &timeout;
+
+    // close timed out connects first so their sockets are not selected on,
+    // and wake up in time for the next pending connect to time out
+    int connectTimeout = CACheckConnectTimeouts();
+    if (-1 != connectTimeout && (NULL == tv || connectTimeout < caglobals.tcp.selectTimeout * 1000))
+    {
+        timeout.tv_sec = connectTimeout / 1000;
+        timeout.tv_usec = (connectTimeout % 1000) * 1000;
+        tv = &timeout;
+    }
 
     FD_ZERO(&readFds);
+    FD_ZERO(&writeFds);
     CA_FD_SET(ipv4, &readFds);
     CA_FD_SET(ipv4s, &readFds);
     CA_FD_SET(ipv6, &readFds);
@@ -243,13 +673,20 @@ static void CAFindReadyMessage()
     CATCPSessionInfo_t *session = NULL;
     LL_FOREACH(g_sessionList, session)
     {
-        if (session && session->fd != OC_INVALID_SOCKET && session->state == CONNECTED)
+        if (session && session->fd != OC_INVALID_SOCKET)
         {
-            FD_SET(session->fd, &readFds);
+            if (session->state == CONNECTED)
+            {
+                FD_SET(session->fd, &readFds);
+            }
+            if (session->waitWritable)
+            {
+                FD_SET(session->fd, &writeFds);
+            }
         }
     }
 
-    int ret = select(caglobals.tcp.maxfd + 1, &readFds, NULL, NULL, &timeout);
+    int ret = select(caglobals.tcp.maxfd + 1, &readFds, &writeFds, NULL, tv);
 
     if (caglobals.tcp.terminate)
     {
@@ -263,7 +700,7 @@ static void CAFindReadyMessage()
     }
     else if (0 < ret)
     {
-        CASelectReturned(&readFds);
+        CASelectReturned(&readFds, &writeFds);
     }
     else // if (0 > ret)
     {
@@ -272,9 +709,10 @@ static void CAFindReadyMessage()
     }
 }
 
-static void CASelectReturned(fd_set *readFds)
+static void CASelectReturned(fd_set *readFds, fd_set *writeFds)
 {
     VERIFY_NON_NULL_VOID(readFds, TAG, "readFds is NULL");
+    VERIFY_NON_NULL_VOID(writeFds, TAG, "writeFds is NULL");
 
     if (caglobals.tcp.ipv4.fd != -1 && FD_ISSET(caglobals.tcp.ipv4.fd, readFds))
     {
@@ -283,7 +721,7 @@ static void CASelectReturned(fd_set *readFds)
     }
     else if (caglobals.tcp.ipv4s.fd != -1 && FD_ISSET(caglobals.tcp.ipv4s.fd, readFds))
     {
-        CAAcceptConnection(CA_IPV4 | CA_SECURE, &caglobals.tcp.ipv4s);
+        CAAcceptConnection((CATransportFlags_t)(CA_IPV4 | CA_SECURE), &caglobals.tcp.ipv4s);
         return;
     }
     else if (caglobals.tcp.ipv6.fd != -1 && FD_ISSET(caglobals.tcp.ipv6.fd, readFds))
@@ -293,7 +731,7 @@ static void CASelectReturned(fd_set *readFds)
     }
     else if (caglobals.tcp.ipv6s.fd != -1 && FD_ISSET(caglobals.tcp.ipv6s.fd, readFds))
     {
-        CAAcceptConnection(CA_IPV6 | CA_SECURE, &caglobals.tcp.ipv6s);
+        CAAcceptConnection((CATransportFlags_t)(CA_IPV6 | CA_SECURE), &caglobals.tcp.ipv6s);
         return;
     }
     else if (-1 != caglobals.tcp.connectionFds[0] &&
@@ -313,19 +751,141 @@ static void CASelectReturned(fd_set *readFds)
     else
     {
         CATCPSessionInfo_t *session = NULL;
-        LL_FOREACH(g_sessionList, session)
+        CATCPSessionInfo_t *tmp = NULL;
+        LL_FOREACH_SAFE(g_sessionList, session, tmp)
         {
             if (session && session->fd != OC_INVALID_SOCKET)
             {
-                if (FD_ISSET(session->fd, readFds))
+                CASocketFd_t fd = session->fd;
+                if (FD_ISSET(fd, writeFds) && !CASendPendingData(fd))
+                {
+                    continue;
+                }
+                if (FD_ISSET(fd, readFds))
                 {
-                    CAReceiveMessage(session->fd);
+                    CAReceiveMessage(fd);
                 }
             }
         }
     }
 }
 
+#if defined(USE_EPOLL)
+
+static void CAEpollAddFd(CASocketFd_t fd, uint32_t events)
+{
+    struct epoll_event event = { 0 };
+    event.events = events;
+    event.data.fd = fd;
+    if (-1 == epoll_ctl(caglobals.tcp.epollFd, EPOLL_CTL_ADD, fd, &event))
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_ctl(%d) failed: %s", fd, strerror(errno));
+    }
+}
+
+/**
+ * Register the accept sockets and pipes with a new epoll instance.  Session
+ * sockets are added once connected and removed before they are closed, so
+ * the wait no longer walks the session list nor is bound by FD_SETSIZE.
+ * On failure epollFd stays -1 and the receive thread falls back to select().
+ */
+static void CAInitializeEpoll()
+{
+    caglobals.tcp.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == caglobals.tcp.epollFd)
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_create1 failed: %s (using select)", strerror(errno));
+        return;
+    }
+
+    CASocketFd_t fds[] = { caglobals.tcp.ipv4.fd, caglobals.tcp.ipv4s.fd,
+                           caglobals.tcp.ipv6.fd, caglobals.tcp.ipv6s.fd,
+                           caglobals.tcp.shutdownFds[0], caglobals.tcp.connectionFds[0] };
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+    {
+        if (OC_INVALID_SOCKET != fds[i])
+        {
+            CAEpollAddFd(fds[i], EPOLLIN);
+        }
+    }
+}
+
+static void CAFindReadyMessageEpoll(int epollFd)
+{
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    int timeout = caglobals.tcp.selectTimeout == -1 ? -1 : caglobals.tcp.selectTimeout * 1000;
+    int connectTimeout = CACheckConnectTimeouts();
+    if (-1 != connectTimeout && (-1 == timeout || connectTimeout < timeout))
+    {
+        timeout = connectTimeout;
+    }
+
+    int ret = epoll_wait(epollFd, events, EPOLL_MAX_EVENTS, timeout);
+
+    if (caglobals.tcp.terminate)
+    {
+        OIC_LOG_V(DEBUG, TAG, "Packet receiver Stop request received.");
+        return;
+    }
+
+    if (0 == ret)
+    {
+        return;
+    }
+    else if (0 < ret)
+    {
+        CAEpollReturned(events, ret);
+    }
+    else if (EINTR != errno)
+    {
+        OIC_LOG_V(FATAL, TAG, "epoll_wait error %s", strerror(errno));
+    }
+}
+
+static void CAEpollReturned(struct epoll_event *events, int count)
+{
+    for (int i = 0; i < count && !caglobals.tcp.terminate; i++)
+    {
+        CASocketFd_t fd = events[i].data.fd;
+
+        if (fd == caglobals.tcp.ipv4.fd)
+        {
+            CAAcceptConnection(CA_IPV4, &caglobals.tcp.ipv4);
+        }
+        else if (fd == caglobals.tcp.ipv4s.fd)
+        {
+            CAAcceptConnection((CATransportFlags_t)(CA_IPV4 | CA_SECURE), &caglobals.tcp.ipv4s);
+        }
+        else if (fd == caglobals.tcp.ipv6.fd)
+        {
+            CAAcceptConnection(CA_IPV6, &caglobals.tcp.ipv6);
+        }
+        else if (fd == caglobals.tcp.ipv6s.fd)
+        {
+            CAAcceptConnection((CATransportFlags_t)(CA_IPV6 | CA_SECURE), &caglobals.tcp.ipv6s);
+        }
+        else if (fd == caglobals.tcp.shutdownFds[0] || fd == caglobals.tcp.connectionFds[0])
+        {
+            // the socket is already registered; only drain the wakeup.
+            char buf[MAX_ADDR_STR_SIZE_CA] = {0};
+            (void)read(fd, buf, sizeof (buf));
+        }
+        else
+        {
+            if ((events[i].events & EPOLLOUT) && !CASendPendingData(fd))
+            {
+                continue;
+            }
+            if (events[i].events & ~EPOLLOUT)
+            {
+                CAReceiveMessage(fd);
+            }
+        }
+    }
+}
+
+#endif // USE_EPOLL
+
 #else // if defined(WSA_WAIT_EVENT_0)
 
 /**
@@ -539,6 +1099,7 @@ static void CAAcceptConnection(CATransportFlags_t flag, CASocket_t *sock)
             return;
         }
 
+        CASetNonBlocking(sockfd);
         svritem->fd = sockfd;
         svritem->sep.endpoint.flags = flag;
         svritem->sep.endpoint.adapter = CA_ADAPTER_TCP;
@@ -548,10 +1109,16 @@ static void CAAcceptConnection(CATransportFlags_t flag, CASocket_t *sock)
                             svritem->sep.endpoint.addr, &svritem->sep.endpoint.port);
 
         oc_mutex_lock(g_mutexObjectList);
-        LL_APPEND(g_sessionList, svritem);
+        CAAddSession(svritem);
         oc_mutex_unlock(g_mutexObjectList);
 
         CHECKFD(sockfd);
+#if defined(USE_EPOLL)
+        if (-1 != caglobals.tcp.epollFd)
+        {
+            CAEpollAddFd(sockfd, EPOLLIN);
+        }
+#endif
 
         // pass the connection information to CA Common Layer.
         if (g_connectionCallback)
@@ -598,8 +1165,12 @@ void CACleanData(CATCPSessionInfo_t *svritem)
 {
     if (svritem)
     {
-        OICFree(svritem->data);
-        svritem->data = NULL;
+        if (svritem->dataSize > CA_TCP_KEEP_BUFFER_SIZE)
+        {
+            OICFree(svritem->data);
+            svritem->data = NULL;
+            svritem->dataSize = 0;
+        }
         svritem->len = 0;
         svritem->tlsLen = 0;
         svritem->totalLen = 0;
@@ -630,14 +1201,20 @@ CAResult_t CAConstructCoAP(CATCPSessionInfo_t *svritem, unsigned char **data,
     size_t inLen = *dataLength;
     OIC_LOG_V(DEBUG, TAG, "before-datalength : %u", *dataLength);
 
-    if (NULL == svritem->data && inLen > 0)
+    if (0 == svritem->len && inLen > 0)
     {
         // allocate memory for message header (CoAP header size because it is bigger)
-        svritem->data = (unsigned char *) OICCalloc(1, COAP_MAX_HEADER_SIZE);
-        if (NULL == svritem->data)
+        if (svritem->dataSize < COAP_MAX_HEADER_SIZE)
         {
-            OIC_LOG(ERROR, TAG, "OICCalloc - out of memory");
-            return CA_MEMORY_ALLOC_FAILED;
+            unsigned char *buffer = (unsigned char *)OICRealloc(svritem->data,
+                                                                COAP_MAX_HEADER_SIZE);
+            if (NULL == buffer)
+            {
+                OIC_LOG(ERROR, TAG, "OICRealloc - out of memory");
+                return CA_MEMORY_ALLOC_FAILED;
+            }
+            svritem->data = buffer;
+            svritem->dataSize = COAP_MAX_HEADER_SIZE;
         }
 
         // copy 1 byte to parse coap header length
@@ -650,6 +1227,8 @@ CAResult_t CAConstructCoAP(CATCPSessionInfo_t *svritem, unsigned char **data,
     //if not enough data received - read them on next CAFillHeader() call
     if (0 == inLen)
     {
+        *data = inBuffer;
+        *dataLength = inLen;
         return CA_STATUS_OK;
     }
 
@@ -689,13 +1268,18 @@ CAResult_t CAConstructCoAP(CATCPSessionInfo_t *svritem, unsigned char **data,
         svritem->totalLen = CAGetTotalLengthFromHeader(svritem->data);
 
         // allocate required memory
-        unsigned char *buffer = OICRealloc(svritem->data, svritem->totalLen);
-        if (NULL == buffer)
+        if (svritem->totalLen > svritem->dataSize)
         {
-            OIC_LOG(ERROR, TAG, "OICRealloc - out of memory");
-            return CA_MEMORY_ALLOC_FAILED;
+            unsigned char *buffer = (unsigned char *)OICRealloc(svritem->data,
+                                                                svritem->totalLen);
+            if (NULL == buffer)
+            {
+                OIC_LOG(ERROR, TAG, "OICRealloc - out of memory");
+                return CA_MEMORY_ALLOC_FAILED;
+            }
+            svritem->data = buffer;
+            svritem->dataSize = svritem->totalLen;
         }
-        svritem->data = buffer;
     }
 
     // PAYLOAD
@@ -743,30 +1327,16 @@ static void CAReceiveMessage(CASocketFd_t fd)
         svritem->protocol = TLS;
 
 #ifdef __WITH_TLS__
-        size_t nbRead = 0;
-        size_t tlsLength = 0;
+        // read whatever is available, records are decrypted from the buffer in place
+        // and a partial record is kept at its start for the next read.
+        size_t nbRead = sizeof(svritem->tlsdata) - svritem->tlsLen;
 
-        if (TLS_HEADER_SIZE > svritem->tlsLen)
-        {
-            nbRead = TLS_HEADER_SIZE - svritem->tlsLen;
-        }
-        else
+        len = recv(fd, svritem->tlsdata + svritem->tlsLen, nbRead, 0);
+        if (len < 0 && (EWOULDBLOCK == errno || EAGAIN == errno))
         {
-            //[3][4] bytes in tls header are tls payload length
-            tlsLength = TLS_HEADER_SIZE +
-                            (size_t)((svritem->tlsdata[3] << 8) | svritem->tlsdata[4]);
-            OIC_LOG_V(DEBUG, TAG, "toal tls length = %u", tlsLength);
-            if (tlsLength > sizeof(svritem->tlsdata))
-            {
-                OIC_LOG_V(ERROR, TAG, "toal tls length is too big (buffer size : %u)",
-                                    sizeof(svritem->tlsdata));
-                return;
-            }
-            nbRead = tlsLength - svritem->tlsLen;
+            return;
         }
-
-        len = recv(fd, svritem->tlsdata + svritem->tlsLen, nbRead, 0);
-        if (len < 0)
+        else if (len < 0)
         {
             OIC_LOG_V(ERROR, TAG, "recv failed %s", strerror(errno));
             res = CA_RECEIVE_FAILED;
@@ -781,13 +1351,36 @@ static void CAReceiveMessage(CASocketFd_t fd)
             svritem->tlsLen += len;
             OIC_LOG_V(DEBUG, TAG, "nb_read : %u bytes , recv() : %d bytes, svritem->tlsLen : %u bytes",
                                 nbRead, len, svritem->tlsLen);
-            if (tlsLength > 0 && tlsLength == svritem->tlsLen)
+
+            size_t offset = 0;
+            while (CA_STATUS_OK == res && svritem->tlsLen - offset >= TLS_HEADER_SIZE)
             {
+                //[3][4] bytes in tls header are tls payload length
+                const unsigned char *record = svritem->tlsdata + offset;
+                size_t tlsLength = TLS_HEADER_SIZE + (size_t)((record[3] << 8) | record[4]);
+                if (tlsLength > sizeof(svritem->tlsdata))
+                {
+                    OIC_LOG_V(ERROR, TAG, "toal tls length is too big (buffer size : %u)",
+                                        sizeof(svritem->tlsdata));
+                    res = CA_RECEIVE_FAILED;
+                    break;
+                }
+                if (tlsLength > svritem->tlsLen - offset)
+                {
+                    break;
+                }
+
                 //when successfully read data - pass them to callback.
-                res = CAdecryptSsl(&svritem->sep, (uint8_t *)svritem->tlsdata, svritem->tlsLen);
-                svritem->tlsLen = 0;
+                res = CAdecryptSsl(&svritem->sep, (uint8_t *)record, tlsLength);
+                offset += tlsLength;
                 OIC_LOG_V(DEBUG, TAG, "%s: CAdecryptSsl returned %d", __func__, res);
             }
+
+            if (CA_STATUS_OK == res && offset > 0)
+            {
+                svritem->tlsLen -= offset;
+                memmove(svritem->tlsdata, svritem->tlsdata + offset, svritem->tlsLen);
+            }
         }
 #endif
 
@@ -798,7 +1391,11 @@ static void CAReceiveMessage(CASocketFd_t fd)
 
         // svritem->tlsdata can also be used as receiving buffer in case of raw tcp
         len = recv(fd, svritem->tlsdata, sizeof(svritem->tlsdata), 0);
-        if (len < 0)
+        if (len < 0 && (EWOULDBLOCK == errno || EAGAIN == errno))
+        {
+            return;
+        }
+        else if (len < 0)
         {
             OIC_LOG_V(ERROR, TAG, "recv failed %s", strerror(errno));
             res = CA_RECEIVE_FAILED;
@@ -865,9 +1462,16 @@ static void CAWakeUpForReadFdsUpdate()
 }
 #endif
 
-static CAResult_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem)
+/**
+ * Create a non-blocking socket for a client session and start connecting.
+ * A connect that does not complete at once is finished by the receive
+ * thread when the socket turns writable (see CACompleteConnect()).
+ *
+ * @return the socket, or OC_INVALID_SOCKET if the connect failed at once.
+ */
+static CASocketFd_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem)
 {
-    VERIFY_NON_NULL(svritem, TAG, "svritem is NULL");
+    VERIFY_NON_NULL_RET(svritem, TAG, "svritem is NULL", OC_INVALID_SOCKET);
 
     OIC_LOG_V(DEBUG, TAG, "try to connect with [%s:%u]",
               svritem->sep.endpoint.addr, svritem->sep.endpoint.port);
@@ -877,9 +1481,13 @@ static CAResult_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem)
     if (OC_INVALID_SOCKET == fd)
     {
         OIC_LOG_V(ERROR, TAG, "create socket failed: %s", strerror(errno));
-        return CA_SOCKET_OPERATION_FAILED;
+        return OC_INVALID_SOCKET;
     }
+    CASetNonBlocking(fd);
+    oc_mutex_lock(g_mutexObjectList);
     svritem->fd = fd;
+    CAIndexSessionFd(svritem);
+    oc_mutex_unlock(g_mutexObjectList);
 
     // #2. convert address from string to binary.
     struct sockaddr_storage sa = { .ss_family = family };
@@ -888,7 +1496,7 @@ static CAResult_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem)
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "convert name to sockaddr failed");
-        return CA_SOCKET_OPERATION_FAILED;
+        return OC_INVALID_SOCKET;
     }
 
     // #3. set socket length.
@@ -903,28 +1511,60 @@ static CAResult_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem)
     }
 
     // #4. connect to remote server device.
+    bool connected = true;
     if (connect(fd, (struct sockaddr *)&sa, socklen) < 0)
     {
-        OIC_LOG_V(ERROR, TAG, "failed to connect socket, %s", strerror(errno));
-        CALogSendStateInfo(svritem->sep.endpoint.adapter, svritem->sep.endpoint.addr,
-                           svritem->sep.endpoint.port, 0, false, strerror(errno));
-        return CA_SOCKET_OPERATION_FAILED;
+        if (EINPROGRESS != errno)
+        {
+            OIC_LOG_V(ERROR, TAG, "failed to connect socket, %s", strerror(errno));
+            CALogSendStateInfo(svritem->sep.endpoint.adapter, svritem->sep.endpoint.addr,
+                               svritem->sep.endpoint.port, 0, false, strerror(errno));
+            return OC_INVALID_SOCKET;
+        }
+        OIC_LOG(DEBUG, TAG, "connect socket in progress");
+        connected = false;
     }
 
-    OIC_LOG(DEBUG, TAG, "connect socket success");
-    svritem->state = CONNECTED;
-    CHECKFD(svritem->fd);
+    // #5. hand the socket to the receive thread.
+    oc_mutex_lock(g_mutexObjectList);
+    if (connected)
+    {
+        OIC_LOG(DEBUG, TAG, "connect socket success");
+        svritem->state = CONNECTED;
+    }
+    else
+    {
+        svritem->connectDeadline = OICGetCurrentTime(TIME_IN_MS) + CA_TCP_CONNECT_TIMEOUT * 1000;
+        svritem->connectNext = g_connectingList;
+        g_connectingList = svritem;
+        svritem->waitWritable = true;
+    }
+    CAEndpoint_t endpoint = svritem->sep.endpoint;
+    CHECKFD(fd);
+#if defined(USE_EPOLL)
+    if (-1 != caglobals.tcp.epollFd)
+    {
+        CAEpollAddFd(fd, connected ? EPOLLIN : EPOLLOUT);
+    }
+#endif
+    oc_mutex_unlock(g_mutexObjectList);
+
 #if !defined(WSA_WAIT_EVENT_0)
-    ssize_t len = CAWakeUpForReadFdsUpdate(svritem->sep.endpoint.addr);
-    if (-1 == len)
+    // select() needs the new fd; both waits need the connect deadline.
+    if (-1 == CAWakeUpForReadFdsUpdate(endpoint.addr))
     {
         OIC_LOG(ERROR, TAG, "wakeup receive thread failed");
-        return CA_SOCKET_OPERATION_FAILED;
     }
 #else
     CAWakeUpForReadFdsUpdate();
 #endif
-    return CA_STATUS_OK;
+
+    // pass the connection information to CA Common Layer.
+    if (connected && g_connectionCallback)
+    {
+        g_connectionCallback(&endpoint, true, true);
+    }
+    return fd;
 }
 
 static CASocketFd_t CACreateAcceptSocket(int family, CASocket_t *sock)
@@ -939,6 +1579,7 @@ static CASocketFd_t CACreateAcceptSocket(int family, CASocket_t *sock)
 
     socklen_t socklen = 0;
     struct sockaddr_storage server = { .ss_family = family };
+    int reuse = 1;
 
     CASocketFd_t fd = socket(family, SOCK_STREAM, IPPROTO_TCP);
     if (OC_INVALID_SOCKET == fd)
@@ -965,7 +1606,6 @@ static CASocketFd_t CACreateAcceptSocket(int family, CASocket_t *sock)
         socklen = sizeof (struct sockaddr_in);
     }
 
-    int reuse = 1;
     if (OC_SOCKET_ERROR == setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, OPTVAL_T(&reuse), sizeof(reuse)))
     {
         OIC_LOG(ERROR, TAG, "setsockopt SO_REUSEADDR");
@@ -1112,8 +1752,12 @@ CAResult_t CATCPStartServer(const ca_thread_pool_t threadPool)
     CHECKFD(caglobals.tcp.connectionFds[1]);
 #endif
 
+#if defined(USE_EPOLL)
+    CAInitializeEpoll();
+#endif
+
     caglobals.tcp.terminate = false;
-    res = ca_thread_pool_add_task(threadPool, CAReceiveHandler, NULL);
+    res = ca_thread_pool_add_dedicated_task(threadPool, CAReceiveHandler, NULL);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "thread_pool_add_task failed");
@@ -1175,6 +1819,13 @@ void CATCPStopServer()
     oc_mutex_unlock(g_mutexObjectList);
 
     CATCPDisconnectAll();
+#if defined(USE_EPOLL)
+    if (-1 != caglobals.tcp.epollFd)
+    {
+        close(caglobals.tcp.epollFd);
+        caglobals.tcp.epollFd = -1;
+    }
+#endif
     CATCPDestroyMutex();
     CATCPDestroyCond();
 
@@ -1227,6 +1878,180 @@ size_t CACheckPayloadLengthFromHeader(const void *data, size_t dlen)
     return payloadLen;
 }
 
+/**
+ * Close a failed session and hand the data still queued on it to the error
+ * callback.  Data queued on a TLS session is ciphertext, so it is dropped and
+ * a single error without payload is reported for the endpoint instead.
+ */
+static void CAFailTCPSession(CASocketFd_t fd, CAResult_t result)
+{
+#ifdef __WITH_TLS__
+    oc_mutex_lock(g_mutexObjectList);
+    CATCPSessionInfo_t *tlsSession = CAFindSessionByFd(fd);
+    CAEndpoint_t tlsEndpoint = { CA_DEFAULT_ADAPTER };
+    if (tlsSession)
+    {
+        tlsEndpoint = tlsSession->sep.endpoint;
+    }
+    oc_mutex_unlock(g_mutexObjectList);
+
+    if (tlsSession && CA_STATUS_OK != CAcloseSslConnection(&tlsEndpoint))
+    {
+        OIC_LOG(ERROR, TAG, "Failed to close TLS session");
+    }
+#endif
+
+    oc_mutex_lock(g_mutexObjectList);
+    CATCPSessionInfo_t *session = CAFindSessionByFd(fd);
+    if (!session)
+    {
+        oc_mutex_unlock(g_mutexObjectList);
+        return;
+    }
+    CAEndpoint_t endpoint = session->sep.endpoint;
+    CATCPPendingData_t *pending = session->sendHead;
+    session->sendHead = NULL;
+    session->sendTail = NULL;
+    session->sendQueued = 0;
+    session->sendOffset = 0;
+    CARemoveSession(session);
+    CADisconnectTCPSession(session);
+    oc_mutex_unlock(g_mutexObjectList);
+
+    bool secure = (endpoint.flags & CA_SECURE);
+    if (secure && pending && g_tcpErrorHandler)
+    {
+        g_tcpErrorHandler(&endpoint, NULL, 0, result);
+    }
+
+    while (pending)
+    {
+        CATCPPendingData_t *next = pending->next;
+        if (!secure && g_tcpErrorHandler)
+        {
+            g_tcpErrorHandler(&endpoint, pending->data, pending->len, result);
+        }
+        OICFree(pending);
+        pending = next;
+    }
+}
+
+/**
+ * Fail the sessions whose connect has not completed in time.
+ * @return ms until the next pending connect expires, or -1 if none is pending.
+ */
+static int CACheckConnectTimeouts()
+{
+    while (true)
+    {
+        CASocketFd_t expired = OC_INVALID_SOCKET;
+        uint64_t next = UINT64_MAX;
+        uint64_t now = OICGetCurrentTime(TIME_IN_MS);
+
+        oc_mutex_lock(g_mutexObjectList);
+        for (CATCPSessionInfo_t *session = g_connectingList; session;
+             session = session->connectNext)
+        {
+            if (session->connectDeadline <= now)
+            {
+                expired = session->fd;
+                break;
+            }
+            if (session->connectDeadline - now < next)
+            {
+                next = session->connectDeadline - now;
+            }
+        }
+        oc_mutex_unlock(g_mutexObjectList);
+
+        if (OC_INVALID_SOCKET == expired)
+        {
+            return (UINT64_MAX == next) ? -1 : (int)next;  // at most CA_TCP_CONNECT_TIMEOUT s
+        }
+
+        OIC_LOG(ERROR, TAG, "connect timed out");
+        CAFailTCPSession(expired, CA_SEND_FAILED);
+    }
+}
+
+/**
+ * Finish a non-blocking connect once the socket reports writable.
+ * @return false if the connect failed.
+ */
+static bool CACompleteConnect(CATCPSessionInfo_t *session)
+{
+    int error = 0;
+    socklen_t len = sizeof (error);
+    if (OC_SOCKET_ERROR == getsockopt(session->fd, SOL_SOCKET, SO_ERROR, OPTVAL_T(&error), &len))
+    {
+        error = errno;
+    }
+    if (0 != error)
+    {
+        OIC_LOG_V(ERROR, TAG, "failed to connect socket, %s", strerror(error));
+        CALogSendStateInfo(session->sep.endpoint.adapter, session->sep.endpoint.addr,
+                           session->sep.endpoint.port, 0, false, strerror(error));
+        return false;
+    }
+
+    OIC_LOG(DEBUG, TAG, "connect socket success");
+    CARemoveConnecting(session);
+    session->state = CONNECTED;
+    session->waitWritable = false;
+#if defined(USE_EPOLL)
+    if (-1 != caglobals.tcp.epollFd)
+    {
+        struct epoll_event event = { 0 };
+        event.events = EPOLLIN;
+        event.data.fd = session->fd;
+        if (-1 == epoll_ctl(caglobals.tcp.epollFd, EPOLL_CTL_MOD, session->fd, &event))
+        {
+            OIC_LOG_V(ERROR, TAG, "epoll_ctl(%d) failed: %s", session->fd, strerror(errno));
+        }
+    }
+#endif
+    return true;
+}
+
+/**
+ * Complete a pending connect, then continue writing the session's send queue,
+ * once its socket is writable.
+ * @return false if the session failed and was closed.
+ */
+static bool CASendPendingData(CASocketFd_t fd)
+{
+    oc_mutex_lock(g_mutexObjectList);
+    CATCPSessionInfo_t *session = CAFindSessionByFd(fd);
+    if (!session)
+    {
+        oc_mutex_unlock(g_mutexObjectList);
+        return true;
+    }
+
+    bool connected = false;
+    bool ok = true;
+    if (CONNECTING == session->state)
+    {
+        ok = connected = CACompleteConnect(session);
+    }
+    ok = ok && CAFlushPendingData(session);
+    CAEndpoint_t endpoint = session->sep.endpoint;
+    bool isClient = session->isClient;
+    oc_mutex_unlock(g_mutexObjectList);
+
+    // pass the connection information to CA Common Layer.
+    if (connected && g_connectionCallback)
+    {
+        g_connectionCallback(&endpoint, true, isClient);
+    }
+
+    if (!ok)
+    {
+        CAFailTCPSession(fd, CA_SEND_FAILED);
+    }
+    return ok;
+}
+
 static ssize_t sendData(const CAEndpoint_t *endpoint, const void *data,
                         size_t dlen, const char *fam)
 {
@@ -1245,25 +2070,37 @@ static ssize_t sendData(const CAEndpoint_t *endpoint, const void *data,
         }
     }
 
-    // #2. send data to remote device.
-    ssize_t remainLen = dlen;
-    do
+    // #2. send data to remote device; whatever the socket does not take now,
+    // or everything while the connect is pending, is queued behind earlier
+    // data and written by the receive thread.
+    oc_mutex_lock(g_mutexObjectList);
+    CATCPSessionInfo_t *session = CAFindSessionByFd(sockFd);
+    ssize_t len = -1;
+    if (session)
     {
-        ssize_t len = send(sockFd, data, remainLen, 0);
-        if (-1 == len)
+        bool writable = (CONNECTED == session->state && !session->sendHead);
+        len = writable ? CAWriteSocket(sockFd, data, dlen) : 0;
+        if (0 <= len && (size_t)len < dlen)
         {
-            if (EWOULDBLOCK != errno)
+            if (CAQueuePendingData(session, (const char *)data + len, dlen - len))
             {
-                OIC_LOG_V(ERROR, TAG, "unicast ipv4tcp sendTo failed: %s", strerror(errno));
-                CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
-                                   len, false, strerror(errno));
-                return len;
+                CAUpdateWriteInterest(session);
+            }
+            else
+            {
+                len = -1;
             }
-            continue;
         }
-        data = ((char*)data) + len;
-        remainLen -= len;
-    } while (remainLen > 0);
+    }
+    oc_mutex_unlock(g_mutexObjectList);
+
+    if (-1 == len)
+    {
+        OIC_LOG_V(ERROR, TAG, "unicast %stcp sendTo failed: %s", fam, strerror(errno));
+        CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                           len, false, strerror(errno));
+        return len;
+    }
 
 #ifndef TB_LOG
     (void)fam;
@@ -1374,23 +2211,23 @@ CASocketFd_t CAConnectTCPSession(const CAEndpoint_t *endpoint)
 
     // #2. add TCP connection info to list
     oc_mutex_lock(g_mutexObjectList);
-    LL_APPEND(g_sessionList, svritem);
+    CAAddSession(svritem);
     oc_mutex_unlock(g_mutexObjectList);
 
-    // #3. create the socket and connect to TCP server
+    // #3. create the socket and start connecting to TCP server;
+    // the receive thread may already own svritem once this returns.
     int family = (svritem->sep.endpoint.flags & CA_IPV6) ? AF_INET6 : AF_INET;
-    if (CA_STATUS_OK != CATCPCreateSocket(family, svritem))
+    CASocketFd_t fd = CATCPCreateSocket(family, svritem);
+    if (OC_INVALID_SOCKET == fd)
     {
+        oc_mutex_lock(g_mutexObjectList);
+        CARemoveSession(svritem);
+        CADisconnectTCPSession(svritem);
+        oc_mutex_unlock(g_mutexObjectList);
         return OC_INVALID_SOCKET;
     }
 
-    // #4. pass the connection information to CA Common Layer.
-    if (g_connectionCallback)
-    {
-        g_connectionCallback(&(svritem->sep.endpoint), true, svritem->isClient);
-    }
-
-    return svritem->fd;
+    return fd;
 }
 
 CAResult_t CADisconnectTCPSession(CATCPSessionInfo_t *removedData)
@@ -1402,6 +2239,12 @@ CAResult_t CADisconnectTCPSession(CATCPSessionInfo_t *removedData)
     // close the socket and remove session info in list.
     if (removedData->fd != OC_INVALID_SOCKET)
     {
+#if defined(USE_EPOLL)
+        if (-1 != caglobals.tcp.epollFd)
+        {
+            (void)epoll_ctl(caglobals.tcp.epollFd, EPOLL_CTL_DEL, removedData->fd, NULL);
+        }
+#endif
         shutdown(removedData->fd, SHUT_RDWR);
         OC_CLOSE_SOCKET(removedData->fd);
         removedData->fd = OC_INVALID_SOCKET;
@@ -1417,6 +2260,7 @@ CAResult_t CADisconnectTCPSession(CATCPSessionInfo_t *removedData)
     }
     OICFree(removedData->data);
     removedData->data = NULL;
+    CAClearPendingData(removedData);
 
     OICFree(removedData);
     removedData = NULL;
@@ -1430,11 +2274,11 @@ void CATCPDisconnectAll()
     oc_mutex_lock(g_mutexObjectList);
     CATCPSessionInfo_t *session = NULL;
     CATCPSessionInfo_t *tmp = NULL;
-    LL_FOREACH_SAFE(g_sessionList, session, tmp);
+    LL_FOREACH_SAFE(g_sessionList, session, tmp)
     {
         if (session)
         {
-            LL_DELETE(g_sessionList, session);
+            CARemoveSession(session);
             // disconnect session from remote device.
             CADisconnectTCPSession(session);
         }
@@ -1457,23 +2301,11 @@ CATCPSessionInfo_t *CAGetTCPSessionInfoFromEndpoint(const CAEndpoint_t *endpoint
 
     // get connection info from list
     oc_mutex_lock(g_mutexObjectList);
-    CATCPSessionInfo_t *session = NULL;
-    LL_FOREACH(g_sessionList, session)
-    {
-        if (!strncmp(session->sep.endpoint.addr, endpoint->addr,
-                     sizeof(session->sep.endpoint.addr))
-                && (session->sep.endpoint.port == endpoint->port)
-                && (session->sep.endpoint.flags & endpoint->flags))
-        {
-            oc_mutex_unlock(g_mutexObjectList);
-            OIC_LOG(DEBUG, TAG, "Found in session list");
-            return session;
-        }
-    }
-
+    CATCPSessionInfo_t *session = CAFindSessionByEndpoint(endpoint);
     oc_mutex_unlock(g_mutexObjectList);
-    OIC_LOG(DEBUG, TAG, "Session not found");
-    return NULL;
+
+    OIC_LOG(DEBUG, TAG, session ? "Found in session list" : "Session not found");
+    return session;
 }
 
 CASocketFd_t CAGetSocketFDFromEndpoint(const CAEndpoint_t *endpoint)
@@ -1484,41 +2316,33 @@ CASocketFd_t CAGetSocketFDFromEndpoint(const CAEndpoint_t *endpoint)
 
     // get connection info from list.
     oc_mutex_lock(g_mutexObjectList);
-    CATCPSessionInfo_t *session = NULL;
-    LL_FOREACH(g_sessionList, session)
-    {
-        if (!strncmp(session->sep.endpoint.addr, endpoint->addr,
-                     sizeof(session->sep.endpoint.addr))
-                && (session->sep.endpoint.port == endpoint->port)
-                && (session->sep.endpoint.flags & endpoint->flags))
-        {
-            oc_mutex_unlock(g_mutexObjectList);
-            OIC_LOG(DEBUG, TAG, "Found in session list");
-            return session->fd;
-        }
-    }
-
+    CATCPSessionInfo_t *session = CAFindSessionByEndpoint(endpoint);
+    CASocketFd_t fd = session ? session->fd : OC_INVALID_SOCKET;
     oc_mutex_unlock(g_mutexObjectList);
-    OIC_LOG(DEBUG, TAG, "Session not found");
-    return OC_INVALID_SOCKET;
+
+    OIC_LOG(DEBUG, TAG, session ? "Found in session list" : "Session not found");
+    return fd;
 }
 
-CATCPSessionInfo_t *CAGetSessionInfoFromFD(CASocketFd_t fd)
+bool CATCPIsSendQueueFull(const CAEndpoint_t *endpoint)
 {
+    VERIFY_NON_NULL_RET(endpoint, TAG, "endpoint is NULL", false);
+
     oc_mutex_lock(g_mutexObjectList);
+    CATCPSessionInfo_t *session = CAFindSessionByEndpoint(endpoint);
+    bool full = session && session->sendQueued >= caglobals.tcp.sendHighWaterMark;
+    oc_mutex_unlock(g_mutexObjectList);
 
-    CATCPSessionInfo_t *session = NULL;
-    LL_FOREACH(g_sessionList, session)
-    {
-        if (session && session->fd == fd)
-        {
-            oc_mutex_unlock(g_mutexObjectList);
-            return session;
-        }
-    }
+    return full;
+}
 
+CATCPSessionInfo_t *CAGetSessionInfoFromFD(CASocketFd_t fd)
+{
+    oc_mutex_lock(g_mutexObjectList);
+    CATCPSessionInfo_t *session = CAFindSessionByFd(fd);
     oc_mutex_unlock(g_mutexObjectList);
-    return NULL;
+
+    return session;
 }
 
 CAResult_t CASearchAndDeleteTCPSession(const CAEndpoint_t *endpoint)
@@ -1528,23 +2352,15 @@ CAResult_t CASearchAndDeleteTCPSession(const CAEndpoint_t *endpoint)
     OIC_LOG_V(DEBUG, TAG, "Looking for [%s:%d]", endpoint->addr, endpoint->port);
 
     // get connection info from list
-    CATCPSessionInfo_t *session = NULL;
-    CATCPSessionInfo_t *tmp = NULL;
-
     oc_mutex_lock(g_mutexObjectList);
-    LL_FOREACH_SAFE(g_sessionList, session, tmp)
+    CATCPSessionInfo_t *session = CAFindSessionByEndpoint(endpoint);
+    if (session)
     {
-        if (!strncmp(session->sep.endpoint.addr, endpoint->addr,
-                     sizeof(session->sep.endpoint.addr))
-                && (session->sep.endpoint.port == endpoint->port)
-                && (session->sep.endpoint.flags & endpoint->flags))
-        {
-            OIC_LOG(DEBUG, TAG, "Found in session list");
-            LL_DELETE(g_sessionList, session);
-            CADisconnectTCPSession(session);
-            oc_mutex_unlock(g_mutexObjectList);
-            return CA_STATUS_OK;
-        }
+        OIC_LOG(DEBUG, TAG, "Found in session list");
+        CARemoveSession(session);
+        CADisconnectTCPSession(session);
+        oc_mutex_unlock(g_mutexObjectList);
+        return CA_STATUS_OK;
     }
     oc_mutex_unlock(g_mutexObjectList);
 
@@ -1570,6 +2386,21 @@ size_t CAGetTotalLengthFromHeader(const unsigned char *recvBuffer)
     return headerLen + optPaylaodLen;
 }
 
+size_t CAGetMessageLengthFromBuffer(const unsigned char *recvBuffer, size_t size)
+{
+    if (NULL == recvBuffer || 0 == size)
+    {
+        return 0;
+    }
+
+    coap_transport_t transport = coap_get_tcp_header_type_from_initbyte(recvBuffer[0] >> 4);
+    if (size < coap_get_tcp_header_length_for_transport(transport))
+    {
+        return 0;
+    }
+    return coap_get_total_message_length(recvBuffer, size);
+}
+
 void CATCPSetErrorHandler(CATCPErrorHandleCallback errorHandleCallback)
 {
     g_tcpErrorHandler = errorHandleCallback;
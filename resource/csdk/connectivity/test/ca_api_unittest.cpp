@@ -28,6 +28,18 @@
 #include "cafragmentation.h"
 #include "caleinterface.h"
 
+#ifdef __linux__
+#include "caipinterface.h"
+#include "caipnwmonitor.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 #define CA_TRANSPORT_ADAPTER_SCOPE  1000
 #define CA_BLE_FIRST_SEGMENT_PAYLOAD_SIZE (((CA_DEFAULT_BLE_MTU_SIZE) - (CA_BLE_HEADER_SIZE)) \
                                            - (CA_BLE_LENGTH_HEADER_SIZE))
@@ -550,6 +562,285 @@ TEST(CAGetPortNumberTest, CAGetPortNumberToAssign)
 #endif
 }
 
+#ifdef __linux__
+static volatile int g_receivedRequests = 0;
+
+static void count_request_handler(const CAEndpoint_t * /*object*/,
+                                  const CARequestInfo_t * /*requestInfo*/)
+{
+    g_receivedRequests++;
+}
+
+TEST(CAReceiveShardsTest, RequestsFromManyPeers)
+{
+    EXPECT_EQ(CA_STATUS_INVALID_PARAM, CASetIPReceiveShards(0, false));
+    EXPECT_EQ(CA_STATUS_OK, CASetIPReceiveShards(4, false));
+
+    ASSERT_EQ(CA_STATUS_OK, CAInitialize(CA_ADAPTER_IP));
+    CARegisterHandler(count_request_handler, response_handler, error_handler);
+    EXPECT_EQ(CA_STATUS_OK, CASelectNetwork(CA_ADAPTER_IP));
+    EXPECT_EQ(CA_STATUS_OK, CAStartListeningServer());
+
+    uint16_t port = CAGetAssignedPortNumber(CA_ADAPTER_IP, CA_IPV4);
+    ASSERT_NE(static_cast<uint16_t>(0), port);
+
+    struct sockaddr_in sin;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // every peer has its own source port, so the kernel spreads them over the shards
+    const int peers = 16;
+    const int requestsPerPeer = 8;
+    g_receivedRequests = 0;
+    for (int peer = 0; peer < peers; peer++)
+    {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_NE(-1, fd);
+        for (int i = 0; i < requestsPerPeer; i++)
+        {
+            // NON GET with a two byte token, unique per request
+            uint16_t id = (uint16_t) (peer * requestsPerPeer + i + 1);
+            uint8_t pdu[] = { 0x52, 0x01, (uint8_t) (id >> 8), (uint8_t) id,
+                              (uint8_t) (id >> 8), (uint8_t) id };
+            EXPECT_EQ((ssize_t) sizeof(pdu), sendto(fd, pdu, sizeof(pdu), 0,
+                                                    (struct sockaddr *) &sin, sizeof(sin)));
+        }
+        close(fd);
+    }
+
+    for (int i = 0; i < 200 && g_receivedRequests < peers * requestsPerPeer; i++)
+    {
+        CAHandleRequestResponse();
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(peers * requestsPerPeer, g_receivedRequests);
+
+    CATerminate();
+    EXPECT_EQ(CA_STATUS_OK, CASetIPReceiveShards(1, false));
+}
+
+TEST(CAIPServerTest, WakeUpAfterRestartDoesNotTouchReusedFd)
+{
+    for (int i = 0; i < 5; i++)
+    {
+        ASSERT_EQ(CA_STATUS_OK, CAInitialize(CA_ADAPTER_IP));
+        EXPECT_EQ(CA_STATUS_OK, CASelectNetwork(CA_ADAPTER_IP));
+        EXPECT_EQ(CA_STATUS_OK, CAStartListeningServer());
+        CAWakeUpForChange();
+        CATerminate();
+    }
+
+    // the receive thread closes its eventfd when it leaves; a descriptor
+    // that later gets the same number must never see a wakeup
+    for (int i = 0; i < 50; i++)
+    {
+        int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        ASSERT_NE(-1, fd);
+        CAWakeUpForChange();
+        uint64_t value = 0;
+        EXPECT_EQ(-1, read(fd, &value, sizeof(value)));
+        close(fd);
+        usleep(10 * 1000);
+    }
+}
+
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+static volatile bool g_terminated = false;
+
+static void *terminate_thread(void * /*arg*/)
+{
+    CATerminate();
+    g_terminated = true;
+    return NULL;
+}
+
+TEST(CAIPInterfaceSnapshotTest, StopWaitsForReaders)
+{
+    // no network monitor, no snapshot and no reader left behind
+    EXPECT_TRUE(NULL == CAIPAcquireInterfaceSnapshot());
+
+    ASSERT_EQ(CA_STATUS_OK, CAInitialize(CA_ADAPTER_IP));
+    EXPECT_EQ(CA_STATUS_OK, CASelectNetwork(CA_ADAPTER_IP));
+    EXPECT_EQ(CA_STATUS_OK, CAStartListeningServer());
+
+    const u_arraylist_t *iflist = CAIPAcquireInterfaceSnapshot();
+    if (!iflist)
+    {
+        // no netlink socket in this environment
+        CATerminate();
+        return;
+    }
+
+    // readers share the snapshot, each release drops one of them
+    EXPECT_EQ(iflist, CAIPAcquireInterfaceSnapshot());
+    CAIPReleaseInterfaceSnapshot();
+
+    g_terminated = false;
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, terminate_thread, NULL));
+
+    // the last reader still holds the snapshot, stopping must not free it
+    usleep(200 * 1000);
+    EXPECT_FALSE(g_terminated);
+    for (uint32_t i = 0; i < u_arraylist_length(iflist); i++)
+    {
+        EXPECT_TRUE(NULL != u_arraylist_get(iflist, i));
+    }
+
+    CAIPReleaseInterfaceSnapshot();
+    pthread_join(thread, NULL);
+    EXPECT_TRUE(g_terminated);
+
+    // the reader count is back to zero, a restart and stop do not wait
+    ASSERT_EQ(CA_STATUS_OK, CAInitialize(CA_ADAPTER_IP));
+    EXPECT_EQ(CA_STATUS_OK, CASelectNetwork(CA_ADAPTER_IP));
+    EXPECT_EQ(CA_STATUS_OK, CAStartListeningServer());
+    iflist = CAIPAcquireInterfaceSnapshot();
+    EXPECT_TRUE(NULL != iflist);
+    CAIPReleaseInterfaceSnapshot();
+    CATerminate();
+}
+#endif // CA_IP_INTERFACE_SNAPSHOT
+
+#ifdef TCP_ADAPTER
+static char g_receivedUris[64];
+
+static void uri_request_handler(const CAEndpoint_t * /*object*/,
+                                const CARequestInfo_t *requestInfo)
+{
+    // every test request has a one letter uri path
+    size_t len = strlen(g_receivedUris);
+    const char *uri = requestInfo->info.resourceUri;
+    if (uri && *uri && len + 1 < sizeof(g_receivedUris))
+    {
+        g_receivedUris[len] = uri[strlen(uri) - 1];
+    }
+}
+
+class CATCPServerTest : public testing::Test
+{
+    protected:
+    int m_fd;
+
+    virtual void SetUp()
+    {
+        memset(g_receivedUris, 0, sizeof(g_receivedUris));
+        m_fd = -1;
+
+        ASSERT_EQ(CA_STATUS_OK, CAInitialize(CA_ADAPTER_TCP));
+        CARegisterHandler(uri_request_handler, response_handler, error_handler);
+        ASSERT_EQ(CA_STATUS_OK, CASelectNetwork(CA_ADAPTER_TCP));
+        ASSERT_EQ(CA_STATUS_OK, CAStartListeningServer());
+
+        uint16_t port = CAGetAssignedPortNumber(CA_ADAPTER_TCP, CA_IPV4);
+        ASSERT_NE(static_cast<uint16_t>(0), port);
+
+        struct sockaddr_in sin;
+        memset(&sin, 0, sizeof(sin));
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons(port);
+        sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        m_fd = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_NE(-1, m_fd);
+        int on = 1;
+        setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        ASSERT_EQ(0, connect(m_fd, (struct sockaddr *) &sin, sizeof(sin)));
+    }
+
+    virtual void TearDown()
+    {
+        if (-1 != m_fd)
+        {
+            close(m_fd);
+        }
+        CATerminate();
+    }
+
+    // sends the bytes in one write and gives the server time to read them on their own
+    void sendPart(const uint8_t *data, size_t len)
+    {
+        EXPECT_EQ((ssize_t) len, send(m_fd, data, len, 0));
+        usleep(20 * 1000);
+    }
+
+    void waitForUris(const char *expected)
+    {
+        for (int i = 0; i < 200 && strlen(g_receivedUris) < strlen(expected); i++)
+        {
+            CAHandleRequestResponse();
+            usleep(10 * 1000);
+        }
+        EXPECT_STREQ(expected, g_receivedUris);
+    }
+};
+
+// GET with a one byte token and a one letter Uri-Path, without a payload
+#define CA_TCP_TEST_FRAME(token, uri) { 0x21, 0x01, (token), 0xb1, (uri) }
+
+// GET whose 23 bytes of options and payload need an extended length byte
+#define CA_TCP_TEST_LONG_FRAME(token, uri) \
+    { 0xd1, 23 - 13, 0x01, (token), 0xb1, (uri), 0xff, \
+      'p', 'a', 'y', 'l', 'o', 'a', 'd', 'p', 'a', 'y', \
+      'l', 'o', 'a', 'd', 'p', 'a', 'y', 'l', 'o', 'a' }
+
+TEST_F(CATCPServerTest, FrameSplitAcrossReads)
+{
+    // byte by byte, the header itself arrives in pieces
+    const uint8_t shortFrame[] = CA_TCP_TEST_FRAME(1, 'a');
+    for (size_t i = 0; i < sizeof(shortFrame); i++)
+    {
+        sendPart(shortFrame + i, 1);
+    }
+
+    // split in the extended header, in the token, in the options and in the payload
+    const uint8_t longFrame[] = CA_TCP_TEST_LONG_FRAME(2, 'b');
+    const size_t splits[] = { 1, 2, 4, 5, 10 };
+    char expected[sizeof(splits) / sizeof(splits[0]) + 2] = "a";
+    for (size_t i = 0; i < sizeof(splits) / sizeof(splits[0]); i++)
+    {
+        uint8_t frame[sizeof(longFrame)];
+        memcpy(frame, longFrame, sizeof(frame));
+        frame[5] = (uint8_t) ('b' + i);
+        expected[i + 1] = (char) frame[5];
+
+        sendPart(frame, splits[i]);
+        sendPart(frame + splits[i], sizeof(frame) - splits[i]);
+    }
+
+    waitForUris(expected);
+}
+
+TEST_F(CATCPServerTest, MultipleFramesInOneRead)
+{
+    const uint8_t first[] = CA_TCP_TEST_FRAME(1, 'a');
+    const uint8_t second[] = CA_TCP_TEST_LONG_FRAME(2, 'b');
+    const uint8_t third[] = CA_TCP_TEST_FRAME(3, 'c');
+    const uint8_t fourth[] = CA_TCP_TEST_LONG_FRAME(4, 'd');
+
+    // three whole frames and the start of a fourth, then the rest of it
+    uint8_t stream[sizeof(first) + sizeof(second) + sizeof(third) + sizeof(fourth)];
+    size_t len = 0;
+    memcpy(stream + len, first, sizeof(first));
+    len += sizeof(first);
+    memcpy(stream + len, second, sizeof(second));
+    len += sizeof(second);
+    memcpy(stream + len, third, sizeof(third));
+    len += sizeof(third);
+    memcpy(stream + len, fourth, sizeof(fourth));
+    len += sizeof(fourth);
+
+    const size_t partial = len - sizeof(fourth) + 7;
+    sendPart(stream, partial);
+    sendPart(stream + partial, len - partial);
+
+    waitForUris("abcd");
+}
+#endif // TCP_ADAPTER
+#endif
+
 TEST(CAfragmentationTest, FragmentTest)
 {
 #if defined(LE_ADAPTER)
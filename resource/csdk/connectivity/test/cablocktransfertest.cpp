@@ -19,6 +19,9 @@
  ******************************************************************/
 
 #include "gtest/gtest.h"
+
+#include <unistd.h>
+
 #include "cainterface.h"
 #include "cautilinterface.h"
 #include "cacommon.h"
@@ -752,3 +755,297 @@ TEST_F(CABlockTransferTests, CAUpdatePayloadToCADataWithResponse)
 
     EXPECT_STREQ((const char*) payload, (const char*) cadata.responseInfo->info.payload);
 }
+
+TEST_F(CABlockTransferTests, CAGetBlockDataFromBlockDataListManyTest)
+{
+    CAEndpoint_t* tempRep = NULL;
+    CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
+
+    CAToken_t tempToken = NULL;
+    CAGenerateToken(&tempToken, CA_MAX_TOKEN_LEN);
+
+    CARequestInfo_t requestInfo;
+    memset(&requestInfo, 0, sizeof(CARequestInfo_t));
+    requestInfo.method = CA_GET;
+    requestInfo.info.type = CA_MSG_NONCONFIRM;
+    requestInfo.info.token = tempToken;
+    requestInfo.info.tokenLength = CA_MAX_TOKEN_LEN;
+
+    CAData_t cadata;
+    memset(&cadata, 0, sizeof(CAData_t));
+    cadata.type = SEND_TYPE_UNICAST;
+    cadata.remoteEndpoint = tempRep;
+    cadata.requestInfo = &requestInfo;
+    cadata.dataType = CA_REQUEST_DATA;
+
+    // more transfers than buckets, so that the chains are walked
+    const size_t count = CA_BLOCK_DATA_TABLE_SIZE * 2;
+    CABlockData_t *currData[CA_BLOCK_DATA_TABLE_SIZE * 2] = { NULL, };
+    for (size_t i = 0; i < count; i++)
+    {
+        tempRep->port = (uint16_t) (5683 + i);
+        currData[i] = CACreateNewBlockData(&cadata);
+        ASSERT_TRUE(currData[i] != NULL);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ(currData[i], CAGetBlockDataFromBlockDataList(currData[i]->blockDataId));
+    }
+
+    CABlockDataID_t *removedId = CACreateBlockDatablockId(tempToken, CA_MAX_TOKEN_LEN,
+                                                          "127.0.0.1", 5683);
+    ASSERT_TRUE(removedId != NULL);
+    EXPECT_EQ(CA_STATUS_OK, CARemoveBlockDataFromList(removedId));
+    EXPECT_TRUE(NULL == CAGetBlockDataFromBlockDataList(removedId));
+    EXPECT_EQ(currData[1], CAGetBlockDataFromBlockDataList(currData[1]->blockDataId));
+    CADestroyBlockID(removedId);
+
+    // the token of a sent request is found by the message id of the reply
+    coap_pdu_t *pdu = coap_pdu_init(CA_MSG_RESET, 0, requestInfo.info.messageId,
+                                    COAP_MAX_PDU_SIZE);
+    ASSERT_TRUE(pdu != NULL);
+    CAResponseInfo_t responseInfo;
+    memset(&responseInfo, 0, sizeof(CAResponseInfo_t));
+    EXPECT_EQ(CA_STATUS_OK, CAGetTokenFromBlockDataList(pdu, tempRep, &responseInfo));
+    ASSERT_EQ(CA_MAX_TOKEN_LEN, responseInfo.info.tokenLength);
+    EXPECT_EQ(0, memcmp(tempToken, responseInfo.info.token, CA_MAX_TOKEN_LEN));
+    free(responseInfo.info.token);
+    coap_delete_pdu(pdu);
+
+    for (size_t i = 1; i < count / 2; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK, CARemoveBlockDataFromList(currData[i]->blockDataId));
+    }
+
+    // the rest is removed with the table
+    EXPECT_EQ(CA_STATUS_OK, CARemoveAllBlockDataFromList());
+    for (size_t i = count / 2; i < count; i++)
+    {
+        CABlockDataID_t *id = CACreateBlockDatablockId(tempToken, CA_MAX_TOKEN_LEN,
+                                                       "127.0.0.1", (uint16_t) (5683 + i));
+        ASSERT_TRUE(id != NULL);
+        EXPECT_TRUE(NULL == CAGetBlockDataFromBlockDataList(id));
+        CADestroyBlockID(id);
+    }
+
+    CADestroyToken(tempToken);
+    CADestroyEndpoint(tempRep);
+}
+
+TEST_F(CABlockTransferTests, CAUpdatePayloadDataWithoutSizeOptionTest)
+{
+    CAEndpoint_t* tempRep = NULL;
+    CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
+
+    CAToken_t tempToken = NULL;
+    CAGenerateToken(&tempToken, CA_MAX_TOKEN_LEN);
+
+    uint8_t block[64];
+
+    CARequestInfo_t requestInfo;
+    memset(&requestInfo, 0, sizeof(CARequestInfo_t));
+    requestInfo.method = CA_PUT;
+    requestInfo.info.type = CA_MSG_CONFIRM;
+    requestInfo.info.token = tempToken;
+    requestInfo.info.tokenLength = CA_MAX_TOKEN_LEN;
+
+    CAData_t cadata;
+    memset(&cadata, 0, sizeof(CAData_t));
+    cadata.type = SEND_TYPE_UNICAST;
+    cadata.remoteEndpoint = tempRep;
+    cadata.requestInfo = &requestInfo;
+    cadata.dataType = CA_REQUEST_DATA;
+
+    CABlockData_t *currData = CACreateNewBlockData(&cadata);
+    ASSERT_TRUE(currData != NULL);
+
+    requestInfo.info.payload = (CAPayload_t) block;
+    requestInfo.info.payloadSize = sizeof(block);
+
+    const size_t blockCount = 100;
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        memset(block, (int) i, sizeof(block));
+        EXPECT_EQ(CA_STATUS_OK, CAUpdatePayloadData(currData, &cadata,
+                                                    CA_OPTION1_REQUEST_BLOCK, false,
+                                                    COAP_OPTION_BLOCK1));
+    }
+
+    // the buffer is grown geometrically rather than by one block at a time
+    size_t fullPayload = 0;
+    CAPayload_t payload = CAGetPayloadFromBlockDataList(currData->blockDataId, &fullPayload);
+    ASSERT_TRUE(payload != NULL);
+    EXPECT_EQ(blockCount * sizeof(block), fullPayload);
+    EXPECT_GE(currData->payloadCapacity, fullPayload);
+    EXPECT_LT(currData->payloadCapacity, 2 * fullPayload);
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        EXPECT_EQ((uint8_t) i, payload[i * sizeof(block) + sizeof(block) - 1]);
+    }
+
+    EXPECT_EQ(CA_STATUS_OK, CARemoveBlockDataFromList(currData->blockDataId));
+
+    CADestroyToken(tempToken);
+    CADestroyEndpoint(tempRep);
+}
+
+static size_t g_producedMaxLength = 0;
+static bool g_streamReleased = false;
+
+static bool producePayload(void *context, size_t offset, uint8_t *buf, size_t length)
+{
+    size_t total = *(size_t *) context;
+    if (offset + length > total)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        buf[i] = (uint8_t) (offset + i);
+    }
+    if (length > g_producedMaxLength)
+    {
+        g_producedMaxLength = length;
+    }
+    return true;
+}
+
+static void releasePayload(void *context)
+{
+    (void) context;
+    g_streamReleased = true;
+}
+
+TEST_F(CABlockTransferTests, CAAddBlockOption2WithPayloadStream)
+{
+    CAEndpoint_t* tempRep = NULL;
+    CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
+
+    CAToken_t tempToken = NULL;
+    CAGenerateToken(&tempToken, CA_MAX_TOKEN_LEN);
+
+    size_t payloadSize = LARGE_PAYLOAD_LENGTH * 3;
+    g_producedMaxLength = 0;
+    g_streamReleased = false;
+
+    CAPayloadStream_t *stream = NULL;
+    EXPECT_EQ(CA_STATUS_OK, CACreatePayloadStream(producePayload, releasePayload,
+                                                  &payloadSize, &stream));
+    ASSERT_TRUE(stream != NULL);
+
+    CAResponseInfo_t responseInfo;
+    memset(&responseInfo, 0, sizeof(CAResponseInfo_t));
+    responseInfo.result = CA_CONTENT;
+    responseInfo.info.type = CA_MSG_NONCONFIRM;
+    responseInfo.info.token = tempToken;
+    responseInfo.info.tokenLength = CA_MAX_TOKEN_LEN;
+    responseInfo.info.payloadStream = stream;
+    responseInfo.info.payloadSize = payloadSize;
+
+    CAData_t cadata;
+    memset(&cadata, 0, sizeof(CAData_t));
+    cadata.type = SEND_TYPE_UNICAST;
+    cadata.remoteEndpoint = tempRep;
+    cadata.responseInfo = &responseInfo;
+    cadata.dataType = CA_RESPONSE_DATA;
+
+    CABlockData_t *currData = CACreateNewBlockData(&cadata);
+    ASSERT_TRUE(currData != NULL);
+    EXPECT_EQ(CA_STATUS_OK, CAUpdateBlockOptionType(currData->blockDataId,
+                                                    COAP_OPTION_BLOCK2));
+
+    coap_list_t *options = NULL;
+    coap_transport_t transport = COAP_UDP;
+    coap_pdu_t *pdu = CAGeneratePDU(CA_CONTENT, &responseInfo.info, tempRep, &options,
+                                    &transport);
+    ASSERT_TRUE(pdu != NULL);
+    EXPECT_EQ(CA_STATUS_OK, CAAddBlockOption(&pdu, &responseInfo.info, tempRep, &options));
+
+    // only the first block is produced
+    size_t dataLength = 0;
+    uint8_t *data = NULL;
+    EXPECT_EQ(1, coap_get_data(pdu, &dataLength, &data));
+    EXPECT_EQ(static_cast<size_t>(LARGE_PAYLOAD_LENGTH), dataLength);
+    EXPECT_EQ(static_cast<size_t>(LARGE_PAYLOAD_LENGTH), g_producedMaxLength);
+    for (size_t i = 0; i < dataLength; i++)
+    {
+        EXPECT_EQ((uint8_t) i, data[i]);
+    }
+
+    coap_delete_list(options);
+    coap_delete_pdu(pdu);
+
+    // the block data keeps its own reference
+    CADestroyPayloadStream(stream);
+    EXPECT_FALSE(g_streamReleased);
+    EXPECT_EQ(CA_STATUS_OK, CARemoveBlockDataFromList(currData->blockDataId));
+    EXPECT_TRUE(g_streamReleased);
+
+    CADestroyToken(tempToken);
+    CADestroyEndpoint(tempRep);
+}
+
+TEST_F(CABlockTransferTests, CASendResponseWithPayloadStream)
+{
+    EXPECT_EQ(CA_STATUS_OK, CASelectNetwork(CA_ADAPTER_IP));
+
+    CAEndpoint_t* tempRep = NULL;
+    CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "192.0.2.1", 5683, &tempRep);
+
+    CAToken_t tempToken = NULL;
+    CAGenerateToken(&tempToken, CA_MAX_TOKEN_LEN);
+
+    size_t payloadSize = LARGE_PAYLOAD_LENGTH * 3;
+    g_producedMaxLength = 0;
+    g_streamReleased = false;
+
+    CAPayloadStream_t *stream = NULL;
+    EXPECT_EQ(CA_STATUS_OK, CACreatePayloadStream(producePayload, releasePayload,
+                                                  &payloadSize, &stream));
+    ASSERT_TRUE(stream != NULL);
+
+    CAResponseInfo_t responseInfo;
+    memset(&responseInfo, 0, sizeof(CAResponseInfo_t));
+    responseInfo.result = CA_CONTENT;
+    responseInfo.info.type = CA_MSG_NONCONFIRM;
+    responseInfo.info.messageId = 1;
+    responseInfo.info.dataType = CA_RESPONSE_DATA;
+    responseInfo.info.token = tempToken;
+    responseInfo.info.tokenLength = CA_MAX_TOKEN_LEN;
+    responseInfo.info.payloadStream = stream;
+    responseInfo.info.payloadSize = payloadSize;
+
+    // the stream is kept for the next blocks instead of being read at once
+    EXPECT_EQ(CA_STATUS_OK, CASendResponse(tempRep, &responseInfo));
+    CADestroyPayloadStream(stream);
+
+    CABlockDataID_t *blockDataID = CACreateBlockDatablockId(tempToken, CA_MAX_TOKEN_LEN,
+                                                            tempRep->addr, tempRep->port);
+    ASSERT_TRUE(blockDataID != NULL);
+    CABlockData_t *currData = CAGetBlockDataFromBlockDataList(blockDataID);
+    ASSERT_TRUE(currData != NULL);
+    ASSERT_TRUE(currData->sentData->responseInfo != NULL);
+    EXPECT_TRUE(currData->sentData->responseInfo->info.payloadStream != NULL);
+    EXPECT_TRUE(currData->sentData->responseInfo->info.payload == NULL);
+    EXPECT_EQ(COAP_OPTION_BLOCK2, currData->type);
+
+    // the send thread produces only the first block
+    for (int i = 0; i < 200 && 0 == g_producedMaxLength; i++)
+    {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(static_cast<size_t>(LARGE_PAYLOAD_LENGTH), g_producedMaxLength);
+
+    // the stream is released once the sent block is done with it
+    EXPECT_EQ(CA_STATUS_OK, CARemoveBlockDataFromList(blockDataID));
+    for (int i = 0; i < 200 && !g_streamReleased; i++)
+    {
+        usleep(10 * 1000);
+    }
+    EXPECT_TRUE(g_streamReleased);
+
+    CADestroyBlockID(blockDataID);
+    CADestroyToken(tempToken);
+    CADestroyEndpoint(tempRep);
+}
@@ -0,0 +1,216 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+#include "cadedup.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+
+class CADedupF : public testing::Test {
+public:
+    CADedupF() :
+      testing::Test()
+  {
+      memset(&context, 0, sizeof(context));
+      memset(&endpoint, 0, sizeof(endpoint));
+      memset(&info, 0, sizeof(info));
+  }
+
+protected:
+    virtual void SetUp()
+    {
+        ASSERT_EQ(CA_STATUS_OK, CADedupInitialize(&context));
+
+        endpoint.adapter = CA_ADAPTER_IP;
+        OICStrcpy(endpoint.addr, sizeof(endpoint.addr), "192.168.0.1");
+        endpoint.port = 5683;
+
+        info.type = CA_MSG_CONFIRM;
+        info.messageId = 1234;
+        info.token = token;
+        info.tokenLength = sizeof(token);
+    }
+
+    virtual void TearDown()
+    {
+        CADedupTerminate(&context);
+    }
+
+    bool check(void **response, uint32_t *responseLength)
+    {
+        return CADedupCheckRequest(&context, &endpoint, &info, response, responseLength);
+    }
+
+    CADedup_t context;
+    CAEndpoint_t endpoint;
+    CAInfo_t info;
+    char token[4] = { 1, 2, 3, 4 };
+};
+
+TEST_F(CADedupF, FirstRequestPasses)
+{
+    void *response = NULL;
+    uint32_t responseLength = 0;
+
+    EXPECT_FALSE(check(&response, &responseLength));
+    EXPECT_TRUE(response == NULL);
+}
+
+TEST_F(CADedupF, DuplicateWithoutResponse)
+{
+    void *response = NULL;
+    uint32_t responseLength = 0;
+
+    info.type = CA_MSG_NONCONFIRM;
+    EXPECT_FALSE(check(&response, &responseLength));
+    EXPECT_TRUE(check(&response, &responseLength));
+    EXPECT_TRUE(response == NULL);
+    EXPECT_EQ(static_cast<uint32_t>(0), responseLength);
+}
+
+TEST_F(CADedupF, ConfirmableDuplicateGetsEmptyAck)
+{
+    void *response = NULL;
+    uint32_t responseLength = 0;
+
+    EXPECT_FALSE(check(&response, &responseLength));
+    EXPECT_TRUE(check(&response, &responseLength));
+    ASSERT_TRUE(response != NULL);
+    ASSERT_EQ(static_cast<uint32_t>(4), responseLength);
+
+    const uint8_t *ack = (const uint8_t *) response;
+    EXPECT_EQ(0x60, ack[0]);
+    EXPECT_EQ(0x00, ack[1]);
+    EXPECT_EQ(0, memcmp(&ack[2], &info.messageId, sizeof(info.messageId)));
+    OICFree(response);
+}
+
+TEST_F(CADedupF, DuplicateGetsSavedResponse)
+{
+    const uint8_t ack[] = { 0x60, 0x45, 0x04, 0xD2 };
+    void *response = NULL;
+    uint32_t responseLength = 0;
+
+    EXPECT_FALSE(check(&response, &responseLength));
+    CADedupSaveResponse(&context, &endpoint, info.messageId, ack, sizeof(ack));
+
+    EXPECT_TRUE(check(&response, &responseLength));
+    ASSERT_TRUE(response != NULL);
+    ASSERT_EQ(static_cast<uint32_t>(sizeof(ack)), responseLength);
+    EXPECT_EQ(0, memcmp(ack, response, sizeof(ack)));
+    OICFree(response);
+}
+
+TEST_F(CADedupF, OtherEndpointPasses)
+{
+    void *response = NULL;
+    uint32_t responseLength = 0;
+
+    EXPECT_FALSE(check(&response, &responseLength));
+
+    endpoint.port = 5684;
+    EXPECT_FALSE(check(&response, &responseLength));
+
+    OICStrcpy(endpoint.addr, sizeof(endpoint.addr), "192.168.0.2");
+    EXPECT_FALSE(check(&response, &responseLength));
+}
+
+TEST_F(CADedupF, ReusedMessageIdPasses)
+{
+    const uint8_t ack[] = { 0x60, 0x45, 0x04, 0xD2 };
+    void *response = NULL;
+    uint32_t responseLength = 0;
+
+    EXPECT_FALSE(check(&response, &responseLength));
+    CADedupSaveResponse(&context, &endpoint, info.messageId, ack, sizeof(ack));
+
+    token[0] = 9;
+    EXPECT_FALSE(check(&response, &responseLength));
+
+    // the response of the former request is not repeated
+    EXPECT_TRUE(check(&response, &responseLength));
+    ASSERT_TRUE(response != NULL);
+    EXPECT_EQ(0x00, ((const uint8_t *) response)[1]);
+    OICFree(response);
+}
+
+TEST_F(CADedupF, ResponseForUnknownRequest)
+{
+    const uint8_t ack[] = { 0x60, 0x00, 0x04, 0xD2 };
+    void *response = NULL;
+    uint32_t responseLength = 0;
+
+    CADedupSaveResponse(&context, &endpoint, info.messageId, ack, sizeof(ack));
+    EXPECT_FALSE(check(&response, &responseLength));
+    EXPECT_TRUE(response == NULL);
+}
+
+TEST_F(CADedupF, OldestIsForgotten)
+{
+    void *response = NULL;
+    uint32_t responseLength = 0;
+
+    for (uint32_t i = 0; i < CA_DEDUP_MAX_ENTRIES; i++)
+    {
+        info.messageId = (uint16_t) i;
+        EXPECT_FALSE(check(&response, &responseLength));
+    }
+    EXPECT_EQ(static_cast<uint32_t>(CA_DEDUP_MAX_ENTRIES), context.count);
+
+    info.messageId = CA_DEDUP_MAX_ENTRIES;
+    EXPECT_FALSE(check(&response, &responseLength));
+    EXPECT_EQ(static_cast<uint32_t>(CA_DEDUP_MAX_ENTRIES), context.count);
+
+    info.messageId = 1;
+    EXPECT_TRUE(check(&response, &responseLength));
+    OICFree(response);
+    info.messageId = 0;
+    EXPECT_FALSE(check(&response, &responseLength));
+}
+
+TEST_F(CADedupF, ReusedMessageIdIsForgottenLast)
+{
+    void *response = NULL;
+    uint32_t responseLength = 0;
+
+    info.type = CA_MSG_NONCONFIRM;
+    for (uint32_t i = 0; i < CA_DEDUP_MAX_ENTRIES; i++)
+    {
+        info.messageId = (uint16_t) i;
+        EXPECT_FALSE(check(&response, &responseLength));
+    }
+
+    // a new request with message id 0 makes its entry the most recent one
+    token[0] = 9;
+    info.messageId = 0;
+    EXPECT_FALSE(check(&response, &responseLength));
+
+    info.messageId = CA_DEDUP_MAX_ENTRIES;
+    EXPECT_FALSE(check(&response, &responseLength));
+    EXPECT_EQ(static_cast<uint32_t>(CA_DEDUP_MAX_ENTRIES), context.count);
+
+    info.messageId = 0;
+    EXPECT_TRUE(check(&response, &responseLength));
+    info.messageId = 1;
+    EXPECT_FALSE(check(&response, &responseLength));
+}
@@ -23,6 +23,7 @@
 #include "gtest/gtest.h"
 
 #include "caprotocolmessage.h"
+#include "oic_malloc.h"
 
 namespace {
 
@@ -248,3 +249,346 @@ TEST(CAProtocolMessage, CAGetInfoFromPDU)
     coap_delete_list(options);
     coap_delete_pdu(pdu);
 }
+
+namespace {
+
+/**
+ * Helper to generate a message with an option list, as blockwise transfer does.
+ */
+coap_pdu_t *generateWithOptionList(code_t code, const CAInfo_t *info,
+                                   const CAEndpoint_t *endpoint, coap_transport_t *transport)
+{
+    coap_list_t *optlist = NULL;
+    if (info->resourceUri)
+    {
+        EXPECT_EQ(CA_STATUS_OK, CAParseURI(info->resourceUri, &optlist));
+    }
+    EXPECT_EQ(CA_STATUS_OK, CAParseHeadOption(code, info, &optlist));
+
+    coap_pdu_t *pdu = CAGeneratePDUImpl(code, info, endpoint, optlist, transport);
+    coap_delete_list(optlist);
+    return pdu;
+}
+
+void verifyEncodedPDU(code_t code, const CAInfo_t *info, const CAEndpoint_t *endpoint)
+{
+    coap_transport_t expectedTransport = COAP_UDP;
+    coap_pdu_t *expected = generateWithOptionList(code, info, endpoint, &expectedTransport);
+    ASSERT_TRUE(expected != NULL);
+
+    size_t length = 0;
+    coap_transport_t transport = COAP_UDP;
+    EXPECT_EQ(CA_STATUS_OK, CAEncodePDU(code, info, endpoint, NULL, 0, &length, &transport));
+    EXPECT_EQ(expected->length, length);
+    EXPECT_EQ(expectedTransport, transport);
+
+    uint8_t buffer[COAP_MAX_PDU_SIZE];
+    EXPECT_EQ(CA_STATUS_FAILED, CAEncodePDU(code, info, endpoint, buffer, length - 1,
+                                            &length, &transport));
+    EXPECT_EQ(CA_STATUS_OK, CAEncodePDU(code, info, endpoint, buffer, sizeof(buffer),
+                                        &length, &transport));
+    ASSERT_EQ(expected->length, length);
+    EXPECT_EQ(0, memcmp(expected->transport_hdr, buffer, length));
+
+    coap_delete_pdu(expected);
+}
+
+} // namespace
+
+TEST(CAProtocolMessage, CAEncodePDUMatchesOptionList)
+{
+    CAEndpoint_t tempRep;
+    memset(&tempRep, 0, sizeof(CAEndpoint_t));
+    tempRep.flags = CA_DEFAULT_FLAGS;
+    tempRep.adapter = CA_ADAPTER_GATT_BTLE;
+
+    CAHeaderOption_t options[2];
+    memset(options, 0, sizeof(options));
+    options[0].optionID = COAP_OPTION_OBSERVE;
+    options[0].optionLength = 4;
+    options[0].optionData[3] = 1;
+    options[1].optionID = 2049;
+    options[1].optionLength = 300;
+
+    CAInfo_t inData;
+    memset(&inData, 0, sizeof(CAInfo_t));
+    inData.type = CA_MSG_CONFIRM;
+    inData.messageId = 1234;
+    inData.token = (CAToken_t)"token";
+    inData.tokenLength = strlen(inData.token);
+    inData.resourceUri = (CAURI_t)"/oic/res?rt=core.light&if=oic.if.baseline";
+    inData.options = options;
+    inData.numOptions = 2;
+    inData.payload = (CAPayload_t) "requestPayload";
+    inData.payloadSize = strlen((const char *) inData.payload);
+    inData.payloadFormat = CA_FORMAT_APPLICATION_VND_OCF_CBOR;
+    inData.payloadVersion = 2048;
+
+    verifyEncodedPDU(CA_GET, &inData, &tempRep);
+
+    inData.type = CA_MSG_ACKNOWLEDGE;
+    verifyEncodedPDU(CA_CONTENT, &inData, &tempRep);
+
+#ifdef WITH_TCP
+    tempRep.adapter = CA_ADAPTER_TCP;
+    verifyEncodedPDU(CA_GET, &inData, &tempRep);
+
+    inData.payloadSize = 0;
+    inData.numOptions = 0;
+    inData.resourceUri = NULL;
+    verifyEncodedPDU(CA_GET, &inData, &tempRep);
+#endif
+}
+
+TEST(CAProtocolMessage, CAEncodePDUEmptyMessage)
+{
+    CAEndpoint_t tempRep;
+    memset(&tempRep, 0, sizeof(CAEndpoint_t));
+    tempRep.flags = CA_DEFAULT_FLAGS;
+    tempRep.adapter = CA_ADAPTER_IP;
+
+    CAInfo_t inData;
+    memset(&inData, 0, sizeof(CAInfo_t));
+    inData.type = CA_MSG_RESET;
+    inData.messageId = 1234;
+
+    uint8_t buffer[4];
+    size_t length = 0;
+    coap_transport_t transport = COAP_UDP;
+    EXPECT_EQ(CA_STATUS_OK, CAEncodePDU(CA_EMPTY, &inData, &tempRep, buffer, sizeof(buffer),
+                                        &length, &transport));
+    EXPECT_EQ(static_cast<size_t>(4), length);
+    EXPECT_EQ(0x70, buffer[0]);
+    EXPECT_EQ(0, buffer[1]);
+
+    inData.token = (CAToken_t)"token";
+    inData.tokenLength = strlen(inData.token);
+    EXPECT_EQ(CA_STATUS_INVALID_PARAM, CAEncodePDU(CA_EMPTY, &inData, &tempRep, buffer,
+                                                   sizeof(buffer), &length, &transport));
+}
+
+TEST(CAProtocolMessage, CAOptionIterator)
+{
+    CAEndpoint_t tempRep;
+    memset(&tempRep, 0, sizeof(CAEndpoint_t));
+    tempRep.flags = CA_DEFAULT_FLAGS;
+    tempRep.adapter = CA_ADAPTER_IP;
+
+    CAInfo_t inData;
+    memset(&inData, 0, sizeof(CAInfo_t));
+    inData.type = CA_MSG_NONCONFIRM;
+    inData.messageId = 1234;
+    inData.token = (CAToken_t)"token";
+    inData.tokenLength = strlen(inData.token);
+    inData.resourceUri = (CAURI_t)"/oic/res?rt=core.light";
+    inData.payload = (CAPayload_t) "requestPayload";
+    inData.payloadSize = strlen((const char *) inData.payload);
+    inData.payloadFormat = CA_FORMAT_APPLICATION_CBOR;
+
+    uint8_t buffer[COAP_MAX_PDU_SIZE];
+    size_t length = 0;
+    coap_transport_t transport = COAP_UDP;
+    ASSERT_EQ(CA_STATUS_OK, CAEncodePDU(CA_GET, &inData, &tempRep, buffer, sizeof(buffer),
+                                        &length, &transport));
+
+    CoAPOptionCase cases[] = {
+        {COAP_OPTION_URI_PATH, 3, "oic"},
+        {COAP_OPTION_URI_PATH, 3, "res"},
+        {COAP_OPTION_CONTENT_FORMAT, 1, "<"},
+        {COAP_OPTION_URI_QUERY, 13, "rt=core.light"},
+    };
+    size_t numCases = sizeof(cases) / sizeof(cases[0]);
+
+    CAOptionIterator_t iter;
+    ASSERT_EQ(CA_STATUS_OK, CAOptionIteratorInit(&iter, buffer, length, &tempRep));
+
+    size_t index = 0;
+    uint16_t number = 0;
+    const uint8_t *value = NULL;
+    uint16_t valueLength = 0;
+    while (CAOptionIteratorNext(&iter, &number, &value, &valueLength))
+    {
+        ASSERT_LT(index, numCases);
+        EXPECT_EQ(cases[index].key, number);
+        EXPECT_EQ(cases[index].length, valueLength);
+        EXPECT_EQ(cases[index].dataStr, std::string((const char *) value, valueLength));
+        index++;
+    }
+    EXPECT_EQ(numCases, index);
+
+    // the iterator stops at the payload marker
+    ASSERT_LT(iter.next, iter.end);
+    EXPECT_EQ(COAP_PAYLOAD_START, *iter.next);
+
+    // a truncated option is not returned
+    ASSERT_EQ(CA_STATUS_OK, CAOptionIteratorInit(&iter, buffer, 4 + 5 + 2,
+                                                 &tempRep));
+    EXPECT_FALSE(CAOptionIteratorNext(&iter, &number, &value, &valueLength));
+}
+
+TEST(CAProtocolMessage, CAGetInfoFromPDUReadsOptionsInPlace)
+{
+    CAEndpoint_t tempRep;
+    memset(&tempRep, 0, sizeof(CAEndpoint_t));
+    tempRep.flags = CA_DEFAULT_FLAGS;
+    tempRep.adapter = CA_ADAPTER_IP;
+    tempRep.port = 5683;
+
+    CAHeaderOption_t options[2];
+    memset(options, 0, sizeof(options));
+    options[0].optionID = 2048;
+    options[0].optionLength = 3;
+    memcpy(options[0].optionData, "abc", 3);
+    options[1].optionID = COAP_OPTION_OBSERVE;
+    options[1].optionLength = 0;
+
+    CAInfo_t inData;
+    memset(&inData, 0, sizeof(CAInfo_t));
+    inData.type = CA_MSG_CONFIRM;
+    inData.messageId = 1234;
+    inData.token = (CAToken_t)"token";
+    inData.tokenLength = strlen(inData.token);
+    inData.resourceUri = (CAURI_t)"/oic/res?rt=core.light;if=oic.if.ll";
+    inData.options = options;
+    inData.numOptions = sizeof(options) / sizeof(options[0]);
+    inData.payload = (CAPayload_t) "requestPayload";
+    inData.payloadSize = strlen((const char *) inData.payload);
+    inData.payloadFormat = CA_FORMAT_APPLICATION_VND_OCF_CBOR;
+    inData.acceptFormat = CA_FORMAT_APPLICATION_CBOR;
+    inData.payloadVersion = 2048;
+
+    uint8_t buffer[COAP_MAX_PDU_SIZE];
+    size_t length = 0;
+    coap_transport_t transport = COAP_UDP;
+    ASSERT_EQ(CA_STATUS_OK, CAEncodePDU(CA_GET, &inData, &tempRep, buffer, sizeof(buffer),
+                                        &length, &transport));
+
+    uint32_t code = CA_NOT_FOUND;
+    coap_pdu_t *pdu = CAParsePDU((const char *) buffer, length, &code, &tempRep);
+    ASSERT_TRUE(pdu != NULL);
+
+    CAInfo_t outData;
+    ASSERT_EQ(CA_STATUS_OK, CAGetInfoFromPDU(pdu, &tempRep, &code, &outData));
+
+    EXPECT_EQ(static_cast<uint32_t>(CA_GET), code);
+    EXPECT_EQ(CA_MSG_CONFIRM, outData.type);
+    EXPECT_EQ(1234, outData.messageId);
+    ASSERT_TRUE(outData.resourceUri != NULL);
+    EXPECT_STREQ("/oic/res?rt=core.light;if=oic.if.ll", outData.resourceUri);
+    EXPECT_EQ(CA_FORMAT_APPLICATION_VND_OCF_CBOR, outData.payloadFormat);
+    EXPECT_EQ(CA_FORMAT_APPLICATION_CBOR, outData.acceptFormat);
+    EXPECT_EQ(2048, outData.payloadVersion);
+
+    // an empty observe option reads as a 0 byte of length 1
+    ASSERT_EQ(2u, outData.numOptions);
+    EXPECT_EQ(COAP_OPTION_OBSERVE, outData.options[0].optionID);
+    EXPECT_EQ(1, outData.options[0].optionLength);
+    EXPECT_EQ(0, outData.options[0].optionData[0]);
+    EXPECT_EQ(2048, outData.options[1].optionID);
+    EXPECT_EQ(3, outData.options[1].optionLength);
+    EXPECT_EQ(0, memcmp("abc", outData.options[1].optionData, 3));
+
+    ASSERT_EQ(inData.payloadSize, outData.payloadSize);
+    EXPECT_EQ(0, memcmp(inData.payload, outData.payload, outData.payloadSize));
+
+    OICFree(outData.options);
+    OICFree(outData.token);
+    OICFree(outData.payload);
+    OICFree(outData.resourceUri);
+    coap_delete_pdu(pdu);
+}
+
+#ifdef WITH_BWT
+namespace {
+
+/**
+ * Helper to verify a blockwise transfer message against one built with an option list.
+ */
+void verifyBlockPDU(code_t code, const CAInfo_t *info, const CAEndpoint_t *endpoint)
+{
+    coap_list_t *optlist = NULL;
+    coap_transport_t transport = COAP_UDP;
+    coap_pdu_t *pdu = CAGeneratePDU(code, info, endpoint, &optlist, &transport);
+    ASSERT_TRUE(pdu != NULL);
+
+    // options and payload are left to blockwise transfer
+    EXPECT_TRUE(optlist == NULL);
+    EXPECT_EQ(sizeof(coap_hdr_t) + info->tokenLength, pdu->length);
+
+    // block number 0 with the more bit, 1024 bytes
+    char block[] = { 0x0E };
+    coap_insert(&optlist, CACreateNewOptionNode(COAP_OPTION_BLOCK1, sizeof(block), block),
+                CAOrderOpts);
+    coap_pdu_t *blockPdu = CAGenerateBlockPDU(pdu, info, &optlist, info->payloadSize);
+    ASSERT_TRUE(blockPdu != NULL);
+    ASSERT_TRUE(blockPdu->data != NULL);
+    memcpy(blockPdu->data, info->payload, info->payloadSize);
+
+    coap_list_t *expectedList = NULL;
+    coap_insert(&expectedList, CACreateNewOptionNode(COAP_OPTION_BLOCK1, sizeof(block), block),
+                CAOrderOpts);
+    EXPECT_EQ(CA_STATUS_OK, CAParseURI(info->resourceUri, &expectedList));
+    EXPECT_EQ(CA_STATUS_OK, CAParseHeadOption(code, info, &expectedList));
+
+    coap_pdu_t *expected = coap_pdu_init(info->type, COAP_RESPONSE_CODE(code),
+                                         pdu->transport_hdr->udp.id, COAP_MAX_PDU_SIZE);
+    ASSERT_TRUE(expected != NULL);
+    coap_add_token(expected, info->tokenLength, (const unsigned char *) info->token);
+    for (coap_list_t *opt = expectedList; opt; opt = opt->next)
+    {
+        coap_add_option(expected, COAP_OPTION_KEY(*(coap_option *) opt->data),
+                        COAP_OPTION_LENGTH(*(coap_option *) opt->data),
+                        COAP_OPTION_DATA(*(coap_option *) opt->data));
+    }
+    coap_add_data(expected, info->payloadSize, (const unsigned char *) info->payload);
+
+    ASSERT_EQ(expected->length, blockPdu->length);
+    EXPECT_EQ(0, memcmp(expected->transport_hdr, blockPdu->transport_hdr, blockPdu->length));
+
+    coap_delete_pdu(expected);
+    coap_delete_list(expectedList);
+    coap_delete_pdu(blockPdu);
+    coap_delete_pdu(pdu);
+    coap_delete_list(optlist);
+}
+
+} // namespace
+
+TEST(CAProtocolMessage, CAGenerateBlockPDUMatchesOptionList)
+{
+    CAEndpoint_t tempRep;
+    memset(&tempRep, 0, sizeof(CAEndpoint_t));
+    tempRep.flags = CA_DEFAULT_FLAGS;
+    tempRep.adapter = CA_ADAPTER_IP;
+    tempRep.port = 5683;
+
+    CAHeaderOption_t options[40];
+    memset(options, 0, sizeof(options));
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++)
+    {
+        options[i].optionID = 2048 + i;
+        options[i].optionLength = 1;
+        options[i].optionData[0] = i;
+    }
+
+    CAInfo_t inData;
+    memset(&inData, 0, sizeof(CAInfo_t));
+    inData.type = CA_MSG_CONFIRM;
+    inData.messageId = 1234;
+    inData.token = (CAToken_t)"token";
+    inData.tokenLength = strlen(inData.token);
+    inData.resourceUri = (CAURI_t)"/oic/res?rt=core.light";
+    inData.options = options;
+    inData.numOptions = 2;
+    inData.payload = (CAPayload_t) "requestPayload";
+    inData.payloadSize = strlen((const char *) inData.payload);
+    inData.payloadFormat = CA_FORMAT_APPLICATION_VND_OCF_CBOR;
+    inData.payloadVersion = 2048;
+
+    verifyBlockPDU(CA_PUT, &inData, &tempRep);
+
+    // more options than are encoded in one pass
+    inData.numOptions = sizeof(options) / sizeof(options[0]);
+    verifyBlockPDU(CA_PUT, &inData, &tempRep);
+}
+#endif
@@ -0,0 +1,275 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "caretransmission.h"
+#include "cathreadpool.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+
+static int g_sentCount = 0;
+static uint16_t g_lastSentId = 0;
+
+static CAResult_t CARetransmissionTestSend(const CAEndpoint_t *endpoint, const void *pdu,
+                                           uint32_t size, CADataType_t dataType)
+{
+    (void) endpoint;
+    (void) size;
+    (void) dataType;
+    const uint8_t *data = (const uint8_t *) pdu;
+    g_lastSentId = (uint16_t) ((data[2] << 8) | data[3]);
+    g_sentCount++;
+    return CA_STATUS_OK;
+}
+
+class CARetransmissionF : public testing::Test {
+public:
+    CARetransmissionF() :
+      testing::Test(), threadPool(NULL)
+  , started(false)
+  {
+      memset(&context, 0, sizeof(context));
+      memset(&endpoint, 0, sizeof(endpoint));
+  }
+
+protected:
+    virtual void SetUp()
+    {
+        g_sentCount = 0;
+        g_lastSentId = 0;
+
+        ASSERT_EQ(CA_STATUS_OK, ca_thread_pool_init(1, &threadPool));
+
+        CARetransmissionConfig_t config;
+        memset(&config, 0, sizeof(config));
+        config.supportType = CA_ADAPTER_IP;
+        config.tryingCount = DEFAULT_RETRANSMISSION_COUNT;
+        config.nstart = 1;
+        ASSERT_EQ(CA_STATUS_OK, CARetransmissionInitialize(&context, threadPool,
+                                                           CARetransmissionTestSend,
+                                                           NULL, &config));
+
+        endpoint.adapter = CA_ADAPTER_IP;
+        OICStrcpy(endpoint.addr, sizeof(endpoint.addr), "192.168.0.1");
+        endpoint.port = 5683;
+    }
+
+    virtual void TearDown()
+    {
+        if (started)
+        {
+            CARetransmissionStop(&context);
+        }
+        CARetransmissionDestroy(&context);
+        ca_thread_pool_free(threadPool);
+    }
+
+    CAResult_t send(uint16_t messageId)
+    {
+        uint8_t con[] = { 0x40, 0x01, (uint8_t) (messageId >> 8), (uint8_t) messageId };
+        return CARetransmissionSendData(&context, &endpoint, CA_REQUEST_DATA,
+                                        con, sizeof(con));
+    }
+
+    CAResult_t receiveAck(uint16_t messageId, uint16_t *ackedId = NULL)
+    {
+        uint8_t ack[] = { 0x60, 0x00, (uint8_t) (messageId >> 8), (uint8_t) messageId };
+        void *retransmissionPdu = NULL;
+        CAResult_t res = CARetransmissionReceivedData(&context, &endpoint, ack, sizeof(ack),
+                                                      &retransmissionPdu);
+        if (NULL != ackedId && NULL != retransmissionPdu)
+        {
+            const uint8_t *data = (const uint8_t *) retransmissionPdu;
+            *ackedId = (uint16_t) ((data[2] << 8) | data[3]);
+        }
+        OICFree(retransmissionPdu);
+        return res;
+    }
+
+    CAResult_t start()
+    {
+        CAResult_t res = CARetransmissionStart(&context);
+        started = (CA_STATUS_OK == res);
+        return res;
+    }
+
+    ca_thread_pool_t threadPool;
+    CARetransmission_t context;
+    CAEndpoint_t endpoint;
+    bool started;
+};
+
+TEST_F(CARetransmissionF, NonConfirmableIsNotSent)
+{
+    uint8_t non[] = { 0x50, 0x01, 0x00, 0x01 };
+    EXPECT_EQ(CA_NOT_SUPPORTED, CARetransmissionSendData(&context, &endpoint, CA_REQUEST_DATA,
+                                                         non, sizeof(non)));
+    EXPECT_EQ(0, g_sentCount);
+}
+
+TEST_F(CARetransmissionF, NstartHoldsBackConfirmable)
+{
+    EXPECT_EQ(CA_STATUS_OK, send(1));
+    EXPECT_EQ(CA_STATUS_OK, send(2));
+    EXPECT_EQ(1, g_sentCount);
+    EXPECT_EQ(1, g_lastSentId);
+
+    // the acknowledgement of the first exchange lets the second one start
+    EXPECT_EQ(CA_STATUS_OK, receiveAck(1));
+    EXPECT_EQ(2, g_sentCount);
+    EXPECT_EQ(2, g_lastSentId);
+
+    EXPECT_EQ(CA_STATUS_OK, receiveAck(2));
+    EXPECT_EQ(2, g_sentCount);
+}
+
+TEST_F(CARetransmissionF, OtherEndpointIsNotHeldBack)
+{
+    EXPECT_EQ(CA_STATUS_OK, send(1));
+
+    endpoint.port = 5684;
+    EXPECT_EQ(CA_STATUS_OK, send(2));
+    EXPECT_EQ(2, g_sentCount);
+}
+
+TEST_F(CARetransmissionF, HeldBackDataIsLimited)
+{
+    for (uint16_t i = 0; i <= RETRANSMISSION_MAX_DEFERRED; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK, send(i));
+    }
+    EXPECT_EQ(CA_SEND_FAILED, send(RETRANSMISSION_MAX_DEFERRED + 1));
+    EXPECT_EQ(1, g_sentCount);
+}
+
+TEST_F(CARetransmissionF, TimeoutFollowsRoundTripTime)
+{
+    EXPECT_EQ(static_cast<uint64_t>(DEFAULT_ACK_TIMEOUT_SEC * 1000),
+              CARetransmissionGetTimeout(&context, &endpoint));
+
+    // acknowledgements received right away bring the timeout down to its lower bound
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK, send(i));
+        EXPECT_EQ(CA_STATUS_OK, receiveAck(i));
+    }
+    uint64_t timeout = CARetransmissionGetTimeout(&context, &endpoint);
+    EXPECT_LT(timeout, static_cast<uint64_t>(DEFAULT_ACK_TIMEOUT_SEC * 1000));
+    EXPECT_GE(timeout, static_cast<uint64_t>(RETRANSMISSION_MIN_RTO_MSEC));
+
+    endpoint.port = 5684;
+    EXPECT_EQ(static_cast<uint64_t>(DEFAULT_ACK_TIMEOUT_SEC * 1000),
+              CARetransmissionGetTimeout(&context, &endpoint));
+}
+
+TEST_F(CARetransmissionF, AcknowledgementRemovesItsData)
+{
+    // without NSTART everything is registered, enough to grow the id table
+    context.config.nstart = 0;
+    const uint16_t count = 300;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK, send(i));
+    }
+    EXPECT_EQ(count, g_sentCount);
+    EXPECT_EQ(count, context.dataCount);
+
+    // ids which share a bucket are told apart, in any order
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint16_t messageId = (uint16_t) ((i * 7) % count);
+        uint16_t ackedId = UINT16_MAX;
+        EXPECT_EQ(CA_STATUS_OK, receiveAck(messageId, &ackedId));
+        EXPECT_EQ(messageId, ackedId);
+        EXPECT_EQ((uint32_t) (count - i - 1), context.dataCount);
+    }
+}
+
+TEST_F(CARetransmissionF, UnknownAcknowledgementKeepsData)
+{
+    context.config.nstart = 0;
+    EXPECT_EQ(CA_STATUS_OK, send(1));
+    EXPECT_EQ(CA_STATUS_OK, send(2));
+
+    uint16_t ackedId = UINT16_MAX;
+    EXPECT_EQ(CA_STATUS_OK, receiveAck(3, &ackedId));
+    EXPECT_EQ(UINT16_MAX, ackedId);
+    EXPECT_EQ(2u, context.dataCount);
+
+    EXPECT_EQ(CA_STATUS_OK, receiveAck(1));
+    EXPECT_EQ(CA_STATUS_OK, receiveAck(1));
+    EXPECT_EQ(1u, context.dataCount);
+
+    // a removed id can be registered again
+    EXPECT_EQ(CA_STATUS_OK, send(1));
+    EXPECT_EQ(2u, context.dataCount);
+}
+
+TEST_F(CARetransmissionF, DuplicateIdIsSentWithoutRetransmission)
+{
+    context.config.nstart = 0;
+    EXPECT_EQ(CA_STATUS_OK, send(1));
+
+    // the duplicate is still sent once, but only the first one is retransmitted
+    EXPECT_EQ(CA_STATUS_OK, send(1));
+    EXPECT_EQ(2, g_sentCount);
+    EXPECT_EQ(1, g_lastSentId);
+    EXPECT_EQ(1u, context.dataCount);
+
+    EXPECT_EQ(CA_STATUS_OK, receiveAck(1));
+    EXPECT_EQ(0u, context.dataCount);
+}
+
+TEST_F(CARetransmissionF, EarliestDeadlineIsRetransmittedFirst)
+{
+    context.config.nstart = 0;
+
+    // train the first endpoint down to the shortest timeout
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK, send(i));
+        EXPECT_EQ(CA_STATUS_OK, receiveAck(i));
+    }
+    uint16_t fastPort = endpoint.port;
+
+    // the other endpoint was registered first, but it is due seconds later
+    endpoint.port = 5684;
+    EXPECT_EQ(CA_STATUS_OK, send(100));
+    endpoint.port = fastPort;
+    EXPECT_EQ(CA_STATUS_OK, send(200));
+    EXPECT_EQ(CA_STATUS_OK, send(201));
+
+    // removing the heap root leaves the next earliest data on top
+    EXPECT_EQ(CA_STATUS_OK, receiveAck(200));
+    EXPECT_EQ(2u, context.dataCount);
+
+    int sentCount = g_sentCount;
+    ASSERT_EQ(CA_STATUS_OK, start());
+    for (int i = 0; i < 150 && sentCount == g_sentCount; i++)
+    {
+        usleep(10 * 1000);
+    }
+    ASSERT_LT(sentCount, g_sentCount);
+    EXPECT_EQ(201, g_lastSentId);
+}
@@ -0,0 +1,208 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+// Test function hooks
+#define CACleanData CACleanDataTest
+#define CAConstructCoAP CAConstructCoAPTest
+#define CATCPStartServer CATCPStartServerTest
+#define CATCPStopServer CATCPStopServerTest
+#define CATCPSetPacketReceiveCallback CATCPSetPacketReceiveCallbackTest
+#define CATCPSetConnectionChangedCallback CATCPSetConnectionChangedCallbackTest
+#define CACheckPayloadLengthFromHeader CACheckPayloadLengthFromHeaderTest
+#define CATCPSendData CATCPSendDataTest
+#define CAGetTCPInterfaceInformation CAGetTCPInterfaceInformationTest
+#define CAConnectTCPSession CAConnectTCPSessionTest
+#define CADisconnectTCPSession CADisconnectTCPSessionTest
+#define CATCPDisconnectAll CATCPDisconnectAllTest
+#define CAGetTCPSessionInfoFromEndpoint CAGetTCPSessionInfoFromEndpointTest
+#define CAGetSocketFDFromEndpoint CAGetSocketFDFromEndpointTest
+#define CATCPIsSendQueueFull CATCPIsSendQueueFullTest
+#define CAGetSessionInfoFromFD CAGetSessionInfoFromFDTest
+#define CASearchAndDeleteTCPSession CASearchAndDeleteTCPSessionTest
+#define CAGetTotalLengthFromHeader CAGetTotalLengthFromHeaderTest
+#define CAGetMessageLengthFromBuffer CAGetMessageLengthFromBufferTest
+#define CATCPSetErrorHandler CATCPSetErrorHandlerTest
+
+#define CAdecryptSsl CAdecryptSslTcpTest
+#define CAcloseSslConnection CAcloseSslConnectionTcpTest
+#define CAcloseSslConnectionAll CAcloseSslConnectionAllTcpTest
+
+#include "../src/tcp_adapter/catcpserver.c"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+static std::vector<std::vector<uint8_t> > g_decryptedRecords;
+static size_t g_closedConnections = 0;
+
+CAResult_t CAdecryptSslTcpTest(const CASecureEndpoint_t * /*sep*/, uint8_t *data, uint32_t dataLen)
+{
+    g_decryptedRecords.push_back(std::vector<uint8_t>(data, data + dataLen));
+    return CA_STATUS_OK;
+}
+
+CAResult_t CAcloseSslConnectionTcpTest(const CAEndpoint_t * /*endpoint*/)
+{
+    g_closedConnections++;
+    return CA_STATUS_OK;
+}
+
+void CAcloseSslConnectionAllTcpTest(CATransportAdapter_t /*transportType*/)
+{
+}
+
+class CATCPServerTlsTest : public testing::Test
+{
+    protected:
+    int m_peer;
+    CATCPSessionInfo_t *m_session;
+
+    virtual void SetUp()
+    {
+        g_decryptedRecords.clear();
+        g_closedConnections = 0;
+        m_peer = -1;
+        m_session = NULL;
+
+        ASSERT_EQ(CA_STATUS_OK, CATCPCreateMutex());
+
+        int fds[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        CASetNonBlocking(fds[0]);
+        m_peer = fds[1];
+
+        m_session = (CATCPSessionInfo_t *) OICCalloc(1, sizeof(*m_session));
+        ASSERT_TRUE(NULL != m_session);
+        m_session->fd = fds[0];
+        m_session->state = CONNECTED;
+        m_session->sep.endpoint.adapter = CA_ADAPTER_TCP;
+        m_session->sep.endpoint.flags = (CATransportFlags_t) (CA_IPV4 | CA_SECURE);
+        m_session->sep.endpoint.port = 5684;
+        OICStrcpy(m_session->sep.endpoint.addr, sizeof(m_session->sep.endpoint.addr),
+                  "127.0.0.1");
+
+        oc_mutex_lock(g_mutexObjectList);
+        CAAddSession(m_session);
+        oc_mutex_unlock(g_mutexObjectList);
+    }
+
+    virtual void TearDown()
+    {
+        if (-1 != m_peer)
+        {
+            close(m_peer);
+        }
+        if (m_session)
+        {
+            CASearchAndDeleteTCPSessionTest(&m_session->sep.endpoint);
+        }
+        CATCPDestroyMutex();
+    }
+
+    // application data record whose content bytes are all the given value
+    static std::vector<uint8_t> record(uint8_t value, size_t len)
+    {
+        std::vector<uint8_t> data(TLS_HEADER_SIZE + len, value);
+        data[0] = 0x17;
+        data[1] = 0x03;
+        data[2] = 0x03;
+        data[3] = (uint8_t) (len >> 8);
+        data[4] = (uint8_t) len;
+        return data;
+    }
+
+    // one write, read by the server in one recv()
+    void receive(const std::vector<uint8_t> &data, size_t offset, size_t len)
+    {
+        ASSERT_EQ((ssize_t) len, write(m_peer, &data[offset], len));
+        CAReceiveMessage(m_session->fd);
+    }
+};
+
+TEST_F(CATCPServerTlsTest, SeveralRecordsInOneRead)
+{
+    std::vector<uint8_t> first = record('a', 1);
+    std::vector<uint8_t> second = record('b', 300);
+    std::vector<uint8_t> third = record('c', 17);
+
+    std::vector<uint8_t> stream(first);
+    stream.insert(stream.end(), second.begin(), second.end());
+    stream.insert(stream.end(), third.begin(), third.end());
+
+    receive(stream, 0, stream.size());
+
+    // every record is decrypted on its own, in order
+    ASSERT_EQ(3u, g_decryptedRecords.size());
+    EXPECT_TRUE(first == g_decryptedRecords[0]);
+    EXPECT_TRUE(second == g_decryptedRecords[1]);
+    EXPECT_TRUE(third == g_decryptedRecords[2]);
+    EXPECT_EQ(0u, m_session->tlsLen);
+    EXPECT_EQ(0u, g_closedConnections);
+}
+
+TEST_F(CATCPServerTlsTest, PartialRecordIsKeptForTheNextRead)
+{
+    std::vector<uint8_t> first = record('a', 10);
+    std::vector<uint8_t> second = record('b', 20);
+    std::vector<uint8_t> third = record('c', 30);
+
+    std::vector<uint8_t> stream(first);
+    stream.insert(stream.end(), second.begin(), second.end());
+    stream.insert(stream.end(), third.begin(), third.end());
+
+    // two records and the header of the third only in part
+    const size_t split = first.size() + second.size() + 3;
+    receive(stream, 0, split);
+    ASSERT_EQ(2u, g_decryptedRecords.size());
+    EXPECT_TRUE(first == g_decryptedRecords[0]);
+    EXPECT_TRUE(second == g_decryptedRecords[1]);
+    EXPECT_EQ(3u, m_session->tlsLen);
+
+    // the rest of the third record and a fourth one
+    std::vector<uint8_t> fourth = record('d', 1);
+    stream.insert(stream.end(), fourth.begin(), fourth.end());
+    receive(stream, split, stream.size() - split);
+    ASSERT_EQ(4u, g_decryptedRecords.size());
+    EXPECT_TRUE(third == g_decryptedRecords[2]);
+    EXPECT_TRUE(fourth == g_decryptedRecords[3]);
+    EXPECT_EQ(0u, m_session->tlsLen);
+}
+
+TEST_F(CATCPServerTlsTest, OversizedRecordClosesTheSession)
+{
+    std::vector<uint8_t> first = record('a', 4);
+    std::vector<uint8_t> stream(first);
+    const uint8_t oversized[TLS_HEADER_SIZE] = { 0x17, 0x03, 0x03, 0xff, 0xff };
+    stream.insert(stream.end(), oversized, oversized + sizeof(oversized));
+
+    CAEndpoint_t endpoint = m_session->sep.endpoint;
+    receive(stream, 0, stream.size());
+    m_session = NULL;
+
+    // the record before it is still passed up
+    ASSERT_EQ(1u, g_decryptedRecords.size());
+    EXPECT_TRUE(first == g_decryptedRecords[0]);
+    EXPECT_EQ(1u, g_closedConnections);
+    EXPECT_TRUE(NULL == CAGetTCPSessionInfoFromEndpointTest(&endpoint));
+}
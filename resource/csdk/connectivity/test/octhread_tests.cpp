@@ -542,3 +542,112 @@ TEST(ConditionTests, TC_07_WAITDURATION)
 
     oc_cond_free(sharedCond);
 }
+
+static void countFunc(void *context)
+{
+    int *pCount = (int *) context;
+    __sync_fetch_and_add(pCount, 1);
+}
+
+TEST(ThreadPoolTests, TC_01_REUSE_WORKERS)
+{
+    ca_thread_pool_t mythreadpool;
+
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_init(3, &mythreadpool));
+
+    int count = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_add_task(mythreadpool, countFunc, &count));
+        // let the task finish so that the next one can reuse its worker
+        usleep(MINIMAL_LOOP_SLEEP * USECS_PER_MSEC);
+    }
+
+    ca_thread_pool_stats_t stats;
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_get_stats(mythreadpool, &stats));
+    EXPECT_EQ(3u, stats.num_of_threads);
+    EXPECT_EQ(0u, stats.queue_depth);
+    EXPECT_EQ(10u, stats.tasks_completed);
+
+    ca_thread_pool_free(mythreadpool);
+
+    EXPECT_EQ(10, count);
+}
+
+static void blockingFunc(void *context)
+{
+    volatile int *pRelease = (volatile int *) context;
+    while (!*pRelease)
+    {
+        usleep(MINIMAL_LOOP_SLEEP * USECS_PER_MSEC);
+    }
+}
+
+TEST(ThreadPoolTests, TC_02_FULL_POOL_REFUSES_TASK)
+{
+    ca_thread_pool_t mythreadpool;
+
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_init(3, &mythreadpool));
+
+    volatile int release = 0;
+    for (int i = 0; i < CA_THREAD_POOL_MAX_THREADS; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_add_task(mythreadpool, blockingFunc,
+                                                        (void *) &release));
+    }
+
+    // every worker is taken by a task which does not return yet
+    int count = 0;
+    EXPECT_EQ(CA_STATUS_FAILED, ca_thread_pool_add_task(mythreadpool, countFunc, &count));
+
+    ca_thread_pool_stats_t stats;
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_get_stats(mythreadpool, &stats));
+    EXPECT_EQ(static_cast<uint32_t>(CA_THREAD_POOL_MAX_THREADS), stats.num_of_threads);
+
+    release = 1;
+    ca_thread_pool_free(mythreadpool);
+
+    EXPECT_EQ(0, count);
+}
+
+TEST(ThreadPoolTests, TC_03_DEDICATED_TASKS_KEEP_WORKERS)
+{
+    ca_thread_pool_t mythreadpool;
+
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_init(3, &mythreadpool));
+
+    // more tasks which don't return than the pool has workers
+    volatile int release = 0;
+    const int dedicatedCount = CA_THREAD_POOL_MAX_THREADS + 4;
+    for (int i = 0; i < dedicatedCount; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_add_dedicated_task(mythreadpool, blockingFunc,
+                                                                  (void *) &release));
+    }
+
+    int count = 0;
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_add_task(mythreadpool, countFunc, &count));
+
+    ca_thread_pool_stats_t stats;
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_get_stats(mythreadpool, &stats));
+    EXPECT_EQ(3u, stats.num_of_threads);
+    EXPECT_EQ(static_cast<uint32_t>(dedicatedCount), stats.dedicated_threads);
+
+    // returned dedicated tasks no longer count, and their threads are joined later
+    release = 1;
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_get_stats(mythreadpool, &stats));
+        if (0 == stats.dedicated_threads)
+        {
+            break;
+        }
+        usleep(MINIMAL_LOOP_SLEEP * USECS_PER_MSEC);
+    }
+    EXPECT_EQ(0u, stats.dedicated_threads);
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_add_dedicated_task(mythreadpool, countFunc, &count));
+
+    ca_thread_pool_free(mythreadpool);
+
+    EXPECT_EQ(2, count);
+}
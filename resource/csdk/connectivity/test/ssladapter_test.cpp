@@ -1870,6 +1870,7 @@ static int testCAinitSslAdapter()
     g_caSslContext = NULL;
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
+    FreePeerTableLocks();
     g_sslContextMutex = NULL;
 
     return ret;
@@ -1904,6 +1905,7 @@ static int testCAsetSslAdapterCallbacks()
 
     // CAinitSslAdapter
     g_sslContextMutex = oc_mutex_new();
+    NewPeerTableLocks();
     oc_mutex_lock(g_sslContextMutex);
     g_caSslContext = (SslContext_t *)OICCalloc(1, sizeof(SslContext_t));
     g_caSslContext->peerList = u_arraylist_create();
@@ -1969,6 +1971,7 @@ static int testCAsetSslAdapterCallbacks()
     g_caSslContext = NULL;
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
+    FreePeerTableLocks();
     g_sslContextMutex = NULL;
 
     return ret;
@@ -2026,6 +2029,7 @@ static void * test0CAinitiateSslHandshake(void * arg)
 
     // CAinitSslAdapter
     g_sslContextMutex = oc_mutex_new();
+    NewPeerTableLocks();
     oc_mutex_lock(g_sslContextMutex);
     g_caSslContext = (SslContext_t *)OICCalloc(1, sizeof(SslContext_t));
     g_caSslContext->peerList = u_arraylist_create();
@@ -2081,9 +2085,12 @@ static void * test0CAinitiateSslHandshake(void * arg)
 
     // CAcloseTlsConnection
     oc_mutex_lock(g_sslContextMutex);
-    SslEndPoint_t * tep = GetSslPeer(&serverAddr);
+    SslEndPoint_t * tep = AcquireSslPeer(&serverAddr);
+    oc_mutex_lock(tep->mutex);
     mbedtls_ssl_close_notify(&tep->ssl);
-    RemovePeerFromList(&tep->sep.endpoint);
+    RemovePeerFromList(tep);
+    oc_mutex_unlock(tep->mutex);
+    ReleaseSslPeer(tep);
     oc_mutex_unlock(g_sslContextMutex);
 
     // CAdeinitTlsAdapter
@@ -2099,6 +2106,7 @@ static void * test0CAinitiateSslHandshake(void * arg)
     g_caSslContext = NULL;
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
+    FreePeerTableLocks();
     g_sslContextMutex = NULL;
 
     socketClose();
@@ -2187,6 +2195,7 @@ static void * testCAencryptSsl(void * arg)
 
     // CAinitTlsAdapter
     g_sslContextMutex = oc_mutex_new();
+    NewPeerTableLocks();
     oc_mutex_lock(g_sslContextMutex);
     g_caSslContext = (SslContext_t *)OICCalloc(1, sizeof(SslContext_t));
     g_caSslContext->peerList = u_arraylist_create();
@@ -2251,7 +2260,12 @@ static void * testCAencryptSsl(void * arg)
 
     // CAinitiateSslHandshake
     oc_mutex_lock(g_sslContextMutex);
-    InitiateTlsHandshake(&serverAddr);
+    SslEndPoint_t * hsTep = InitiateTlsHandshake(&serverAddr);
+    if (NULL != hsTep)
+    {
+        oc_mutex_unlock(hsTep->mutex);
+        ReleaseSslPeer(hsTep);
+    }
     oc_mutex_unlock(g_sslContextMutex);
 
     unsigned char buffer[2048] = {'\0'};
@@ -2287,6 +2301,7 @@ static void * testCAencryptSsl(void * arg)
     g_caSslContext = NULL;
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
+    FreePeerTableLocks();
     g_sslContextMutex = NULL;
 
     socketClose();
@@ -2573,6 +2588,7 @@ static void * testCAdecryptSsl(void * arg)
 
     // CAinitTlsAdapter
     g_sslContextMutex = oc_mutex_new();
+    NewPeerTableLocks();
     oc_mutex_lock(g_sslContextMutex);
     g_caSslContext = (SslContext_t *)OICCalloc(1, sizeof(SslContext_t));
     g_caSslContext->peerList = u_arraylist_create();
@@ -2616,7 +2632,12 @@ static void * testCAdecryptSsl(void * arg)
 
     // CAinitiateSslHandshake
     oc_mutex_lock(g_sslContextMutex);
-    InitiateTlsHandshake(&serverAddr);
+    SslEndPoint_t * hsTep = InitiateTlsHandshake(&serverAddr);
+    if (NULL != hsTep)
+    {
+        oc_mutex_unlock(hsTep->mutex);
+        ReleaseSslPeer(hsTep);
+    }
     oc_mutex_unlock(g_sslContextMutex);
 
     CASecureEndpoint_t * sep = (CASecureEndpoint_t *) malloc (sizeof(CASecureEndpoint_t));
@@ -2650,6 +2671,7 @@ static void * testCAdecryptSsl(void * arg)
     g_caSslContext = NULL;
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
+    FreePeerTableLocks();
     g_sslContextMutex = NULL;
 
     socketClose();
@@ -2717,6 +2739,7 @@ static int testCAdeinitSslAdapter()
 
     // CAinitTlsAdapter
     g_sslContextMutex = oc_mutex_new();
+    NewPeerTableLocks();
     oc_mutex_lock(g_sslContextMutex);
     g_caSslContext = (SslContext_t *)OICCalloc(1, sizeof(SslContext_t));
     g_caSslContext->peerList = u_arraylist_create();
@@ -2836,6 +2859,7 @@ static void * testServer(void * arg)
     g_caSslContext = NULL;
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
+    FreePeerTableLocks();
     g_sslContextMutex = NULL;
 
     socketClose_server();
@@ -3054,6 +3078,7 @@ static int testCAsetTlsCipherSuite()
     g_caSslContext = NULL;
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
+    FreePeerTableLocks();
     g_sslContextMutex = NULL;
 
     return ret;
@@ -3103,6 +3128,7 @@ static void * testCAsslGenerateOwnerPsk(void * arg)
 
     // CAinitTlsAdapter
     g_sslContextMutex = oc_mutex_new();
+    NewPeerTableLocks();
     oc_mutex_lock(g_sslContextMutex);
     g_caSslContext = (SslContext_t *)OICCalloc(1, sizeof(SslContext_t));
     g_caSslContext->peerList = u_arraylist_create();
@@ -3147,7 +3173,12 @@ static void * testCAsslGenerateOwnerPsk(void * arg)
 
     // CAinitiateSslHandshake
     oc_mutex_lock(g_sslContextMutex);
-    InitiateTlsHandshake(&serverAddr);
+    SslEndPoint_t * hsTep = InitiateTlsHandshake(&serverAddr);
+    if (NULL != hsTep)
+    {
+        oc_mutex_unlock(hsTep->mutex);
+        ReleaseSslPeer(hsTep);
+    }
     oc_mutex_unlock(g_sslContextMutex);
 
     ret = CAsslGenerateOwnerPsk(&serverAddr,
@@ -3158,9 +3189,12 @@ static void * testCAsslGenerateOwnerPsk(void * arg)
 
     // CAcloseTlsConnection
     oc_mutex_lock(g_sslContextMutex);
-    SslEndPoint_t * tep = GetSslPeer(&serverAddr);
+    SslEndPoint_t * tep = AcquireSslPeer(&serverAddr);
+    oc_mutex_lock(tep->mutex);
     mbedtls_ssl_close_notify(&tep->ssl);
-    RemovePeerFromList(&tep->sep.endpoint);
+    RemovePeerFromList(tep);
+    oc_mutex_unlock(tep->mutex);
+    ReleaseSslPeer(tep);
     oc_mutex_unlock(g_sslContextMutex);
 
     // CAdeinitTlsAdapter
@@ -3176,6 +3210,7 @@ static void * testCAsslGenerateOwnerPsk(void * arg)
     g_caSslContext = NULL;
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
+    FreePeerTableLocks();
     g_sslContextMutex = NULL;
 
     socketClose();
@@ -3229,3 +3264,525 @@ TEST(TLSAdaper, Test_ParseChain)
 
     EXPECT_EQ(10, ret + errNum);
 }
+
+TEST(TLSAdaper, Test_PeerTable)
+{
+    CAEndpoint_t ep;
+    memset(&ep, 0, sizeof(ep));
+    ep.adapter = CA_ADAPTER_TCP;
+    ep.flags = CA_SECURE;
+    char addr[] = "127.0.0.1";
+    memcpy(ep.addr, addr, sizeof(addr));
+
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+
+    const int peerCount = 8;
+    SslEndPoint_t * peers[peerCount];
+    oc_mutex_lock(g_sslContextMutex);
+    for (int i = 0; i < peerCount; i++)
+    {
+        ep.port = 5000 + i;
+        peers[i] = NewSslEndPoint(&ep, &g_caSslContext->serverTlsConf);
+        EXPECT_TRUE(NULL != peers[i] && AddPeerToList(peers[i]));
+    }
+    oc_mutex_unlock(g_sslContextMutex);
+
+    // same address, every port is a different peer
+    for (int i = 0; i < peerCount; i++)
+    {
+        ep.port = 5000 + i;
+        SslEndPoint_t * tep = AcquireSslPeer(&ep);
+        EXPECT_EQ(peers[i], tep);
+        ReleaseSslPeer(tep);
+    }
+    ep.port = 6000;
+    EXPECT_TRUE(NULL == AcquireSslPeer(&ep));
+
+    // a removed peer stays valid for its holders but is no longer found
+    ep.port = 5003;
+    SslEndPoint_t * tep = AcquireSslPeer(&ep);
+    ASSERT_TRUE(NULL != tep);
+    oc_mutex_lock(g_sslContextMutex);
+    oc_mutex_lock(tep->mutex);
+    RemovePeerFromList(tep);
+    oc_mutex_unlock(tep->mutex);
+    oc_mutex_unlock(g_sslContextMutex);
+    EXPECT_TRUE(tep->removed);
+    EXPECT_TRUE(NULL == AcquireSslPeer(&ep));
+    ReleaseSslPeer(tep);
+    EXPECT_EQ((uint32_t)(peerCount - 1), u_arraylist_length(g_caSslContext->peerList));
+
+    // BLE peers are matched by address only
+    ep.adapter = CA_ADAPTER_GATT_BTLE;
+    ep.port = 1;
+    oc_mutex_lock(g_sslContextMutex);
+    SslEndPoint_t * blePeer = NewSslEndPoint(&ep, &g_caSslContext->serverTlsConf);
+    EXPECT_TRUE(NULL != blePeer && AddPeerToList(blePeer));
+    oc_mutex_unlock(g_sslContextMutex);
+    ep.port = 2;
+    tep = AcquireSslPeer(&ep);
+    EXPECT_EQ(blePeer, tep);
+    ReleaseSslPeer(tep);
+
+    CAdeinitSslAdapter();
+}
+
+static int g_pkixInfoCalls = 0;
+
+static void countingInfoCallback(PkiInfo_t * inf)
+{
+    g_pkixInfoCalls++;
+    infoCallback_that_loads_x509(inf);
+}
+
+static int countOwnCerts(const mbedtls_ssl_config * conf)
+{
+    int count = 0;
+    for (const mbedtls_ssl_key_cert * cur = conf->key_cert; NULL != cur; cur = cur->next)
+    {
+        count++;
+    }
+    return count;
+}
+
+TEST(TLSAdaper, Test_PkixCache)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+    CAsetPkixInfoCallback(countingInfoCallback);
+    g_pkixInfoCalls = 0;
+
+    oc_mutex_lock(g_sslContextMutex);
+    EXPECT_EQ(0, InitPKIX(CA_ADAPTER_TCP));
+    EXPECT_EQ(0, InitPKIX(CA_ADAPTER_TCP));
+    // the DTLS configs are set up from the same parsed certificates
+    EXPECT_EQ(0, InitPKIX(CA_ADAPTER_IP));
+    EXPECT_EQ(1, g_pkixInfoCalls);
+    oc_mutex_unlock(g_sslContextMutex);
+
+    CAinvalidatePkixInfoCache();
+
+    oc_mutex_lock(g_sslContextMutex);
+    EXPECT_EQ(0, InitPKIX(CA_ADAPTER_TCP));
+    EXPECT_EQ(0, InitPKIX(CA_ADAPTER_IP));
+    EXPECT_EQ(2, g_pkixInfoCalls);
+
+    // a new generation replaces the own certificate instead of adding one
+    EXPECT_EQ(1, countOwnCerts(&g_caSslContext->serverTlsConf));
+    EXPECT_EQ(1, countOwnCerts(&g_caSslContext->clientTlsConf));
+    EXPECT_EQ(1, countOwnCerts(&g_caSslContext->serverDtlsConf));
+    EXPECT_EQ(1, countOwnCerts(&g_caSslContext->clientDtlsConf));
+    oc_mutex_unlock(g_sslContextMutex);
+
+    CAdeinitSslAdapter();
+}
+
+TEST(TLSAdaper, Test_AsyncHandshake)
+{
+    EXPECT_EQ(CA_STATUS_NOT_INITIALIZED, CAsetSslAsyncHandshake(true));
+
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+    EXPECT_EQ(CA_STATUS_OK, CAsetSslAsyncHandshake(true));
+    EXPECT_TRUE(NULL != g_sslHandshakePool);
+    EXPECT_EQ(CA_STATUS_OK, CAsetSslAsyncHandshake(false));
+
+    // TLS records are never queued
+    CASecureEndpoint_t sep;
+    memset(&sep, 0, sizeof(sep));
+    sep.endpoint.adapter = CA_ADAPTER_TCP;
+    uint8_t record[] = { 0x16, 0x03, 0x03, 0x00, 0x00 };
+    EXPECT_EQ(CA_STATUS_OK, CAsetSslAsyncHandshake(true));
+    EXPECT_FALSE(QueueSslHandshake(&sep, record, sizeof(record)));
+
+    // stops the handshake thread
+    CAdeinitSslAdapter();
+    EXPECT_TRUE(NULL == g_sslHandshakePool);
+}
+
+/* **************************
+ *
+ *
+ * Session resumption tests
+ *
+ *
+ * *************************/
+
+typedef struct
+{
+    unsigned char buf[32768];
+    size_t len;
+} SslTestPipe_t;
+
+typedef struct
+{
+    SslTestPipe_t * out;
+    SslTestPipe_t * in;
+} SslTestBio_t;
+
+static SslTestPipe_t g_clientToServer;
+static SslTestPipe_t g_serverToClient;
+static SslTestPipe_t g_serverOutput;    // what the server sent during the last handshake
+static SslTestBio_t g_clientBio = { &g_clientToServer, &g_serverToClient };
+static SslTestBio_t g_serverBio = { &g_serverToClient, &g_clientToServer };
+
+static int pipeSend(void * ctx, const unsigned char * buf, size_t len)
+{
+    SslTestPipe_t * pipe = ((SslTestBio_t *) ctx)->out;
+    if (len > sizeof(pipe->buf) - pipe->len)
+    {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+    memcpy(pipe->buf + pipe->len, buf, len);
+    pipe->len += len;
+    if (pipe == &g_serverToClient && len <= sizeof(g_serverOutput.buf) - g_serverOutput.len)
+    {
+        memcpy(g_serverOutput.buf + g_serverOutput.len, buf, len);
+        g_serverOutput.len += len;
+    }
+    return (int) len;
+}
+
+static int pipeRecv(void * ctx, unsigned char * buf, size_t len)
+{
+    SslTestPipe_t * pipe = ((SslTestBio_t *) ctx)->in;
+    if (0 == pipe->len)
+    {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    size_t n = (len < pipe->len) ? len : pipe->len;
+    memcpy(buf, pipe->buf, n);
+    memmove(pipe->buf, pipe->buf + n, pipe->len - n);
+    pipe->len -= n;
+    return (int) n;
+}
+
+typedef struct
+{
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt crt;
+    mbedtls_pk_context pkey;
+#ifdef MBEDTLS_SSL_CACHE_C
+    mbedtls_ssl_cache_context cache;
+#endif
+} SslTestServer_t;
+
+static bool setupTestServer(SslTestServer_t * srv, bool useTickets)
+{
+    mbedtls_ssl_config_init(&srv->conf);
+    mbedtls_x509_crt_init(&srv->crt);
+    mbedtls_pk_init(&srv->pkey);
+#ifdef MBEDTLS_SSL_CACHE_C
+    mbedtls_ssl_cache_init(&srv->cache);
+#endif
+
+    if (0 != mbedtls_ssl_config_defaults(&srv->conf, MBEDTLS_SSL_IS_SERVER,
+                                         MBEDTLS_SSL_TRANSPORT_STREAM,
+                                         MBEDTLS_SSL_PRESET_DEFAULT) ||
+        0 != mbedtls_x509_crt_parse(&srv->crt, serverCert, serverCertLen) ||
+        0 != mbedtls_pk_parse_key(&srv->pkey, serverPrivateKey, serverPrivateKeyLen, NULL, 0) ||
+        0 != mbedtls_ssl_conf_own_cert(&srv->conf, &srv->crt, &srv->pkey))
+    {
+        return false;
+    }
+    mbedtls_ssl_conf_rng(&srv->conf, SslRandom, &g_caSslContext->rnd);
+
+    if (useTickets)
+    {
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+        mbedtls_ssl_conf_session_tickets_cb(&srv->conf, SslTicketWrite, mbedtls_ssl_ticket_parse,
+                                            &g_caSslContext->ticketCtx);
+        return true;
+#endif
+    }
+    else
+    {
+#ifdef MBEDTLS_SSL_CACHE_C
+        mbedtls_ssl_conf_session_cache(&srv->conf, &srv->cache,
+                                       mbedtls_ssl_cache_get, SslCacheSet);
+        return true;
+#endif
+    }
+    return false;
+}
+
+static void freeTestServer(SslTestServer_t * srv)
+{
+#ifdef MBEDTLS_SSL_CACHE_C
+    mbedtls_ssl_cache_free(&srv->cache);
+#endif
+    mbedtls_ssl_config_free(&srv->conf);
+    mbedtls_pk_free(&srv->pkey);
+    mbedtls_x509_crt_free(&srv->crt);
+}
+
+static void setupTestClientConf(mbedtls_ssl_config * conf)
+{
+    mbedtls_ssl_config_init(conf);
+    mbedtls_ssl_config_defaults(conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                MBEDTLS_SSL_PRESET_DEFAULT);
+    mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(conf, SslRandom, &g_caSslContext->rnd);
+}
+
+static SslEndPoint_t * newTestClient(const CAEndpoint_t * endpoint, mbedtls_ssl_config * conf)
+{
+    oc_mutex_lock(g_sslContextMutex);
+    SslEndPoint_t * tep = NewSslEndPoint(endpoint, conf);
+    if (NULL != tep)
+    {
+        mbedtls_ssl_set_bio(&tep->ssl, &g_clientBio, pipeSend, pipeRecv, NULL);
+        LoadClientSession(tep);
+    }
+    oc_mutex_unlock(g_sslContextMutex);
+    return tep;
+}
+
+/**
+ * Runs the handshake of a client peer with a new server context, in memory.
+ */
+static bool runTestHandshake(SslEndPoint_t * client, SslTestServer_t * srv)
+{
+    g_clientToServer.len = 0;
+    g_serverToClient.len = 0;
+    g_serverOutput.len = 0;
+
+    mbedtls_ssl_context server;
+    mbedtls_ssl_init(&server);
+    bool done = false;
+    if (0 == mbedtls_ssl_setup(&server, &srv->conf))
+    {
+        mbedtls_ssl_set_bio(&server, &g_serverBio, pipeSend, pipeRecv, NULL);
+        for (int i = 0; i < 64 && !done; i++)
+        {
+            int ret = mbedtls_ssl_handshake(&client->ssl);
+            if (0 != ret && MBEDTLS_ERR_SSL_WANT_READ != ret && MBEDTLS_ERR_SSL_WANT_WRITE != ret)
+            {
+                break;
+            }
+            ret = mbedtls_ssl_handshake(&server);
+            if (0 != ret && MBEDTLS_ERR_SSL_WANT_READ != ret && MBEDTLS_ERR_SSL_WANT_WRITE != ret)
+            {
+                break;
+            }
+            done = (MBEDTLS_SSL_HANDSHAKE_OVER == client->ssl.state &&
+                    MBEDTLS_SSL_HANDSHAKE_OVER == server.state);
+        }
+    }
+    mbedtls_ssl_free(&server);
+    return done;
+}
+
+/**
+ * Tells whether the server sent its certificate in the last handshake,
+ * i.e. whether the full exchange took place.
+ */
+static bool serverSentCertificate()
+{
+    size_t pos = 0;
+    while (pos + 5 <= g_serverOutput.len)
+    {
+        const unsigned char * rec = g_serverOutput.buf + pos;
+        size_t recLen = (size_t) ((rec[3] << 8) | rec[4]);
+        if (MBEDTLS_SSL_MSG_CHANGE_CIPHER_SPEC == rec[0])
+        {
+            // the rest is encrypted
+            break;
+        }
+        if (MBEDTLS_SSL_MSG_HANDSHAKE == rec[0])
+        {
+            size_t off = 5;
+            while (off + 4 <= 5 + recLen && pos + off < g_serverOutput.len)
+            {
+                if (MBEDTLS_SSL_HS_CERTIFICATE == rec[off])
+                {
+                    return true;
+                }
+                off += 4 + (size_t) ((rec[off + 1] << 16) | (rec[off + 2] << 8) | rec[off + 3]);
+            }
+        }
+        pos += 5 + recLen;
+    }
+    return false;
+}
+
+static SslClientSession_t * findClientSession(const CAEndpoint_t * endpoint)
+{
+    oc_mutex_lock(g_sslContextMutex);
+    SslClientSession_t * entry = GetClientSession(endpoint);
+    oc_mutex_unlock(g_sslContextMutex);
+    return entry;
+}
+
+static CAResult_t failTestHandshake(SslEndPoint_t * peer, int ret)
+{
+    SSL_CHECK_FAIL(peer, ret, "Handshake error", 1, CA_STATUS_FAILED,
+                   MBEDTLS_SSL_ALERT_MSG_HANDSHAKE_FAILURE);
+    return CA_STATUS_OK;
+}
+
+static void setupTestEndpoint(CAEndpoint_t * ep)
+{
+    memset(ep, 0, sizeof(*ep));
+    ep->adapter = CA_ADAPTER_TCP;
+    ep->flags = CA_SECURE;
+    OICStrcpy(ep->addr, sizeof(ep->addr), "127.0.0.1");
+    ep->port = 5684;
+}
+
+static void testSessionResumption(bool useTickets)
+{
+    CAEndpoint_t ep;
+    setupTestEndpoint(&ep);
+
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+    SslTestServer_t srv;
+    mbedtls_ssl_config clientConf;
+    setupTestClientConf(&clientConf);
+    ASSERT_TRUE(setupTestServer(&srv, useTickets));
+
+    // the first handshake is a full one and its session is stored
+    SslEndPoint_t * tep = newTestClient(&ep, &clientConf);
+    ASSERT_TRUE(NULL != tep);
+    EXPECT_TRUE(runTestHandshake(tep, &srv));
+    EXPECT_TRUE(serverSentCertificate());
+    oc_mutex_lock(g_sslContextMutex);
+    SaveClientSession(tep);
+    oc_mutex_unlock(g_sslContextMutex);
+    DeleteSslEndPoint(tep);
+    EXPECT_TRUE(NULL != findClientSession(&ep));
+
+    // the next connection resumes it without the certificate exchange
+    tep = newTestClient(&ep, &clientConf);
+    ASSERT_TRUE(NULL != tep);
+    EXPECT_TRUE(runTestHandshake(tep, &srv));
+    EXPECT_FALSE(serverSentCertificate());
+    DeleteSslEndPoint(tep);
+
+    // another server address gets a full handshake
+    ep.port = 5685;
+    tep = newTestClient(&ep, &clientConf);
+    ASSERT_TRUE(NULL != tep);
+    EXPECT_TRUE(runTestHandshake(tep, &srv));
+    EXPECT_TRUE(serverSentCertificate());
+    DeleteSslEndPoint(tep);
+
+    freeTestServer(&srv);
+    mbedtls_ssl_config_free(&clientConf);
+    CAdeinitSslAdapter();
+}
+
+#ifdef MBEDTLS_SSL_CACHE_C
+TEST(TLSAdaper, Test_SessionResumptionCache)
+{
+    testSessionResumption(false);
+}
+#endif
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+TEST(TLSAdaper, Test_SessionResumptionTicket)
+{
+    testSessionResumption(true);
+}
+#endif
+
+TEST(TLSAdaper, Test_NonResumableSession)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    session.ciphersuite = MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256;
+    session.id_len = 32;
+#ifdef MBEDTLS_SSL_CACHE_C
+    EXPECT_EQ(-1, SslCacheSet(&g_caSslContext->sessionCache, &session));
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+    unsigned char ticket[512];
+    size_t ticketLen = 0;
+    uint32_t lifetime = 0;
+    EXPECT_EQ(-1, SslTicketWrite(&g_caSslContext->ticketCtx, &session, ticket,
+                                 ticket + sizeof(ticket), &ticketLen, &lifetime));
+#endif
+    mbedtls_ssl_session_free(&session);
+
+    CAdeinitSslAdapter();
+}
+
+TEST(TLSAdaper, Test_ClientSessionStore)
+{
+    CAEndpoint_t ep;
+    setupTestEndpoint(&ep);
+
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+    SslTestServer_t srv;
+    mbedtls_ssl_config clientConf;
+    setupTestClientConf(&clientConf);
+    ASSERT_TRUE(setupTestServer(&srv, false));
+
+    SslEndPoint_t * tep = newTestClient(&ep, &clientConf);
+    ASSERT_TRUE(NULL != tep);
+    ASSERT_TRUE(runTestHandshake(tep, &srv));
+
+    // servers with a known device ID are found by it, at any address
+    OICStrcpy(tep->sep.endpoint.remoteId, sizeof(tep->sep.endpoint.remoteId), "device-1");
+    uint64_t before = OICGetCurrentTime(TIME_IN_MS);
+    oc_mutex_lock(g_sslContextMutex);
+    SaveClientSession(tep);
+    oc_mutex_unlock(g_sslContextMutex);
+    CAEndpoint_t other = ep;
+    OICStrcpy(other.addr, sizeof(other.addr), "127.0.0.2");
+    OICStrcpy(other.remoteId, sizeof(other.remoteId), "device-1");
+    SslClientSession_t * entry = findClientSession(&other);
+    ASSERT_TRUE(NULL != entry);
+    OICStrcpy(other.remoteId, sizeof(other.remoteId), "device-2");
+    EXPECT_TRUE(NULL == findClientSession(&other));
+
+    // a session expires SSL_SESSION_LIFETIME after it was stored
+    EXPECT_LE(before + (uint64_t) SSL_SESSION_LIFETIME * 1000, entry->expires);
+    EXPECT_GE(OICGetCurrentTime(TIME_IN_MS) + (uint64_t) SSL_SESSION_LIFETIME * 1000,
+              entry->expires);
+    entry->expires = OICGetCurrentTime(TIME_IN_MS);
+    OICStrcpy(ep.remoteId, sizeof(ep.remoteId), "device-1");
+    SslEndPoint_t * expired = newTestClient(&ep, &clientConf);
+    ASSERT_TRUE(NULL != expired);
+    DeleteSslEndPoint(expired);
+    EXPECT_TRUE(NULL == findClientSession(&ep));
+
+    // without device ID, by address and port; the oldest entry makes room
+    tep->sep.endpoint.remoteId[0] = '\0';
+    oc_mutex_lock(g_sslContextMutex);
+    for (uint16_t i = 0; i <= SSL_SESSION_CACHE_SIZE; i++)
+    {
+        tep->sep.endpoint.port = (uint16_t) (6000 + i);
+        SaveClientSession(tep);
+    }
+    oc_mutex_unlock(g_sslContextMutex);
+    memset(ep.remoteId, 0, sizeof(ep.remoteId));
+    ep.port = 6000;
+    EXPECT_TRUE(NULL == findClientSession(&ep));
+    for (uint16_t i = 1; i <= SSL_SESSION_CACHE_SIZE; i++)
+    {
+        ep.port = (uint16_t) (6000 + i);
+        EXPECT_TRUE(NULL != findClientSession(&ep));
+    }
+    DeleteSslEndPoint(tep);
+
+    // a failed handshake forgets the session of the server
+    ep.port = 6001;
+    SslEndPoint_t * peer = newTestClient(&ep, &clientConf);
+    ASSERT_TRUE(NULL != peer);
+    oc_mutex_lock(g_sslContextMutex);
+    ASSERT_TRUE(AddPeerToList(peer));
+    oc_mutex_unlock(g_sslContextMutex);
+    peer = AcquireSslPeer(&ep);
+    ASSERT_TRUE(NULL != peer);
+    CAsetSslHandshakeCallback(NULL);
+    oc_mutex_lock(g_sslContextMutex);
+    oc_mutex_lock(peer->mutex);
+    EXPECT_EQ(CA_STATUS_FAILED, failTestHandshake(peer, MBEDTLS_ERR_SSL_BAD_HS_SERVER_HELLO));
+    EXPECT_TRUE(NULL == findClientSession(&ep));
+    EXPECT_TRUE(NULL == AcquireSslPeer(&ep));
+
+    freeTestServer(&srv);
+    mbedtls_ssl_config_free(&clientConf);
+    CAdeinitSslAdapter();
+}
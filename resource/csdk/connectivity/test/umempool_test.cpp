@@ -0,0 +1,175 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+#include "umempool.h"
+#include "oic_malloc.h"
+#include "octhread.h"
+
+typedef struct
+{
+    void *next;
+    char data[56];
+} TestObject_t;
+
+class UMemPoolF : public testing::Test {
+public:
+    UMemPoolF() :
+      testing::Test(),
+      pool(NULL)
+  {
+  }
+
+protected:
+    virtual void SetUp()
+    {
+        pool = u_mempool_create(sizeof(TestObject_t), 2, 4);
+        ASSERT_TRUE(pool != NULL);
+    }
+
+    virtual void TearDown()
+    {
+        u_mempool_delete(pool);
+    }
+
+    u_mempool_t *pool;
+};
+
+TEST(UMemPool, CreateInvalid)
+{
+    EXPECT_TRUE(NULL == u_mempool_create(1, 0, 1));
+    EXPECT_TRUE(NULL == u_mempool_alloc(NULL));
+}
+
+TEST_F(UMemPoolF, Preallocated)
+{
+    u_mempool_stats_t stats;
+    u_mempool_get_stats(pool, &stats);
+    EXPECT_EQ(static_cast<uint32_t>(2), stats.cached);
+
+    TestObject_t *first = (TestObject_t *) u_mempool_alloc(pool);
+    TestObject_t *second = (TestObject_t *) u_mempool_alloc(pool);
+    TestObject_t *third = (TestObject_t *) u_mempool_alloc(pool);
+    ASSERT_TRUE(first != NULL && second != NULL && third != NULL);
+
+    u_mempool_get_stats(pool, &stats);
+    EXPECT_EQ(static_cast<uint32_t>(2), stats.hits);
+    EXPECT_EQ(static_cast<uint32_t>(1), stats.misses);
+    EXPECT_EQ(static_cast<uint32_t>(0), stats.cached);
+
+    u_mempool_free(pool, first);
+    u_mempool_free(pool, second);
+    u_mempool_free(pool, third);
+}
+
+TEST_F(UMemPoolF, Reuse)
+{
+    TestObject_t *object = (TestObject_t *) u_mempool_alloc(pool);
+    ASSERT_TRUE(object != NULL);
+    memset(object, 0xA5, sizeof(TestObject_t));
+    u_mempool_free(pool, object);
+
+    TestObject_t *again = (TestObject_t *) u_mempool_alloc(pool);
+    EXPECT_EQ(object, again);
+
+    // objects from the pool are zero filled
+    TestObject_t zero;
+    memset(&zero, 0, sizeof(zero));
+    EXPECT_EQ(0, memcmp(&zero, again, sizeof(zero)));
+    u_mempool_free(pool, again);
+}
+
+TEST_F(UMemPoolF, HeapObjects)
+{
+    // objects of the pool's size from the heap may be freed into the pool
+    TestObject_t *object = (TestObject_t *) OICMalloc(sizeof(TestObject_t));
+    ASSERT_TRUE(object != NULL);
+    u_mempool_free(pool, object);
+
+    u_mempool_stats_t stats;
+    u_mempool_get_stats(pool, &stats);
+    EXPECT_EQ(static_cast<uint32_t>(1), stats.releases);
+    EXPECT_EQ(static_cast<uint32_t>(3), stats.cached);
+
+    // and objects of the pool may be freed to the heap
+    OICFree(u_mempool_alloc(pool));
+}
+
+TEST_F(UMemPoolF, Overflow)
+{
+    void *objects[6] = { NULL };
+    for (int i = 0; i < 6; ++i)
+    {
+        objects[i] = u_mempool_alloc(pool);
+        ASSERT_TRUE(objects[i] != NULL);
+    }
+    for (int i = 0; i < 6; ++i)
+    {
+        u_mempool_free(pool, objects[i]);
+    }
+
+    u_mempool_stats_t stats;
+    u_mempool_get_stats(pool, &stats);
+    EXPECT_EQ(static_cast<uint32_t>(4), stats.cached);
+    EXPECT_EQ(static_cast<uint32_t>(4), stats.releases);
+    EXPECT_EQ(static_cast<uint32_t>(2), stats.overflows);
+}
+
+static const int POOL_THREADS = 4;
+static const int POOL_ROUNDS = 10000;
+
+static void *poolUser(void *context)
+{
+    u_mempool_t *pool = (u_mempool_t *) context;
+    for (int i = 0; i < POOL_ROUNDS; ++i)
+    {
+        TestObject_t *object = (TestObject_t *) u_mempool_alloc(pool);
+        if (object)
+        {
+            object->data[0] = 1;
+            u_mempool_free(pool, object);
+        }
+    }
+    return NULL;
+}
+
+TEST_F(UMemPoolF, MultiThread)
+{
+    oc_thread threads[POOL_THREADS];
+    for (int i = 0; i < POOL_THREADS; ++i)
+    {
+        ASSERT_EQ(OC_THREAD_SUCCESS, oc_thread_new(&threads[i], poolUser, pool));
+    }
+    for (int i = 0; i < POOL_THREADS; ++i)
+    {
+        EXPECT_EQ(OC_THREAD_SUCCESS, oc_thread_wait(threads[i]));
+        oc_thread_free(threads[i]);
+    }
+
+    u_mempool_stats_t stats;
+    u_mempool_get_stats(pool, &stats);
+    EXPECT_EQ(static_cast<uint32_t>(POOL_THREADS * POOL_ROUNDS), stats.hits + stats.misses);
+    EXPECT_EQ(static_cast<uint32_t>(POOL_THREADS * POOL_ROUNDS),
+              stats.releases + stats.overflows);
+    EXPECT_LE(stats.cached, static_cast<uint32_t>(4));
+}
@@ -0,0 +1,167 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#include "uringbuffer.h"
+#include "octhread.h"
+
+class URingBufferF : public testing::Test {
+public:
+    URingBufferF() :
+      testing::Test(),
+      ring(NULL)
+  {
+  }
+
+protected:
+    virtual void SetUp()
+    {
+        ring = u_ringbuffer_create(8);
+        ASSERT_TRUE(ring != NULL);
+    }
+
+    virtual void TearDown()
+    {
+        u_ringbuffer_delete(ring);
+    }
+
+    u_ringbuffer_t *ring;
+};
+
+TEST(URingBuffer, Base)
+{
+    u_ringbuffer_t *ring = u_ringbuffer_create(1);
+    ASSERT_TRUE(ring != NULL);
+
+    u_ringbuffer_delete(ring);
+}
+
+TEST(URingBuffer, CreateInvalid)
+{
+    EXPECT_TRUE(NULL == u_ringbuffer_create(0));
+}
+
+TEST(URingBuffer, CapacityRoundsUp)
+{
+    u_ringbuffer_t *ring = u_ringbuffer_create(5);
+    ASSERT_TRUE(ring != NULL);
+
+    EXPECT_EQ(static_cast<uint32_t>(8), u_ringbuffer_get_capacity(ring));
+
+    u_ringbuffer_delete(ring);
+}
+
+TEST_F(URingBufferF, Full)
+{
+    int values[9] = { 0 };
+    for (int i = 0; i < 8; ++i)
+    {
+        EXPECT_TRUE(u_ringbuffer_push(ring, &values[i], sizeof(int)));
+    }
+    EXPECT_EQ(static_cast<uint32_t>(8), u_ringbuffer_get_size(ring));
+
+    EXPECT_FALSE(u_ringbuffer_push(ring, &values[8], sizeof(int)));
+
+    u_queue_message_t messages[1];
+    ASSERT_EQ(static_cast<uint32_t>(1), u_ringbuffer_pop_batch(ring, messages, 1));
+    EXPECT_EQ(&values[0], messages[0].msg);
+
+    EXPECT_TRUE(u_ringbuffer_push(ring, &values[8], sizeof(int)));
+}
+
+TEST_F(URingBufferF, Order)
+{
+    int values[20] = { 0 };
+    u_queue_message_t messages[8];
+    int next = 0;
+
+    // wrap around several times
+    for (int i = 0; i < 20; ++i)
+    {
+        ASSERT_TRUE(u_ringbuffer_push(ring, &values[i], sizeof(int)));
+        if (i % 3 == 2)
+        {
+            uint32_t count = u_ringbuffer_pop_batch(ring, messages, 8);
+            for (uint32_t j = 0; j < count; ++j)
+            {
+                EXPECT_EQ(&values[next++], messages[j].msg);
+            }
+        }
+    }
+
+    uint32_t count = u_ringbuffer_pop_batch(ring, messages, 8);
+    for (uint32_t j = 0; j < count; ++j)
+    {
+        EXPECT_EQ(&values[next++], messages[j].msg);
+    }
+    EXPECT_EQ(20, next);
+    EXPECT_EQ(static_cast<uint32_t>(0), u_ringbuffer_get_size(ring));
+}
+
+static const int RING_PRODUCERS = 4;
+static const int RING_ITEMS = 10000;
+
+static void *ringProducer(void *context)
+{
+    u_ringbuffer_t *ring = (u_ringbuffer_t *)context;
+    for (int i = 0; i < RING_ITEMS; ++i)
+    {
+        while (!u_ringbuffer_push(ring, ring, sizeof(int)))
+        {
+            std::this_thread::yield();
+        }
+    }
+    return NULL;
+}
+
+TEST_F(URingBufferF, MultiProducer)
+{
+    oc_thread threads[RING_PRODUCERS];
+    for (int i = 0; i < RING_PRODUCERS; ++i)
+    {
+        ASSERT_EQ(OC_THREAD_SUCCESS, oc_thread_new(&threads[i], ringProducer, ring));
+    }
+
+    u_queue_message_t messages[8];
+    int received = 0;
+    while (received < RING_PRODUCERS * RING_ITEMS)
+    {
+        uint32_t count = u_ringbuffer_pop_batch(ring, messages, 8);
+        for (uint32_t j = 0; j < count; ++j)
+        {
+            EXPECT_EQ(ring, messages[j].msg);
+        }
+        if (0 == count)
+        {
+            std::this_thread::yield();
+        }
+        received += count;
+    }
+
+    for (int i = 0; i < RING_PRODUCERS; ++i)
+    {
+        EXPECT_EQ(OC_THREAD_SUCCESS, oc_thread_wait(threads[i]));
+        oc_thread_free(threads[i]);
+    }
+    EXPECT_EQ(static_cast<uint32_t>(0), u_ringbuffer_get_size(ring));
+}
@@ -123,6 +123,20 @@ CAResult_t CASetPortNumberToAssign(CATransportAdapter_t adapter,
     return CA_NOT_SUPPORTED;
 }
 
+CAResult_t CASetIPReceiveShards(uint8_t shards, bool pinToCpus)
+{
+    OIC_LOG_V(DEBUG, TAG, "CASetIPReceiveShards %u", shards);
+
+    if (0 == shards || CA_IP_MAX_RECEIVE_SHARDS < shards)
+    {
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    caglobals.ip.receiveShards = shards;
+    caglobals.ip.receiveAffinity = pinToCpus;
+    return CA_STATUS_OK;
+}
+
 uint16_t CAGetAssignedPortNumber(CATransportAdapter_t adapter, CATransportFlags_t flag)
 {
     OIC_LOG(DEBUG, TAG, "CAGetAssignedPortNumber");
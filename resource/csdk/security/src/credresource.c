@@ -1336,6 +1336,11 @@ static bool UpdatePersistentStorage(const OicSecCred_t *cred)
         }
     }
 
+#if defined(__WITH_DTLS__) || defined(__WITH_TLS__)
+    // certificates may have changed, have the TLS adapter parse them again
+    CAinvalidatePkixInfo();
+#endif
+
     OIC_LOG(DEBUG, TAG, "OUT Cred UpdatePersistentStorage");
     return ret;
 }
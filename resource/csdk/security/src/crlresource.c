@@ -19,6 +19,7 @@
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
 #include "utlist.h"
+#include "casecurityinterface.h"
 #include "payload_logging.h"
 #include "psinterface.h"
 #include "resourcemanager.h"
@@ -497,7 +498,9 @@ OCStackResult UpdateCRLResource(OicSecCrl_t *crl)
         return res;
     }
 
-    return UpdateSecureResourceInPS(OIC_CBOR_CRL_NAME, payload, size);
+    res = UpdateSecureResourceInPS(OIC_CBOR_CRL_NAME, payload, size);
+    CAinvalidatePkixInfo();
+    return res;
 }
 
 static OCEntityHandlerResult HandleCRLPostRequest(const OCEntityHandlerRequest *ehRequest)
@@ -186,6 +186,15 @@ typedef struct OCResource {
     /** Points to next resource in list.*/
     struct OCResource *next;
 
+    /** Points to next resource in the same bucket of the uri index.*/
+    struct OCResource *uriNext;
+
+    /** Points to next resource in the same bucket of the handle index.*/
+    struct OCResource *handleNext;
+
+    /** Hash of uri.*/
+    uint32_t uriHash;
+
     /** Relative path on the device; will be combined with base url to create fully qualified path.*/
     char *uri;
 
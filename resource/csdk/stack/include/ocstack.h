@@ -39,6 +39,16 @@ extern "C" {
 /** Macro to use Random port.*/
 #define USE_RANDOM_PORT (0)
 
+/** Number of received messages OCProcess() dispatches per call.*/
+#ifndef OC_DEFAULT_PROCESS_BATCH_SIZE
+#define OC_DEFAULT_PROCESS_BATCH_SIZE (32)
+#endif
+
+/** Longest time OCProcessWait() blocks while the stack has periodic work.*/
+#ifndef OC_MAX_PROCESS_WAIT_MS
+#define OC_MAX_PROCESS_WAIT_MS (1000)
+#endif
+
 /*
  * Function prototypes
  */
@@ -127,6 +137,44 @@ OCStackResult OCStopMulticastServer();
  */
 OCStackResult OCProcess();
 
+/**
+ * This function is the same as OCProcess() but dispatches up to maxCount received
+ * messages in one call. OCProcess() uses ::OC_DEFAULT_PROCESS_BATCH_SIZE.
+ * A caller seeing a non-zero remaining count can call again without waiting.
+ *
+ * @param maxCount        Maximum number of received messages to dispatch.
+ * @param remaining       Number of received messages still waiting. May be NULL.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OCProcessBatch(uint32_t maxCount, uint32_t *remaining);
+
+/**
+ * This function blocks until OCProcess() has received messages to dispatch,
+ * timeoutMs expires, or OCProcessWakeUp() is called. It must be called without
+ * holding locks that OCProcess() callbacks take.
+ * When the stack has periodic work (presence, keepalive, routing) the wait is
+ * limited to ::OC_MAX_PROCESS_WAIT_MS so that OCProcess() still runs on time.
+ *
+ * @param timeoutMs       Longest wait in milliseconds, 0 to wait for messages or
+ *                        OCProcessWakeUp() only.
+ *
+ * @return ::OC_STACK_OK if messages are waiting, ::OC_STACK_TIMEOUT if the wait
+ *         timed out or was woken up, ::OC_STACK_NOTIMPL if this build cannot wait
+ *         (the caller should poll OCProcess()), some other value upon failure.
+ */
+OCStackResult OCProcessWait(uint32_t timeoutMs);
+
+/**
+ * This function wakes up all threads blocked in OCProcessWait(), e.g. both the
+ * client and the server processing thread in Both mode, so each of them can check
+ * whether it has to stop. If no thread is waiting, the next OCProcessWait()
+ * returns at once instead.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OCProcessWakeUp();
+
 /**
  * This function discovers or Perform requests on a specified resource
  * (specified by that Resource's respective URI).
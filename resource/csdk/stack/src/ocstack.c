@@ -125,6 +125,25 @@ static OCStackState stackState = OC_STACK_UNINITIALIZED;
 
 OCResource *headResource = NULL;
 static OCResource *tailResource = NULL;
+
+/**
+ * Initial number of buckets of the resource indexes (power of two).
+ * The indexes double when they hold as many resources as buckets.
+ */
+#ifndef OC_RESOURCE_INDEX_SIZE
+#define OC_RESOURCE_INDEX_SIZE 64
+#endif
+
+/** Buckets used until the resource indexes grow. */
+static OCResource *resourceUriBuckets[OC_RESOURCE_INDEX_SIZE];
+static OCResource *resourceHandleBuckets[OC_RESOURCE_INDEX_SIZE];
+
+/** Resources chained by uri and by handle, kept in sync with the resource list. */
+static OCResource **resourceUriIndex = resourceUriBuckets;
+static OCResource **resourceHandleIndex = resourceHandleBuckets;
+static size_t resourceIndexSize = OC_RESOURCE_INDEX_SIZE;
+static size_t resourceCount = 0;
+
 static OCResourceHandle platformResource = {0};
 static OCResourceHandle deviceResource = {0};
 static OCResourceHandle introspectionResource = {0};
@@ -200,6 +219,13 @@ static OCStackResult initResources();
  */
 static void insertResource(OCResource *resource);
 
+/**
+ * Add a resource to the uri index once its uri is set.
+ *
+ * @param resource Resource to be added.
+ */
+static void indexResourceUri(OCResource *resource);
+
 /**
  * Find a resource in the linked list of resources.
  *
@@ -3492,6 +3518,15 @@ exit:
 
 OCStackResult OCProcess()
 {
+    return OCProcessBatch(OC_DEFAULT_PROCESS_BATCH_SIZE, NULL);
+}
+
+OCStackResult OCProcessBatch(uint32_t maxCount, uint32_t *remaining)
+{
+    if (remaining)
+    {
+        *remaining = 0;
+    }
     if (stackState == OC_STACK_UNINITIALIZED)
     {
         return OC_STACK_ERROR;
@@ -3499,7 +3534,7 @@ OCStackResult OCProcess()
 #ifdef WITH_PRESENCE
     OCProcessPresence();
 #endif
-    CAHandleRequestResponse();
+    CAHandleRequestResponseBatch(maxCount, remaining);
 
 #ifdef ROUTING_GATEWAY
     RMProcess();
@@ -3511,6 +3546,44 @@ OCStackResult OCProcess()
     return OC_STACK_OK;
 }
 
+OCStackResult OCProcessWait(uint32_t timeoutMs)
+{
+    if (stackState == OC_STACK_UNINITIALIZED)
+    {
+        return OC_STACK_ERROR;
+    }
+
+#if defined(WITH_PRESENCE) || defined(TCP_ADAPTER) || defined(ROUTING_GATEWAY)
+    // presence, keepalive and routing are checked from OCProcess()
+    if (0 == timeoutMs || OC_MAX_PROCESS_WAIT_MS < timeoutMs)
+    {
+        timeoutMs = OC_MAX_PROCESS_WAIT_MS;
+    }
+#endif
+
+    switch (CAWaitForRequestResponse(timeoutMs))
+    {
+        case CA_STATUS_OK:
+            return OC_STACK_OK;
+        case CA_REQUEST_TIMEOUT:
+            return OC_STACK_TIMEOUT;
+        case CA_NOT_SUPPORTED:
+            return OC_STACK_NOTIMPL;
+        default:
+            return OC_STACK_ERROR;
+    }
+}
+
+OCStackResult OCProcessWakeUp()
+{
+    if (stackState == OC_STACK_UNINITIALIZED)
+    {
+        return OC_STACK_ERROR;
+    }
+
+    return (CA_STATUS_OK == CAWakeUpRequestResponse()) ? OC_STACK_OK : OC_STACK_ERROR;
+}
+
 #ifdef WITH_PRESENCE
 OCStackResult OCStartPresence(const uint32_t ttl)
 {
@@ -3705,21 +3778,11 @@ OCStackResult OCCreateResourceWithEp(OCResourceHandle *handle,
         return OC_STACK_INVALID_PARAM;
     }
 
-    // If the headResource is NULL, then no resources have been created...
-    pointer = headResource;
-    if (pointer)
+    // Repeated URLs are not allowed.  If a repeat is found, exit with an error
+    if (OCGetResourceHandleAtUri(uri))
     {
-        // At least one resources is in the resource list, so we need to search for
-        // repeated URLs, which are not allowed.  If a repeat is found, exit with an error
-        while (pointer)
-        {
-            if (strncmp(uri, pointer->uri, MAX_URI_LENGTH) == 0)
-            {
-                OIC_LOG_V(ERROR, TAG, "Resource %s already exists", uri);
-                return OC_STACK_INVALID_PARAM;
-            }
-            pointer = pointer->next;
-        }
+        OIC_LOG_V(ERROR, TAG, "Resource %s already exists", uri);
+        return OC_STACK_INVALID_PARAM;
     }
     // Create the pointer and insert it into the resource list
     pointer = (OCResource *) OICCalloc(1, sizeof(OCResource));
@@ -3739,6 +3802,7 @@ OCStackResult OCCreateResourceWithEp(OCResourceHandle *handle,
         result = OC_STACK_NO_MEMORY;
         goto exit;
     }
+    indexResourceUri(pointer);
 
     // Set properties.  Set OC_ACTIVE
     pointer->resourceProperties = (OCResourceProperty) (resourceProperties
@@ -4777,6 +4841,79 @@ OCStackResult initResources()
     return result;
 }
 
+static uint32_t hashResourceUri(const char *uri)
+{
+    uint32_t hash = 2166136261u;
+    for (const char *c = uri; '\0' != *c; c++)
+    {
+        hash = (hash ^ (uint8_t) *c) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t hashResourceHandle(const OCResource *resource)
+{
+    return (uint32_t) (((uintptr_t) resource >> 4) * 2654435761u);
+}
+
+/**
+ * Double the resource indexes. The indexes keep their size if memory runs out,
+ * lookups only get slower.
+ */
+static void growResourceIndex()
+{
+    size_t size = resourceIndexSize * 2;
+    OCResource **uriIndex = (OCResource **) OICCalloc(size, sizeof(OCResource *));
+    OCResource **handleIndex = (OCResource **) OICCalloc(size, sizeof(OCResource *));
+    if (!uriIndex || !handleIndex)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to grow resource index");
+        OICFree(uriIndex);
+        OICFree(handleIndex);
+        return;
+    }
+
+    for (OCResource *pointer = headResource; pointer; pointer = pointer->next)
+    {
+        // a resource is in the uri index as soon as its uri is set.
+        if (pointer->uri)
+        {
+            pointer->uriNext = uriIndex[pointer->uriHash & (size - 1)];
+            uriIndex[pointer->uriHash & (size - 1)] = pointer;
+        }
+        uint32_t hash = hashResourceHandle(pointer);
+        pointer->handleNext = handleIndex[hash & (size - 1)];
+        handleIndex[hash & (size - 1)] = pointer;
+    }
+
+    if (resourceUriIndex != resourceUriBuckets)
+    {
+        OICFree(resourceUriIndex);
+        OICFree(resourceHandleIndex);
+    }
+    resourceUriIndex = uriIndex;
+    resourceHandleIndex = handleIndex;
+    resourceIndexSize = size;
+}
+
+/**
+ * Go back to the initial resource indexes once no resource is left.
+ */
+static void resetResourceIndex()
+{
+    if (resourceUriIndex != resourceUriBuckets)
+    {
+        OICFree(resourceUriIndex);
+        OICFree(resourceHandleIndex);
+    }
+    memset(resourceUriBuckets, 0, sizeof(resourceUriBuckets));
+    memset(resourceHandleBuckets, 0, sizeof(resourceHandleBuckets));
+    resourceUriIndex = resourceUriBuckets;
+    resourceHandleIndex = resourceHandleBuckets;
+    resourceIndexSize = OC_RESOURCE_INDEX_SIZE;
+    resourceCount = 0;
+}
+
 void insertResource(OCResource *resource)
 {
     if (!headResource)
@@ -4790,11 +4927,65 @@ void insertResource(OCResource *resource)
         tailResource = resource;
     }
     resource->next = NULL;
+
+    OCResource **bucket = &resourceHandleIndex[hashResourceHandle(resource)
+                                               & (resourceIndexSize - 1)];
+    resource->handleNext = *bucket;
+    *bucket = resource;
+
+    if (++resourceCount > resourceIndexSize)
+    {
+        growResourceIndex();
+    }
+}
+
+void indexResourceUri(OCResource *resource)
+{
+    resource->uriHash = hashResourceUri(resource->uri);
+    OCResource **bucket = &resourceUriIndex[resource->uriHash & (resourceIndexSize - 1)];
+    resource->uriNext = *bucket;
+    *bucket = resource;
+}
+
+/**
+ * Remove a resource from the uri and handle indexes.
+ */
+static void unindexResource(OCResource *resource)
+{
+    OCResource **link = NULL;
+    if (resource->uri)
+    {
+        link = &resourceUriIndex[resource->uriHash & (resourceIndexSize - 1)];
+        while (*link && *link != resource)
+        {
+            link = &(*link)->uriNext;
+        }
+        if (*link)
+        {
+            *link = resource->uriNext;
+        }
+    }
+
+    link = &resourceHandleIndex[hashResourceHandle(resource) & (resourceIndexSize - 1)];
+    while (*link && *link != resource)
+    {
+        link = &(*link)->handleNext;
+    }
+    if (*link)
+    {
+        *link = resource->handleNext;
+    }
+
+    if (0 == --resourceCount)
+    {
+        resetResourceIndex();
+    }
 }
 
 OCResource *findResource(OCResource *resource)
 {
-    OCResource *pointer = headResource;
+    OCResource *pointer = resourceHandleIndex[hashResourceHandle(resource)
+                                              & (resourceIndexSize - 1)];
 
     while (pointer)
     {
@@ -4802,7 +4993,7 @@ OCResource *findResource(OCResource *resource)
         {
             return resource;
         }
-        pointer = pointer->next;
+        pointer = pointer->handleNext;
     }
     return NULL;
 }
@@ -4897,6 +5088,7 @@ OCStackResult deleteResource(OCResource *resource)
                 prev->next = temp->next;
             }
 
+            unindexResource(temp);
             deleteResourceElements(temp);
             OICFree(temp);
             temp = NULL;
@@ -5557,16 +5749,17 @@ OCResourceHandle OCGetResourceHandleAtUri(const char *uri)
         return NULL;
     }
 
-    OCResource *pointer = headResource;
+    uint32_t hash = hashResourceUri(uri);
+    OCResource *pointer = resourceUriIndex[hash & (resourceIndexSize - 1)];
 
     while (pointer)
     {
-        if (strncmp(uri, pointer->uri, MAX_URI_LENGTH) == 0)
+        if (pointer->uriHash == hash && strncmp(uri, pointer->uri, MAX_URI_LENGTH) == 0)
         {
             OIC_LOG_V(DEBUG, TAG, "Found Resource %s", uri);
             return pointer;
         }
-        pointer = pointer->next;
+        pointer = pointer->uriNext;
     }
     return NULL;
 }
@@ -26,7 +26,6 @@
 #include "oic_string.h"
 #include "oic_time.h"
 #include "ocrandom.h"
-#include "uarraylist.h"
 #include "ocstackinternal.h"
 #include "ocpayloadcbor.h"
 #include "ocpayload.h"
@@ -77,6 +76,21 @@ static const uint64_t USECS_PER_SEC = 1000000;
  */
 #define DEFAULT_INTERVAL_COUNT  6
 
+/**
+ * Initial number of KeepAlive table buckets (power of two).
+ * The table doubles when it holds as many entries as buckets.
+ */
+#ifndef KEEPALIVE_TABLE_SIZE
+#define KEEPALIVE_TABLE_SIZE 64
+#endif
+
+/**
+ * Max number of expired entries handled by one ProcessKeepAlive() call.
+ */
+#ifndef KEEPALIVE_MAX_BATCH
+#define KEEPALIVE_MAX_BATCH 64
+#endif
+
 /**
  * KeepAlive key to parser Payload Table.
  */
@@ -97,15 +111,10 @@ static bool g_isKeepAliveInitialized = false;
  */
 static OCResourceHandle g_keepAliveHandle = NULL;
 
-/**
- * KeepAlive table which holds connection interval.
- */
-static u_arraylist_t *g_keepAliveConnectionTable = NULL;
-
 /**
  * KeepAlive table entries.
  */
-typedef struct
+typedef struct KeepAliveEntry
 {
     OCMode mode;                    /**< host Mode of Operation. */
     CAEndpoint_t remoteAddr;        /**< destination Address. */
@@ -115,8 +124,32 @@ typedef struct
     int64_t *intervalInfo;          /**< interval values for KeepAlive. */
     bool sentPingMsg;               /**< if oic client already sent ping message. */
     uint64_t timeStamp;             /**< last sent or received ping message. in microseconds. */
+    uint64_t deadline;              /**< time the entry is due. in microseconds. */
+    size_t heapIndex;               /**< position in the deadline heap. */
+    uint32_t hash;                  /**< hash of remote address and port. */
+    struct KeepAliveEntry *next;    /**< next entry in the same table bucket. */
 } KeepAliveEntry_t;
 
+/**
+ * KeepAlive table which holds connection interval, hashed by remote address and port.
+ */
+static KeepAliveEntry_t **g_keepAliveConnectionTable = NULL;
+
+/**
+ * Number of KeepAlive table buckets.
+ */
+static size_t g_keepAliveTableSize = 0;
+
+/**
+ * Min-heap of all KeepAlive entries ordered by deadline, as large as the table.
+ */
+static KeepAliveEntry_t **g_keepAliveHeap = NULL;
+
+/**
+ * Number of KeepAlive entries.
+ */
+static size_t g_keepAliveCount = 0;
+
 /**
  * Send disconnect message to remove connection.
  */
@@ -183,10 +216,22 @@ OCStackResult HandleKeepAliveResponse(const CAEndpoint_t *endPoint,
  * @param[in]   endpoint    Remote Endpoint information (like ipaddress,
  *                          port, reference uri and transport type) to
  *                          which the ping message has to be sent.
- * @param[out]  index       index of array list.
  * @return  KeepAlive entry to send ping message.
  */
-static KeepAliveEntry_t *GetEntryFromEndpoint(const CAEndpoint_t *endpoint, uint32_t *index);
+static KeepAliveEntry_t *GetEntryFromEndpoint(const CAEndpoint_t *endpoint);
+
+/**
+ * Recompute the deadline of an entry after its interval, timeStamp or
+ * sentPingMsg changed.
+ * @param[in]   entry       KeepAlive entry.
+ */
+static void ScheduleKeepAliveEntry(KeepAliveEntry_t *entry);
+
+/**
+ * Move an entry up or down the deadline heap after its deadline changed.
+ * @param[in]   entry       KeepAlive entry.
+ */
+static void FixHeapEntry(KeepAliveEntry_t *entry);
 
 /**
  * Add keepalive entry.
@@ -259,8 +304,13 @@ OCStackResult InitializeKeepAlive(OCMode mode)
 
     if (!g_keepAliveConnectionTable)
     {
-        g_keepAliveConnectionTable = u_arraylist_create();
-        if (NULL == g_keepAliveConnectionTable)
+        g_keepAliveConnectionTable = (KeepAliveEntry_t **) OICCalloc(KEEPALIVE_TABLE_SIZE,
+                                                         sizeof(KeepAliveEntry_t *));
+        g_keepAliveHeap = (KeepAliveEntry_t **) OICCalloc(KEEPALIVE_TABLE_SIZE,
+                                                          sizeof(KeepAliveEntry_t *));
+        g_keepAliveTableSize = KEEPALIVE_TABLE_SIZE;
+        g_keepAliveCount = 0;
+        if (NULL == g_keepAliveConnectionTable || NULL == g_keepAliveHeap)
         {
             OIC_LOG(ERROR, TAG, "Creating KeepAlive Table failed");
             TerminateKeepAlive(mode);
@@ -294,11 +344,17 @@ OCStackResult TerminateKeepAlive(OCMode mode)
         }
     }
 
-    if (NULL != g_keepAliveConnectionTable)
+    for (size_t i = 0; i < g_keepAliveCount; i++)
     {
-        u_arraylist_destroy(g_keepAliveConnectionTable);
-        g_keepAliveConnectionTable = NULL;
+        OICFree(g_keepAliveHeap[i]->intervalInfo);
+        OICFree(g_keepAliveHeap[i]);
     }
+    OICFree(g_keepAliveConnectionTable);
+    g_keepAliveConnectionTable = NULL;
+    OICFree(g_keepAliveHeap);
+    g_keepAliveHeap = NULL;
+    g_keepAliveTableSize = 0;
+    g_keepAliveCount = 0;
 
     g_isKeepAliveInitialized = false;
 
@@ -405,8 +461,7 @@ OCStackResult SendKeepAliveResponse(OCServerRequest *request,
     CAEndpoint_t endpoint = {.adapter = CA_DEFAULT_ADAPTER};
     CopyDevAddrToEndpoint(&request->devAddr, &endpoint);
 
-    uint32_t index = 0;
-    KeepAliveEntry_t *entry = GetEntryFromEndpoint(&endpoint, &index);
+    KeepAliveEntry_t *entry = GetEntryFromEndpoint(&endpoint);
     int64_t interval = (entry) ? entry->interval : 0;
 
     // Create KeepAlive payload to send response message.
@@ -419,10 +474,10 @@ OCStackResult SendKeepAliveResponse(OCServerRequest *request,
         AddResourceInterfaceNameToPayload(payload);
     }
 
-    OCEntityHandlerResponse ehResponse = { .ehResult = result, 
-                                           .payload = (OCPayload*) payload, 
-                                           .requestHandle = request,
-                                           .resourceHandle = g_keepAliveHandle };
+    OCEntityHandlerResponse ehResponse = { .requestHandle = request,
+                                           .resourceHandle = g_keepAliveHandle,
+                                           .ehResult = result,
+                                           .payload = (OCPayload*) payload };
     OICStrcpy(ehResponse.resourceUri, sizeof(ehResponse.resourceUri), KEEPALIVE_RESOURCE_URI);
 
     // Send response message.
@@ -432,8 +487,8 @@ OCStackResult SendKeepAliveResponse(OCServerRequest *request,
 OCEntityHandlerResult HandleKeepAliveGETRequest(OCServerRequest *request,
                                                 const OCResource *resource)
 {
-    VERIFY_NON_NULL(request, FATAL, OC_STACK_INVALID_PARAM);
-    VERIFY_NON_NULL(resource, FATAL, OC_STACK_INVALID_PARAM);
+    VERIFY_NON_NULL(request, FATAL, OC_EH_ERROR);
+    VERIFY_NON_NULL(resource, FATAL, OC_EH_ERROR);
 
     OIC_LOG_V(DEBUG, TAG, "Find Ping resource [%s]", request->resourceUrl);
 
@@ -451,15 +506,14 @@ OCEntityHandlerResult HandleKeepAliveGETRequest(OCServerRequest *request,
 OCEntityHandlerResult HandleKeepAlivePOSTRequest(OCServerRequest *request,
                                                  const OCResource *resource)
 {
-    VERIFY_NON_NULL(request, FATAL, OC_STACK_INVALID_PARAM);
-    VERIFY_NON_NULL(resource, FATAL, OC_STACK_INVALID_PARAM);
+    VERIFY_NON_NULL(request, FATAL, OC_EH_ERROR);
+    VERIFY_NON_NULL(resource, FATAL, OC_EH_ERROR);
 
     // Get entry from KeepAlive table.
     CAEndpoint_t endpoint = { .adapter = CA_DEFAULT_ADAPTER };
     CopyDevAddrToEndpoint(&request->devAddr, &endpoint);
 
-    uint32_t index = 0;
-    KeepAliveEntry_t *entry = GetEntryFromEndpoint(&endpoint, &index);
+    KeepAliveEntry_t *entry = GetEntryFromEndpoint(&endpoint);
     if (!entry)
     {
         OIC_LOG(ERROR, TAG, "Received the first keepalive message from client");
@@ -481,6 +535,7 @@ OCEntityHandlerResult HandleKeepAlivePOSTRequest(OCServerRequest *request,
     entry->interval = interval;
     OIC_LOG_V(DEBUG, TAG, "Received interval is [%" PRId64 "]", entry->interval);
     entry->timeStamp = OICGetCurrentTime(TIME_IN_US);
+    ScheduleKeepAliveEntry(entry);
 
     OCPayloadDestroy(ocPayload);
 
@@ -496,8 +551,7 @@ OCStackResult HandleKeepAliveResponse(const CAEndpoint_t *endPoint,
     OIC_LOG(DEBUG, TAG, "HandleKeepAliveResponse IN");
 
     // Get entry from KeepAlive table.
-    uint32_t index = 0;
-    KeepAliveEntry_t *entry = GetEntryFromEndpoint(endPoint, &index);
+    KeepAliveEntry_t *entry = GetEntryFromEndpoint(endPoint);
     if (!entry)
     {
         // Receive response message about find /oic/ping request.
@@ -536,6 +590,7 @@ OCStackResult HandleKeepAliveResponse(const CAEndpoint_t *endPoint,
     {
         // Set sentPingMsg values with false.
         entry->sentPingMsg = false;
+        ScheduleKeepAliveEntry(entry);
 
         // Check the received interval value.
         int64_t interval = 0;
@@ -555,65 +610,49 @@ void ProcessKeepAlive()
         return;
     }
 
-    uint32_t len = u_arraylist_length(g_keepAliveConnectionTable);
-
-    for (uint32_t i = 0; i < len; i++)
+    // Only entries whose deadline passed are visited, the earliest is on top of the heap.
+    uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
+    for (size_t handled = 0; handled < KEEPALIVE_MAX_BATCH && 0 < g_keepAliveCount
+         && g_keepAliveHeap[0]->deadline <= currentTime; handled++)
     {
-        KeepAliveEntry_t *entry = (KeepAliveEntry_t *)u_arraylist_get(g_keepAliveConnectionTable,
-                                                                      i);
-        if (NULL == entry)
-        {
-            continue;
-        }
+        KeepAliveEntry_t *entry = g_keepAliveHeap[0];
 
-        uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
-        if (OC_CLIENT == entry->mode)
+        if (OC_CLIENT == entry->mode && !entry->sentPingMsg)
         {
-            if (entry->sentPingMsg)
-            {
-                /*
-                 * If an OIC Client does not receive the response within 1 minutes,
-                 * terminate the connection.
-                 * In this case the timeStamp means last time sent ping message.
-                 */
-                if ((KEEPALIVE_RESPONSE_TIMEOUT_SEC * USECS_PER_SEC) <= currentTime - entry->timeStamp)
-                {
-                    OIC_LOG(DEBUG, TAG, "Client does not receive the response within 1 minutes.");
+            // Increase interval value.
+            IncreaseInterval(entry);
 
-                    // Send message to disconnect session.
-                    SendDisconnectMessage(entry);
-                }
-            }
-            else
+            OCStackResult result = SendPingMessage(entry);
+            if (OC_STACK_OK != result)
             {
-                if ((entry->interval * KEEPALIVE_RESPONSE_TIMEOUT_SEC * USECS_PER_SEC)
-                        <= currentTime - entry->timeStamp)
-                {
-                    // Increase interval value.
-                    IncreaseInterval(entry);
-
-                    OCStackResult result = SendPingMessage(entry);
-                    if (OC_STACK_OK != result)
-                    {
-                        OIC_LOG(ERROR, TAG, "Failed to send ping request");
-                        continue;
-                    }
-                }
+                OIC_LOG(ERROR, TAG, "Failed to send ping request");
+
+                // try again when the increased interval has passed.
+                entry->timeStamp = currentTime;
+                ScheduleKeepAliveEntry(entry);
             }
         }
-        else if (OC_SERVER == entry->mode)
+        else if (OC_CLIENT == entry->mode)
+        {
+            /*
+             * If an OIC Client does not receive the response within 1 minutes,
+             * terminate the connection.
+             * In this case the timeStamp means last time sent ping message.
+             */
+            OIC_LOG(DEBUG, TAG, "Client does not receive the response within 1 minutes.");
+
+            // Send message to disconnect session.
+            SendDisconnectMessage(entry);
+        }
+        else
         {
             /*
              * If an OIC Server does not receive a PUT request to ping resource
              * within the specified interval time, terminate the connection.
              * In this case the timeStamp means last time received ping message.
              */
-            if ((entry->interval * KEEPALIVE_RESPONSE_TIMEOUT_SEC * USECS_PER_SEC)
-                    <= currentTime - entry->timeStamp)
-            {
-                OIC_LOG(DEBUG, TAG, "Server does not receive a PUT request.");
-                SendDisconnectMessage(entry);
-            }
+            OIC_LOG(DEBUG, TAG, "Server does not receive a PUT request.");
+            SendDisconnectMessage(entry);
         }
     }
 }
@@ -640,15 +679,17 @@ OCStackResult SendDisconnectMessage(const KeepAliveEntry_t *entry)
      * If CA get the empty message from RI, CA will disconnect a connection.
      */
 
-    OCStackResult result = RemoveKeepAliveEntry(&entry->remoteAddr);
+    // the entry is freed when it is removed.
+    CAEndpoint_t remoteAddr = entry->remoteAddr;
+    OCStackResult result = RemoveKeepAliveEntry(&remoteAddr);
     if (result != OC_STACK_OK)
     {
         return result;
     }
 
     CARequestInfo_t requestInfo = { .method = CA_POST };
-    result = CASendRequest(&entry->remoteAddr, &requestInfo);
-    return CAResultToOCResult(result);
+    CAResult_t caResult = CASendRequest(&remoteAddr, &requestInfo);
+    return CAResultToOCResult(caResult);
 }
 
 OCStackResult SendPingMessage(KeepAliveEntry_t *entry)
@@ -656,7 +697,9 @@ OCStackResult SendPingMessage(KeepAliveEntry_t *entry)
     VERIFY_NON_NULL(entry, FATAL, OC_STACK_INVALID_PARAM);
 
     // Send ping message.
-    OCCallbackData pingData = { .context = NULL, .cb = PingRequestCallback };
+    OCCallbackData pingData;
+    memset(&pingData, 0, sizeof(pingData));
+    pingData.cb = PingRequestCallback;
     OCDevAddr devAddr = { .adapter = OC_ADAPTER_TCP };
     CopyEndpointToDevAddr(&(entry->remoteAddr), &devAddr);
 
@@ -673,6 +716,7 @@ OCStackResult SendPingMessage(KeepAliveEntry_t *entry)
     // Update timeStamp with time sent ping message for next ping message.
     entry->timeStamp = OICGetCurrentTime(TIME_IN_US);
     entry->sentPingMsg = true;
+    ScheduleKeepAliveEntry(entry);
 
     OIC_LOG_V(DEBUG, TAG, "Client sent ping message, interval [%" PRId64 "]", entry->interval);
 
@@ -699,30 +743,123 @@ OCStackApplicationResult PingRequestCallback(void* ctx, OCDoHandle handle,
     return OC_STACK_DELETE_TRANSACTION;
 }
 
-KeepAliveEntry_t *GetEntryFromEndpoint(const CAEndpoint_t *endpoint, uint32_t *index)
+/**
+ * FNV-1a hash of the remote address and port.
+ */
+static uint32_t HashEndpoint(const CAEndpoint_t *endpoint)
 {
-    if (!g_keepAliveConnectionTable)
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(endpoint->addr) && '\0' != endpoint->addr[i]; i++)
     {
-        OIC_LOG(ERROR, TAG, "KeepAlive Table was not Created.");
-        return NULL;
+        hash = (hash ^ (uint8_t) endpoint->addr[i]) * 16777619u;
     }
+    hash = (hash ^ (endpoint->port & 0xFF)) * 16777619u;
+    hash = (hash ^ (endpoint->port >> 8)) * 16777619u;
+    return hash;
+}
 
-    uint32_t len = u_arraylist_length(g_keepAliveConnectionTable);
+static void SetHeapEntry(size_t index, KeepAliveEntry_t *entry)
+{
+    g_keepAliveHeap[index] = entry;
+    entry->heapIndex = index;
+}
 
-    for (uint32_t i = 0; i < len; i++)
+void FixHeapEntry(KeepAliveEntry_t *entry)
+{
+    size_t index = entry->heapIndex;
+    while (0 < index && g_keepAliveHeap[(index - 1) / 2]->deadline > entry->deadline)
     {
-        KeepAliveEntry_t *entry = (KeepAliveEntry_t *)u_arraylist_get(g_keepAliveConnectionTable,
-                                                                      i);
-        if (NULL == entry)
+        SetHeapEntry(index, g_keepAliveHeap[(index - 1) / 2]);
+        index = (index - 1) / 2;
+    }
+    for (;;)
+    {
+        size_t child = 2 * index + 1;
+        if (child >= g_keepAliveCount)
+        {
+            break;
+        }
+        if (child + 1 < g_keepAliveCount
+            && g_keepAliveHeap[child + 1]->deadline < g_keepAliveHeap[child]->deadline)
         {
-            continue;
+            child++;
         }
+        if (entry->deadline <= g_keepAliveHeap[child]->deadline)
+        {
+            break;
+        }
+        SetHeapEntry(index, g_keepAliveHeap[child]);
+        index = child;
+    }
+    SetHeapEntry(index, entry);
+}
+
+void ScheduleKeepAliveEntry(KeepAliveEntry_t *entry)
+{
+    if (OC_CLIENT == entry->mode && entry->sentPingMsg)
+    {
+        entry->deadline = entry->timeStamp + KEEPALIVE_RESPONSE_TIMEOUT_SEC * USECS_PER_SEC;
+    }
+    else if (entry->interval < 0)
+    {
+        entry->deadline = UINT64_MAX;
+    }
+    else
+    {
+        entry->deadline = entry->timeStamp
+                          + entry->interval * KEEPALIVE_RESPONSE_TIMEOUT_SEC * USECS_PER_SEC;
+    }
+    FixHeapEntry(entry);
+}
 
-        if (!strncmp(entry->remoteAddr.addr, endpoint->addr, sizeof(entry->remoteAddr.addr))
+/**
+ * Double the KeepAlive table and the heap.
+ */
+static bool GrowKeepAliveTable()
+{
+    size_t size = g_keepAliveTableSize * 2;
+    KeepAliveEntry_t **heap = (KeepAliveEntry_t **) OICRealloc(g_keepAliveHeap,
+                                                               size * sizeof(KeepAliveEntry_t *));
+    if (NULL == heap)
+    {
+        return false;
+    }
+    g_keepAliveHeap = heap;
+
+    KeepAliveEntry_t **table = (KeepAliveEntry_t **) OICCalloc(size, sizeof(KeepAliveEntry_t *));
+    if (NULL == table)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < g_keepAliveCount; i++)
+    {
+        KeepAliveEntry_t *entry = g_keepAliveHeap[i];
+        entry->next = table[entry->hash & (size - 1)];
+        table[entry->hash & (size - 1)] = entry;
+    }
+    OICFree(g_keepAliveConnectionTable);
+    g_keepAliveConnectionTable = table;
+    g_keepAliveTableSize = size;
+    return true;
+}
+
+KeepAliveEntry_t *GetEntryFromEndpoint(const CAEndpoint_t *endpoint)
+{
+    if (!g_keepAliveConnectionTable)
+    {
+        OIC_LOG(ERROR, TAG, "KeepAlive Table was not Created.");
+        return NULL;
+    }
+
+    uint32_t hash = HashEndpoint(endpoint);
+    for (KeepAliveEntry_t *entry = g_keepAliveConnectionTable[hash & (g_keepAliveTableSize - 1)];
+         NULL != entry; entry = entry->next)
+    {
+        if (entry->hash == hash
+                && !strncmp(entry->remoteAddr.addr, endpoint->addr, sizeof(entry->remoteAddr.addr))
                 && (entry->remoteAddr.port == endpoint->port))
         {
             OIC_LOG(DEBUG, TAG, "Connection Info found in KeepAlive table");
-            *index = i;
             return entry;
         }
     }
@@ -745,6 +882,12 @@ KeepAliveEntry_t *AddKeepAliveEntry(const CAEndpoint_t *endpoint, OCMode mode,
         return NULL;
     }
 
+    if (g_keepAliveCount == g_keepAliveTableSize && !GrowKeepAliveTable())
+    {
+        OIC_LOG(ERROR, TAG, "Failed to grow KeepAlive Table");
+        return NULL;
+    }
+
     KeepAliveEntry_t *entry = (KeepAliveEntry_t *) OICCalloc(1, sizeof(KeepAliveEntry_t));
     if (NULL == entry)
     {
@@ -765,6 +908,12 @@ KeepAliveEntry_t *AddKeepAliveEntry(const CAEndpoint_t *endpoint, OCMode mode,
     if (!entry->intervalInfo)
     {
         entry->intervalInfo = (int64_t*) OICMalloc(entry->intervalSize * sizeof(int64_t));
+        if (!entry->intervalInfo)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to Malloc KeepAlive intervals");
+            OICFree(entry);
+            return NULL;
+        }
         for (size_t i = 0; i < entry->intervalSize; i++)
         {
             entry->intervalInfo[i] = KEEPALIVE_MIN_INTERVAL << i;
@@ -772,14 +921,12 @@ KeepAliveEntry_t *AddKeepAliveEntry(const CAEndpoint_t *endpoint, OCMode mode,
     }
     entry->interval = entry->intervalInfo[0];
 
-    bool result = u_arraylist_add(g_keepAliveConnectionTable, (void *)entry);
-    if (!result)
-    {
-        OIC_LOG(ERROR, TAG, "Adding node to head failed");
-        OICFree(entry->intervalInfo);
-        OICFree(entry);
-        return NULL;
-    }
+    entry->hash = HashEndpoint(&entry->remoteAddr);
+    entry->next = g_keepAliveConnectionTable[entry->hash & (g_keepAliveTableSize - 1)];
+    g_keepAliveConnectionTable[entry->hash & (g_keepAliveTableSize - 1)] = entry;
+
+    SetHeapEntry(g_keepAliveCount++, entry);
+    ScheduleKeepAliveEntry(entry);
 
     return entry;
 }
@@ -788,28 +935,33 @@ OCStackResult RemoveKeepAliveEntry(const CAEndpoint_t *endpoint)
 {
     VERIFY_NON_NULL(endpoint, FATAL, OC_STACK_INVALID_PARAM);
 
-    uint32_t index = 0;
-    KeepAliveEntry_t *entry = GetEntryFromEndpoint(endpoint, &index);
+    KeepAliveEntry_t *entry = GetEntryFromEndpoint(endpoint);
     if (!entry)
     {
         OIC_LOG(ERROR, TAG, "There is no entry in keepalive table.");
         return OC_STACK_ERROR;
     }
 
-    KeepAliveEntry_t *removedEntry = (KeepAliveEntry_t *)
-                                        u_arraylist_remove(g_keepAliveConnectionTable, index);
-    if (NULL == removedEntry)
+    KeepAliveEntry_t **link = &g_keepAliveConnectionTable[entry->hash & (g_keepAliveTableSize - 1)];
+    while (*link != entry)
     {
-        OIC_LOG(ERROR, TAG, "Removed Entry is NULL");
-        return OC_STACK_ERROR;
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+
+    KeepAliveEntry_t *last = g_keepAliveHeap[--g_keepAliveCount];
+    if (last != entry)
+    {
+        SetHeapEntry(entry->heapIndex, last);
+        FixHeapEntry(last);
     }
 
     OIC_LOG_V(DEBUG, TAG, "Remove Connection Info from KeepAlive table, "
-             "remote addr=%s port:%d", removedEntry->remoteAddr.addr,
-             removedEntry->remoteAddr.port);
+             "remote addr=%s port:%d", entry->remoteAddr.addr,
+             entry->remoteAddr.port);
 
     OICFree(entry->intervalInfo);
-    OICFree(removedEntry);
+    OICFree(entry);
 
     return OC_STACK_OK;
 }
@@ -825,7 +977,9 @@ void HandleKeepAliveConnCB(const CAEndpoint_t *endpoint, bool isConnected, bool
         if (isClient)
         {
             // Send discover message to find ping resource
-            OCCallbackData pingData = {.context = NULL, .cb = PingRequestCallback };
+            OCCallbackData pingData;
+            memset(&pingData, 0, sizeof(pingData));
+            pingData.cb = PingRequestCallback;
             OCDevAddr devAddr = { .adapter = OC_ADAPTER_TCP };
             CopyEndpointToDevAddr(endpoint, &devAddr);
 
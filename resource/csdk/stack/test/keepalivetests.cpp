@@ -0,0 +1,191 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+// Test function hooks
+#define InitializeKeepAlive InitializeKeepAliveTest
+#define TerminateKeepAlive TerminateKeepAliveTest
+#define ProcessKeepAlive ProcessKeepAliveTest
+#define HandleKeepAliveRequest HandleKeepAliveRequestTest
+#define HandleKeepAliveResponse HandleKeepAliveResponseTest
+#define HandleKeepAliveConnCB HandleKeepAliveConnCBTest
+#define AddKeepAliveEntry AddKeepAliveEntryTest
+#define OCDoResource OCDoResourceTest
+#define CASendRequest CASendRequestTest
+
+#include "../src/oickeepalive.c"
+
+static const uint64_t USECS_PER_MIN = 60 * USECS_PER_SEC;
+
+static OCStackResult g_pingResult = OC_STACK_OK;
+static size_t g_pingCount = 0;
+static std::vector<uint16_t> g_disconnectedPorts;
+
+OCStackResult OCDoResourceTest(OCDoHandle * /*handle*/, OCMethod /*method*/,
+                               const char * /*requestUri*/, const OCDevAddr * /*destination*/,
+                               OCPayload *payload, OCConnectivityType /*connectivityType*/,
+                               OCQualityOfService /*qos*/, OCCallbackData * /*cbData*/,
+                               OCHeaderOption * /*options*/, uint8_t /*numOptions*/)
+{
+    OCPayloadDestroy(payload);
+    g_pingCount++;
+    return g_pingResult;
+}
+
+CAResult_t CASendRequestTest(const CAEndpoint_t *object, const CARequestInfo_t * /*requestInfo*/)
+{
+    g_disconnectedPorts.push_back(object->port);
+    return CA_STATUS_OK;
+}
+
+class KeepAliveTests : public testing::Test
+{
+    protected:
+    virtual void SetUp()
+    {
+        g_pingResult = OC_STACK_OK;
+        g_pingCount = 0;
+        g_disconnectedPorts.clear();
+        ASSERT_EQ(OC_STACK_OK, InitializeKeepAliveTest(OC_CLIENT));
+    }
+
+    virtual void TearDown()
+    {
+        TerminateKeepAliveTest(OC_CLIENT);
+    }
+
+    // endpoints differ by port, so the port tells the entries apart.
+    static CAEndpoint_t endpoint(uint16_t port)
+    {
+        CAEndpoint_t ep = { .adapter = CA_ADAPTER_TCP };
+        OICStrcpy(ep.addr, sizeof(ep.addr), "192.168.0.1");
+        ep.port = port;
+        return ep;
+    }
+
+    // entry whose last ping was the given number of minutes ago.
+    static KeepAliveEntry_t *addEntry(uint16_t port, OCMode mode, uint64_t minutesAgo)
+    {
+        CAEndpoint_t ep = endpoint(port);
+        KeepAliveEntry_t *entry = AddKeepAliveEntryTest(&ep, mode, NULL);
+        if (entry)
+        {
+            entry->timeStamp -= minutesAgo * USECS_PER_MIN;
+            ScheduleKeepAliveEntry(entry);
+        }
+        return entry;
+    }
+
+    static bool hasEntry(uint16_t port)
+    {
+        CAEndpoint_t ep = endpoint(port);
+        return NULL != GetEntryFromEndpoint(&ep);
+    }
+};
+
+TEST_F(KeepAliveTests, DueEntriesAreHandledInDeadlineOrder)
+{
+    // the default interval is 2 minutes, entries 2 and 3 minutes old are due.
+    const uint64_t minutesAgo[] = { 0, 3, 1, 2 };
+    for (uint16_t port = 1; port <= 200; port++)
+    {
+        ASSERT_TRUE(addEntry(port, OC_SERVER, minutesAgo[port % 4]) != NULL);
+    }
+    EXPECT_EQ(200u, g_keepAliveCount);
+
+    ProcessKeepAliveTest();
+
+    // a server disconnects entries which were not pinged in time, the oldest first
+    ASSERT_EQ(static_cast<size_t>(KEEPALIVE_MAX_BATCH), g_disconnectedPorts.size());
+    for (size_t i = 0; i < g_disconnectedPorts.size(); i++)
+    {
+        EXPECT_FALSE(hasEntry(g_disconnectedPorts[i]));
+        if (i < 50)
+        {
+            EXPECT_EQ(1, g_disconnectedPorts[i] % 4);
+        }
+        else
+        {
+            EXPECT_EQ(3, g_disconnectedPorts[i] % 4);
+        }
+    }
+
+    ProcessKeepAliveTest();
+    EXPECT_EQ(100u, g_disconnectedPorts.size());
+    EXPECT_EQ(100u, g_keepAliveCount);
+    for (uint16_t port = 1; port <= 200; port++)
+    {
+        EXPECT_EQ(0 == port % 2, hasEntry(port));
+    }
+    EXPECT_EQ(0u, g_pingCount);
+}
+
+TEST_F(KeepAliveTests, DisconnectRemovesEntry)
+{
+    for (uint16_t port = 1; port <= 100; port++)
+    {
+        ASSERT_TRUE(addEntry(port, OC_SERVER, port % 2) != NULL);
+    }
+
+    for (uint16_t port = 1; port <= 100; port += 3)
+    {
+        CAEndpoint_t ep = endpoint(port);
+        HandleKeepAliveConnCBTest(&ep, false, false);
+    }
+    EXPECT_EQ(66u, g_keepAliveCount);
+    for (uint16_t port = 1; port <= 100; port++)
+    {
+        EXPECT_EQ(1 != port % 3, hasEntry(port));
+    }
+
+    // the remaining entries are still in deadline order
+    for (size_t i = 1; i < g_keepAliveCount; i++)
+    {
+        EXPECT_EQ(i, g_keepAliveHeap[i]->heapIndex);
+        EXPECT_LE(g_keepAliveHeap[(i - 1) / 2]->deadline, g_keepAliveHeap[i]->deadline);
+    }
+
+    // nothing is due yet
+    ProcessKeepAliveTest();
+    EXPECT_EQ(0u, g_disconnectedPorts.size());
+}
+
+TEST_F(KeepAliveTests, FailedPingWaitsForTheNextInterval)
+{
+    KeepAliveEntry_t *entry = addEntry(1, OC_CLIENT, 3);
+    ASSERT_TRUE(entry != NULL);
+    ASSERT_TRUE(addEntry(2, OC_CLIENT, 0) != NULL);
+
+    g_pingResult = OC_STACK_ERROR;
+    ProcessKeepAliveTest();
+
+    // the ping is tried once, then the entry waits for the increased interval
+    EXPECT_EQ(1u, g_pingCount);
+    EXPECT_FALSE(entry->sentPingMsg);
+    EXPECT_EQ(KEEPALIVE_MIN_INTERVAL << 1, entry->interval);
+    EXPECT_LT(OICGetCurrentTime(TIME_IN_US), entry->deadline);
+
+    ProcessKeepAliveTest();
+    EXPECT_EQ(1u, g_pingCount);
+    EXPECT_EQ(0u, g_disconnectedPorts.size());
+}
@@ -626,6 +626,85 @@ TEST(StackStop, StackStopRepeated)
     EXPECT_EQ(OC_STACK_ERROR, OCStop());
 }
 
+TEST(StackProcess, ProcessBatchWithoutInit)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    uint32_t remaining = 1;
+    EXPECT_EQ(OC_STACK_ERROR, OCProcessBatch(OC_DEFAULT_PROCESS_BATCH_SIZE, &remaining));
+    EXPECT_EQ(0u, remaining);
+}
+
+TEST(StackProcess, ProcessBatchIdle)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    EXPECT_EQ(OC_STACK_OK, OCInit("127.0.0.1", 5683, OC_CLIENT));
+    uint32_t remaining = 1;
+    EXPECT_EQ(OC_STACK_OK, OCProcessBatch(OC_DEFAULT_PROCESS_BATCH_SIZE, &remaining));
+    EXPECT_EQ(0u, remaining);
+    EXPECT_EQ(OC_STACK_OK, OCProcessBatch(1, NULL));
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackProcess, ProcessWaitWithoutInit)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    EXPECT_EQ(OC_STACK_ERROR, OCProcessWait(10));
+    EXPECT_EQ(OC_STACK_ERROR, OCProcessWakeUp());
+}
+
+TEST(StackProcess, ProcessWaitTimeout)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    EXPECT_EQ(OC_STACK_OK, OCInit("127.0.0.1", 5683, OC_CLIENT));
+    EXPECT_EQ(OC_STACK_TIMEOUT, OCProcessWait(10));
+    EXPECT_EQ(OC_STACK_OK, OCProcessWakeUp());
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackProcess, ProcessWakeUpBeforeWait)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    EXPECT_EQ(OC_STACK_OK, OCInit("127.0.0.1", 5683, OC_CLIENT));
+
+    // a wakeup which comes before the wait is not lost
+    EXPECT_EQ(OC_STACK_OK, OCProcessWakeUp());
+    uint64_t start = OICGetCurrentTime(TIME_IN_MS);
+    EXPECT_EQ(OC_STACK_TIMEOUT, OCProcessWait(3000));
+    EXPECT_GT(500u, OICGetCurrentTime(TIME_IN_MS) - start);
+
+    // and it is taken by one wait only
+    EXPECT_EQ(OC_STACK_TIMEOUT, OCProcessWait(10));
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackProcess, ProcessWakeUpReleasesEveryWaiter)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    EXPECT_EQ(OC_STACK_OK, OCInit("127.0.0.1", 5683, OC_CLIENT_SERVER));
+
+    // the client and the server wrapper each wait in their own thread
+    std::atomic<int> returned(0);
+    auto wait = [&returned]()
+    {
+        EXPECT_EQ(OC_STACK_TIMEOUT, OCProcessWait(3000));
+        returned++;
+    };
+    uint64_t start = OICGetCurrentTime(TIME_IN_MS);
+    std::thread first(wait);
+    std::thread second(wait);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(OC_STACK_OK, OCProcessWakeUp());
+    first.join();
+    second.join();
+    EXPECT_EQ(2, returned);
+    EXPECT_GT(500u, OICGetCurrentTime(TIME_IN_MS) - start);
+
+    // nothing is left over for a later wait
+    EXPECT_EQ(OC_STACK_TIMEOUT, OCProcessWait(10));
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
 TEST(StackResource, DISABLED_UpdateResourceNullURI)
 {
     itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
@@ -2049,6 +2128,51 @@ TEST(StackResourceAccess, DeleteMiddleResource)
     EXPECT_EQ(OC_STACK_OK, OCStop());
 }
 
+TEST(StackResourceAccess, GetResourceHandleAtUriManyResources)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting GetResourceHandleAtUriManyResources test");
+    InitStack(OC_SERVER);
+
+    const int numCreated = 150;
+    OCResourceHandle handles[numCreated];
+    char uri[MAX_URI_LENGTH];
+    for (int i = 0; i < numCreated; i++)
+    {
+        snprintf(uri, sizeof(uri), "/a/led%d", i);
+        EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handles[i],
+                                                "core.led",
+                                                "core.rw",
+                                                uri,
+                                                0,
+                                                NULL,
+                                                OC_DISCOVERABLE|OC_OBSERVABLE));
+    }
+
+    // delete every other resource
+    for (int i = 0; i < numCreated; i += 2)
+    {
+        EXPECT_EQ(OC_STACK_OK, OCDeleteResource(handles[i]));
+    }
+
+    for (int i = 0; i < numCreated; i++)
+    {
+        snprintf(uri, sizeof(uri), "/a/led%d", i);
+        if (i % 2)
+        {
+            EXPECT_EQ(handles[i], OCGetResourceHandleAtUri(uri));
+            EXPECT_EQ(OC_STACK_OK, OCBindResourceTypeToResource(handles[i], "core.brightled"));
+        }
+        else
+        {
+            EXPECT_TRUE(NULL == OCGetResourceHandleAtUri(uri));
+        }
+    }
+    EXPECT_TRUE(NULL != OCGetResourceHandleAtUri(OC_RSRVD_DEVICE_URI));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
 // Visual Studio versions earlier than 2015 have bugs in is_pod and report the wrong answer.
 #if !defined(_MSC_VER) || (_MSC_VER >= 1900)
 TEST(PODTests, OCHeaderOption)
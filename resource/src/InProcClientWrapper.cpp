@@ -89,6 +89,7 @@ namespace OC
         if (m_threadRun && m_listeningThread.joinable())
         {
             m_threadRun = false;
+            OCProcessWakeUp();
             m_listeningThread.join();
         }
 
@@ -111,11 +112,12 @@ namespace OC
         while(m_threadRun)
         {
             OCStackResult result;
+            uint32_t remaining = 0;
             auto cLock = m_csdkLock.lock();
             if (cLock)
             {
                 std::lock_guard<std::recursive_mutex> lock(*cLock);
-                result = OCProcess();
+                result = OCProcessBatch(OC_DEFAULT_PROCESS_BATCH_SIZE, &remaining);
             }
             else
             {
@@ -127,8 +129,16 @@ namespace OC
                 // TODO: do something with result if failed?
             }
 
-            // To minimize CPU utilization we may wish to do this with sleep
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            // To minimize CPU utilization, block until the next message arrives
+            // unless messages are still waiting
+            if (0 == remaining)
+            {
+                result = OCProcessWait(OC_MAX_PROCESS_WAIT_MS);
+                if (OC_STACK_OK != result && OC_STACK_TIMEOUT != result)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+            }
         }
     }
 
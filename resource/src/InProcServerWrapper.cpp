@@ -314,6 +314,7 @@ namespace OC
         if(m_processThread.joinable())
         {
             m_threadRun = false;
+            OCProcessWakeUp();
             m_processThread.join();
         }
 
@@ -333,10 +334,11 @@ namespace OC
         while(cLock && m_threadRun)
         {
             OCStackResult result;
+            uint32_t remaining = 0;
 
             {
                 std::lock_guard<std::recursive_mutex> lock(*cLock);
-                result = OCProcess();
+                result = OCProcessBatch(OC_DEFAULT_PROCESS_BATCH_SIZE, &remaining);
             }
 
             if(OC_STACK_ERROR == result)
@@ -345,7 +347,15 @@ namespace OC
                 // ...the value of variable result is simply ignored for now.
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            // keep draining while messages are waiting, then sleep until the next one
+            if (0 == remaining)
+            {
+                result = OCProcessWait(OC_MAX_PROCESS_WAIT_MS);
+                if (OC_STACK_OK != result && OC_STACK_TIMEOUT != result)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+            }
         }
     }
 